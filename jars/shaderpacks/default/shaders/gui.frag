@@ -1,9 +1,28 @@
 #version 450
 
+// Each atlas is an array texture with one layer per kind of data. The GUI only needs the albedo layer
+layout(binding = 0) uniform sampler2DArray gui_atlas;
+layout(binding = 1) uniform sampler2DArray font_atlas;
+
+const float ALBEDO_LAYER = 0.0;
+
 in vec2 uv;
+in vec4 tint;
+flat in uint atlas;
 
-out vec3 color;
+out vec4 color;
 
 void main() {
-    color = vec3(uv, 1);
+    if(atlas == 1u) {
+        color = texture(font_atlas, vec3(uv, ALBEDO_LAYER));
+    } else {
+        color = texture(gui_atlas, vec3(uv, ALBEDO_LAYER));
+    }
+
+    color *= tint;
+
+    // Glyphs and button edges are cut out, not blended
+    if(color.a < 0.1) {
+        discard;
+    }
 }
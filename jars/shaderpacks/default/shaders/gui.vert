@@ -1,7 +1,11 @@
 #version 450
 
-layout(location = 0) in vec3 position_in;
-layout(location = 1) in vec2 uv_in;
+// Every GUI element is an instance of the unit quad. See quad_instance in gl_quad_instance_buffer.h
+layout(location = 0) in vec2 corner;
+layout(location = 1) in vec4 rect;      // x, y, width, height, in GUI pixels
+layout(location = 2) in vec4 uv_rect;   // min_u, min_v, max_u, max_v
+layout(location = 3) in vec4 color_in;
+layout(location = 4) in uint atlas_in;  // 0 for the GUI atlas, 1 for the font atlas
 
 layout(binding = 20, std140) uniform cameraData {
     float viewWidth;
@@ -9,10 +13,17 @@ layout(binding = 20, std140) uniform cameraData {
 };
 
 out vec2 uv;
+out vec4 tint;
+flat out uint atlas;
 
 void main() {
-	gl_Position.xyz = position_in / vec3(viewWidth * 0.5, viewHeight * 0.5, 1) + vec3(-1, -1, 0);
+	vec2 position = rect.xy + corner * rect.zw;
+
+	gl_Position.xy = position / vec2(viewWidth * 0.5, viewHeight * 0.5) + vec2(-1, -1);
+	gl_Position.z = 0.0f;
 	gl_Position.w = 1.0f;
 
-	uv = uv_in;
+	uv = mix(uv_rect.xy, uv_rect.zw, corner);
+	tint = color_in;
+	atlas = atlas_in;
 }
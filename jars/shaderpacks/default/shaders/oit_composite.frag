@@ -0,0 +1,26 @@
+#version 450
+
+// Blends the weighted blended OIT targets over the scene. See weighted_blended_oit.h
+layout(binding = 0) uniform sampler2D accumulation;
+layout(binding = 1) uniform sampler2D revealage;
+
+out vec4 color;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    float reveal = texelFetch(revealage, texel, 0).r;
+    if(reveal >= 1.0) {
+        // Nothing translucent here
+        discard;
+    }
+
+    vec4 accumulated = texelFetch(accumulation, texel, 0);
+
+    // Too many layers can still overflow the half floats. The average color is all that matters, so use white
+    if(any(isinf(accumulated.rgb))) {
+        accumulated.rgb = vec3(accumulated.a);
+    }
+
+    color = vec4(accumulated.rgb / max(accumulated.a, 0.00001), 1.0 - reveal);
+}
@@ -2,6 +2,7 @@ package com.continuum.nova;
 
 import com.sun.jna.*;
 
+import java.nio.ByteBuffer;
 import java.util.Arrays;
 import java.util.Collections;
 import java.util.List;
@@ -99,7 +100,7 @@ public interface NovaNative extends Library
         @Override
         protected List<String> getFieldOrder()
         {
-            return Arrays.asList("x_position", "y_position", "width", "height", "is_pressed");
+            return Arrays.asList("x_position", "y_position", "width", "height", "text", "is_pressed");
         }
     }
 
@@ -233,12 +234,37 @@ public interface NovaNative extends Library
         SPECULAR
     }
 
+    enum PixelFormat
+    {
+        RGBA,
+        BGRA,
+        ABGR,
+        RGB,
+        BGR,
+        RG,
+        RED
+    }
+
     void init_nova();
 
     void add_texture(mc_atlas_texture texture, int atlas_type, int texture_type);
 
+    /**
+     * Uploads a texture straight out of a direct ByteBuffer, without copying it into JNA memory first
+     *
+     * @return 1 if the texture was added, 0 if the parameters were invalid. JNA reads a boolean return as a whole
+     * int, but the native side only sets one byte of a bool, so this has to be an int
+     */
+    int add_texture_from_buffer(ByteBuffer pixel_data, int length, int width, int height, int row_stride, int pixel_format, int atlas_type, int texture_type);
+
     void add_texture_location(mc_texture_atlas_location location);
 
+    /**
+     * Adds every texture location in an atlas at once. names holds each name as null-terminated UTF-8, name_offsets
+     * says where each name starts, and uv_rects holds min_u, max_u, min_v, max_v for each texture
+     */
+    void add_texture_locations(byte[] names, int names_length, int[] name_offsets, float[] uv_rects, int count);
+
     int get_max_texture_size();
 
     void reset_texture_manager();
@@ -249,5 +275,34 @@ public interface NovaNative extends Library
 
     boolean should_close();
 
-    void send_change_gui_screen_command(mc_set_gui_screen_command set_gui_screen);
+    /**
+     * Tells the native code how wide each glyph in the font is, in GUI pixels
+     */
+    void set_font_glyph_widths(byte[] widths, int count);
+
+    Pointer get_command_ring();
+
+    int get_command_ring_size();
+
+    int ring_command_doorbell(int write_position);
+
+    /**
+     * Tells the native code how much light each block gives off and how much it blocks, indexed by block ID. Send
+     * these before any chunk sections
+     */
+    void set_block_light_properties(byte[] emissions, byte[] opacities, int count);
+
+    /**
+     * Adds a 16x16x16 section of blocks to the native light engine, or replaces the one that's there. Block IDs are
+     * indexed by x + z * 16 + y * 256. There have to be all 4096 of them, even
+     * if the section is all air
+     */
+    void add_chunk_section(int x, int y, int z, short[] block_ids);
+
+    void remove_chunk_section(int x, int y, int z);
+
+    /**
+     * Tells the native light engine that a block changed. The position is in blocks
+     */
+    void set_block(int x, int y, int z, int block_id);
 }
\ No newline at end of file
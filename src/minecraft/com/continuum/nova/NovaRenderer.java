@@ -1,7 +1,10 @@
 package com.continuum.nova;
 
 import com.continuum.nova.utils.AtlasGenerator;
+import com.continuum.nova.utils.CommandRingWriter;
 import com.continuum.nova.utils.RenderCommandBuilder;
+import net.minecraft.block.Block;
+import net.minecraft.block.state.IBlockState;
 import net.minecraft.client.Minecraft;
 import net.minecraft.client.gui.GuiScreen;
 import net.minecraft.client.renderer.entity.Render;
@@ -17,9 +20,13 @@ import java.awt.*;
 import java.awt.image.BufferedImage;
 import java.awt.image.DataBufferByte;
 import java.io.BufferedInputStream;
+import java.io.ByteArrayOutputStream;
 import java.io.IOException;
 import java.lang.management.ManagementFactory;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
 import java.util.ArrayList;
+import java.util.Collections;
 import java.util.List;
 import java.util.Map;
 
@@ -425,6 +432,20 @@ public class NovaRenderer implements IResourceManagerReloadListener
         }
     }
 
+    private final List<ResourceLocation> GUI_ALBEDO_TEXTURES_LOCATION = new ArrayList<>();
+    {
+        {
+            GUI_ALBEDO_TEXTURES_LOCATION.add(new ResourceLocation("textures/gui/widgets.png"));
+        }
+    }
+
+    private static final ResourceLocation FONT_TEXTURE_LOCATION = new ResourceLocation("textures/font/ascii.png");
+
+    /**
+     * Block IDs only go up to 4095, since the other four bits of a block state are the metadata
+     */
+    private static final int MAX_BLOCK_IDS = 4096;
+
     private boolean firstLoad = true;
     private int renderChunkDistance = 4;
 
@@ -440,6 +461,88 @@ public class NovaRenderer implements IResourceManagerReloadListener
         int maxAtlasSize = NovaNative.INSTANCE.get_max_texture_size();
         AtlasGenerator gen = new AtlasGenerator();
         addTextures(TERRAIN_ALBEDO_TEXTURES_LOCATION, NovaNative.AtlasType.TERRAIN, NovaNative.TextureType.ALBEDO, resourceManager, maxAtlasSize, gen);
+        addTextures(GUI_ALBEDO_TEXTURES_LOCATION, NovaNative.AtlasType.GUI, NovaNative.TextureType.ALBEDO, resourceManager, maxAtlasSize, gen);
+        addTextures(Collections.singletonList(FONT_TEXTURE_LOCATION), NovaNative.AtlasType.FONT, NovaNative.TextureType.ALBEDO, resourceManager, maxAtlasSize, gen);
+        sendGlyphWidths(resourceManager);
+    }
+
+    /**
+     * Measures every glyph in the font the same way Minecraft's FontRenderer does, and sends the widths to the native
+     * code so it lays text out the same way
+     */
+    private void sendGlyphWidths(IResourceManager resourceManager)
+    {
+        BufferedImage font;
+        try
+        {
+            font = ImageIO.read(new BufferedInputStream(resourceManager.getResource(FONT_TEXTURE_LOCATION).getInputStream()));
+        }
+        catch (IOException e)
+        {
+            LOG.warn("Could not read the font texture, text will use the default glyph widths: " + e.getMessage());
+            return;
+        }
+
+        if (font == null)
+        {
+            return;
+        }
+
+        int cellWidth = font.getWidth() / 16;
+        int cellHeight = font.getHeight() / 16;
+        float scale = 8.0f / cellWidth;
+        byte[] widths = new byte[256];
+
+        for (int glyph = 0; glyph < 256; glyph++)
+        {
+            int cellX = (glyph % 16) * cellWidth;
+            int cellY = (glyph / 16) * cellHeight;
+
+            // Find the rightmost column with anything in it
+            int lastColumn = cellWidth - 1;
+            for (; lastColumn >= 0; lastColumn--)
+            {
+                boolean columnEmpty = true;
+                for (int y = 0; y < cellHeight && columnEmpty; y++)
+                {
+                    columnEmpty = (font.getRGB(cellX + lastColumn, cellY + y) >>> 24) == 0;
+                }
+
+                if (!columnEmpty)
+                {
+                    break;
+                }
+            }
+
+            widths[glyph] = (byte) (glyph == ' ' ? 4 : (int) (0.5 + (lastColumn + 1) * scale) + 1);
+        }
+
+        NovaNative.INSTANCE.set_font_glyph_widths(widths, widths.length);
+    }
+
+    /**
+     * Sends how much light every block gives off and how much it blocks, so the native light engine lights things the
+     * same way Minecraft does
+     */
+    private void sendBlockLightProperties()
+    {
+        byte[] emissions = new byte[MAX_BLOCK_IDS];
+        byte[] opacities = new byte[MAX_BLOCK_IDS];
+
+        for (Block block : Block.REGISTRY)
+        {
+            int id = Block.getIdFromBlock(block);
+            if (id < 0 || id >= MAX_BLOCK_IDS)
+            {
+                continue;
+            }
+
+            IBlockState state = block.getDefaultState();
+            emissions[id] = (byte) Math.min(state.getLightValue(), 15);
+            opacities[id] = (byte) Math.min(state.getLightOpacity(), 15);
+        }
+
+        NovaNative.INSTANCE.set_block_light_properties(emissions, opacities, MAX_BLOCK_IDS);
     }
 
     private void addTextures(
@@ -481,39 +584,30 @@ public class NovaRenderer implements IResourceManagerReloadListener
                 byte[] imageData = ((DataBufferByte)image.getRaster().getDataBuffer()).getData();
                 LOG.info("The image has " + imageData.length + " separate pixels");
 
-                for (int i = 0; i < imageData.length; i += 4)
-                {
-                    byte a = imageData[i];
-                    byte b = imageData[i + 1];
-                    byte g = imageData[i + 2];
-                    byte r = imageData[i + 3];
-                    imageData[i] = r;
-                    imageData[i + 1] = g;
-                    imageData[i + 2] = b;
-                    imageData[i + 3] = a;
-                }
+                // The native code reads ABGR and BGR directly, so the bytes can go over exactly as the image has them
+                NovaNative.PixelFormat pixelFormat = image.getColorModel().getNumComponents() == 4 ? NovaNative.PixelFormat.ABGR : NovaNative.PixelFormat.BGR;
+                int rowStride = image.getWidth() * image.getColorModel().getNumComponents();
+
+                ByteBuffer pixelBuffer = getTextureUploadBuffer(imageData.length);
+                pixelBuffer.put(imageData);
+                pixelBuffer.flip();
 
-                NovaNative.mc_atlas_texture atlasTex = new NovaNative.mc_atlas_texture(
+                boolean added = NovaNative.INSTANCE.add_texture_from_buffer(
+                    pixelBuffer,
+                    imageData.length,
                     image.getWidth(),
                     image.getHeight(),
-                    image.getColorModel().getNumComponents(),
-                    imageData
-                );
-                NovaNative.INSTANCE.add_texture(atlasTex, atlasType.ordinal(), textureType.ordinal());
-                Map<String, Rectangle> rectangleMap = texture.getRectangleMap();
-
-                for (String texName : rectangleMap.keySet())
+                    rowStride,
+                    pixelFormat.ordinal(),
+                    atlasType.ordinal(),
+                    textureType.ordinal()
+                ) != 0;
+                if (!added)
                 {
-                    Rectangle rect = rectangleMap.get(texName);
-                    NovaNative.mc_texture_atlas_location atlasLoc = new NovaNative.mc_texture_atlas_location(
-                        texName,
-                        rect.x / (float)image.getWidth(),
-                        rect.y / (float)image.getHeight(),
-                        rect.width / (float)image.getWidth(),
-                        rect.height / (float)image.getHeight()
-                    );
-                    NovaNative.INSTANCE.add_texture_location(atlasLoc);
+                    LOG.warn("Nova rejected the " + atlasType + " " + textureType + " texture");
                 }
+                Map<String, Rectangle> rectangleMap = texture.getRectangleMap();
+                addTextureLocations(rectangleMap, image.getWidth(), image.getHeight());
             }
             catch (AtlasGenerator.Texture.WrongNumComponentsException e)
             {
@@ -522,6 +616,56 @@ public class NovaRenderer implements IResourceManagerReloadListener
         }
     }
 
+    private ByteBuffer textureUploadBuffer;
+
+    private CommandRingWriter commands;
+
+    /**
+     * Returns a cleared direct buffer with room for at least the given number of bytes
+     *
+     * The buffer is reused between atlases so that a resource reload doesn't allocate a new direct buffer per atlas
+     */
+    private ByteBuffer getTextureUploadBuffer(int size)
+    {
+        if (textureUploadBuffer == null || textureUploadBuffer.capacity() < size)
+        {
+            textureUploadBuffer = ByteBuffer.allocateDirect(size);
+        }
+
+        textureUploadBuffer.clear();
+        return textureUploadBuffer;
+    }
+
+    /**
+     * Sends every texture location in an atlas to the native code in a single call
+     */
+    private void addTextureLocations(Map<String, Rectangle> rectangleMap, int atlasWidth, int atlasHeight)
+    {
+        int count = rectangleMap.size();
+        int[] nameOffsets = new int[count];
+        float[] uvRects = new float[count * 4];
+        ByteArrayOutputStream names = new ByteArrayOutputStream(count * 32);
+
+        int i = 0;
+        for (Map.Entry<String, Rectangle> entry : rectangleMap.entrySet())
+        {
+            byte[] encodedName = entry.getKey().getBytes(StandardCharsets.UTF_8);
+            nameOffsets[i] = names.size();
+            names.write(encodedName, 0, encodedName.length);
+            names.write(0);
+
+            Rectangle rect = entry.getValue();
+            uvRects[i * 4] = rect.x / (float)atlasWidth;
+            uvRects[i * 4 + 1] = (rect.x + rect.width) / (float)atlasWidth;
+            uvRects[i * 4 + 2] = rect.y / (float)atlasHeight;
+            uvRects[i * 4 + 3] = (rect.y + rect.height) / (float)atlasHeight;
+            i++;
+        }
+
+        byte[] packedNames = names.toByteArray();
+        NovaNative.INSTANCE.add_texture_locations(packedNames, packedNames.length, nameOffsets, uvRects, count);
+    }
+
     public void preInit() {
         System.getProperties().setProperty("jna.library.path", "D:\\Documents\\Nova Renderer\\jars\\versions\\1.10\\1.10-natives");
         System.getProperties().setProperty("jna.dump_memory", "false");
@@ -530,6 +674,8 @@ public class NovaRenderer implements IResourceManagerReloadListener
         String curDir = System.getProperty("user.dir");
         LOG.info("Current directory: " + curDir);
         NovaNative.INSTANCE.init_nova();
+        sendBlockLightProperties();
+        commands = new CommandRingWriter();
         LOG.info("Native code initialized");
     }
 
@@ -539,8 +685,10 @@ public class NovaRenderer implements IResourceManagerReloadListener
 
     public void updateCameraAndRender(float renderPartialTicks, long systemNanoTime, Minecraft mc)
     {
-        NovaNative.mc_render_command cmd = RenderCommandBuilder.makeRenderCommand(mc, renderPartialTicks);
-        NovaNative.INSTANCE.send_render_command(cmd);
+        RenderCommandBuilder.writeRenderCommand(commands, mc, renderPartialTicks);
+
+        // Everything written since the last frame goes over in this one call
+        commands.flush();
 
         if (NovaNative.INSTANCE.should_close())
         {
@@ -550,7 +698,6 @@ public class NovaRenderer implements IResourceManagerReloadListener
 
     public void setGuiScreen(GuiScreen guiScreenIn)
     {
-        NovaNative.mc_set_gui_screen_command set_gui_screen = RenderCommandBuilder.createSetGuiScreenCommand(guiScreenIn);
-        NovaNative.INSTANCE.send_change_gui_screen_command(set_gui_screen);
+        RenderCommandBuilder.writeSetGuiScreenCommand(commands, guiScreenIn);
     }
 }
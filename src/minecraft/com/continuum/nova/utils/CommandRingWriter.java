@@ -0,0 +1,219 @@
+package com.continuum.nova.utils;
+
+import com.continuum.nova.NovaNative;
+import com.sun.jna.Pointer;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Writes commands into the native command ring
+ *
+ * The native code owns a ring buffer in shared memory. Instead of marshalling a JNA Structure for every command, we
+ * write a compact binary encoding of each command straight into that memory, then ring the doorbell once per frame to
+ * tell the native code how far we got. See command_ring.h for the encoding.
+ *
+ * Only one thread may write to the ring.
+ */
+public class CommandRingWriter
+{
+    private static final int MAGIC = 0x41564F4E;
+    private static final int VERSION = 1;
+
+    private static final int COMMAND_HEADER_SIZE = 8;
+
+    private static final short WRAP = 0;
+    private static final short SET_GUI_SCREEN = 1;
+    private static final short RENDER = 2;
+    private static final short ADD_TEXTURE_LOCATION = 3;
+
+    private final ByteBuffer ring;
+    private final int capacity;
+
+    /**
+     * Positions count bytes forever and are compared as unsigned ints, exactly like on the native side
+     */
+    private int writePosition;
+    private int readPosition;
+
+    public CommandRingWriter()
+    {
+        Pointer memory = NovaNative.INSTANCE.get_command_ring();
+        int size = NovaNative.INSTANCE.get_command_ring_size();
+        ByteBuffer wholeRing = memory.getByteBuffer(0, size).order(ByteOrder.nativeOrder());
+
+        if (wholeRing.getInt(0) != MAGIC)
+        {
+            throw new IllegalStateException("The native command ring doesn't start with the right magic number");
+        }
+
+        if (wholeRing.getInt(4) != VERSION)
+        {
+            throw new IllegalStateException("The native command ring uses version " + wholeRing.getInt(4) + " but I only speak version " + VERSION);
+        }
+
+        capacity = wholeRing.getInt(8);
+        int dataOffset = wholeRing.getInt(12);
+
+        wholeRing.position(dataOffset);
+        ring = wholeRing.slice().order(ByteOrder.nativeOrder());
+    }
+
+    public void writeSetGuiScreen(int numButtons, int[] xPositions, int[] yPositions, int[] widths, int[] heights, boolean[] pressed, String[] text)
+    {
+        byte[][] encodedText = new byte[numButtons][];
+        int size = COMMAND_HEADER_SIZE + 4;
+
+        for (int i = 0; i < numButtons; i++)
+        {
+            encodedText[i] = text[i] == null ? new byte[0] : text[i].getBytes(StandardCharsets.UTF_8);
+            if (encodedText[i].length > 0xFFFF)
+            {
+                encodedText[i] = new byte[0];
+            }
+
+            size += 20 + padToFour(encodedText[i].length);
+        }
+
+        int offset = beginCommand(SET_GUI_SCREEN, size);
+        ring.putInt(offset, numButtons);
+        offset += 4;
+
+        for (int i = 0; i < numButtons; i++)
+        {
+            ring.putInt(offset, xPositions[i]);
+            ring.putInt(offset + 4, yPositions[i]);
+            ring.putInt(offset + 8, widths[i]);
+            ring.putInt(offset + 12, heights[i]);
+            ring.put(offset + 16, (byte) (pressed[i] ? 1 : 0));
+            ring.put(offset + 17, (byte) 0);
+            ring.putShort(offset + 18, (short) encodedText[i].length);
+            offset += 20;
+
+            for (byte b : encodedText[i])
+            {
+                ring.put(offset++, b);
+            }
+
+            offset += padToFour(encodedText[i].length) - encodedText[i].length;
+        }
+
+        endCommand(size);
+    }
+
+    public void writeRender(long previousFrameTime, float mouseX, float mouseY, double cameraX, double cameraY, double cameraZ)
+    {
+        int size = COMMAND_HEADER_SIZE + 40;
+        int offset = beginCommand(RENDER, size);
+
+        ring.putLong(offset, previousFrameTime);
+        ring.putFloat(offset + 8, mouseX);
+        ring.putFloat(offset + 12, mouseY);
+        ring.putDouble(offset + 16, cameraX);
+        ring.putDouble(offset + 24, cameraY);
+        ring.putDouble(offset + 32, cameraZ);
+
+        endCommand(size);
+    }
+
+    public void writeAddTextureLocation(String name, float minU, float maxU, float minV, float maxV)
+    {
+        byte[] encodedName = name.getBytes(StandardCharsets.UTF_8);
+        if (encodedName.length > 0xFFFF)
+        {
+            // The length goes over as a u16, and a texture with a chopped-off name would never be found
+            throw new IllegalArgumentException("Texture name " + name + " is " + encodedName.length + " bytes, but the most the ring can send is " + 0xFFFF);
+        }
+
+        int size = COMMAND_HEADER_SIZE + 20 + padToFour(encodedName.length);
+        int offset = beginCommand(ADD_TEXTURE_LOCATION, size);
+
+        ring.putFloat(offset, minU);
+        ring.putFloat(offset + 4, maxU);
+        ring.putFloat(offset + 8, minV);
+        ring.putFloat(offset + 12, maxV);
+        ring.putShort(offset + 16, (short) encodedName.length);
+        ring.putShort(offset + 18, (short) 0);
+        offset += 20;
+
+        for (byte b : encodedName)
+        {
+            ring.put(offset++, b);
+        }
+
+        endCommand(size);
+    }
+
+    /**
+     * Tells the native code about everything written since the last flush. This is the only JNA call the ring needs
+     */
+    public void flush()
+    {
+        readPosition = NovaNative.INSTANCE.ring_command_doorbell(writePosition);
+    }
+
+    /**
+     * Makes room for a command of the given size and writes its header
+     *
+     * @return The offset in the ring to write the command's payload at
+     */
+    private int beginCommand(short type, int size)
+    {
+        size = padToEight(size);
+        if (size > capacity)
+        {
+            throw new IllegalArgumentException("A command of " + size + " bytes will never fit in a ring of " + capacity + " bytes");
+        }
+
+        int offset = writePosition & (capacity - 1);
+        if (offset + size > capacity)
+        {
+            // Not enough room before the end of the ring. Skip to the start
+            int paddingSize = capacity - offset;
+            waitForSpace(paddingSize);
+            ring.putShort(offset, WRAP);
+            ring.putShort(offset + 2, (short) 0);
+            ring.putInt(offset + 4, paddingSize);
+            writePosition += paddingSize;
+            offset = 0;
+        }
+
+        waitForSpace(size);
+        ring.putShort(offset, type);
+        ring.putShort(offset + 2, (short) 0);
+        ring.putInt(offset + 4, size);
+
+        return offset + COMMAND_HEADER_SIZE;
+    }
+
+    private void endCommand(int size)
+    {
+        writePosition += padToEight(size);
+    }
+
+    /**
+     * Blocks until the native side has read enough of the ring for the given number of bytes to fit
+     */
+    private void waitForSpace(int bytes)
+    {
+        while (capacity - (writePosition - readPosition) < bytes)
+        {
+            flush();
+            if (capacity - (writePosition - readPosition) < bytes)
+            {
+                Thread.yield();
+            }
+        }
+    }
+
+    private static int padToFour(int value)
+    {
+        return (value + 3) & ~3;
+    }
+
+    private static int padToEight(int value)
+    {
+        return (value + 7) & ~7;
+    }
+}
@@ -22,44 +22,51 @@ public class RenderCommandBuilder
 {
     private static final Logger LOG = LogManager.getLogger(RenderCommandBuilder.class);
 
-    public static NovaNative.mc_render_command makeRenderCommand(Minecraft mc, float partialTicks)
-    {
-        NovaNative.mc_render_command command = new NovaNative.mc_render_command();
-        addRenderWorldCommand(mc, partialTicks, command);
-        return command;
-    }
+    /**
+     * Must match MAX_NUM_BUTTONS in mc_gui_objects.h
+     */
+    private static final int MAX_NUM_BUTTONS = 22;
 
-    public static NovaNative.mc_set_gui_screen_command createSetGuiScreenCommand(GuiScreen curScreen)
+    public static void writeRenderCommand(CommandRingWriter commands, Minecraft mc, float partialTicks)
     {
-        NovaNative.mc_set_gui_screen_command set_gui_screen_command = new NovaNative.mc_set_gui_screen_command();
-        int cur_button = 0;
+        double cameraX = 0;
+        double cameraY = 0;
+        double cameraZ = 0;
+        Entity viewEntity = mc.getRenderViewEntity();
 
-        for (GuiButton button : curScreen.getButtonList())
+        if (Utils.exists(viewEntity))
         {
-            NovaNative.mc_gui_button new_button = new NovaNative.mc_gui_button();
-            new_button.x_position = button.xPosition;
-            new_button.y_position = button.yPosition;
-            new_button.width = button.getButtonWidth();
-            new_button.height = button.getButtonHeight();
-            new_button.text = button.displayString;
-            set_gui_screen_command.screen.buttons[cur_button] = new_button;
-            cur_button++;
+            cameraX = viewEntity.lastTickPosX + (viewEntity.posX - viewEntity.lastTickPosX) * partialTicks;
+            cameraY = viewEntity.lastTickPosY + (viewEntity.posY - viewEntity.lastTickPosY) * partialTicks;
+            cameraZ = viewEntity.lastTickPosZ + (viewEntity.posZ - viewEntity.lastTickPosZ) * partialTicks;
         }
 
-        set_gui_screen_command.screen.num_buttons = cur_button;
-        return set_gui_screen_command;
+        commands.writeRender(0, 0, 0, cameraX, cameraY, cameraZ);
     }
 
-    private static void addRenderWorldCommand(Minecraft mc, double partialTicks, NovaNative.mc_render_command command)
+    public static void writeSetGuiScreenCommand(CommandRingWriter commands, GuiScreen curScreen)
     {
-        Entity viewEntity = mc.getRenderViewEntity();
+        List<GuiButton> buttons = curScreen.getButtonList();
+        int numButtons = Math.min(buttons.size(), MAX_NUM_BUTTONS);
 
-        if (Utils.exists(viewEntity))
+        int[] xPositions = new int[numButtons];
+        int[] yPositions = new int[numButtons];
+        int[] widths = new int[numButtons];
+        int[] heights = new int[numButtons];
+        boolean[] pressed = new boolean[numButtons];
+        String[] text = new String[numButtons];
+
+        for (int i = 0; i < numButtons; i++)
         {
-            command.world_params.camera_x = viewEntity.lastTickPosX + (viewEntity.posX - viewEntity.lastTickPosX) * partialTicks;
-            command.world_params.camera_y = viewEntity.lastTickPosY + (viewEntity.posY - viewEntity.lastTickPosY) * partialTicks;
-            command.world_params.camera_z = viewEntity.lastTickPosZ + (viewEntity.posZ - viewEntity.lastTickPosZ) * partialTicks;
+            GuiButton button = buttons.get(i);
+            xPositions[i] = button.xPosition;
+            yPositions[i] = button.yPosition;
+            widths[i] = button.getButtonWidth();
+            heights[i] = button.getButtonHeight();
+            text[i] = button.displayString;
         }
+
+        commands.writeSetGuiScreen(numButtons, xPositions, yPositions, widths, heights, pressed, text);
     }
 
     private static NovaNative.mc_chunk makeChunk(World world, BlockPos chunkCoordinates)
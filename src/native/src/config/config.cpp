@@ -8,7 +8,7 @@
 
 #include "utils/utils.h"
 
-config::config(std::string filename) {
+config::config(std::string filename) : settings(std::make_shared<nova_settings>()) {
     LOG(INFO) << "Loading config from " << filename;
 
     std::ifstream config_file(filename);
@@ -25,21 +25,97 @@ config::config(std::string filename) {
 }
 
 void config::register_change_listener(iconfig_listener *new_listener) {
-    config_change_listeners.push_back(new_listener);
+    config_change_listeners.push_back({new_listener, {}});
+}
+
+void config::register_change_listener(iconfig_listener *new_listener, std::vector<std::string> keys) {
+    config_change_listeners.push_back({new_listener, keys});
 }
 
 nlohmann::json & config::get_options() {
     return options;
 }
 
+std::shared_ptr<const nova_settings> config::get_settings() const {
+    return std::atomic_load(&settings);
+}
+
 void config::update_config_changed() {
-    for(iconfig_listener * l : config_change_listeners) {
-        l->on_config_change(options["settings"]);
+    nlohmann::json & settings_node = options["settings"];
+
+    std::vector<std::string> changed_paths = diff(last_notified_settings, settings_node);
+    if(changed_paths.empty()) {
+        return;
     }
+
+    // Build the new settings off to the side, then swap them in all at once so nobody sees half of a change
+    std::shared_ptr<const nova_settings> new_settings = std::make_shared<nova_settings>(
+            nova_settings::from_json(settings_node));
+    std::atomic_store(&settings, new_settings);
+
+    for(listener_subscription & subscription : config_change_listeners) {
+        bool wants_change = subscription.keys.empty();
+        for(const std::string & key : subscription.keys) {
+            for(const std::string & changed_path : changed_paths) {
+                wants_change |= path_overlaps(key, changed_path);
+            }
+        }
+
+        if(wants_change) {
+            subscription.listener->on_config_change(*new_settings);
+        }
+    }
+
+    last_notified_settings = settings_node;
+}
+
+std::vector<std::string> config::diff(const nlohmann::json & old_value, const nlohmann::json & new_value) {
+    std::vector<std::string> changed_paths;
+    diff(old_value, new_value, "", changed_paths);
+    return changed_paths;
+}
+
+void config::diff(const nlohmann::json & old_value, const nlohmann::json & new_value, const std::string & path,
+                  std::vector<std::string> & changed_paths) {
+    if(!old_value.is_object() || !new_value.is_object()) {
+        if(old_value != new_value) {
+            // The root has no name, but it still needs a path
+            changed_paths.push_back(path.empty() ? "/" : path);
+        }
+        return;
+    }
+
+    for(auto it = new_value.begin(); it != new_value.end(); ++it) {
+        auto old_child = old_value.find(it.key());
+        if(old_child == old_value.end()) {
+            changed_paths.push_back(path + "/" + it.key());
+        } else {
+            diff(*old_child, it.value(), path + "/" + it.key(), changed_paths);
+        }
+    }
+
+    for(auto it = old_value.begin(); it != old_value.end(); ++it) {
+        if(new_value.find(it.key()) == new_value.end()) {
+            changed_paths.push_back(path + "/" + it.key());
+        }
+    }
+}
+
+bool config::path_overlaps(const std::string & key, const std::string & changed_path) {
+    if(key == "/" || changed_path == "/") {
+        return true;
+    }
+
+    const std::string & shorter = key.size() < changed_path.size() ? key : changed_path;
+    const std::string & longer = key.size() < changed_path.size() ? changed_path : key;
+
+    // "/view" shouldn't match "/viewWidth", so the longer path has to continue with a new segment
+    return longer.compare(0, shorter.size(), shorter) == 0 &&
+            (longer.size() == shorter.size() || longer[shorter.size()] == '/');
 }
 
 void config::update_config_loaded() {
-    for(iconfig_listener * l : config_change_listeners) {
-        l->on_config_loaded(options);
+    for(listener_subscription & subscription : config_change_listeners) {
+        subscription.listener->on_config_loaded(options);
     }
 }
@@ -6,9 +6,11 @@
 #ifndef RENDERER_CONFIG_H
 #define RENDERER_CONFIG_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <json.hpp>
+#include "nova_settings.h"
 
 class config;
 
@@ -23,11 +25,12 @@ public:
      * This method is called throughout Nova's lifetime whenever a configuration value changes. This method should
      * handle changing configuration values such as the size of the window and what shaderpack the user has loaded
      *
-     * Note that this method only recieves the read-write config values (the 'settings' node)
+     * Note that this method only recieves the read-write config values (the 'settings' node), already checked and
+     * pulled out into a nova_settings
      *
-     * \param new_config The updated configuration
+     * \param new_settings The updated settings
      */
-    virtual void on_config_change(nlohmann::json& new_config) = 0;
+    virtual void on_config_change(const nova_settings& new_settings) = 0;
 
     /*!
      * \brief Tells listeners that the configuration has been loaded
@@ -63,11 +66,45 @@ public:
 
     /*!
      * \brief Registers the given iconfig_change_listener as an Observer
+     *
+     * The listener hears about every change, no matter which settings changed
      */
     void register_change_listener(iconfig_listener* new_listener);
 
+    /*!
+     * \brief Registers the given iconfig_change_listener as an Observer that only cares about some of the settings
+     *
+     * The listener's on_config_change is only called when one of the given settings changed. Keys are paths relative
+     * to the 'settings' node, written like JSON pointers: "/viewWidth", or "/shaderpackOptions/bloom". Subscribing to
+     * an object means you hear about any change inside it
+     *
+     * \param new_listener The listener to register
+     * \param keys The paths of the settings the listener cares about
+     */
+    void register_change_listener(iconfig_listener* new_listener, std::vector<std::string> keys);
+
+    /*!
+     * \brief Finds every value that's different between two JSON documents
+     *
+     * Objects are compared key by key, so changing one value deep in an object only reports that one value. Anything
+     * that isn't an object is compared as a whole, so a changed array is reported as one path
+     *
+     * \param old_value The JSON before the change
+     * \param new_value The JSON after the change
+     * \return The JSON pointer of every value that was added, removed, or changed
+     */
+    static std::vector<std::string> diff(const nlohmann::json & old_value, const nlohmann::json & new_value);
+
     nlohmann::json& get_options();
 
+    /*!
+     * \brief Returns the settings as of the last call to #update_config_changed
+     *
+     * The settings are swapped out as a whole when they change, so hang on to the pointer for as long as you want a
+     * consistent view of them, like for a whole frame. This is safe to call from any thread
+     */
+    std::shared_ptr<const nova_settings> get_settings() const;
+
     /*!
      * \brief Updates all the change listeners with the current state of the settings
      *
@@ -75,6 +112,9 @@ public:
      * are pretty computationally intensive to change, the update listeners after all the values are changed
      *
      * Note that this method only send the read-write config values (children of the node 'settings') to the listeners
+     *
+     * Only listeners that care about one of the settings that changed since the last call are told about the change.
+     * The first call tells everyone, since everything is new
      */
     void update_config_changed();
 
@@ -83,8 +123,36 @@ public:
      */
     void update_config_loaded();
 private:
+    /*!
+     * \brief A listener, and the settings it wants to hear about. No keys means it wants to hear about everything
+     */
+    struct listener_subscription {
+        iconfig_listener * listener;
+        std::vector<std::string> keys;
+    };
+
     nlohmann::json options;
-    std::vector<iconfig_listener*> config_change_listeners;
+    std::vector<listener_subscription> config_change_listeners;
+
+    /*!
+     * \brief The settings as of the last call to #update_config_changed, so we can tell what changed since then
+     */
+    nlohmann::json last_notified_settings;
+
+    /*!
+     * \brief The typed settings. Only ever read and written with std::atomic_load and std::atomic_store
+     */
+    std::shared_ptr<const nova_settings> settings;
+
+    static void diff(const nlohmann::json & old_value, const nlohmann::json & new_value, const std::string & path,
+                     std::vector<std::string> & changed_paths);
+
+    /*!
+     * \brief Checks if a change to changed_path is something a listener subscribed to key should hear about
+     *
+     * That's when one is the other, or when one is inside the other
+     */
+    static bool path_overlaps(const std::string & key, const std::string & changed_path);
 };
 
 #endif //RENDERER_CONFIG_H
@@ -0,0 +1,89 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "nova_settings.h"
+
+#include <limits>
+#include <easylogging++.h>
+
+/*!
+ * \brief Reads an integer setting, falling back to the default if it's missing, not an integer, or too small
+ */
+static void read_setting(const nlohmann::json & settings, const char * name, int minimum, int & value) {
+    auto setting = settings.find(name);
+    if(setting == settings.end()) {
+        return;
+    }
+
+    if(!setting->is_number_integer()) {
+        LOG(WARNING) << "Setting " << name << " should be an integer, but it's " << *setting << ". Using "
+                     << value << " instead";
+        return;
+    }
+
+    int64_t new_value = setting->get<int64_t>();
+    if(new_value < minimum || new_value > std::numeric_limits<int>::max()) {
+        LOG(WARNING) << "Setting " << name << " is " << new_value << ", which is out of range. Using " << value
+                     << " instead";
+        return;
+    }
+
+    value = (int) new_value;
+}
+
+/*!
+ * \brief Reads a string setting, falling back to the default if it's missing or not a string
+ */
+static void read_setting(const nlohmann::json & settings, const char * name, std::string & value) {
+    auto setting = settings.find(name);
+    if(setting == settings.end()) {
+        return;
+    }
+
+    if(!setting->is_string()) {
+        LOG(WARNING) << "Setting " << name << " should be a string, but it's " << *setting << ". Using "
+                     << value << " instead";
+        return;
+    }
+
+    value = setting->get<std::string>();
+}
+
+/*!
+ * \brief Reads the transparency mode, falling back to the default if it's missing or isn't one of the modes
+ */
+static void read_setting(const nlohmann::json & settings, const char * name, nova_settings::transparency_mode & value) {
+    std::string mode_name = value == nova_settings::transparency_mode::sorted ? "sorted" : "weightedBlended";
+    read_setting(settings, name, mode_name);
+
+    if(mode_name == "sorted") {
+        value = nova_settings::transparency_mode::sorted;
+
+    } else if(mode_name == "weightedBlended") {
+        value = nova_settings::transparency_mode::weighted_blended;
+
+    } else {
+        LOG(WARNING) << "Setting " << name << " should be \"sorted\" or \"weightedBlended\", but it's " << mode_name
+                     << ". Using the default instead";
+    }
+}
+
+nova_settings nova_settings::from_json(const nlohmann::json & settings) {
+    nova_settings typed_settings;
+
+    if(!settings.is_object()) {
+        LOG(WARNING) << "The settings should be an object, but they're " << settings << ". Using the defaults";
+        return typed_settings;
+    }
+
+    read_setting(settings, "loadedShaderpack", typed_settings.loaded_shaderpack);
+    read_setting(settings, "viewWidth", 1, typed_settings.view_width);
+    read_setting(settings, "viewHeight", 1, typed_settings.view_height);
+    read_setting(settings, "transparencyMode", typed_settings.transparency);
+    read_setting(settings, "shadowMapResolution", 256, typed_settings.shadow_map_resolution);
+
+    typed_settings.raw = settings;
+
+    return typed_settings;
+}
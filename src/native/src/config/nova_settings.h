@@ -0,0 +1,72 @@
+/*!
+ * \brief Defines the typed version of Nova's read-write settings
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_NOVA_SETTINGS_H
+#define RENDERER_NOVA_SETTINGS_H
+
+#include <string>
+#include <json.hpp>
+
+/*!
+ * \brief Every read-write setting, already pulled out of the JSON and checked
+ *
+ * Reading a value out of a nlohmann::json means hashing a string and walking a map, and you get an exception if
+ * someone put a string where a number should be. This struct is filled in once per config change, so everyone else
+ * gets plain fields that are always valid.
+ *
+ * This mirrors schemas/config_schema.json. Each field has the same default and limits as its schema property, so if you
+ * add a property there, add it here and to #from_json too.
+ */
+struct nova_settings {
+    /*!
+     * \brief The ways translucent things like water and glass can be drawn
+     */
+    enum class transparency_mode {
+        sorted,             //!< "sorted": sort translucent faces back to front, then blend them in that order
+        weighted_blended,   //!< "weightedBlended": weighted blended order-independent transparency, no sorting needed
+    };
+
+    /*!
+     * \brief The name of the shaderpack that was most recently loaded. Schema property "loadedShaderpack"
+     */
+    std::string loaded_shaderpack = "default";
+
+    /*!
+     * \brief The width of the window, in pixels. Schema property "viewWidth"
+     */
+    int view_width = 800;
+
+    /*!
+     * \brief The height of the window, in pixels. Schema property "viewHeight"
+     */
+    int view_height = 480;
+
+    /*!
+     * \brief How translucent geometry is drawn. Schema property "transparencyMode"
+     */
+    transparency_mode transparency = transparency_mode::sorted;
+
+    /*!
+     * \brief How many texels wide and tall each shadow cascade is. Schema property "shadowMapResolution"
+     */
+    int shadow_map_resolution = 2048;
+
+    /*!
+     * \brief The settings node these settings were read from, for anything that isn't in the schema, like the options
+     * a shaderpack defines
+     */
+    nlohmann::json raw;
+
+    /*!
+     * \brief Reads the settings out of the 'settings' node of the config
+     *
+     * Any setting that's missing, has the wrong type, or is out of range gets its default value, and we log a warning
+     * if it was there but wrong
+     */
+    static nova_settings from_json(const nlohmann::json & settings);
+};
+
+#endif //RENDERER_NOVA_SETTINGS_H
@@ -0,0 +1,62 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "chunk_bounds.h"
+
+void chunk_bounds::set_chunk(uint64_t chunk_id, const aabb & bounds) {
+    auto existing = indices.find(chunk_id);
+    if(existing != indices.end()) {
+        aabb & old_bounds = boxes[existing->second];
+        if(old_bounds.min == bounds.min && old_bounds.max == bounds.max) {
+            return;
+        }
+
+        old_bounds = bounds;
+
+    } else {
+        indices[chunk_id] = (uint32_t) boxes.size();
+        boxes.push_back(bounds);
+        ids.push_back(chunk_id);
+    }
+
+    generation++;
+}
+
+void chunk_bounds::remove_chunk(uint64_t chunk_id) {
+    auto existing = indices.find(chunk_id);
+    if(existing == indices.end()) {
+        return;
+    }
+
+    // Move the last chunk into the hole, so the boxes stay packed
+    const uint32_t index = existing->second;
+    const uint32_t last = (uint32_t) boxes.size() - 1;
+    if(index != last) {
+        boxes[index] = boxes[last];
+        ids[index] = ids[last];
+        indices[ids[index]] = index;
+    }
+
+    boxes.pop_back();
+    ids.pop_back();
+    indices.erase(chunk_id);
+
+    generation++;
+}
+
+uint32_t chunk_bounds::get_num_chunks() const {
+    return (uint32_t) boxes.size();
+}
+
+const std::vector<aabb> & chunk_bounds::get_boxes() const {
+    return boxes;
+}
+
+const std::vector<uint64_t> & chunk_bounds::get_ids() const {
+    return ids;
+}
+
+uint64_t chunk_bounds::get_generation() const {
+    return generation;
+}
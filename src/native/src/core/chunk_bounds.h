@@ -0,0 +1,68 @@
+/*!
+ * \brief Defines the set of bounding boxes of every chunk that's loaded
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_CHUNK_BOUNDS_H
+#define RENDERER_CHUNK_BOUNDS_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*!
+ * \brief An axis-aligned bounding box, in world space
+ */
+struct aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+/*!
+ * \brief Keeps the bounding box of every loaded chunk, so anything that culls chunks can go through them all without
+ * knowing where they came from
+ *
+ * The boxes are packed into one array, so looping over them is cheap. Every change bumps the generation, so anything
+ * that caches culling results (like the shadow caster lists) can tell when they're stale.
+ *
+ * Only the render thread should call any of this
+ */
+class chunk_bounds {
+public:
+    /*!
+     * \brief Adds a chunk, or changes its box if it's already there
+     *
+     * \param chunk_id Something that's unique for each chunk, like its packed position
+     */
+    void set_chunk(uint64_t chunk_id, const aabb & bounds);
+
+    void remove_chunk(uint64_t chunk_id);
+
+    uint32_t get_num_chunks() const;
+
+    /*!
+     * \brief Returns every chunk's box. The order changes when chunks are removed
+     */
+    const std::vector<aabb> & get_boxes() const;
+
+    /*!
+     * \brief Returns every chunk's ID, in the same order as #get_boxes
+     */
+    const std::vector<uint64_t> & get_ids() const;
+
+    /*!
+     * \brief Returns a number that changes every time a chunk is added, removed, or changes size
+     */
+    uint64_t get_generation() const;
+
+private:
+    std::vector<aabb> boxes;
+    std::vector<uint64_t> ids;
+    std::unordered_map<uint64_t, uint32_t> indices;
+
+    uint64_t generation = 0;
+};
+
+#endif //RENDERER_CHUNK_BOUNDS_H
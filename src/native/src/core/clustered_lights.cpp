@@ -0,0 +1,500 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include "clustered_lights.h"
+#include "gl/gl_state_cache.h"
+#include "utils/async_log.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOVA_CLUSTERS_USE_SSE
+#include <emmintrin.h>
+#endif
+
+const uint32_t clustered_lights::CLUSTERS_X;
+const uint32_t clustered_lights::CLUSTERS_Y;
+const uint32_t clustered_lights::CLUSTERS_Z;
+const uint32_t clustered_lights::NUM_CLUSTERS;
+const uint32_t clustered_lights::MAX_LIGHTS;
+const uint32_t clustered_lights::MAX_LIGHTS_PER_CLUSTER;
+const uint32_t clustered_lights::MAX_LIGHT_INDICES;
+const GLuint clustered_lights::LIGHT_BUFFER_BINDING;
+const GLuint clustered_lights::CLUSTER_BUFFER_BINDING;
+const GLuint clustered_lights::LIGHT_INDEX_BUFFER_BINDING;
+
+// The SSE path loads a light's position and radius as one vector
+static_assert(sizeof(clustered_lights::point_light) == 32, "point_light has to be eight floats");
+static_assert(offsetof(clustered_lights::point_light, radius) == 12, "point_light's radius has to come right after its "
+        "position");
+static_assert(sizeof(clustered_lights::gpu_light) == 32, "gpu_light has to match the std430 layout in the shader");
+
+clustered_lights::clustered_lights() : clusters(NUM_CLUSTERS), header(), simd_enabled(is_simd_supported()) {
+    header.grid_size[0] = CLUSTERS_X;
+    header.grid_size[1] = CLUSTERS_Y;
+    header.grid_size[2] = CLUSTERS_Z;
+
+    // Every cluster starts out empty, but the shaders still divide by these to find their cluster
+    header.near_plane = 0.1f;
+    header.slice_scale = 1.0f;
+    header.tile_width = 1.0f;
+    header.tile_height = 1.0f;
+
+    lights.reserve(MAX_LIGHTS);
+}
+
+clustered_lights::~clustered_lights() {
+    if(light_buffer != 0) {
+        const GLuint buffers[] = {light_buffer, cluster_buffer, light_index_buffer};
+        gl_state_cache::get().delete_buffers(3, buffers);
+    }
+}
+
+bool clustered_lights::add_light(const point_light & light) {
+    if(lights.size() >= MAX_LIGHTS) {
+        return false;
+    }
+
+    lights.push_back(light);
+    return true;
+}
+
+void clustered_lights::clear_lights() {
+    lights.clear();
+}
+
+uint32_t clustered_lights::get_num_lights() const {
+    return (uint32_t) lights.size();
+}
+
+uint32_t clustered_lights::build(const camera & view_camera) {
+    visible_lights.clear();
+    ranges.clear();
+
+    const cluster_planes planes = make_planes(view_camera);
+    if(simd_enabled) {
+        cull_lights_simd(view_camera, planes);
+    } else {
+        cull_lights_scalar(view_camera, planes, 0);
+    }
+
+    assign_lights();
+
+    header.near_plane = view_camera.near_plane;
+    header.slice_scale = CLUSTERS_Z / std::log(view_camera.far_plane / view_camera.near_plane);
+    header.tile_width = (float) view_camera.view_width / CLUSTERS_X;
+    header.tile_height = (float) view_camera.view_height / CLUSTERS_Y;
+
+    built = true;
+    needs_upload = true;
+
+    return (uint32_t) visible_lights.size();
+}
+
+clustered_lights::cluster_planes clustered_lights::make_planes(const camera & view_camera) {
+    cluster_planes planes;
+
+    // These are the two scale factors from the projection matrix. A view space point is right of the tile edge at
+    // x_ndc when x_scale * x + x_ndc * z > 0, so that's the plane, and dividing by its length makes it a distance
+    const float y_scale = 1.0f / std::tan(view_camera.vertical_fov * 0.5f);
+    const float x_scale = y_scale / view_camera.aspect;
+
+    for(uint32_t i = 0; i <= CLUSTERS_X; i++) {
+        const float edge = -1.0f + 2.0f * i / CLUSTERS_X;
+        const float length = std::sqrt(x_scale * x_scale + edge * edge);
+        planes.x_normal_x[i] = x_scale / length;
+        planes.x_normal_z[i] = edge / length;
+    }
+
+    for(uint32_t i = 0; i <= CLUSTERS_Y; i++) {
+        const float edge = -1.0f + 2.0f * i / CLUSTERS_Y;
+        const float length = std::sqrt(y_scale * y_scale + edge * edge);
+        planes.y_normal_y[i] = y_scale / length;
+        planes.y_normal_z[i] = edge / length;
+    }
+
+    const float depth_ratio = view_camera.far_plane / view_camera.near_plane;
+    for(uint32_t i = 0; i <= CLUSTERS_Z; i++) {
+        planes.slice_depths[i] = view_camera.near_plane * std::pow(depth_ratio, (float) i / CLUSTERS_Z);
+    }
+
+    return planes;
+}
+
+void clustered_lights::cull_lights_scalar(const camera & view_camera, const cluster_planes & planes,
+                                          uint32_t first_light) {
+    const glm::mat4 & view = view_camera.view;
+
+    for(uint32_t i = first_light; i < lights.size(); i++) {
+        const point_light & light = lights[i];
+        const float radius = light.radius;
+
+        // Written out the same way as the SSE version, so they get the same answers
+        const float x = view[0][0] * light.position.x + view[1][0] * light.position.y + view[2][0] * light.position.z
+                        + view[3][0];
+        const float y = view[0][1] * light.position.x + view[1][1] * light.position.y + view[2][1] * light.position.z
+                        + view[3][1];
+        const float z = view[0][2] * light.position.x + view[1][2] * light.position.y + view[2][2] * light.position.z
+                        + view[3][2];
+
+        const float depth = -z;
+        const float nearest = depth - radius;
+        const float furthest = depth + radius;
+        if(furthest <= view_camera.near_plane || nearest >= view_camera.far_plane) {
+            continue;
+        }
+
+        // Off the left or right side of the screen?
+        if(planes.x_normal_x[0] * x + planes.x_normal_z[0] * z <= -radius ||
+           planes.x_normal_x[CLUSTERS_X] * x + planes.x_normal_z[CLUSTERS_X] * z >= radius) {
+            continue;
+        }
+
+        if(planes.y_normal_y[0] * y + planes.y_normal_z[0] * z <= -radius ||
+           planes.y_normal_y[CLUSTERS_Y] * y + planes.y_normal_z[CLUSTERS_Y] * z >= radius) {
+            continue;
+        }
+
+        // The light starts in the tile after the last edge it's completely right of, and ends in the tile before the
+        // first edge it's completely left of
+        int min_x = 0;
+        int max_x = CLUSTERS_X - 1;
+        for(uint32_t edge = 1; edge < CLUSTERS_X; edge++) {
+            const float distance = planes.x_normal_x[edge] * x + planes.x_normal_z[edge] * z;
+            min_x += distance >= radius;
+            max_x -= distance <= -radius;
+        }
+
+        int min_y = 0;
+        int max_y = CLUSTERS_Y - 1;
+        for(uint32_t edge = 1; edge < CLUSTERS_Y; edge++) {
+            const float distance = planes.y_normal_y[edge] * y + planes.y_normal_z[edge] * z;
+            min_y += distance >= radius;
+            max_y -= distance <= -radius;
+        }
+
+        int min_z = 0;
+        int max_z = CLUSTERS_Z - 1;
+        for(uint32_t slice = 1; slice < CLUSTERS_Z; slice++) {
+            min_z += planes.slice_depths[slice] <= nearest;
+            max_z -= planes.slice_depths[slice] > furthest;
+        }
+
+        if(min_x > max_x || min_y > max_y || min_z > max_z) {
+            continue;
+        }
+
+        cluster_range range;
+        range.min_x = (uint8_t) min_x;
+        range.max_x = (uint8_t) max_x;
+        range.min_y = (uint8_t) min_y;
+        range.max_y = (uint8_t) max_y;
+        range.min_z = (uint8_t) min_z;
+        range.max_z = (uint8_t) max_z;
+        add_visible_light(i, glm::vec3(x, y, z), range);
+    }
+}
+
+#ifdef NOVA_CLUSTERS_USE_SSE
+
+void clustered_lights::cull_lights_simd(const camera & view_camera, const cluster_planes & planes) {
+    const glm::mat4 & view = view_camera.view;
+    const __m128 view_x[] = {_mm_set1_ps(view[0][0]), _mm_set1_ps(view[1][0]), _mm_set1_ps(view[2][0]),
+                             _mm_set1_ps(view[3][0])};
+    const __m128 view_y[] = {_mm_set1_ps(view[0][1]), _mm_set1_ps(view[1][1]), _mm_set1_ps(view[2][1]),
+                             _mm_set1_ps(view[3][1])};
+    const __m128 view_z[] = {_mm_set1_ps(view[0][2]), _mm_set1_ps(view[1][2]), _mm_set1_ps(view[2][2]),
+                             _mm_set1_ps(view[3][2])};
+
+    const __m128 near_plane = _mm_set1_ps(view_camera.near_plane);
+    const __m128 far_plane = _mm_set1_ps(view_camera.far_plane);
+    const __m128 zero = _mm_setzero_ps();
+
+    alignas(16) int32_t mins[3][4];
+    alignas(16) int32_t maxes[3][4];
+    alignas(16) float positions[3][4];
+
+    // Four lights at a time. Whatever's left over at the end goes through the scalar version
+    const uint32_t num_groups = (uint32_t) lights.size() / 4;
+    for(uint32_t group = 0; group < num_groups; group++) {
+        const point_light * group_lights = &lights[group * 4];
+
+        // Load four (x, y, z, radius)s and turn them into x, y, z, and radius for four lights
+        __m128 light_x = _mm_loadu_ps(&group_lights[0].position.x);
+        __m128 light_y = _mm_loadu_ps(&group_lights[1].position.x);
+        __m128 light_z = _mm_loadu_ps(&group_lights[2].position.x);
+        __m128 radius = _mm_loadu_ps(&group_lights[3].position.x);
+        _MM_TRANSPOSE4_PS(light_x, light_y, light_z, radius);
+
+        const __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(view_x[0], light_x), _mm_mul_ps(view_x[1], light_y)),
+                                               _mm_mul_ps(view_x[2], light_z)), view_x[3]);
+        const __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(view_y[0], light_x), _mm_mul_ps(view_y[1], light_y)),
+                                               _mm_mul_ps(view_y[2], light_z)), view_y[3]);
+        const __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(view_z[0], light_x), _mm_mul_ps(view_z[1], light_y)),
+                                               _mm_mul_ps(view_z[2], light_z)), view_z[3]);
+
+        const __m128 depth = _mm_sub_ps(zero, z);
+        const __m128 nearest = _mm_sub_ps(depth, radius);
+        const __m128 furthest = _mm_add_ps(depth, radius);
+        const __m128 negative_radius = _mm_sub_ps(zero, radius);
+
+        __m128 visible = _mm_and_ps(_mm_cmpgt_ps(furthest, near_plane), _mm_cmplt_ps(nearest, far_plane));
+
+        const __m128 left = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.x_normal_x[0]), x),
+                                       _mm_mul_ps(_mm_set1_ps(planes.x_normal_z[0]), z));
+        const __m128 right = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.x_normal_x[CLUSTERS_X]), x),
+                                        _mm_mul_ps(_mm_set1_ps(planes.x_normal_z[CLUSTERS_X]), z));
+        const __m128 bottom = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.y_normal_y[0]), y),
+                                         _mm_mul_ps(_mm_set1_ps(planes.y_normal_z[0]), z));
+        const __m128 top = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.y_normal_y[CLUSTERS_Y]), y),
+                                      _mm_mul_ps(_mm_set1_ps(planes.y_normal_z[CLUSTERS_Y]), z));
+        visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpgt_ps(left, negative_radius), _mm_cmplt_ps(right, radius)));
+        visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpgt_ps(bottom, negative_radius), _mm_cmplt_ps(top, radius)));
+
+        if(_mm_movemask_ps(visible) == 0) {
+            continue;
+        }
+
+        // A true comparison is all ones, which is -1, so subtracting it counts up
+        __m128i min_x = _mm_setzero_si128();
+        __m128i max_x = _mm_set1_epi32(CLUSTERS_X - 1);
+        for(uint32_t edge = 1; edge < CLUSTERS_X; edge++) {
+            const __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.x_normal_x[edge]), x),
+                                               _mm_mul_ps(_mm_set1_ps(planes.x_normal_z[edge]), z));
+            min_x = _mm_sub_epi32(min_x, _mm_castps_si128(_mm_cmpge_ps(distance, radius)));
+            max_x = _mm_add_epi32(max_x, _mm_castps_si128(_mm_cmple_ps(distance, negative_radius)));
+        }
+
+        __m128i min_y = _mm_setzero_si128();
+        __m128i max_y = _mm_set1_epi32(CLUSTERS_Y - 1);
+        for(uint32_t edge = 1; edge < CLUSTERS_Y; edge++) {
+            const __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.y_normal_y[edge]), y),
+                                               _mm_mul_ps(_mm_set1_ps(planes.y_normal_z[edge]), z));
+            min_y = _mm_sub_epi32(min_y, _mm_castps_si128(_mm_cmpge_ps(distance, radius)));
+            max_y = _mm_add_epi32(max_y, _mm_castps_si128(_mm_cmple_ps(distance, negative_radius)));
+        }
+
+        __m128i min_z = _mm_setzero_si128();
+        __m128i max_z = _mm_set1_epi32(CLUSTERS_Z - 1);
+        for(uint32_t slice = 1; slice < CLUSTERS_Z; slice++) {
+            const __m128 slice_depth = _mm_set1_ps(planes.slice_depths[slice]);
+            min_z = _mm_sub_epi32(min_z, _mm_castps_si128(_mm_cmple_ps(slice_depth, nearest)));
+            max_z = _mm_add_epi32(max_z, _mm_castps_si128(_mm_cmpgt_ps(slice_depth, furthest)));
+        }
+
+        const __m128i empty = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(min_x, max_x), _mm_cmpgt_epi32(min_y, max_y)),
+                                           _mm_cmpgt_epi32(min_z, max_z));
+        const int visible_mask = _mm_movemask_ps(_mm_andnot_ps(_mm_castsi128_ps(empty), visible));
+        if(visible_mask == 0) {
+            continue;
+        }
+
+        _mm_store_si128((__m128i *) mins[0], min_x);
+        _mm_store_si128((__m128i *) mins[1], min_y);
+        _mm_store_si128((__m128i *) mins[2], min_z);
+        _mm_store_si128((__m128i *) maxes[0], max_x);
+        _mm_store_si128((__m128i *) maxes[1], max_y);
+        _mm_store_si128((__m128i *) maxes[2], max_z);
+        _mm_store_ps(positions[0], x);
+        _mm_store_ps(positions[1], y);
+        _mm_store_ps(positions[2], z);
+
+        for(int lane = 0; lane < 4; lane++) {
+            if((visible_mask & (1 << lane)) == 0) {
+                continue;
+            }
+
+            cluster_range range;
+            range.min_x = (uint8_t) mins[0][lane];
+            range.max_x = (uint8_t) maxes[0][lane];
+            range.min_y = (uint8_t) mins[1][lane];
+            range.max_y = (uint8_t) maxes[1][lane];
+            range.min_z = (uint8_t) mins[2][lane];
+            range.max_z = (uint8_t) maxes[2][lane];
+            add_visible_light(group * 4 + lane, glm::vec3(positions[0][lane], positions[1][lane], positions[2][lane]),
+                              range);
+        }
+    }
+
+    cull_lights_scalar(view_camera, planes, num_groups * 4);
+}
+
+#else
+
+void clustered_lights::cull_lights_simd(const camera & view_camera, const cluster_planes & planes) {
+    cull_lights_scalar(view_camera, planes, 0);
+}
+
+#endif
+
+void clustered_lights::add_visible_light(uint32_t light, const glm::vec3 & view_position, const cluster_range & range) {
+    const point_light & original = lights[light];
+
+    gpu_light visible;
+    visible.position_radius = glm::vec4(view_position, original.radius);
+    visible.color_intensity = glm::vec4(original.color, original.intensity);
+
+    cluster_range visible_range = range;
+    visible_range.light = (uint32_t) visible_lights.size();
+
+    visible_lights.push_back(visible);
+    ranges.push_back(visible_range);
+}
+
+void clustered_lights::assign_lights() {
+    for(cluster & current : clusters) {
+        current.count = 0;
+    }
+
+    for(const cluster_range & range : ranges) {
+        for(uint32_t z = range.min_z; z <= range.max_z; z++) {
+            for(uint32_t y = range.min_y; y <= range.max_y; y++) {
+                for(uint32_t x = range.min_x; x <= range.max_x; x++) {
+                    clusters[get_cluster_index(x, y, z)].count++;
+                }
+            }
+        }
+    }
+
+    // Now that the counts are known, every cluster gets its piece of the index list. Full clusters just get cut off
+    num_dropped = 0;
+    uint32_t num_indices = 0;
+    for(cluster & current : clusters) {
+        const uint32_t wanted = current.count;
+        current.offset = num_indices;
+        current.count = std::min(std::min(wanted, MAX_LIGHTS_PER_CLUSTER), MAX_LIGHT_INDICES - num_indices);
+
+        num_dropped += wanted - current.count;
+        num_indices += current.count;
+    }
+
+    light_indices.resize(num_indices);
+    cluster_fill.assign(NUM_CLUSTERS, 0);
+
+    for(const cluster_range & range : ranges) {
+        for(uint32_t z = range.min_z; z <= range.max_z; z++) {
+            for(uint32_t y = range.min_y; y <= range.max_y; y++) {
+                for(uint32_t x = range.min_x; x <= range.max_x; x++) {
+                    const uint32_t index = get_cluster_index(x, y, z);
+                    const cluster & current = clusters[index];
+                    if(cluster_fill[index] < current.count) {
+                        light_indices[current.offset + cluster_fill[index]] = range.light;
+                        cluster_fill[index]++;
+                    }
+                }
+            }
+        }
+    }
+
+    if(num_dropped > 0) {
+        NOVA_LOG_TRACE("{} lights were left out of full clusters", num_dropped);
+    }
+}
+
+bool clustered_lights::has_clusters() const {
+    return built;
+}
+
+void clustered_lights::upload() {
+    if(light_buffer != 0 && !needs_upload) {
+        return;
+    }
+    needs_upload = false;
+
+    if(light_buffer == 0) {
+        glCreateBuffers(1, &light_buffer);
+        glNamedBufferStorage(light_buffer, MAX_LIGHTS * sizeof(gpu_light), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        glCreateBuffers(1, &cluster_buffer);
+        glNamedBufferStorage(cluster_buffer, sizeof(cluster_header) + NUM_CLUSTERS * sizeof(cluster), nullptr,
+                             GL_DYNAMIC_STORAGE_BIT);
+
+        glCreateBuffers(1, &light_index_buffer);
+        glNamedBufferStorage(light_index_buffer, MAX_LIGHT_INDICES * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    if(!visible_lights.empty()) {
+        glNamedBufferSubData(light_buffer, 0, visible_lights.size() * sizeof(gpu_light), visible_lights.data());
+    }
+
+    glNamedBufferSubData(cluster_buffer, 0, sizeof(cluster_header), &header);
+    glNamedBufferSubData(cluster_buffer, sizeof(cluster_header), NUM_CLUSTERS * sizeof(cluster), clusters.data());
+
+    if(!light_indices.empty()) {
+        glNamedBufferSubData(light_index_buffer, 0, light_indices.size() * sizeof(uint32_t), light_indices.data());
+    }
+}
+
+void clustered_lights::bind() {
+    if(light_buffer == 0) {
+        upload();
+    }
+
+    gl_state_cache & state = gl_state_cache::get();
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, light_buffer);
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, CLUSTER_BUFFER_BINDING, cluster_buffer);
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BUFFER_BINDING, light_index_buffer);
+}
+
+void clustered_lights::set_simd_enabled(bool enabled) {
+    simd_enabled = enabled && is_simd_supported();
+}
+
+bool clustered_lights::is_simd_supported() {
+#ifdef NOVA_CLUSTERS_USE_SSE
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t clustered_lights::get_cluster_index(uint32_t x, uint32_t y, uint32_t z) {
+    return x + y * CLUSTERS_X + z * CLUSTERS_X * CLUSTERS_Y;
+}
+
+const clustered_lights::cluster & clustered_lights::get_cluster(uint32_t x, uint32_t y, uint32_t z) const {
+    return clusters[get_cluster_index(x, y, z)];
+}
+
+const std::vector<clustered_lights::gpu_light> & clustered_lights::get_visible_lights() const {
+    return visible_lights;
+}
+
+const std::vector<uint32_t> & clustered_lights::get_light_indices() const {
+    return light_indices;
+}
+
+uint32_t clustered_lights::get_num_dropped() const {
+    return num_dropped;
+}
+
+std::string clustered_lights::get_glsl_declarations() {
+    std::stringstream glsl;
+
+    glsl << "struct nova_light {\n"
+         << "    vec4 position_radius;\n"
+         << "    vec4 color_intensity;\n"
+         << "};\n"
+         << "layout(std430, binding = " << LIGHT_BUFFER_BINDING << ") readonly buffer nova_light_buffer {\n"
+         << "    nova_light nova_lights[];\n"
+         << "};\n"
+         << "layout(std430, binding = " << CLUSTER_BUFFER_BINDING << ") readonly buffer nova_cluster_buffer {\n"
+         << "    uvec4 nova_cluster_grid;\n"
+         << "    vec4 nova_cluster_params;\n"
+         << "    uvec2 nova_clusters[];\n"
+         << "};\n"
+         << "layout(std430, binding = " << LIGHT_INDEX_BUFFER_BINDING << ") readonly buffer nova_light_index_buffer {\n"
+         << "    uint nova_light_indices[];\n"
+         << "};\n"
+         << "uvec2 nova_get_cluster(vec2 frag_coord, float view_depth) {\n"
+         << "    float slice = log(view_depth / nova_cluster_params.x) * nova_cluster_params.y;\n"
+         << "    uvec3 cluster = uvec3(uvec2(frag_coord / nova_cluster_params.zw), uint(max(slice, 0.0)));\n"
+         << "    cluster = min(cluster, nova_cluster_grid.xyz - 1u);\n"
+         << "    return nova_clusters[cluster.x + (cluster.y + cluster.z * nova_cluster_grid.y) * nova_cluster_grid.x];\n"
+         << "}\n";
+
+    return glsl.str();
+}
@@ -0,0 +1,250 @@
+/*!
+ * \brief Defines the clusters that split up the view frustum for per-pixel block lights
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_CLUSTERED_LIGHTS_H
+#define RENDERER_CLUSTERED_LIGHTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/*!
+ * \brief Works out which point lights touch which part of the screen, so a fragment only shades the lights near it
+ *
+ * The view frustum is split into a grid of clusters: CLUSTERS_X by CLUSTERS_Y tiles across the screen, and CLUSTERS_Z
+ * slices in depth. The slices get exponentially thicker further away, so clusters are about the same shape all the way
+ * out. Every frame, #build finds the clusters each light's bounding sphere touches and makes a list of lights for every
+ * cluster. A fragment figures out which cluster it's in from gl_FragCoord and its depth, and only loops over that
+ * cluster's lights, so hundreds of torches cost about the same per pixel as a few.
+ *
+ * Each light is tested against the planes between the tiles and the slices. That's done four lights at a time with
+ * SSE when the compiler has it, and one at a time otherwise. A light gets the whole box of clusters between its
+ * first and last tile and slice, which is a little generous for lights right next to the camera, but never misses
+ * anything.
+ *
+ * The lights, the clusters, and the light lists go to three shader storage buffers. #get_glsl_declarations has what a
+ * shader needs to read them.
+ */
+class clustered_lights {
+public:
+    /*!
+     * \brief A light that shines the same in every direction, out to its radius
+     */
+    struct point_light {
+        glm::vec3 position;     //!< In world space
+        float radius;           //!< Nothing past this is lit at all
+        glm::vec3 color;
+        float intensity;
+    };
+
+    /*!
+     * \brief Everything about the camera that decides where the clusters are
+     */
+    struct camera {
+        glm::mat4 view;         //!< The camera looks down -z in view space, like OpenGL
+        float vertical_fov;     //!< In radians
+        float aspect;           //!< Width / height
+        float near_plane;
+        float far_plane;
+        int view_width;         //!< In pixels
+        int view_height;        //!< In pixels
+    };
+
+    /*!
+     * \brief Where a cluster's lights are in the light index list
+     */
+    struct cluster {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    /*!
+     * \brief A light as the shaders see it. The position is in view space, since that's what the clusters are in
+     */
+    struct gpu_light {
+        glm::vec4 position_radius;
+        glm::vec4 color_intensity;
+    };
+
+    static const uint32_t CLUSTERS_X = 16;
+    static const uint32_t CLUSTERS_Y = 9;
+    static const uint32_t CLUSTERS_Z = 24;
+    static const uint32_t NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+    static const uint32_t MAX_LIGHTS = 16384;
+
+    /*!
+     * \brief Any more lights than this in one cluster are left out of it. This is what keeps the cost per pixel
+     * bounded
+     */
+    static const uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+    /*!
+     * \brief How many light indices all the clusters can have between them. Lights that don't fit are left out
+     */
+    static const uint32_t MAX_LIGHT_INDICES = 1 << 20;
+
+    static const GLuint LIGHT_BUFFER_BINDING = 5;
+    static const GLuint CLUSTER_BUFFER_BINDING = 6;
+    static const GLuint LIGHT_INDEX_BUFFER_BINDING = 7;
+
+    /*!
+     * \brief Doesn't touch OpenGL. The buffers are made the first time something is uploaded
+     */
+    clustered_lights();
+
+    ~clustered_lights();
+
+    clustered_lights(const clustered_lights & other) = delete;
+    clustered_lights & operator=(const clustered_lights & other) = delete;
+
+    /*!
+     * \brief Adds a light for the next #build
+     *
+     * \return False if there are already MAX_LIGHTS lights
+     */
+    bool add_light(const point_light & light);
+
+    void clear_lights();
+
+    uint32_t get_num_lights() const;
+
+    /*!
+     * \brief Finds the lights in every cluster, as seen from the given camera
+     *
+     * \return How many lights are in at least one cluster
+     */
+    uint32_t build(const camera & view_camera);
+
+    /*!
+     * \brief Returns true once #build has run, so there's something worth sending to the GPU
+     */
+    bool has_clusters() const;
+
+    /*!
+     * \brief Sends what the last #build made to the GPU. Does nothing if it was already sent
+     */
+    void upload();
+
+    /*!
+     * \brief Binds the three buffers to their binding points
+     */
+    void bind();
+
+    /*!
+     * \brief Lets tests and benchmarks try the scalar path on a machine that has SSE. Does nothing when SSE isn't
+     * compiled in
+     */
+    void set_simd_enabled(bool enabled);
+
+    /*!
+     * \brief Returns true if this was compiled with SSE
+     */
+    static bool is_simd_supported();
+
+    static uint32_t get_cluster_index(uint32_t x, uint32_t y, uint32_t z);
+
+    const cluster & get_cluster(uint32_t x, uint32_t y, uint32_t z) const;
+
+    /*!
+     * \brief Returns the lights that were in at least one cluster in the last #build. Clusters refer to lights by their
+     * index in here, not by the order they were added in
+     */
+    const std::vector<gpu_light> & get_visible_lights() const;
+
+    const std::vector<uint32_t> & get_light_indices() const;
+
+    /*!
+     * \brief Returns how many times a light was left out of a cluster in the last #build, because the cluster or the
+     * index list was full
+     */
+    uint32_t get_num_dropped() const;
+
+    /*!
+     * \brief Returns the buffer declarations and nova_get_cluster(vec2 frag_coord, float view_depth), which returns a
+     * uvec2 of the cluster's offset and count in nova_light_indices
+     */
+    static std::string get_glsl_declarations();
+
+private:
+    /*!
+     * \brief The clusters a light touches, from min to max inclusive
+     */
+    struct cluster_range {
+        uint32_t light;
+        uint8_t min_x, max_x;
+        uint8_t min_y, max_y;
+        uint8_t min_z, max_z;
+    };
+
+    /*!
+     * \brief What the shaders need to turn a fragment into a cluster. It's at the start of the cluster buffer
+     */
+    struct cluster_header {
+        uint32_t grid_size[4];
+        float near_plane;
+        float slice_scale;      //!< CLUSTERS_Z / log(far / near)
+        float tile_width;       //!< In pixels
+        float tile_height;      //!< In pixels
+    };
+
+    /*!
+     * \brief The planes between the clusters, in view space. Tile planes go through the camera, so they only need two
+     * numbers each
+     */
+    struct cluster_planes {
+        float x_normal_x[CLUSTERS_X + 1];
+        float x_normal_z[CLUSTERS_X + 1];
+        float y_normal_y[CLUSTERS_Y + 1];
+        float y_normal_z[CLUSTERS_Y + 1];
+        float slice_depths[CLUSTERS_Z + 1];
+    };
+
+    std::vector<point_light> lights;
+
+    std::vector<gpu_light> visible_lights;
+    std::vector<cluster_range> ranges;
+    std::vector<cluster> clusters;
+    std::vector<uint32_t> light_indices;
+    cluster_header header;
+
+    /*!
+     * \brief How many lights each cluster has so far, while the index list is filled in
+     */
+    std::vector<uint32_t> cluster_fill;
+
+    uint32_t num_dropped = 0;
+    bool simd_enabled;
+    bool built = false;
+    bool needs_upload = true;
+
+    GLuint light_buffer = 0;
+    GLuint cluster_buffer = 0;
+    GLuint light_index_buffer = 0;
+
+    static cluster_planes make_planes(const camera & view_camera);
+
+    /*!
+     * \brief Finds the clusters each light from first_light on touches, and fills in visible_lights and ranges
+     */
+    void cull_lights_scalar(const camera & view_camera, const cluster_planes & planes, uint32_t first_light);
+
+    /*!
+     * \brief Does the same thing as #cull_lights_scalar for every light, four at a time
+     */
+    void cull_lights_simd(const camera & view_camera, const cluster_planes & planes);
+
+    void add_visible_light(uint32_t light, const glm::vec3 & view_position, const cluster_range & range);
+
+    /*!
+     * \brief Turns the ranges into a list of lights for each cluster
+     */
+    void assign_lights();
+};
+
+#endif //RENDERER_CLUSTERED_LIGHTS_H
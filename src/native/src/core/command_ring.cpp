@@ -0,0 +1,273 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "command_ring.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <easylogging++.h>
+
+/*!
+ * \brief The size of the header that starts every command
+ */
+const uint32_t COMMAND_HEADER_SIZE = 8;
+
+static uint32_t pad_to_four(uint32_t value) {
+    return (value + 3) & ~3u;
+}
+
+/*!
+ * \brief Reads the fields of one command out of the ring, without ever going past the end of the command
+ *
+ * Everything in the ring came from Java, so none of the lengths in it can be trusted. Once a read doesn't fit, that
+ * read and every read after it give back zeros, and #is_valid returns false
+ */
+class command_reader {
+public:
+    command_reader(const unsigned char * data, uint32_t offset, uint32_t end) : data(data), offset(offset), end(end) {}
+
+    template <typename T>
+    T read() {
+        T value;
+        if(!fits(sizeof(T))) {
+            memset(&value, 0, sizeof(T));
+            return value;
+        }
+
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    /*!
+     * \brief Reads length bytes of text, then skips the padding after them
+     */
+    void read_string(std::string & text, uint32_t length) {
+        if(!fits(pad_to_four(length))) {
+            text.clear();
+            return;
+        }
+
+        text.assign(reinterpret_cast<const char *>(data + offset), length);
+        offset += pad_to_four(length);
+    }
+
+    bool is_valid() const {
+        return valid;
+    }
+
+private:
+    const unsigned char * data;
+    uint32_t offset;
+    uint32_t end;
+    bool valid = true;
+
+    bool fits(uint32_t num_bytes) {
+        valid = valid && num_bytes <= end - offset;
+        return valid;
+    }
+};
+
+static uint32_t round_up_to_power_of_two(uint32_t value) {
+    uint32_t power = 1;
+    while(power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+command_ring::command_ring(uint32_t capacity) : button_text(MAX_NUM_BUTTONS), pending_button_text(MAX_NUM_BUTTONS) {
+    this->capacity = round_up_to_power_of_two(capacity);
+
+    uint32_t header_size = (uint32_t) pad_to_four(sizeof(command_ring_header));
+    memory_size = header_size + this->capacity;
+
+    // Aligned to a cache line, so the positions in the header really do get their own cache lines. aligned_alloc
+    // isn't on every compiler we care about, so allocate a cache line extra and line the memory up ourselves
+    allocation = static_cast<unsigned char *>(malloc(memory_size + 63));
+    if(allocation == nullptr) {
+        throw std::bad_alloc();
+    }
+    memory = reinterpret_cast<unsigned char *>((reinterpret_cast<uintptr_t>(allocation) + 63) & ~(uintptr_t) 63);
+    memset(memory, 0, memory_size);
+
+    header = new(memory) command_ring_header;
+    header->magic = NOVA_COMMAND_RING_MAGIC;
+    header->version = NOVA_COMMAND_RING_VERSION;
+    header->capacity = this->capacity;
+    header->data_offset = header_size;
+    header->write_position.store(0);
+    header->read_position.store(0);
+
+    data = memory + header_size;
+
+    LOG(INFO) << "Created a command ring with " << this->capacity << " bytes of space";
+}
+
+command_ring::~command_ring() {
+    header->~command_ring_header();
+    free(allocation);
+}
+
+void * command_ring::get_memory() noexcept {
+    return memory;
+}
+
+uint32_t command_ring::get_memory_size() const noexcept {
+    return memory_size;
+}
+
+uint32_t command_ring::ring_doorbell(uint32_t new_write_position) noexcept {
+    header->write_position.store(new_write_position, std::memory_order_release);
+    return header->read_position.load(std::memory_order_acquire);
+}
+
+int command_ring::process_commands(iring_command_handler & handler) {
+    uint32_t read_position = header->read_position.load(std::memory_order_relaxed);
+    uint32_t write_position = header->write_position.load(std::memory_order_acquire);
+
+    if(read_position == write_position) {
+        return 0;
+    }
+
+    int num_commands = 0;
+
+    // Only the last of these in a batch matters, so hang on to them and send them at the end
+    mc_gui_screen latest_screen;
+    bool has_screen = false;
+    mc_render_command latest_render_command;
+    bool has_render_command = false;
+
+    while(read_position != write_position) {
+        uint32_t offset = read_position & (capacity - 1);
+        uint32_t command_start = offset;
+
+        // Commands start on eight byte boundaries and the capacity is a power of two, so the header always fits
+        command_reader header_reader(data, command_start, capacity);
+        ring_command_type type = static_cast<ring_command_type>(header_reader.read<uint16_t>());
+        header_reader.read<uint16_t>();
+        uint32_t size = header_reader.read<uint32_t>();
+
+        if(type == ring_command_type::WRAP) {
+            // The rest of the ring is padding, the next command is at the very start
+            read_position += capacity - command_start;
+            continue;
+        }
+
+        if(size < COMMAND_HEADER_SIZE || size % 8 != 0 || size > capacity - command_start ||
+                size > write_position - read_position) {
+            // Something's gone very wrong. Drop everything we have rather than read garbage
+            LOG(ERROR) << "Command of type " << (int) type << " has invalid size " << size
+                       << ". Dropping all pending commands";
+            read_position = write_position;
+            break;
+        }
+
+        command_reader reader(data, command_start + COMMAND_HEADER_SIZE, command_start + size);
+        switch(type) {
+            case ring_command_type::SET_GUI_SCREEN: {
+                int32_t num_buttons = reader.read<int32_t>();
+                if(num_buttons < 0 || num_buttons > MAX_NUM_BUTTONS) {
+                    LOG(ERROR) << "GUI screen has " << num_buttons << " buttons, but I can only handle "
+                               << MAX_NUM_BUTTONS;
+                    break;
+                }
+
+                // Decode into scratch space, so a broken screen doesn't clobber an earlier one from this batch
+                mc_gui_screen screen;
+                screen.num_buttons = num_buttons;
+                for(int32_t i = 0; i < num_buttons; i++) {
+                    mc_gui_button & button = screen.buttons[i];
+                    button.x_position = reader.read<int32_t>();
+                    button.y_position = reader.read<int32_t>();
+                    button.width = reader.read<int32_t>();
+                    button.height = reader.read<int32_t>();
+                    button.is_pressed = reader.read<uint8_t>() != 0;
+                    reader.read<uint8_t>();
+                    uint16_t text_length = reader.read<uint16_t>();
+
+                    reader.read_string(pending_button_text[i], text_length);
+                }
+
+                if(!reader.is_valid()) {
+                    LOG(ERROR) << "GUI screen with " << num_buttons << " buttons doesn't fit in its " << size
+                               << " byte command. Dropping it";
+                    break;
+                }
+
+                // Swapping the vectors doesn't move the strings' characters, so the pointers stay good
+                button_text.swap(pending_button_text);
+                for(int32_t i = 0; i < num_buttons; i++) {
+                    screen.buttons[i].text = button_text[i].c_str();
+                }
+
+                latest_screen = screen;
+                has_screen = true;
+                break;
+            }
+
+            case ring_command_type::RENDER: {
+                mc_render_command render_command;
+                render_command.previous_frame_time = (long) reader.read<int64_t>();
+                render_command.mouse_x = reader.read<float>();
+                render_command.mouse_y = reader.read<float>();
+                render_command.render_world_params.camera_x = reader.read<double>();
+                render_command.render_world_params.camera_y = reader.read<double>();
+                render_command.render_world_params.camera_z = reader.read<double>();
+
+                if(!reader.is_valid()) {
+                    LOG(ERROR) << "Render command doesn't fit in its " << size << " byte command. Dropping it";
+                    break;
+                }
+
+                latest_render_command = render_command;
+                has_render_command = true;
+                break;
+            }
+
+            case ring_command_type::ADD_TEXTURE_LOCATION: {
+                mc_texture_atlas_location location;
+                location.min_u = reader.read<float>();
+                location.max_u = reader.read<float>();
+                location.min_v = reader.read<float>();
+                location.max_v = reader.read<float>();
+                uint16_t name_length = reader.read<uint16_t>();
+                reader.read<uint16_t>();
+
+                reader.read_string(texture_name, name_length);
+                if(!reader.is_valid()) {
+                    LOG(ERROR) << "Texture location with a " << name_length << " byte name doesn't fit in its " << size
+                               << " byte command. Dropping it";
+                    break;
+                }
+
+                location.name = texture_name.c_str();
+
+                handler.on_add_texture_location(location);
+                break;
+            }
+
+            default:
+                // Probably from a newer version of the Java code. Skip it, the size tells us how
+                LOG(WARNING) << "Skipping unknown command type " << (int) type;
+        }
+
+        read_position += size;
+        num_commands++;
+    }
+
+    if(has_screen) {
+        handler.on_set_gui_screen(latest_screen);
+    }
+
+    if(has_render_command) {
+        handler.on_render(latest_render_command);
+    }
+
+    // Tell Java it can reuse the space
+    header->read_position.store(read_position, std::memory_order_release);
+
+    return num_commands;
+}
@@ -0,0 +1,163 @@
+/*!
+ * \brief A ring buffer in shared memory that Java writes commands into and the render thread reads them out of
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_COMMAND_RING_H
+#define RENDERER_COMMAND_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mc/mc_objects.h"
+
+/*!
+ * \brief The version of the binary command encoding. Bump this whenever the layout of any command changes, so that an
+ * out-of-date Java side refuses to talk to us instead of sending garbage
+ */
+#define NOVA_COMMAND_RING_VERSION 1
+
+/*!
+ * \brief The value of the first four bytes of the ring's memory. Spells "NOVA" in little-endian
+ */
+#define NOVA_COMMAND_RING_MAGIC 0x41564F4E
+
+/*!
+ * \brief The types of commands that can be sent through the command ring
+ *
+ * Every command starts with an eight byte header: a uint16 type, a uint16 that's reserved for later, and a uint32
+ * size that covers the header and the payload. Commands are padded so the next one starts on an eight byte boundary,
+ * which means there's always room for a WRAP header at the end of the ring. All values are in the native byte order.
+ */
+enum class ring_command_type : uint16_t {
+    /*!
+     * \brief Not really a command. Means the rest of the ring is padding and the next command is at the start
+     */
+    WRAP = 0,
+
+    /*!
+     * \brief Same data as mc_set_gui_screen_command
+     *
+     * Payload: int32 num_buttons, then for each button: int32 x_position, y_position, width, height, uint8 is_pressed,
+     * uint8 reserved, uint16 text_length, and text_length bytes of UTF-8 text padded to four bytes
+     */
+    SET_GUI_SCREEN = 1,
+
+    /*!
+     * \brief Same data as mc_render_command, minus the GUI screen
+     *
+     * Payload: int64 previous_frame_time, float mouse_x, float mouse_y, double camera_x, camera_y, camera_z
+     */
+    RENDER = 2,
+
+    /*!
+     * \brief Same data as mc_texture_atlas_location
+     *
+     * Payload: float min_u, max_u, min_v, max_v, uint16 name_length, uint16 reserved, and name_length bytes of the
+     * texture name padded to four bytes
+     */
+    ADD_TEXTURE_LOCATION = 3,
+};
+
+/*!
+ * \brief The start of the ring's memory. Java reads the first four fields to find its way around
+ *
+ * The read and write positions count bytes forever and wrap around at 2^32. The offset of a position in the data area
+ * is the position modulo the capacity, which is why the capacity has to be a power of two. Each position gets its own
+ * cache line so the two threads don't fight over it.
+ */
+struct command_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;      //!< The size of the data area, in bytes
+    uint32_t data_offset;   //!< The distance from the start of the header to the data area, in bytes
+
+    alignas(64) std::atomic<uint32_t> write_position;   //!< Only changed by #command_ring::ring_doorbell
+    alignas(64) std::atomic<uint32_t> read_position;    //!< Only changed by the render thread
+};
+
+/*!
+ * \brief Receives the commands that the command ring decodes
+ *
+ * The decoded data only lives as long as the call, so copy whatever you want to keep
+ */
+class iring_command_handler {
+public:
+    virtual void on_set_gui_screen(mc_gui_screen & screen) = 0;
+    virtual void on_render(mc_render_command & command) = 0;
+    virtual void on_add_texture_location(mc_texture_atlas_location & location) = 0;
+};
+
+/*!
+ * \brief A single-producer single-consumer command queue that lives in memory both Java and the native code can see
+ *
+ * Sending a struct through JNA means reflecting over the whole thing and copying it field by field, once per call.
+ * That adds up fast, especially with a GUI screen that has 22 buttons. Instead, Java writes a compact binary encoding
+ * of each command straight into this ring through a direct ByteBuffer, then tells us how far it got with a single
+ * call to #ring_doorbell per frame. The render thread decodes everything that arrived in one go at the start of the
+ * frame.
+ *
+ * Only the last GUI screen of a batch gets sent to the handler, since any screens before it would be replaced before
+ * they were ever drawn. Same goes for render commands.
+ */
+class command_ring {
+public:
+    /*!
+     * \brief Allocates the ring's memory
+     *
+     * \param capacity The size of the data area, in bytes. Rounded up to a power of two
+     */
+    command_ring(uint32_t capacity = 1 << 20);
+
+    ~command_ring();
+
+    /*!
+     * \brief Returns the start of the ring's memory, which is where the header lives
+     */
+    void * get_memory() noexcept;
+
+    /*!
+     * \brief Returns the total size of the ring's memory, including the header
+     */
+    uint32_t get_memory_size() const noexcept;
+
+    /*!
+     * \brief Tells the render thread that everything before the given position is ready to be read
+     *
+     * Called from the Java thread
+     *
+     * \param new_write_position The position just past the last byte Java wrote
+     * \return The current read position, so Java knows how much space has been freed up
+     */
+    uint32_t ring_doorbell(uint32_t new_write_position) noexcept;
+
+    /*!
+     * \brief Decodes every command that's been published so far and sends them to the given handler
+     *
+     * Called from the render thread
+     *
+     * \return The number of commands that were decoded
+     */
+    int process_commands(iring_command_handler & handler);
+
+private:
+    unsigned char * allocation;     //!< What malloc gave us. #memory is in here somewhere, lined up to a cache line
+    unsigned char * memory;
+    uint32_t memory_size;
+
+    command_ring_header * header;
+    unsigned char * data;
+    uint32_t capacity;
+
+    /*
+     * Scratch space for decoding, kept around so decoding doesn't allocate once it's warmed up
+     */
+    std::vector<std::string> button_text;
+    std::vector<std::string> pending_button_text;   //!< Where a GUI screen's text goes until it's known to be valid
+    std::string texture_name;
+};
+
+#endif //RENDERER_COMMAND_RING_H
@@ -4,12 +4,21 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <easylogging++.h>
 #include "gui_renderer.h"
-#include "gl/objects/gl_vertex_buffer.h"
+#include "utils/async_log.h"
+
+const uint16_t gui_renderer::GUI_ATLAS_SELECTOR;
+const uint64_t gui_renderer::EMPTY_SLOT_HASH;
+const unsigned int gui_renderer::MAX_GUI_GLYPHS;
+const unsigned int gui_renderer::TEXT_START;
 
 gui_renderer::gui_renderer(texture_manager & textures, shaderpack & shaders, uniform_buffer_store & uniform_buffers) :
-        tex_manager(textures), shaders(shaders), ubo_manager(uniform_buffers) {
+        tex_manager(textures), shaders(shaders), ubo_manager(uniform_buffers), text(textures), text_hash(0),
+        num_glyphs(0), num_new_glyph_widths(0), has_glyph_widths_available(false), has_screen_available(false) {
+    gui_shader_id = shaders.get_program_id(GUI_SHADER_NAME);
+
     LOG(INFO) << "Created GUI Renderer";
 
     setup_buffers();
@@ -19,28 +28,47 @@ gui_renderer::~gui_renderer() {
 }
 
 void gui_renderer::set_current_screen(mc_gui_screen *screen) {
-    new_screen = *screen;
+    copy_screen(*screen, new_screen, new_screen_text);
     has_screen_available.store(true);
 }
 
+void gui_renderer::copy_screen(const mc_gui_screen & source, mc_gui_screen & destination, std::string * destination_text) {
+    destination = source;
+    for(int i = 0; i < source.num_buttons; i++) {
+        const char * text = source.buttons[i].text;
+        destination_text[i] = text == nullptr ? "" : text;
+        destination.buttons[i].text = destination_text[i].c_str();
+    }
+}
+
 void gui_renderer::render() {
     // Bind the GUI shader
-    gl_shader_program & gui_shader = shaders.get_shader(GUI_SHADER_NAME);
+    gl_shader_program & gui_shader = shaders.get_shader(gui_shader_id);
     gui_shader.bind();
 
-    // Bind the GUI buttons texture to texture unit 0
-    // Commented out because we don't support textures yet. Not really.
-    // texture2D& gui_tex = tex_manager.get_texture_atlas(texture_manager::atlas_type::GUI, texture_manager::texture_type::ALBEDO);
-    // gui_tex.bind(GL_TEXTURE0);
+    // Bind the GUI buttons texture to texture unit 0 and the font to texture unit 1. The shader picks between them
+    // per vertex, and reads the albedo layer of each
+    texture2D_array & gui_tex = tex_manager.get_texture_atlas(texture_manager::atlas_type::GUI);
+    texture2D_array & font_tex = tex_manager.get_texture_atlas(texture_manager::atlas_type::FONT);
+    gui_tex.bind(GL_TEXTURE0);
+    font_tex.bind(GL_TEXTURE1);
+
+    // Draw the buttons and all the text on them in one go. Unused button slots are empty quads, but there's no sense
+    // drawing thousands of empty glyphs
+    cur_screen_buffer->draw(MAX_NUM_BUTTONS + num_glyphs);
 
-    // Draw the 2D GUI geometry
-    cur_screen_buffer->set_active();
-    cur_screen_buffer->draw();
+    // The textures stay bound. The state cache skips binding them again next frame, and anything that wants those
+    // texture units just binds over them
 }
 
 bool gui_renderer::is_different_screen(mc_gui_screen &screen1, mc_gui_screen &screen2) const {
-    for(int i = 0; i < MAX_NUM_BUTTONS; i++) {
-        if(same_buttons(screen1.buttons[i], screen2.buttons[i])) {
+    if(screen1.num_buttons != screen2.num_buttons) {
+        return true;
+    }
+
+    // Only the first num_buttons buttons mean anything. The rest can be left over from older screens
+    for(int i = 0; i < screen1.num_buttons; i++) {
+        if(!same_buttons(screen1.buttons[i], screen2.buttons[i])) {
             return true;
         }
     }
@@ -57,87 +85,218 @@ bool gui_renderer::same_buttons(mc_gui_button & button1, mc_gui_button & button2
             button1.is_pressed == button2.is_pressed;
 }
 
-void gui_renderer::build_gui_geometry() {
-    // We need to make a vertex buffer with the positions and texture coordinates of all the gui elements
-    std::vector<float> vertex_buffer(MAX_NUM_BUTTONS * 4 * 5);    // MAX_NUM_BUTTONS buttons * 4 vertices per button * 5 elements per vertex
-    vertex_buffer.clear();
-    std::vector<unsigned short> indices;
-    unsigned short start_pos = 0;
+/*!
+ * \brief Adds the given bytes to an FNV-1a hash
+ */
+const uint8_t TEXT_COLOR[] = {0xE0, 0xE0, 0xE0, 0xFF};
+const uint8_t PRESSED_TEXT_COLOR[] = {0xFF, 0xFF, 0xA0, 0xFF};
+
+static uint64_t hash_bytes(const void * data, std::size_t size, uint64_t hash = 14695981039346656037ULL) {
+    const unsigned char * bytes = static_cast<const unsigned char *>(data);
+    for(std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+uint64_t gui_renderer::hash_button(const mc_gui_button & button) {
+    const int fields[] = {button.x_position, button.y_position, button.width, button.height, button.is_pressed ? 1 : 0};
+    uint64_t hash = hash_bytes(fields, sizeof(fields));
+
+    // Make sure no button ever looks like an empty slot
+    return hash == EMPTY_SLOT_HASH ? 1 : hash;
+}
+
+uint64_t gui_renderer::hash_screen_text() const {
+    uint64_t hash = hash_bytes(&cur_screen.num_buttons, sizeof(cur_screen.num_buttons));
 
     for(int i = 0; i < cur_screen.num_buttons; i++) {
-        mc_gui_button & button = cur_screen.buttons[i];
+        const mc_gui_button & button = cur_screen.buttons[i];
+        const int fields[] = {button.x_position, button.y_position, button.width, button.height, button.is_pressed ? 1 : 0};
+        hash = hash_bytes(fields, sizeof(fields), hash);
+
+        // Include the terminator so "ab" + "c" doesn't hash the same as "a" + "bc"
+        hash = hash_bytes(cur_screen_text[i].c_str(), cur_screen_text[i].size() + 1, hash);
+    }
+
+    return hash;
+}
 
-        // TODO: More switches to figure out exactly which UVs we should use
-        std::vector<float> & uv_buffer = basic_unpressed_uvs;
-        if(button.is_pressed) {
-            uv_buffer = basic_pressed_uvs;
+uint32_t gui_renderer::update_text_geometry() {
+    uint64_t new_text_hash = hash_screen_text();
+    if(new_text_hash == text_hash) {
+        return 0;
+    }
+
+    text_hash = new_text_hash;
+    num_glyphs = 0;
+
+    for(int i = 0; i < cur_screen.num_buttons; i++) {
+        const mc_gui_button & button = cur_screen.buttons[i];
+        const std::string & label = cur_screen_text[i];
+        if(label.empty()) {
+            continue;
         }
 
-        // Generate the vertexes from the button's position
-        add_vertices_from_button(vertex_buffer, button, uv_buffer);
+        // Minecraft centers button labels, so we do too
+        int x = button.x_position + (button.width - text.get_text_width(label)) / 2;
+        int y = button.y_position + (button.height - text_renderer::LINE_HEIGHT) / 2;
 
-        add_indices_for_button(indices, start_pos);
+        // Same colors Minecraft uses: a yellow tint on the pressed button, off-white everywhere else
+        const uint8_t * color = button.is_pressed ? PRESSED_TEXT_COLOR : TEXT_COLOR;
 
-        // Add the number of new vertices to the offset for indices, so that indices point to the right
-        // vertices
-        start_pos += 4;
+        num_glyphs += text.write_text(label, x, y, color, &instances[TEXT_START + num_glyphs],
+                                      MAX_GUI_GLYPHS - num_glyphs);
     }
 
-    cur_screen_buffer->set_data(vertex_buffer, ivertex_buffer::format::POS_UV, ivertex_buffer::usage::static_draw);
-    cur_screen_buffer->set_index_array(indices, ivertex_buffer::usage::static_draw);
+    if(num_glyphs == 0) {
+        return 0;
+    }
+
+    cur_screen_buffer->set_instances(TEXT_START, &instances[TEXT_START], num_glyphs);
+
+    return num_glyphs * (uint32_t) sizeof(quad_instance);
 }
 
-void gui_renderer::add_indices_for_button(std::vector<unsigned short> &indices, unsigned short start_pos) {
-    for(unsigned short &index : index_buffer) {
-        indices.push_back(index + start_pos);
+void gui_renderer::update_gui_geometry() {
+    uint32_t bytes_this_change = 0;
+    const texture_manager::texture_location & widgets_location = tex_manager.get_texture_location(WIDGETS_TEXTURE_NAME);
+
+    for(unsigned int slot = 0; slot < MAX_NUM_BUTTONS; ) {
+        // Find the next run of slots that changed, so neighbouring changes go up in a single upload
+        unsigned int first_changed = slot;
+        while(first_changed < MAX_NUM_BUTTONS) {
+            bool has_button = (int) first_changed < cur_screen.num_buttons;
+            uint64_t hash = has_button ? hash_button(cur_screen.buttons[first_changed]) : EMPTY_SLOT_HASH;
+            if(hash != slot_hashes[first_changed]) {
+                break;
+            }
+            first_changed++;
+        }
+
+        unsigned int end_changed = first_changed;
+        while(end_changed < MAX_NUM_BUTTONS) {
+            bool has_button = (int) end_changed < cur_screen.num_buttons;
+            uint64_t hash = has_button ? hash_button(cur_screen.buttons[end_changed]) : EMPTY_SLOT_HASH;
+            if(hash == slot_hashes[end_changed]) {
+                break;
+            }
+
+            if(has_button) {
+                mc_gui_button & button = cur_screen.buttons[end_changed];
+
+                // TODO: More switches to figure out exactly which UVs we should use
+                const float * uvs = button.is_pressed ? basic_pressed_uvs : basic_unpressed_uvs;
+                instances[end_changed] = make_button_quad(button, uvs, widgets_location);
+            } else {
+                // Zero-sized quad, so the slot draws nothing
+                instances[end_changed] = quad_instance{};
+            }
+
+            slot_hashes[end_changed] = hash;
+            end_changed++;
+        }
+
+        if(end_changed > first_changed) {
+            unsigned int num_changed = end_changed - first_changed;
+            cur_screen_buffer->set_instances(first_changed, &instances[first_changed], num_changed);
+
+            bytes_this_change += num_changed * (uint32_t) sizeof(quad_instance);
+            stats.slots_uploaded += end_changed - first_changed;
+        }
+
+        slot = end_changed;
     }
-}
 
-void gui_renderer::add_vertices_from_button(std::vector<GLfloat> &vertex_buffer, const mc_gui_button &button,
-                                            const std::vector<GLfloat> &uvs) {
-    add_vertex(
-            vertex_buffer,
-            button.x_position, button.y_position,
-            uvs[0], uvs[1]
-    );
-    add_vertex(
-            vertex_buffer,
-            button.x_position + button.width, button.y_position,
-            uvs[2], uvs[3]
-    );
-    add_vertex(
-            vertex_buffer,
-            button.x_position, button.y_position + button.height,
-            uvs[4], uvs[5]
-    );
-    add_vertex(
-            vertex_buffer,
-            button.x_position + button.width, button.y_position + button.height,
-            uvs[6], uvs[7]
-    );
+    bytes_this_change += update_text_geometry();
+
+    stats.screen_changes++;
+    stats.bytes_uploaded += bytes_this_change;
+    stats.last_screen_change_bytes = bytes_this_change;
+
+    NOVA_LOG_DEBUG("GUI screen changed, uploaded {} bytes of quads ({} bytes over {} screen changes)",
+                   bytes_this_change, stats.bytes_uploaded, stats.screen_changes);
 }
 
-void gui_renderer::setup_buffers() {
-    // Buffer for the GUI geometry
-    cur_screen_buffer = std::unique_ptr<ivertex_buffer>(new gl_vertex_buffer());
+quad_instance gui_renderer::make_button_quad(const mc_gui_button &button, const float * uvs,
+                                            const texture_manager::texture_location & widgets_location) const {
+    // The UVs are relative to the widgets texture, but the widgets texture is just one part of the GUI atlas
+    glm::vec2 widgets_size = widgets_location.max - widgets_location.min;
+
+    quad_instance quad = {};
+    quad.x = (int16_t) button.x_position;
+    quad.y = (int16_t) button.y_position;
+    quad.width = (int16_t) button.width;
+    quad.height = (int16_t) button.height;
+
+    quad.min_u = to_unorm16(widgets_location.min.x + uvs[0] * widgets_size.x);
+    quad.min_v = to_unorm16(widgets_location.min.y + uvs[1] * widgets_size.y);
+    quad.max_u = to_unorm16(widgets_location.min.x + uvs[2] * widgets_size.x);
+    quad.max_v = to_unorm16(widgets_location.min.y + uvs[3] * widgets_size.y);
+
+    quad.color[0] = quad.color[1] = quad.color[2] = quad.color[3] = 0xFF;
+    quad.atlas = GUI_ATLAS_SELECTOR;
+
+    return quad;
 }
 
-void gui_renderer::add_vertex(std::vector<float> &vertex_buffer, int x, int y, float u, float v) {
-    vertex_buffer.push_back(static_cast<float>(x));
-    vertex_buffer.push_back(static_cast<float>(y));
-    vertex_buffer.push_back(0.0f);
+void gui_renderer::setup_buffers() {
+    // Buffer for the GUI quads. Every slot starts out empty
+    cur_screen_buffer = std::unique_ptr<gl_quad_instance_buffer>(
+            new gl_quad_instance_buffer(MAX_NUM_BUTTONS + MAX_GUI_GLYPHS));
 
-    vertex_buffer.push_back(u);
-    vertex_buffer.push_back(v);
+    instances.assign(MAX_NUM_BUTTONS + MAX_GUI_GLYPHS, quad_instance{});
+    std::fill(slot_hashes, slot_hashes + MAX_NUM_BUTTONS, EMPTY_SLOT_HASH);
+    cur_screen.num_buttons = 0;
+    text_hash = 0;
+    num_glyphs = 0;
 }
 
 void gui_renderer::update() {
-    if(has_screen_available && is_different_screen(cur_screen, new_screen)) {
-        cur_screen = new_screen;
-        build_gui_geometry();
+    bool glyph_widths_changed = false;
+    if(has_glyph_widths_available.load()) {
+        // Copy them out under the lock, so Java can't write new ones halfway through
+        unsigned char glyph_widths[256];
+        int num_glyph_widths;
+        {
+            std::lock_guard<std::mutex> lock(new_glyph_widths_lock);
+            num_glyph_widths = num_new_glyph_widths;
+            memcpy(glyph_widths, new_glyph_widths, (std::size_t) num_glyph_widths);
+            has_glyph_widths_available.store(false);
+        }
+
+        text.set_glyph_widths(glyph_widths, num_glyph_widths);
+        glyph_widths_changed = true;
+
+        // Every glyph might have moved, so forget the old text and lay it all out again
+        text_hash = 0;
     }
-}
 
+    bool new_screen_available = has_screen_available.exchange(false);
+    if(new_screen_available && is_different_screen(cur_screen, new_screen)) {
+        copy_screen(new_screen, cur_screen, cur_screen_text);
+        update_gui_geometry();
 
+    } else if(glyph_widths_changed) {
+        uint32_t text_bytes = update_text_geometry();
+        stats.bytes_uploaded += text_bytes;
+    }
+}
 
+void gui_renderer::set_glyph_widths(const unsigned char * widths, int count) {
+    if(widths == nullptr || count <= 0) {
+        LOG(ERROR) << "Got " << count << " glyph widths, which isn't something I can use. Keeping the old ones";
+        return;
+    }
 
+    std::lock_guard<std::mutex> lock(new_glyph_widths_lock);
+    num_new_glyph_widths = std::min(count, 256);
+    memcpy(new_glyph_widths, widths, (std::size_t) num_new_glyph_widths);
+    has_glyph_widths_available.store(true);
+}
+
+const gui_renderer::upload_stats & gui_renderer::get_upload_stats() const {
+    return stats;
+}
@@ -8,10 +8,13 @@
 
 #include <memory>
 #include <atomic>
+#include <mutex>
+#include <cstdint>
 #include "core/uniform_buffer_store.h"
-#include "interfaces/ivertex_buffer.h"
+#include "gl/objects/gl_quad_instance_buffer.h"
 #include "mc/mc_gui_objects.h"
 #include "core/texture_manager.h"
+#include "core/gui/text_renderer.h"
 #include "core/shaders/uniform_buffer_definitions.h"
 #include "shaderpack_loading/shaderpack.h"
 
@@ -33,9 +36,30 @@
  * completely rebuild the GUI geometry when the new gui screen is different from the current GUI screen. I do this so I
  * don't have to send a lot of information to the GPU. While it's true that the GUI geometry wil be relatively small and
  * probably not a bottleneck, I want to ensure that every part of this mod is built for speed and efficiency.
+ *
+ * Every GUI element is a quad, so the VBO doesn't hold vertices at all. It holds one 24 byte quad_instance per element,
+ * and the GPU expands each one into a unit quad with instancing. Every button gets a fixed slot: button 0 is always
+ * instance 0, button 1 is instance 1, and so on up to MAX_NUM_BUTTONS. Slots past the end of the current screen are
+ * zero-sized, so they draw nothing. Each slot remembers a hash of the button it holds, and only slots whose hash changed
+ * get re-uploaded.
+ *
+ * All the text on the screen goes right after the button slots, one instance per glyph. Text changes a lot less often
+ * than buttons get pressed, so whenever any button's text or position changes, I lay out all the text again and upload
+ * it in one go. Each instance says which atlas it samples: 0 is the GUI atlas and 1 is the font atlas. That way the
+ * buttons and all their text are a single draw call.
  */
 class gui_renderer {
 public:
+    /*!
+     * \brief Counts how much GUI data we send to the GPU, so we can tell if the diffing is doing its job
+     */
+    struct upload_stats {
+        uint64_t screen_changes = 0;            //!< How many times we got a screen that differed from the current one
+        uint64_t slots_uploaded = 0;            //!< How many button slots were re-uploaded, in total
+        uint64_t bytes_uploaded = 0;            //!< How many bytes of instance data were uploaded, in total
+        uint32_t last_screen_change_bytes = 0;  //!< How many bytes the most recent screen change uploaded
+    };
+
     gui_renderer(texture_manager& textures, shaderpack& shaders, uniform_buffer_store& uniform_buffers);
     ~gui_renderer();
 
@@ -51,6 +75,8 @@ public:
 
     /*!
      * \brief Sets the GUI screen to render as the given screen
+     *
+     * The button text is copied, so the screen doesn't need to live past this call
      */
     void set_current_screen(mc_gui_screen* screen);
 
@@ -67,41 +93,103 @@ public:
      */
     void update();
 
+    /*!
+     * \brief Returns the running totals of how much GUI geometry has been uploaded
+     */
+    const upload_stats & get_upload_stats() const;
+
+    /*!
+     * \brief Sets the width of each glyph in the font
+     *
+     * This is called from the Java thread, so the widths are held on to until the next #update. If there are no widths
+     * at all, the old ones are kept
+     *
+     * \param widths The width of each glyph, in GUI pixels, indexed by character
+     * \param count The number of glyph widths
+     */
+    void set_glyph_widths(const unsigned char * widths, int count);
+
 private:
-    std::vector<float> basic_unpressed_uvs = {
-            0.0f,       0.3359375f,
-            0.78125f,   0.3359375f,
-            0.0f,       0.4156963f,
-            0.78125f,   0.4156963f
-    };
+    /*!
+     * \brief The value of quad_instance::atlas that means "sample from the GUI atlas"
+     */
+    static const uint16_t GUI_ATLAS_SELECTOR = 0;
 
-    std::vector<float> basic_pressed_uvs = {
-            0.0f,       0.2578112f,
-            0.78125,    0.2578112f,
-            0.0f,       0.3359375f,
-            0.78125f,   0.3359375f
-    };
+    /*!
+     * \brief The hash of a slot that doesn't have a button in it
+     */
+    static const uint64_t EMPTY_SLOT_HASH = 0;
 
-    std::vector<unsigned short> index_buffer = {
-            0, 1, 2,
-            2, 1, 3
-    };
+    /*!
+     * \brief The most glyphs that can be on screen at once
+     */
+    static const unsigned int MAX_GUI_GLYPHS = 2048;
+
+    /*!
+     * \brief The index of the first glyph instance
+     */
+    static const unsigned int TEXT_START = MAX_NUM_BUTTONS;
+
+    /*
+     * UV rectangles of the button textures in widgets.png, as min_u, min_v, max_u, max_v
+     */
+    const float basic_unpressed_uvs[4] = {0.0f, 0.3359375f, 0.78125f, 0.4156963f};
+    const float basic_pressed_uvs[4] = {0.0f, 0.2578112f, 0.78125f, 0.3359375f};
 
     mc_gui_screen cur_screen;
+    std::string cur_screen_text[MAX_NUM_BUTTONS];
 
     texture_manager& tex_manager;
     shaderpack& shaders;
     uniform_buffer_store & ubo_manager;
 
-    std::string WIDGETS_TEXTURE_NAME = "textures/gui/widgets.png";
+    std::string WIDGETS_TEXTURE_NAME = "minecraft:textures/gui/widgets.png";
     std::string GUI_SHADER_NAME = "gui";
+    shaderpack::program_id gui_shader_id;
+
+    std::unique_ptr<gl_quad_instance_buffer> cur_screen_buffer;
+
+    /*!
+     * \brief The hash of the button in each slot, as of the last upload
+     */
+    uint64_t slot_hashes[MAX_NUM_BUTTONS];
+
+    /*!
+     * \brief A CPU-side copy of the whole instance buffer. Changed slots get written here, then uploaded from here
+     */
+    std::vector<quad_instance> instances;
+
+    upload_stats stats;
 
-    std::unique_ptr<ivertex_buffer> cur_screen_buffer;
+    text_renderer text;
+
+    /*!
+     * \brief A hash of everything that decides where the current text goes
+     */
+    uint64_t text_hash;
+    unsigned int num_glyphs;
+
+    // Glyph widths from the Java thread, waiting for the render thread to pick them up. Both threads copy them under
+    // the lock
+    std::mutex new_glyph_widths_lock;
+    unsigned char new_glyph_widths[256];
+    int num_new_glyph_widths;
+    std::atomic<bool> has_glyph_widths_available;
 
     // Memory that will be accessed from both the render thread and the Java thread
     mc_gui_screen new_screen;
+    std::string new_screen_text[MAX_NUM_BUTTONS];
     std::atomic<bool> has_screen_available;
 
+    /*!
+     * \brief Copies a GUI screen, storing each button's text in the given strings and pointing the copied buttons at
+     * them
+     *
+     * Buttons come to us with pointers to text that belongs to someone else, usually JNA or the command ring. That
+     * memory is long gone by the time we draw, so we need our own copy
+     */
+    void copy_screen(const mc_gui_screen & source, mc_gui_screen & destination, std::string * destination_text);
+
     /*!
      * \brief Compares two mc_gui_screen objects, determining if they represent the same visual data
      *
@@ -125,38 +213,41 @@ private:
     bool same_buttons(mc_gui_button& button1, mc_gui_button& button2) const;
 
     /*!
-     * \brief Constructs the geometry needed to render the current GUI screen
+     * \brief Hashes everything about a button that ends up in its quad
      *
-     * Note that the GUI screen does not include things like the spinning background on the main menu screen, because
-     * that's going to be rendered as if it was a scene
+     * Text isn't included, since it doesn't change the button's quad
      */
-    void build_gui_geometry();
+    static uint64_t hash_button(const mc_gui_button & button);
 
     /*!
-     * \brief Adds the vertex with the given parameters to the given vertex buffer
-     *
-     * Note that the z position of the vertices is always set to 0. This is maybe what I want.
+     * \brief Hashes the text of every button on the current screen, along with where each button is
+     */
+    uint64_t hash_screen_text() const;
+
+    /*!
+     * \brief Lays out the text of every button on the current screen and uploads it, if any of it changed
      *
-     * \param vertex_buffer The thing to add vertices to
-     * \param x The x position of the vertex
-     * \param y The y position of the vertex
-     * \param u The u texture coordiante of the vertex
-     * \param v The v texture coordinate of the vertex
+     * \return The number of bytes uploaded
      */
-    void add_vertex(std::vector<float> &vertex_buffer, int x, int y, float u, float v);
+    uint32_t update_text_geometry();
 
     /*!
-     * \brief Adds all the vertices from the given button to the given vertex buffer. uvs holds the uv
-     * coordinates for this button
+     * \brief Updates the quads in the slots whose buttons changed, and uploads just those slots
      *
-     * \param vertex_buffer The vertex buffer to add vertices to
-     * \param button The button to get vertices from
-     * \param uvs The uv coordinates to use for this button
+     * Note that the GUI screen does not include things like the spinning background on the main menu screen, because
+     * that's going to be rendered as if it was a scene
      */
-    void add_vertices_from_button(std::vector<float> &vertex_buffer, const mc_gui_button &button,
-                                  const std::vector<float> &uvs);
+    void update_gui_geometry();
 
-    void add_indices_for_button(std::vector<unsigned short> &indices, unsigned short start_pos);
+    /*!
+     * \brief Makes the quad for the given button
+     *
+     * \param button The button to make a quad for
+     * \param uvs The uv rectangle to use for this button, relative to the widgets texture
+     * \param widgets_location Where the widgets texture is in the GUI atlas
+     */
+    quad_instance make_button_quad(const mc_gui_button &button, const float * uvs,
+                                   const texture_manager::texture_location & widgets_location) const;
 };
 
 
@@ -0,0 +1,158 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "text_renderer.h"
+
+#include <cstring>
+#include <easylogging++.h>
+#include "utils/async_log.h"
+
+const int text_renderer::LINE_HEIGHT;
+const std::size_t text_renderer::MAX_CACHED_STRINGS;
+
+const std::string text_renderer::FONT_TEXTURE_NAME = "minecraft:textures/font/ascii.png";
+
+/*!
+ * \brief The font texture is a grid of this many glyphs by this many glyphs
+ */
+const int GLYPHS_PER_ROW = 16;
+
+/*!
+ * \brief The value of quad_instance::atlas that tells the GUI shader to sample from the font atlas
+ */
+const uint16_t FONT_ATLAS_SELECTOR = 1;
+
+text_renderer::text_renderer(texture_manager & textures) : textures(textures) {
+    // Until Java tells us otherwise, assume every glyph is as wide as most of Minecraft's glyphs are, except for spaces
+    memset(glyph_widths, 6, sizeof(glyph_widths));
+    glyph_widths[' '] = 4;
+}
+
+void text_renderer::set_glyph_widths(const unsigned char * widths, int count) {
+    if(widths == nullptr || count <= 0) {
+        return;
+    }
+
+    if(count > 256) {
+        count = 256;
+    }
+
+    memcpy(glyph_widths, widths, (std::size_t) count);
+    shaped_strings.clear();
+}
+
+int text_renderer::get_text_width(const std::string & text) {
+    return shape(text).width;
+}
+
+unsigned int text_renderer::write_text(const std::string & text, int x, int y, const uint8_t * color,
+                                       quad_instance * quads, unsigned int max_glyphs) {
+    const shaped_text & shaped = shape(text);
+
+    // The font texture is somewhere in the font atlas. Every glyph is a cell of that texture
+    const texture_manager::texture_location & font_location = textures.get_texture_location(FONT_TEXTURE_NAME);
+    glm::vec2 cell_size = (font_location.max - font_location.min) / (float) GLYPHS_PER_ROW;
+
+    unsigned int num_written = 0;
+    for(const shaped_glyph & glyph : shaped.glyphs) {
+        if(num_written == max_glyphs) {
+            break;
+        }
+
+        glm::vec2 uv_min = font_location.min + glm::vec2(glyph.glyph % GLYPHS_PER_ROW, glyph.glyph / GLYPHS_PER_ROW) * cell_size;
+        glm::vec2 uv_max = uv_min + cell_size;
+
+        quad_instance & quad = quads[num_written];
+        quad.x = (int16_t) (x + glyph.x_offset);
+        quad.y = (int16_t) y;
+        quad.width = LINE_HEIGHT;
+        quad.height = LINE_HEIGHT;
+
+        quad.min_u = to_unorm16(uv_min.x);
+        quad.min_v = to_unorm16(uv_min.y);
+        quad.max_u = to_unorm16(uv_max.x);
+        quad.max_v = to_unorm16(uv_max.y);
+
+        memcpy(quad.color, color, sizeof(quad.color));
+        quad.atlas = FONT_ATLAS_SELECTOR;
+        quad.reserved = 0;
+
+        num_written++;
+    }
+
+    return num_written;
+}
+
+std::size_t text_renderer::get_num_cached_strings() const {
+    return shaped_strings.size();
+}
+
+const text_renderer::shaped_text & text_renderer::shape(const std::string & text) {
+    auto cached = shaped_strings.find(text);
+    if(cached != shaped_strings.end()) {
+        return cached->second;
+    }
+
+    if(shaped_strings.size() >= MAX_CACHED_STRINGS) {
+        NOVA_LOG_DEBUG("Shaped string cache is full, clearing it");
+        shaped_strings.clear();
+    }
+
+    shaped_text & shaped = shaped_strings[text];
+    shaped.glyphs.reserve(text.size());
+
+    int pen_x = 0;
+    for(std::size_t pos = 0; pos < text.size(); ) {
+        unsigned char glyph = next_glyph(text, pos);
+
+        // Spaces take up room but don't need a quad
+        if(glyph != ' ') {
+            shaped.glyphs.push_back({pen_x, glyph});
+        }
+
+        pen_x += glyph_widths[glyph];
+    }
+
+    shaped.width = pen_x;
+    return shaped;
+}
+
+unsigned char text_renderer::next_glyph(const std::string & text, std::size_t & pos) {
+    unsigned char lead = (unsigned char) text[pos];
+
+    // How many bytes follow the lead byte, and the bits of the lead byte that belong to the character
+    int num_continuation_bytes;
+    uint32_t character;
+    if(lead < 0x80) {
+        pos++;
+        return lead;
+    } else if((lead & 0xE0) == 0xC0) {
+        num_continuation_bytes = 1;
+        character = lead & 0x1Fu;
+    } else if((lead & 0xF0) == 0xE0) {
+        num_continuation_bytes = 2;
+        character = lead & 0x0Fu;
+    } else if((lead & 0xF8) == 0xF0) {
+        num_continuation_bytes = 3;
+        character = lead & 0x07u;
+    } else {
+        // Not a valid lead byte
+        pos++;
+        return '?';
+    }
+
+    pos++;
+    for(int i = 0; i < num_continuation_bytes; i++) {
+        if(pos >= text.size() || ((unsigned char) text[pos] & 0xC0) != 0x80) {
+            return '?';
+        }
+
+        character = (character << 6) | ((unsigned char) text[pos] & 0x3Fu);
+        pos++;
+    }
+
+    // The top half of the ascii font isn't in Latin-1 order, it's in Minecraft's own order, and everything else lives
+    // in the unicode pages, which we don't load. Plain ASCII it is, for now
+    return character < 128 ? (unsigned char) character : (unsigned char) '?';
+}
@@ -0,0 +1,117 @@
+/*!
+ * \brief Lays out GUI text as quads that sample Minecraft's font texture
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_TEXT_RENDERER_H
+#define RENDERER_TEXT_RENDERER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/texture_manager.h"
+#include "gl/objects/gl_quad_instance_buffer.h"
+
+/*!
+ * \brief Turns strings into glyph quads
+ *
+ * Minecraft's default font is textures/font/ascii.png: a 16x16 grid of 8x8 pixel glyphs. The first half of the grid is
+ * plain ASCII. Java packs that image into the FONT atlas like any other texture, so all I need to find a glyph is the
+ * font texture's location in the atlas and the glyph's cell in the grid.
+ *
+ * Glyphs aren't all eight pixels wide, though. Minecraft measures how wide each glyph is by looking for the rightmost
+ * column with any pixels in it. Java does the same thing and sends us the widths with #set_glyph_widths.
+ *
+ * Shaping a string (figuring out which glyph goes where) only depends on the string, so shaped strings are cached.
+ * The same few button labels show up over and over, and chat lines don't change once they're written.
+ *
+ * The text renderer doesn't own any GPU resources. It writes quads into memory the GUI renderer gives it, so all the
+ * text on a screen ends up in the GUI renderer's buffer next to the buttons, and the whole screen is one draw.
+ */
+class text_renderer {
+public:
+    /*!
+     * \brief The height of a line of text, in GUI pixels
+     */
+    static const int LINE_HEIGHT = 8;
+
+    /*!
+     * \brief The name of the texture that holds the font
+     */
+    static const std::string FONT_TEXTURE_NAME;
+
+    text_renderer(texture_manager & textures);
+
+    /*!
+     * \brief Sets how wide each glyph is, in GUI pixels
+     *
+     * Throws away all the shaped strings, since they were shaped with the old widths
+     *
+     * \param widths The width of each glyph, indexed by character
+     * \param count The number of widths. Anything past 256 is ignored
+     */
+    void set_glyph_widths(const unsigned char * widths, int count);
+
+    /*!
+     * \brief Returns how wide the given text is, in GUI pixels
+     */
+    int get_text_width(const std::string & text);
+
+    /*!
+     * \brief Writes a quad for each glyph in the given text
+     *
+     * \param text The UTF-8 text to write
+     * \param x The x position of the left edge of the text
+     * \param y The y position of the top of the text
+     * \param color The RGBA color of the text
+     * \param quads Where to write the glyph quads to
+     * \param max_glyphs How many glyphs there's room for in quads. Glyphs past that are dropped
+     * \return The number of glyphs written
+     */
+    unsigned int write_text(const std::string & text, int x, int y, const uint8_t * color, quad_instance * quads,
+                            unsigned int max_glyphs);
+
+    /*!
+     * \brief Returns how many strings are in the shaped string cache
+     */
+    std::size_t get_num_cached_strings() const;
+
+private:
+    /*!
+     * \brief A single glyph in a shaped string
+     */
+    struct shaped_glyph {
+        int x_offset;           //!< How far the glyph is from the start of the string, in GUI pixels
+        unsigned char glyph;    //!< Which glyph in the font texture to use
+    };
+
+    struct shaped_text {
+        std::vector<shaped_glyph> glyphs;
+        int width;
+    };
+
+    /*!
+     * \brief When the cache gets this big we throw it away and start over. Chat can say a lot of things
+     */
+    static const std::size_t MAX_CACHED_STRINGS = 1024;
+
+    texture_manager & textures;
+
+    unsigned char glyph_widths[256];
+
+    std::unordered_map<std::string, shaped_text> shaped_strings;
+
+    /*!
+     * \brief Returns the shaped version of the given text, shaping it if we haven't seen it before
+     */
+    const shaped_text & shape(const std::string & text);
+
+    /*!
+     * \brief Reads the next UTF-8 encoded character from the text and returns the glyph for it. Anything that isn't
+     * ASCII becomes a question mark
+     */
+    static unsigned char next_glyph(const std::string & text, std::size_t & pos);
+};
+
+#endif //RENDERER_TEXT_RENDERER_H
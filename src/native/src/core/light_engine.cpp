@@ -0,0 +1,526 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cstring>
+#include "light_engine.h"
+
+const int light_engine::SECTION_SIZE;
+const int light_engine::BLOCKS_PER_SECTION;
+const uint8_t light_engine::MAX_LIGHT;
+const uint32_t light_engine::MAX_BLOCK_IDS;
+
+/*!
+ * \brief What blocks we don't know about do to light. Most blocks are solid, so it's a good guess
+ */
+static const light_engine::block_light_properties UNKNOWN_BLOCK = {0, light_engine::MAX_LIGHT};
+
+/*!
+ * \brief Returns the index of a block on a face of a section. a and b go from 0 to 15 and pick the block on the face
+ */
+static uint16_t get_face_index(int face, int a, int b) {
+    switch(face) {
+        case 0:     // West, x = 0
+            return (uint16_t) (a * 16 + b * 256);
+        case 1:     // East, x = 15
+            return (uint16_t) (15 + a * 16 + b * 256);
+        case 2:     // Down, y = 0
+            return (uint16_t) (a + b * 16);
+        case 3:     // Up, y = 15
+            return (uint16_t) (a + b * 16 + 15 * 256);
+        case 4:     // North, z = 0
+            return (uint16_t) (a + b * 256);
+        default:    // South, z = 15
+            return (uint16_t) (a + 15 * 16 + b * 256);
+    }
+}
+
+/*!
+ * \brief Returns the direction that points back the other way. The directions come in pairs, so that's just flipping
+ * the lowest bit
+ */
+static int get_opposite(int travel) {
+    return travel ^ 1;
+}
+
+light_engine::light_engine(worker_pool * workers) : workers(workers) {
+    pthread_mutex_init(&pending_lock, nullptr);
+
+    for(block_light_properties & block : properties) {
+        block = UNKNOWN_BLOCK;
+    }
+    properties[0] = block_light_properties{0, 0};
+}
+
+light_engine::~light_engine() {
+    wait();
+    pthread_mutex_destroy(&pending_lock);
+}
+
+void light_engine::set_block_properties(uint32_t block_id, const block_light_properties & block_properties) {
+    request new_request;
+    new_request.request_type = request::SET_PROPERTIES;
+    new_request.value = block_id;
+    new_request.properties = block_properties;
+
+    pthread_mutex_lock(&pending_lock);
+    pending_requests.push_back(std::move(new_request));
+    pthread_mutex_unlock(&pending_lock);
+}
+
+void light_engine::add_section(const glm::ivec3 & section_position, const uint16_t * block_ids) {
+    // Copy the blocks here, so whoever called this can reuse their array right away
+    std::unique_ptr<section> new_section(new section());
+    new_section->position = section_position;
+    if(block_ids != nullptr) {
+        std::memcpy(new_section->blocks, block_ids, sizeof(new_section->blocks));
+    }
+
+    request new_request;
+    new_request.request_type = request::ADD_SECTION;
+    new_request.position = section_position;
+    new_request.new_section = std::move(new_section);
+
+    pthread_mutex_lock(&pending_lock);
+    pending_requests.push_back(std::move(new_request));
+    pthread_mutex_unlock(&pending_lock);
+}
+
+void light_engine::remove_section(const glm::ivec3 & section_position) {
+    request new_request;
+    new_request.request_type = request::REMOVE_SECTION;
+    new_request.position = section_position;
+
+    pthread_mutex_lock(&pending_lock);
+    pending_requests.push_back(std::move(new_request));
+    pthread_mutex_unlock(&pending_lock);
+}
+
+void light_engine::set_block(const glm::ivec3 & position, uint16_t block_id) {
+    request new_request;
+    new_request.request_type = request::SET_BLOCK;
+    new_request.position = position;
+    new_request.value = block_id;
+
+    pthread_mutex_lock(&pending_lock);
+    pending_requests.push_back(std::move(new_request));
+    pthread_mutex_unlock(&pending_lock);
+}
+
+void light_engine::update() {
+    if(is_busy()) {
+        return;
+    }
+
+    pthread_mutex_lock(&pending_lock);
+    const bool has_work = !pending_requests.empty();
+    pthread_mutex_unlock(&pending_lock);
+
+    if(!has_work) {
+        return;
+    }
+
+    if(workers == nullptr) {
+        process_requests();
+    } else {
+        workers->submit(run_job, this, &running_job);
+    }
+}
+
+void light_engine::wait() {
+    running_job.wait();
+}
+
+bool light_engine::is_busy() const {
+    return !running_job.is_done();
+}
+
+bool light_engine::take_changed_sections(std::vector<glm::ivec3> & out_sections) {
+    if(is_busy()) {
+        return false;
+    }
+
+    for(const glm::ivec3 & position : changed_sections) {
+        out_sections.push_back(position);
+
+        auto changed = sections.find(get_key(position));
+        if(changed != sections.end()) {
+            changed->second->changed = false;
+        }
+    }
+
+    changed_sections.clear();
+    return true;
+}
+
+uint8_t light_engine::get_light(const glm::ivec3 & position, channel light_channel) const {
+    auto owner = sections.find(get_key(glm::ivec3(position.x >> 4, position.y >> 4, position.z >> 4)));
+    if(owner == sections.end()) {
+        return 0;
+    }
+
+    const uint16_t index = (uint16_t) ((position.x & 15) + (position.z & 15) * 16 + (position.y & 15) * 256);
+    return get_level(*owner->second, index, light_channel);
+}
+
+glm::vec2 light_engine::get_lightmap(const glm::ivec3 & position) const {
+    return glm::vec2(get_light(position, BLOCK_LIGHT) / (float) MAX_LIGHT,
+                     get_light(position, SKY_LIGHT) / (float) MAX_LIGHT);
+}
+
+uint32_t light_engine::get_num_sections() const {
+    return (uint32_t) sections.size();
+}
+
+uint64_t light_engine::get_num_nodes_visited() const {
+    return num_nodes_visited;
+}
+
+uint64_t light_engine::get_key(const glm::ivec3 & section_position) {
+    // 21 bits per axis is way more than a Minecraft world needs
+    return ((uint64_t) (section_position.x & 0x1FFFFF) << 42) | ((uint64_t) (section_position.y & 0x1FFFFF) << 21) |
+           (uint64_t) (section_position.z & 0x1FFFFF);
+}
+
+void light_engine::run_job(void * engine) {
+    static_cast<light_engine *>(engine)->process_requests();
+}
+
+void light_engine::process_requests() {
+    pthread_mutex_lock(&pending_lock);
+    std::swap(pending_requests, working_requests);
+    pthread_mutex_unlock(&pending_lock);
+
+    // All the changes go into the same queues, so a bunch of changes in the same place get lit in one pass
+    for(request & current : working_requests) {
+        switch(current.request_type) {
+            case request::SET_PROPERTIES:
+                if(current.value < MAX_BLOCK_IDS) {
+                    properties[current.value] = current.properties;
+                }
+                break;
+
+            case request::ADD_SECTION: {
+                remove_section_now(current.position);
+
+                section * new_section = current.new_section.get();
+                sections.emplace(get_key(current.position), std::move(current.new_section));
+                link_section(new_section);
+
+                // The section under this one used to get sky light from the open sky. Now it gets it from this one
+                if(new_section->neighbors[DOWN] != nullptr) {
+                    relight_face(*new_section->neighbors[DOWN], UP, SKY_LIGHT);
+                }
+
+                for(int travel = 0; travel < NUM_DIRECTIONS; travel++) {
+                    section * neighbor = new_section->neighbors[travel];
+                    if(neighbor != nullptr) {
+                        spread_from_face(*neighbor, (direction) get_opposite(travel));
+                    }
+                }
+
+                for(uint16_t index = 0; index < BLOCKS_PER_SECTION; index++) {
+                    for(int light_channel = 0; light_channel < NUM_CHANNELS; light_channel++) {
+                        const uint8_t source = get_source_light(*new_section, index, (channel) light_channel);
+                        if(source > 0) {
+                            set_level(*new_section, index, (channel) light_channel, source);
+                            add_queues[light_channel].push_back(light_node{new_section, index, 0});
+                        }
+                    }
+                }
+                break;
+            }
+
+            case request::REMOVE_SECTION:
+                remove_section_now(current.position);
+                break;
+
+            case request::SET_BLOCK: {
+                const glm::ivec3 & position = current.position;
+                auto owner = sections.find(get_key(glm::ivec3(position.x >> 4, position.y >> 4, position.z >> 4)));
+                if(owner != sections.end()) {
+                    const uint16_t index = (uint16_t) ((position.x & 15) + (position.z & 15) * 16 +
+                                                       (position.y & 15) * 256);
+                    set_block_in_section(*owner->second, index, (uint16_t) current.value);
+                }
+                break;
+            }
+        }
+    }
+
+    propagate();
+    working_requests.clear();
+}
+
+void light_engine::remove_section_now(const glm::ivec3 & section_position) {
+    auto existing = sections.find(get_key(section_position));
+    if(existing == sections.end()) {
+        return;
+    }
+
+    // Anything still queued might point into the section, so finish it before the section goes away
+    propagate();
+
+    section * old_section = existing->second.get();
+    unlink_section(old_section);
+
+    // Whatever light came in through the section that's going away has to go too
+    for(int travel = 0; travel < NUM_DIRECTIONS; travel++) {
+        section * neighbor = old_section->neighbors[travel];
+        if(neighbor != nullptr) {
+            relight_face(*neighbor, (direction) get_opposite(travel), BLOCK_LIGHT);
+            relight_face(*neighbor, (direction) get_opposite(travel), SKY_LIGHT);
+        }
+    }
+
+    sections.erase(existing);
+}
+
+void light_engine::link_section(section * new_section) {
+    static const glm::ivec3 OFFSETS[NUM_DIRECTIONS] = {
+            glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+            glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0),
+            glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)
+    };
+
+    for(int travel = 0; travel < NUM_DIRECTIONS; travel++) {
+        auto neighbor = sections.find(get_key(new_section->position + OFFSETS[travel]));
+        if(neighbor != sections.end()) {
+            new_section->neighbors[travel] = neighbor->second.get();
+            neighbor->second->neighbors[get_opposite(travel)] = new_section;
+        }
+    }
+}
+
+void light_engine::unlink_section(section * old_section) {
+    // The old section remembers its neighbors, so they can be relit
+    for(int travel = 0; travel < NUM_DIRECTIONS; travel++) {
+        section * neighbor = old_section->neighbors[travel];
+        if(neighbor != nullptr) {
+            neighbor->neighbors[get_opposite(travel)] = nullptr;
+        }
+    }
+}
+
+void light_engine::set_block_in_section(section & owner, uint16_t index, uint16_t block_id) {
+    if(owner.blocks[index] == block_id) {
+        return;
+    }
+
+    owner.blocks[index] = block_id;
+
+    for(int light_channel = 0; light_channel < NUM_CHANNELS; light_channel++) {
+        // Remove the old light even if it was 0, since the removal fill is what tells the neighbors to light this
+        // block again if it lets more light through now
+        const uint8_t old_level = get_level(owner, index, (channel) light_channel);
+        set_level(owner, index, (channel) light_channel, 0);
+        removal_queues[light_channel].push_back(light_node{&owner, index, old_level});
+
+        const uint8_t source = get_source_light(owner, index, (channel) light_channel);
+        if(source > 0) {
+            set_level(owner, index, (channel) light_channel, source);
+            add_queues[light_channel].push_back(light_node{&owner, index, 0});
+        }
+    }
+}
+
+void light_engine::relight_face(section & owner, direction face, channel light_channel) {
+    for(int a = 0; a < SECTION_SIZE; a++) {
+        for(int b = 0; b < SECTION_SIZE; b++) {
+            const uint16_t index = get_face_index(face, a, b);
+
+            const uint8_t old_level = get_level(owner, index, light_channel);
+            if(old_level > 0) {
+                set_level(owner, index, light_channel, 0);
+                removal_queues[light_channel].push_back(light_node{&owner, index, old_level});
+            }
+
+            const uint8_t source = get_source_light(owner, index, light_channel);
+            if(source > 0) {
+                set_level(owner, index, light_channel, source);
+                add_queues[light_channel].push_back(light_node{&owner, index, 0});
+            }
+        }
+    }
+}
+
+void light_engine::spread_from_face(section & owner, direction face) {
+    for(int a = 0; a < SECTION_SIZE; a++) {
+        for(int b = 0; b < SECTION_SIZE; b++) {
+            const uint16_t index = get_face_index(face, a, b);
+
+            for(int light_channel = 0; light_channel < NUM_CHANNELS; light_channel++) {
+                if(get_level(owner, index, (channel) light_channel) > 0) {
+                    add_queues[light_channel].push_back(light_node{&owner, index, 0});
+                }
+            }
+        }
+    }
+}
+
+void light_engine::propagate() {
+    for(int light_channel = 0; light_channel < NUM_CHANNELS; light_channel++) {
+        // Removal first, since it finds more places that light has to spread from
+        propagate_removal((channel) light_channel);
+        propagate_add((channel) light_channel);
+    }
+}
+
+void light_engine::propagate_removal(channel light_channel) {
+    std::vector<light_node> & queue = removal_queues[light_channel];
+    std::vector<light_node> & add_queue = add_queues[light_channel];
+
+    // The queue grows while we go through it, so no references into it
+    for(std::size_t i = 0; i < queue.size(); i++) {
+        const light_node node = queue[i];
+
+        for(int travel = 0; travel < NUM_DIRECTIONS; travel++) {
+            section * neighbor;
+            uint16_t neighbor_index;
+            if(!get_neighbor(node.owner, node.index, (direction) travel, neighbor, neighbor_index)) {
+                continue;
+            }
+
+            const uint8_t neighbor_level = get_level(*neighbor, neighbor_index, light_channel);
+            if(neighbor_level == 0) {
+                continue;
+            }
+
+            // If the neighbor is dimmer, it could have been lit by this block, so it goes too. Full sky light going
+            // down is the exception, since it doesn't get dimmer
+            const bool lit_by_node = neighbor_level < node.level ||
+                                     (light_channel == SKY_LIGHT && travel == DOWN && node.level == MAX_LIGHT &&
+                                      neighbor_level == MAX_LIGHT);
+
+            if(lit_by_node) {
+                set_level(*neighbor, neighbor_index, light_channel, 0);
+                queue.push_back(light_node{neighbor, neighbor_index, neighbor_level});
+
+                const uint8_t source = get_source_light(*neighbor, neighbor_index, light_channel);
+                if(source > 0) {
+                    set_level(*neighbor, neighbor_index, light_channel, source);
+                    add_queue.push_back(light_node{neighbor, neighbor_index, 0});
+                }
+
+            } else {
+                // Lit by something else, so it can light up the blocks that were just made dark
+                add_queue.push_back(light_node{neighbor, neighbor_index, 0});
+            }
+        }
+    }
+
+    num_nodes_visited += queue.size();
+    queue.clear();
+}
+
+void light_engine::propagate_add(channel light_channel) {
+    std::vector<light_node> & queue = add_queues[light_channel];
+
+    for(std::size_t i = 0; i < queue.size(); i++) {
+        const light_node node = queue[i];
+        const uint8_t level = get_level(*node.owner, node.index, light_channel);
+        if(level <= 1) {
+            // Nothing left to give the neighbors
+            continue;
+        }
+
+        for(int travel = 0; travel < NUM_DIRECTIONS; travel++) {
+            section * neighbor;
+            uint16_t neighbor_index;
+            if(!get_neighbor(node.owner, node.index, (direction) travel, neighbor, neighbor_index)) {
+                continue;
+            }
+
+            const uint8_t new_level = get_propagated_light(level, (direction) travel,
+                                                           neighbor->blocks[neighbor_index], light_channel);
+            if(new_level > get_level(*neighbor, neighbor_index, light_channel)) {
+                set_level(*neighbor, neighbor_index, light_channel, new_level);
+                queue.push_back(light_node{neighbor, neighbor_index, 0});
+            }
+        }
+    }
+
+    num_nodes_visited += queue.size();
+    queue.clear();
+}
+
+uint8_t light_engine::get_source_light(const section & owner, uint16_t index, channel light_channel) const {
+    const uint16_t block_id = owner.blocks[index];
+
+    if(light_channel == BLOCK_LIGHT) {
+        return block_id < MAX_BLOCK_IDS ? properties[block_id].emission : UNKNOWN_BLOCK.emission;
+    }
+
+    // The top of a section with nothing above it is open to the sky
+    if((index >> 8) == SECTION_SIZE - 1 && owner.neighbors[UP] == nullptr) {
+        return get_propagated_light(MAX_LIGHT, DOWN, block_id, SKY_LIGHT);
+    }
+
+    return 0;
+}
+
+uint8_t light_engine::get_propagated_light(uint8_t level, direction travel, uint16_t block_id,
+                                           channel light_channel) const {
+    const uint8_t opacity = block_id < MAX_BLOCK_IDS ? properties[block_id].opacity : UNKNOWN_BLOCK.opacity;
+    if(opacity >= MAX_LIGHT) {
+        return 0;
+    }
+
+    if(light_channel == SKY_LIGHT && travel == DOWN && level == MAX_LIGHT && opacity == 0) {
+        return MAX_LIGHT;
+    }
+
+    const uint8_t attenuation = opacity > 1 ? opacity : (uint8_t) 1;
+    return level > attenuation ? (uint8_t) (level - attenuation) : (uint8_t) 0;
+}
+
+bool light_engine::get_neighbor(section * owner, uint16_t index, direction travel, section *& neighbor,
+                                uint16_t & neighbor_index) {
+    const int x = index & 15;
+    const int z = (index >> 4) & 15;
+    const int y = index >> 8;
+
+    switch(travel) {
+        case WEST:
+            neighbor = x > 0 ? owner : owner->neighbors[WEST];
+            neighbor_index = (uint16_t) (x > 0 ? index - 1 : index + 15);
+            break;
+        case EAST:
+            neighbor = x < 15 ? owner : owner->neighbors[EAST];
+            neighbor_index = (uint16_t) (x < 15 ? index + 1 : index - 15);
+            break;
+        case DOWN:
+            neighbor = y > 0 ? owner : owner->neighbors[DOWN];
+            neighbor_index = (uint16_t) (y > 0 ? index - 256 : index + 15 * 256);
+            break;
+        case UP:
+            neighbor = y < 15 ? owner : owner->neighbors[UP];
+            neighbor_index = (uint16_t) (y < 15 ? index + 256 : index - 15 * 256);
+            break;
+        case NORTH:
+            neighbor = z > 0 ? owner : owner->neighbors[NORTH];
+            neighbor_index = (uint16_t) (z > 0 ? index - 16 : index + 15 * 16);
+            break;
+        default:
+            neighbor = z < 15 ? owner : owner->neighbors[SOUTH];
+            neighbor_index = (uint16_t) (z < 15 ? index + 16 : index - 15 * 16);
+            break;
+    }
+
+    return neighbor != nullptr;
+}
+
+uint8_t light_engine::get_level(const section & owner, uint16_t index, channel light_channel) {
+    const uint8_t both = owner.light[index];
+    return light_channel == BLOCK_LIGHT ? (uint8_t) (both & 0x0F) : (uint8_t) (both >> 4);
+}
+
+void light_engine::set_level(section & owner, uint16_t index, channel light_channel, uint8_t level) {
+    uint8_t & both = owner.light[index];
+    both = light_channel == BLOCK_LIGHT ? (uint8_t) ((both & 0xF0) | level) : (uint8_t) ((both & 0x0F) | (level << 4));
+
+    if(!owner.changed) {
+        owner.changed = true;
+        changed_sections.push_back(owner.position);
+    }
+}
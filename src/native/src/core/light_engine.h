@@ -0,0 +1,283 @@
+/*!
+ * \brief Defines a flood fill light engine for block light and sky light
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_LIGHT_ENGINE_H
+#define RENDERER_LIGHT_ENGINE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <pthread.h>
+#include <glm/glm.hpp>
+#include "utils/worker_pool.h"
+
+/*!
+ * \brief Figures out how much block light and sky light reaches every block, since Minecraft doesn't tell us
+ *
+ * The world is split into 16x16x16 sections, like Minecraft does. Each block gets one byte of light: the low four
+ * bits are block light and the high four bits are sky light, both from 0 to 15.
+ *
+ * Light spreads with two breadth-first flood fills per channel. When a block changes, the light it had is removed
+ * first: the removal fill zeroes every block that was only lit through it and remembers the blocks at the edge that
+ * are lit from somewhere else. Then the add fill spreads light back out from those edges and from any new light
+ * sources. Only the blocks that actually change get touched, so placing a torch costs about as much as the area it
+ * lights up, not the whole world.
+ *
+ * Light loses max(1, opacity) levels for every block it moves into, and opaque blocks (opacity 15) stop it. Sky light
+ * at full strength going straight down through a block with no opacity doesn't lose anything, which is what makes
+ * everything under open sky fully lit. Sky light comes in through the top of any section that doesn't have a section
+ * above it. Minecraft doesn't send empty sections, so add every section of a column from the top of the world down,
+ * using nullptr for the empty ones.
+ *
+ * Any thread can change blocks and sections. Changes are queued up, and #update hands them to a worker thread, which
+ * does all of the light work. Only read light (#get_light and friends) from the render thread, when #is_busy is false.
+ */
+class light_engine {
+public:
+    enum channel {
+        BLOCK_LIGHT = 0,
+        SKY_LIGHT = 1,
+        NUM_CHANNELS = 2,
+    };
+
+    /*!
+     * \brief How a type of block affects light
+     */
+    struct block_light_properties {
+        uint8_t emission;   //!< How much light the block gives off, from 0 to 15
+        uint8_t opacity;    //!< How much light the block takes away, from 0 to 15. 15 means it stops light completely
+    };
+
+    static const int SECTION_SIZE = 16;
+    static const int BLOCKS_PER_SECTION = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
+    static const uint8_t MAX_LIGHT = 15;
+
+    /*!
+     * \brief Block IDs only go this high. Anything higher is treated like stone
+     */
+    static const uint32_t MAX_BLOCK_IDS = 4096;
+
+    /*!
+     * \param workers The threads to light things on. If it's nullptr, #update does all the work right away
+     */
+    light_engine(worker_pool * workers);
+
+    /*!
+     * \brief Waits for any light work that's in progress
+     */
+    ~light_engine();
+
+    light_engine(const light_engine & other) = delete;
+    light_engine & operator=(const light_engine & other) = delete;
+
+    /*
+     * These can be called from any thread. Nothing happens until the next #update
+     */
+
+    /*!
+     * \brief Sets how a type of block affects light. Blocks that are already in the world aren't relit, so set these
+     * before adding any sections
+     *
+     * Until this is called for a block, air (ID 0) lets all light through and everything else blocks it
+     */
+    void set_block_properties(uint32_t block_id, const block_light_properties & properties);
+
+    /*!
+     * \brief Adds a section, or replaces the section that's there already
+     *
+     * \param section_position The section's position, in sections
+     * \param block_ids The ID of every block in the section, indexed by x + z * 16 + y * 256. nullptr means air
+     */
+    void add_section(const glm::ivec3 & section_position, const uint16_t * block_ids);
+
+    void remove_section(const glm::ivec3 & section_position);
+
+    /*!
+     * \brief Changes one block. Blocks in sections that aren't loaded are ignored
+     *
+     * \param position The block's position, in blocks
+     */
+    void set_block(const glm::ivec3 & position, uint16_t block_id);
+
+    /*
+     * Only call these from the render thread
+     */
+
+    /*!
+     * \brief Starts working on the changes since the last call, if the last batch of work is done
+     */
+    void update();
+
+    /*!
+     * \brief Waits until the light work that #update started is done
+     */
+    void wait();
+
+    bool is_busy() const;
+
+    /*!
+     * \brief Adds the position of every section whose light changed since the last call to sections. Those are the
+     * sections that need their lightmap UVs rebuilt
+     *
+     * \return False if the engine is busy. Nothing gets added then, so try again next frame
+     */
+    bool take_changed_sections(std::vector<glm::ivec3> & sections);
+
+    /*!
+     * \brief Returns how much light of a channel reaches a block. Blocks in sections that aren't loaded are dark
+     */
+    uint8_t get_light(const glm::ivec3 & position, channel light_channel) const;
+
+    /*!
+     * \brief Returns a block's light as the lightmap coordinates for terrain_vertex::pack: block light in x and sky
+     * light in y, both in [0, 1]
+     */
+    glm::vec2 get_lightmap(const glm::ivec3 & position) const;
+
+    uint32_t get_num_sections() const;
+
+    /*!
+     * \brief Returns how many blocks the flood fills have visited, for benchmarking
+     */
+    uint64_t get_num_nodes_visited() const;
+
+private:
+    enum direction {
+        WEST = 0,   //!< -x
+        EAST,       //!< +x
+        DOWN,       //!< -y
+        UP,         //!< +y
+        NORTH,      //!< -z
+        SOUTH,      //!< +z
+        NUM_DIRECTIONS
+    };
+
+    struct section {
+        glm::ivec3 position;
+        section * neighbors[NUM_DIRECTIONS] = {};
+        bool changed = false;
+
+        uint16_t blocks[BLOCKS_PER_SECTION];
+
+        /*!
+         * \brief Block light in the low four bits, sky light in the high four bits
+         */
+        uint8_t light[BLOCKS_PER_SECTION];
+    };
+
+    struct light_node {
+        section * owner;
+        uint16_t index;
+        uint8_t level;  //!< Only used for removal, where it's how bright the block was before it was removed
+    };
+
+    /*!
+     * \brief A change that's waiting for the next #update
+     */
+    struct request {
+        enum type {
+            SET_PROPERTIES,
+            ADD_SECTION,
+            REMOVE_SECTION,
+            SET_BLOCK,
+        };
+
+        type request_type;
+        glm::ivec3 position;
+        uint32_t value;
+        block_light_properties properties;
+        std::unique_ptr<section> new_section;
+    };
+
+    worker_pool * workers;
+
+    /*
+     * Anyone can add requests, so pending_requests is behind pending_lock. The worker swaps them into
+     * working_requests so it can work on them without holding the lock
+     */
+    pthread_mutex_t pending_lock;
+    std::vector<request> pending_requests;
+    std::vector<request> working_requests;
+
+    job_group running_job;
+
+    /*
+     * Everything below here is only touched by whoever is doing light work: the worker while a job is running, or the
+     * render thread when it isn't
+     */
+
+    block_light_properties properties[MAX_BLOCK_IDS];
+
+    std::unordered_map<uint64_t, std::unique_ptr<section>> sections;
+
+    std::vector<light_node> add_queues[NUM_CHANNELS];
+    std::vector<light_node> removal_queues[NUM_CHANNELS];
+
+    std::vector<glm::ivec3> changed_sections;
+
+    uint64_t num_nodes_visited = 0;
+
+    static uint64_t get_key(const glm::ivec3 & section_position);
+
+    static void run_job(void * engine);
+
+    void process_requests();
+
+    /*!
+     * \brief Takes a section out of the world right away, and relights the sections next to it
+     */
+    void remove_section_now(const glm::ivec3 & section_position);
+
+    void link_section(section * new_section);
+
+    void unlink_section(section * old_section);
+
+    void set_block_in_section(section & owner, uint16_t index, uint16_t block_id);
+
+    /*!
+     * \brief Throws away the light on one face of a section and lights it again from its neighbors
+     */
+    void relight_face(section & owner, direction face, channel light_channel);
+
+    /*!
+     * \brief Queues up every block on a section's face that has light, so the light spreads into whatever is next
+     * to it
+     */
+    void spread_from_face(section & owner, direction face);
+
+    /*!
+     * \brief Runs all the flood fills until every queue is empty
+     */
+    void propagate();
+
+    void propagate_removal(channel light_channel);
+
+    void propagate_add(channel light_channel);
+
+    /*!
+     * \brief Returns how much light a block makes by itself: its emission for block light, or the sky if it's at the
+     * top of a section with nothing above it
+     */
+    uint8_t get_source_light(const section & owner, uint16_t index, channel light_channel) const;
+
+    /*!
+     * \brief Returns how much light makes it into a block with the given ID, from a neighbor at the given level
+     */
+    uint8_t get_propagated_light(uint8_t level, direction travel, uint16_t block_id, channel light_channel) const;
+
+    /*!
+     * \brief Finds the block next to the given one. Returns false if it's in a section that isn't loaded
+     */
+    static bool get_neighbor(section * owner, uint16_t index, direction travel, section *& neighbor,
+                             uint16_t & neighbor_index);
+
+    static uint8_t get_level(const section & owner, uint16_t index, channel light_channel);
+
+    void set_level(section & owner, uint16_t index, channel light_channel, uint8_t level);
+};
+
+#endif //RENDERER_LIGHT_ENGINE_H
@@ -0,0 +1,138 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <sstream>
+#include <easylogging++.h>
+#include "material_store.h"
+#include "gl/gl_state_cache.h"
+
+const material_store::material_id material_store::INVALID_MATERIAL_ID;
+const GLuint material_store::MATERIAL_BUFFER_BINDING;
+const GLuint material_store::FALLBACK_TEXTURE_UNIT;
+
+static_assert(sizeof(material_store::gpu_material) == 16, "gpu_material has to match the std430 layout in the shader");
+
+material_store::material_store(unsigned int max_materials, int fallback_width, int fallback_height,
+                               bool force_fallback) :
+        max_materials(max_materials), fallback_width(fallback_width), fallback_height(fallback_height) {
+    bindless = texture2D::is_bindless_supported() && !force_fallback;
+
+    glCreateBuffers(1, &material_buffer);
+    glNamedBufferStorage(material_buffer, max_materials * sizeof(gpu_material), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    materials.reserve(max_materials);
+
+    if(bindless) {
+        LOG(INFO) << "Materials will use bindless textures";
+    } else {
+        LOG(INFO) << "Bindless textures aren't supported, so materials will use a " << fallback_width << "x"
+                  << fallback_height << " texture array";
+
+        fallback_textures = std::unique_ptr<texture2D_array>(new texture2D_array());
+        fallback_textures->allocate(fallback_width, fallback_height, (int) max_materials, GL_RGBA8);
+    }
+}
+
+material_store::~material_store() {
+    gl_state_cache::get().delete_buffers(1, &material_buffer);
+}
+
+material_store::material_id material_store::add_material(const unsigned char * rgba_data, int width, int height) {
+    if(materials.size() >= max_materials) {
+        LOG(ERROR) << "Can't add another material, all " << max_materials << " are taken";
+        return INVALID_MATERIAL_ID;
+    }
+
+    material_id id = (material_id) materials.size();
+    gpu_material material = {};
+
+    if(bindless) {
+        std::unique_ptr<texture2D> texture(new texture2D());
+        texture->set_data(rgba_data, width, height, width, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+
+        // The handle has to come after the data, since the texture can't change its storage once it has a handle
+        material.albedo_handle = texture->get_bindless_handle();
+        textures.push_back(std::move(texture));
+
+    } else {
+        if(width != fallback_width || height != fallback_height) {
+            LOG(ERROR) << "Material textures have to be " << fallback_width << "x" << fallback_height
+                       << " without bindless textures, but this one is " << width << "x" << height;
+            return INVALID_MATERIAL_ID;
+        }
+
+        fallback_textures->set_layer_data((int) id, rgba_data, width, GL_RGBA, GL_UNSIGNED_BYTE);
+        material.layer = id;
+    }
+
+    materials.push_back(material);
+    return id;
+}
+
+void material_store::upload() {
+    if(first_unuploaded_material == materials.size()) {
+        return;
+    }
+
+    // Materials never change once they're added, so only the new ones need to go up
+    unsigned int num_new_materials = (unsigned int) materials.size() - first_unuploaded_material;
+    glNamedBufferSubData(material_buffer, first_unuploaded_material * sizeof(gpu_material),
+                         num_new_materials * sizeof(gpu_material), &materials[first_unuploaded_material]);
+
+    first_unuploaded_material = (unsigned int) materials.size();
+}
+
+void material_store::bind() {
+    gl_state_cache::get().bind_buffer_base(GL_SHADER_STORAGE_BUFFER, MATERIAL_BUFFER_BINDING, material_buffer);
+
+    if(!bindless) {
+        fallback_textures->bind(GL_TEXTURE0 + FALLBACK_TEXTURE_UNIT);
+    }
+}
+
+bool material_store::uses_bindless_textures() const {
+    return bindless;
+}
+
+const texture2D_array * material_store::get_fallback_textures() const {
+    return fallback_textures.get();
+}
+
+unsigned int material_store::get_num_materials() const {
+    return (unsigned int) materials.size();
+}
+
+const material_store::gpu_material & material_store::get_material(material_id id) const {
+    return materials.at(id);
+}
+
+std::string material_store::get_glsl_declarations() const {
+    std::stringstream glsl;
+
+    if(bindless) {
+        glsl << "#extension GL_ARB_bindless_texture : require\n";
+    }
+
+    glsl << "struct nova_material {\n"
+         << "    uvec2 albedo_handle;\n"
+         << "    uint layer;\n"
+         << "    uint reserved;\n"
+         << "};\n"
+         << "layout(std430, binding = " << MATERIAL_BUFFER_BINDING << ") readonly buffer nova_materials {\n"
+         << "    nova_material materials[];\n"
+         << "};\n";
+
+    if(bindless) {
+        glsl << "vec4 sample_material(uint id, vec2 uv) {\n"
+             << "    return texture(sampler2D(materials[id].albedo_handle), uv);\n"
+             << "}\n";
+    } else {
+        glsl << "layout(binding = " << FALLBACK_TEXTURE_UNIT << ") uniform sampler2DArray nova_material_textures;\n"
+             << "vec4 sample_material(uint id, vec2 uv) {\n"
+             << "    return texture(nova_material_textures, vec3(uv, float(materials[id].layer)));\n"
+             << "}\n";
+    }
+
+    return glsl.str();
+}
@@ -0,0 +1,146 @@
+/*!
+ * \brief Defines a table of materials that shaders can index into, instead of binding a texture per draw
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_MATERIAL_STORE_H
+#define RENDERER_MATERIAL_STORE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "gl/objects/texture2D.h"
+#include "gl/objects/texture2D_array.h"
+
+/*!
+ * \brief Holds a bunch of textures that don't fit in an atlas, and a shader storage buffer that says where each one is
+ *
+ * Every mob type has its own skin, and every item icon is its own texture. If each one needed its own texture bind,
+ * every entity or icon would be its own draw. Instead, each texture becomes a material with a small integer ID. An
+ * instanced draw passes each instance's material ID along, and the shader looks the material up in the material
+ * buffer.
+ *
+ * How the shader gets from a material to a texture depends on the driver:
+ *  - With ARB_bindless_texture, every material's texture is its own texture2D, and the material buffer holds its
+ *  resident handle. Textures can be any size.
+ *  - Without it, every material's texture is a layer in one texture2D_array, which is bound to
+ *  #FALLBACK_TEXTURE_UNIT, and the material buffer holds the layer. Every texture has to be the size the store was
+ *  made with.
+ *
+ * Either way, #get_glsl_declarations gives you GLSL that declares the material buffer and a sample_material(id, uv)
+ * function, so shaders don't need to know which one they got.
+ *
+ * Like everything else that touches OpenGL, only make one of these once there's a context
+ */
+class material_store {
+public:
+    typedef unsigned int material_id;
+
+    static const material_id INVALID_MATERIAL_ID = 0xFFFFFFFF;
+
+    /*!
+     * \brief The shader storage buffer binding the material buffer is bound to
+     */
+    static const GLuint MATERIAL_BUFFER_BINDING = 4;
+
+    /*!
+     * \brief The texture unit that the fallback texture array is bound to
+     */
+    static const GLuint FALLBACK_TEXTURE_UNIT = 8;
+
+    /*!
+     * \brief What the material buffer holds for each material. Matches the std430 struct in #get_glsl_declarations
+     */
+    struct gpu_material {
+        GLuint64 albedo_handle;     //!< The bindless handle of the material's texture. 0 in the fallback
+        uint32_t layer;             //!< The layer of the fallback texture array. 0 with bindless textures
+        uint32_t reserved;
+    };
+
+    /*!
+     * \param max_materials The most materials this store can hold
+     * \param fallback_width The width of every texture, if bindless textures aren't supported
+     * \param fallback_height The height of every texture, if bindless textures aren't supported
+     * \param force_fallback Use the texture array even if bindless textures are supported. Mostly for testing
+     */
+    material_store(unsigned int max_materials, int fallback_width, int fallback_height, bool force_fallback = false);
+
+    /*!
+     * \brief Deletes the material buffer. The textures delete themselves
+     */
+    ~material_store();
+
+    // The material buffer belongs to exactly one store, so copies would delete it twice
+    material_store(const material_store & other) = delete;
+    material_store & operator=(const material_store & other) = delete;
+
+    /*!
+     * \brief Adds a material with the given RGBA8 texture
+     *
+     * \return The new material's ID, or INVALID_MATERIAL_ID if the store is full or the texture is the wrong size for
+     * the fallback
+     */
+    material_id add_material(const unsigned char * rgba_data, int width, int height);
+
+    /*!
+     * \brief Sends any materials added since the last upload to the material buffer
+     */
+    void upload();
+
+    /*!
+     * \brief Binds the material buffer, and the fallback texture array if we're using it
+     */
+    void bind();
+
+    /*!
+     * \brief Returns true if materials use bindless handles, false if they use the fallback texture array
+     */
+    bool uses_bindless_textures() const;
+
+    /*!
+     * \brief Returns the texture array that holds every material's texture, or nullptr if materials use bindless
+     * handles
+     */
+    const texture2D_array * get_fallback_textures() const;
+
+    unsigned int get_num_materials() const;
+
+    const gpu_material & get_material(material_id id) const;
+
+    /*!
+     * \brief Returns GLSL that declares the material buffer and a vec4 sample_material(uint id, vec2 uv) function
+     *
+     * The bindless version needs an #extension line, so put this right after the shader's #version line
+     */
+    std::string get_glsl_declarations() const;
+
+private:
+    unsigned int max_materials;
+    int fallback_width;
+    int fallback_height;
+    bool bindless;
+
+    GLuint material_buffer;
+
+    std::vector<gpu_material> materials;
+
+    /*!
+     * \brief The first material that isn't in the material buffer yet
+     */
+    unsigned int first_unuploaded_material = 0;
+
+    /*!
+     * \brief Each material's texture, when we're using bindless textures
+     */
+    std::vector<std::unique_ptr<texture2D>> textures;
+
+    /*!
+     * \brief Every material's texture, when we aren't
+     */
+    std::unique_ptr<texture2D_array> fallback_textures;
+};
+
+#endif //RENDERER_MATERIAL_STORE_H
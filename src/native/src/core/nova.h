@@ -34,6 +34,28 @@ NOVA_EXPORT void init_nova();
  */
 NOVA_EXPORT void add_texture(mc_atlas_texture & texture, int atlas_type, int texture_type);
 
+/*!
+ * \brief Adds a new texture to the Nova Renderer, uploading it directly from memory owned by the caller
+ *
+ * This is the fast path for textures. Java passes the address of a direct ByteBuffer and Nova hands that memory
+ * straight to OpenGL, so there's no copy into a JNA Memory and no conversion to floats. The buffer only needs to stay
+ * alive until this function returns.
+ *
+ * \param pixel_data The first byte of the texture data
+ * \param length The number of bytes available at pixel_data
+ * \param width The width of the texture, in pixels
+ * \param height The height of the texture, in pixels
+ * \param row_stride The number of bytes from the start of one row of pixels to the start of the next
+ * \param pixel_format How the bytes of each pixel are laid out. See \ref texture_manager::pixel_format
+ * \param atlas_type The atlas this texture is. See \ref texture_manager::atlas_type
+ * \param texture_type The kind of data in this texture. See \ref texture_manager::texture_type
+ *
+ * \return 1 if the texture was added, 0 if the parameters were invalid. This is an int rather than a bool because JNA
+ * reads a Java boolean return value as a whole int, and the upper bytes of a C++ bool's return register are garbage
+ */
+NOVA_EXPORT int add_texture_from_buffer(const unsigned char * pixel_data, int length, int width, int height,
+                                        int row_stride, int pixel_format, int atlas_type, int texture_type);
+
 /*!
  * \brief Adds the given location to the list of texture locations
  *
@@ -44,6 +66,21 @@ NOVA_EXPORT void add_texture(mc_atlas_texture & texture, int atlas_type, int tex
  */
 NOVA_EXPORT void add_texture_location(mc_texture_atlas_location location);
 
+/*!
+ * \brief Adds a whole atlas' worth of texture locations in one call
+ *
+ * The locations are copied right away, but they only show up in the texture manager at the start of the next frame,
+ * when the render thread adds them
+ *
+ * \param names The names of all the textures, each one followed by a null terminator
+ * \param names_length The size of names, in bytes
+ * \param name_offsets The offset in names of each texture's name
+ * \param uv_rects Four floats for each texture: min_u, max_u, min_v, max_v
+ * \param count The number of textures
+ */
+NOVA_EXPORT void add_texture_locations(const char * names, int names_length, const int * name_offsets,
+                                       const float * uv_rects, int count);
+
 /*!
  * \brief Queries OpenGL and returns the maximum texture size that OpenGL allows
  */
@@ -76,11 +113,67 @@ NOVA_EXPORT void send_render_command(mc_render_command * command);
 NOVA_EXPORT bool should_close();
 
 /*!
- * \brief Sets the GUI screen that Nova should render
+ * \brief Tells Nova how wide each glyph in the font is, so it can lay out text the same way Minecraft does
+ *
+ * \param widths The width of each glyph, in GUI pixels, indexed by character
+ * \param count The number of widths. Should be 256. If it's 0 or less, or widths is null, the old widths are kept
+ */
+NOVA_EXPORT void set_font_glyph_widths(const unsigned char * widths, int count);
+
+/*!
+ * \brief Returns the shared memory that Java writes commands into
  *
- * \param set_gui_screen The command to set the GUI screen
+ * Java should wrap this in a direct ByteBuffer of get_command_ring_size() bytes. The memory starts with a header that
+ * says where the data area is and how big it is. See \ref command_ring for the full story and \ref ring_command_type
+ * for how each command is encoded
+ */
+NOVA_EXPORT void * get_command_ring();
+
+/*!
+ * \brief Returns the size, in bytes, of the memory returned by get_command_ring()
+ */
+NOVA_EXPORT int get_command_ring_size();
+
+/*!
+ * \brief Tells Nova that Java has written commands into the command ring
+ *
+ * Call this once per frame, after writing all of that frame's commands. It's the only JNA call needed to send them
+ *
+ * \param write_position The position just past the last command Java wrote
+ * \return The position Nova has read up to. Everything before it can be overwritten
+ */
+NOVA_EXPORT unsigned int ring_command_doorbell(unsigned int write_position);
+
+/*!
+ * \brief Tells Nova how each type of block affects light, so the light engine matches Minecraft
+ *
+ * Call this before adding any chunk sections, since blocks that are already loaded aren't relit
+ *
+ * \param emissions How much light each block gives off, from 0 to 15, indexed by block ID
+ * \param opacities How much light each block takes away, from 0 to 15, indexed by block ID
+ * \param count How many blocks there are. This can't be more than light_engine::MAX_BLOCK_IDS
+ */
+NOVA_EXPORT void set_block_light_properties(const unsigned char * emissions, const unsigned char * opacities, int count);
+
+/*!
+ * \brief Gives the light engine a 16x16x16 section of blocks, or replaces the one that's there
+ *
+ * Add the sections of a column from the top down, so sky light doesn't get let in and then taken away again
+ *
+ * \param x The section's x position, in sections
+ * \param y The section's y position, in sections
+ * \param z The section's z position, in sections
+ * \param block_ids The ID of each block, indexed by x + z * 16 + y * 256. There have to be all 4096 of them, even
+ * if the section is all air
+ */
+NOVA_EXPORT void add_chunk_section(int x, int y, int z, const unsigned short * block_ids);
+
+NOVA_EXPORT void remove_chunk_section(int x, int y, int z);
+
+/*!
+ * \brief Tells the light engine that a block changed. The position is in blocks
  */
-NOVA_EXPORT void send_change_gui_screen_command(mc_set_gui_screen_command * set_gui_screen);
+NOVA_EXPORT void set_block(int x, int y, int z, int block_id);
 
 };  // End extern C
     // I don't like doing this, but I just saw this closing curly brace and freaked out a little bit.
@@ -9,6 +9,7 @@
  * \author David
  */
 
+#include <easylogging++.h>
 #include "nova.h"
 #include "nova_renderer.h"
 
@@ -26,6 +27,17 @@ NOVA_EXPORT void add_texture(mc_atlas_texture & texture, int atlas_type, int tex
     );
 }
 
+NOVA_EXPORT int add_texture_from_buffer(const unsigned char * pixel_data, int length, int width, int height,
+                                        int row_stride, int pixel_format, int atlas_type, int texture_type) {
+    bool added = TEXTURE_MANAGER.add_texture(
+            pixel_data, length, width, height, row_stride,
+            static_cast<texture_manager::pixel_format>(pixel_format),
+            static_cast<texture_manager::atlas_type>(atlas_type),
+            static_cast<texture_manager::texture_type>(texture_type)
+    );
+    return added ? 1 : 0;
+}
+
 NOVA_EXPORT void reset_texture_manager() {
     TEXTURE_MANAGER.reset();
 }
@@ -34,6 +46,12 @@ NOVA_EXPORT void add_texture_location(mc_texture_atlas_location location) {
     TEXTURE_MANAGER.add_texture_location(location);
 }
 
+NOVA_EXPORT void add_texture_locations(const char * names, int names_length, const int * name_offsets,
+                                       const float * uv_rects, int count) {
+    // Java sends these from its own thread, so they wait for the render thread to add them
+    TEXTURE_MANAGER.queue_texture_locations(names, names_length, name_offsets, uv_rects, count);
+}
+
 NOVA_EXPORT int get_max_texture_size() {
     return TEXTURE_MANAGER.get_max_texture_size();
 }
@@ -47,6 +65,53 @@ NOVA_EXPORT bool should_close() {
     return nova_renderer::instance->should_end();
 }
 
-NOVA_EXPORT void send_change_gui_screen_command(mc_set_gui_screen_command * set_gui_screen) {
-    nova_renderer::instance->get_gui_renderer().set_current_screen(&set_gui_screen->screen);
+NOVA_EXPORT void set_font_glyph_widths(const unsigned char * widths, int count) {
+    nova_renderer::instance->get_gui_renderer().set_glyph_widths(widths, count);
+}
+
+NOVA_EXPORT void * get_command_ring() {
+    return nova_renderer::instance->get_command_ring().get_memory();
+}
+
+NOVA_EXPORT int get_command_ring_size() {
+    return (int) nova_renderer::instance->get_command_ring().get_memory_size();
+}
+
+NOVA_EXPORT unsigned int ring_command_doorbell(unsigned int write_position) {
+    return nova_renderer::instance->get_command_ring().ring_doorbell(write_position);
+}
+
+NOVA_EXPORT void set_block_light_properties(const unsigned char * emissions, const unsigned char * opacities, int count) {
+    if(emissions == nullptr || opacities == nullptr) {
+        LOG(ERROR) << "Can't set block light properties without both the emissions and the opacities";
+        return;
+    }
+
+    if(count <= 0 || (uint32_t) count > light_engine::MAX_BLOCK_IDS) {
+        LOG(ERROR) << "Can't set the light properties of " << count << " blocks, it has to be between 1 and "
+                   << light_engine::MAX_BLOCK_IDS;
+        return;
+    }
+
+    light_engine & lighting = nova_renderer::instance->get_light_engine();
+    for(int i = 0; i < count; i++) {
+        lighting.set_block_properties((uint32_t) i, {emissions[i], opacities[i]});
+    }
+}
+
+NOVA_EXPORT void add_chunk_section(int x, int y, int z, const unsigned short * block_ids) {
+    if(block_ids == nullptr) {
+        LOG(ERROR) << "Chunk section (" << x << ", " << y << ", " << z << ") doesn't have any blocks, so it wasn't added";
+        return;
+    }
+
+    nova_renderer::instance->get_light_engine().add_section(glm::ivec3(x, y, z), block_ids);
+}
+
+NOVA_EXPORT void remove_chunk_section(int x, int y, int z) {
+    nova_renderer::instance->get_light_engine().remove_section(glm::ivec3(x, y, z));
+}
+
+NOVA_EXPORT void set_block(int x, int y, int z, int block_id) {
+    nova_renderer::instance->get_light_engine().set_block(glm::ivec3(x, y, z), (uint16_t) block_id);
 }
@@ -5,10 +5,17 @@
 #include "nova_renderer.h"
 
 #include <easylogging++.h>
+#include "utils/async_log.h"
+#include "gl/gl_state_cache.h"
 
 INITIALIZE_EASYLOGGINGPP
 
 std::unique_ptr<nova_renderer> nova_renderer::instance;
+
+/*!
+ * \brief How big each frame's arena starts out. It grows if a frame needs more
+ */
+static const std::size_t FRAME_ARENA_SIZE = 1024 * 1024;
 pthread_t nova_renderer::render_thread;
 
 void * run_render(void * ignored) {
@@ -21,17 +28,29 @@ void * run_render(void * ignored) {
     return nullptr;
 }
 
-nova_renderer::nova_renderer() : gui_renderer_instance(tex_manager, shaders, ubo_manager), nova_config("config/config.json") {
+nova_renderer::nova_renderer() : gui_renderer_instance(tex_manager, shaders, ubo_manager), nova_config("config/config.json"),
+                                 frame_memory(FRAME_ARENA_SIZE), translucent_faces(&workers),
+                                 translucent_oit(shaders), lighting(&workers),
+                                 last_render_command() {
 
-    nova_config.register_change_listener(&game_window);
-    nova_config.register_change_listener(&shaders);
-    nova_config.register_change_listener(&ubo_manager);
+    // Each subsystem only hears about the settings it uses, so changing one setting doesn't make everything redo
+    // all its work
+    nova_config.register_change_listener(&game_window, {"/viewWidth", "/viewHeight"});
+    nova_config.register_change_listener(&shaders, {"/loadedShaderpack"});
+    nova_config.register_change_listener(&ubo_manager, {"/viewWidth", "/viewHeight"});
+    nova_config.register_change_listener(&translucent_oit, {"/transparencyMode", "/viewWidth", "/viewHeight"});
+    nova_config.register_change_listener(&shadows, {"/shadowMapResolution"});
 
     nova_config.update_config_loaded();
     nova_config.update_config_changed();
 
     shaders.link_up_uniform_buffers(ubo_manager);
 
+    // Vanilla skins are 64x64 and item icons are 16x16. GL 4.5 guarantees at least 2048 array layers, which is what
+    // the fallback needs
+    entity_materials = std::unique_ptr<material_store>(new material_store(256, 64, 64));
+    item_icon_materials = std::unique_ptr<material_store>(new material_store(2048, 16, 16));
+
     enable_debug();
 
     glClearColor(0.0, 0.0, 0.0, 1.0);
@@ -39,18 +58,75 @@ nova_renderer::nova_renderer() : gui_renderer_instance(tex_manager, shaders, ubo
 
 nova_renderer::~nova_renderer() {
     game_window.destroy();
+
+    // Make sure the last few messages make it out before the process goes away
+    async_log::flush();
 }
 
 void nova_renderer::render_frame() {
+    // Everything the frame from FRAMES_IN_FLIGHT frames ago allocated goes away here
+    frame_memory.begin_frame();
+    const frame_arenas::frame_stats & last_frame = frame_memory.get_last_frame_stats();
+    NOVA_LOG_TRACE("Last frame used {} bytes of its arena, which went to the heap {} times. The render thread made {} "
+                   "heap allocations", last_frame.arena_bytes_used, last_frame.arena_heap_allocations,
+                   last_frame.heap_allocations);
+
+    // Pick up any shaders that the shaderpack author changed since the last frame
+    shaders.reload_changed_programs();
+
+    // Handle everything Minecraft sent us since the last frame
+    commands.process_commands(*this);
+    tex_manager.add_queued_texture_locations();
+
+    // Start lighting whatever blocks changed. When chunks get meshed here, they'll rebuild the sections from
+    // take_changed_sections and put get_lightmap into each terrain_vertex
+    lighting.update();
+
     // Clear to the clear color
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Render GUI to GUI buffer
+    // Send any materials that showed up since the last frame
+    entity_materials->upload();
+    item_icon_materials->upload();
+
+    // Render GUI to GUI buffer, after re-uploading whatever changed since the last screen
+    gui_renderer_instance.update();
     gui_renderer_instance.render();
 
+    // Send the block light clusters over whenever they change. Minecraft doesn't send the camera's rotation yet, so
+    // whatever renders the world calls build() with the real camera, and this uploads what it made. Until then there's
+    // nothing to send
+    if(block_lights.has_clusters()) {
+        block_lights.upload();
+        block_lights.bind();
+    }
+
+    // The shadow pass goes here once there are chunks to draw: begin_cascade for each cascade, draw its casters, then
+    // end_shadow_pass. Until then there's nothing to put in the shadow map, so there's no sense clearing it
+
     // Render solid geometry
     // Render entities
-    // Render transparent things
+    // Render transparent things. With OIT they can go in any order, otherwise put them in order for wherever the
+    // camera is now
+    if(translucent_oit.is_enabled()) {
+        // With nothing translucent there's no sense clearing and blending two window-sized targets
+        if(translucent_faces.get_num_faces() > 0) {
+            translucent_oit.begin_translucent_pass();
+            // Render the translucent chunks
+            const glm::vec2 window_size = game_window.get_size();
+            translucent_oit.composite((GLsizei) window_size.x, (GLsizei) window_size.y);
+        }
+
+    } else {
+        const mc_render_world_params & world = last_render_command.render_world_params;
+        const uint32_t num_sorted = translucent_faces.sort(glm::dvec3(world.camera_x, world.camera_y, world.camera_z));
+        NOVA_LOG_TRACE("Sorted the translucent faces of {} chunks", num_sorted);
+    }
+
+    gl_state_cache & state = gl_state_cache::get();
+    NOVA_LOG_TRACE("Frame made {} GL state changes and skipped {}", state.get_counters().issued,
+                   state.get_counters().elided);
+    state.reset_counters();
 
     game_window.end_frame();
 }
@@ -81,7 +157,67 @@ gui_renderer & nova_renderer::get_gui_renderer() {
    return gui_renderer_instance;
 }
 
-std::string translate_debug_source(GLenum source) {
+command_ring & nova_renderer::get_command_ring() {
+    return commands;
+}
+
+material_store & nova_renderer::get_entity_materials() {
+    return *entity_materials;
+}
+
+material_store & nova_renderer::get_item_icon_materials() {
+    return *item_icon_materials;
+}
+
+frame_arena & nova_renderer::get_frame_arena() {
+    return frame_memory.get_current();
+}
+
+const frame_arenas::frame_stats & nova_renderer::get_last_frame_stats() const {
+    return frame_memory.get_last_frame_stats();
+}
+
+worker_pool & nova_renderer::get_workers() {
+    return workers;
+}
+
+translucency_sorter & nova_renderer::get_translucency_sorter() {
+    return translucent_faces;
+}
+
+weighted_blended_oit & nova_renderer::get_translucent_oit() {
+    return translucent_oit;
+}
+
+light_engine & nova_renderer::get_light_engine() {
+    return lighting;
+}
+
+clustered_lights & nova_renderer::get_block_lights() {
+    return block_lights;
+}
+
+chunk_bounds & nova_renderer::get_chunk_bounds() {
+    return chunks;
+}
+
+shadow_cascades & nova_renderer::get_shadows() {
+    return shadows;
+}
+
+void nova_renderer::on_set_gui_screen(mc_gui_screen & screen) {
+    gui_renderer_instance.set_current_screen(&screen);
+}
+
+void nova_renderer::on_render(mc_render_command & command) {
+    last_render_command = command;
+}
+
+void nova_renderer::on_add_texture_location(mc_texture_atlas_location & location) {
+    tex_manager.add_texture_location(location);
+}
+
+const char * translate_debug_source(GLenum source) {
     switch(source) {
         case GL_DEBUG_SOURCE_API:
             return "API";
@@ -100,7 +236,7 @@ std::string translate_debug_source(GLenum source) {
     }
 }
 
-std::string translate_debug_type(GLenum type) {
+const char * translate_debug_type(GLenum type) {
     switch(type) {
         case GL_DEBUG_TYPE_ERROR:
             return "an error, probably from the API";
@@ -126,24 +262,26 @@ std::string translate_debug_type(GLenum type) {
 }
 
 void debug_logger(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar * message, const void * user_param) {
-    std::string source_name = translate_debug_source(source);
-    std::string type_name = translate_debug_type(type);
+    // Some drivers call this a lot, from whatever thread they feel like, so it only copies the message into the
+    // async log. The logging thread does the formatting
+    const char * source_name = translate_debug_source(source);
+    const char * type_name = translate_debug_type(type);
 
     switch(severity) {
         case GL_DEBUG_SEVERITY_HIGH:
-            LOG(ERROR) << id << " - Message from " << source_name << " of type " << type_name << ": " << message;
+            NOVA_LOG_ERROR("{} - Message from {} of type {}: {}", id, source_name, type_name, message);
             break;
         case GL_DEBUG_SEVERITY_MEDIUM:
-            LOG(INFO) << id << " - Message from " << source_name << " of type " << type_name << ": " << message;
+            NOVA_LOG_INFO("{} - Message from {} of type {}: {}", id, source_name, type_name, message);
             break;
         case GL_DEBUG_SEVERITY_LOW:
-            LOG(DEBUG)<< id << " - Message from " << source_name << " of type " << type_name << ": " << message;
+            NOVA_LOG_DEBUG("{} - Message from {} of type {}: {}", id, source_name, type_name, message);
             break;
         case GL_DEBUG_SEVERITY_NOTIFICATION:
-            LOG(TRACE)<< id << " - Message from " << source_name << " of type " << type_name << ": " << message;
+            NOVA_LOG_TRACE("{} - Message from {} of type {}: {}", id, source_name, type_name, message);
             break;
         default:
-            LOG(INFO) << id << " - Message from " << source_name << " of type " << type_name << ": " << message;
+            NOVA_LOG_INFO("{} - Message from {} of type {}: {}", id, source_name, type_name, message);
     }
 }
 
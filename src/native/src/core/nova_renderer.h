@@ -13,10 +13,20 @@
 
 #include "nova.h"
 #include "texture_manager.h"
+#include "material_store.h"
 #include "gui/gui_renderer.h"
 #include "config/config.h"
 #include "shaderpack_loading/shaderpack.h"
 #include "uniform_buffer_store.h"
+#include "chunk_bounds.h"
+#include "clustered_lights.h"
+#include "command_ring.h"
+#include "light_engine.h"
+#include "shadow_cascades.h"
+#include "translucency_sorter.h"
+#include "weighted_blended_oit.h"
+#include "utils/frame_arena.h"
+#include "utils/worker_pool.h"
 #include "../gl/windowing/glfw_gl_window.h"
 
 /*!
@@ -34,7 +44,7 @@
  * flags that specify rendering commands are available. However, I'm using atomics for those, so I don't expect too many
  * problems. If I notice the renderer missing render commands, I'll re-evaluate the data integrity scheme
  */
-class nova_renderer {
+class nova_renderer : public iring_command_handler {
 public:
     /*!
      * \brief A singleton for the nova_renderer instance
@@ -104,6 +114,76 @@ public:
      */
     gui_renderer & get_gui_renderer();
 
+    /*!
+     * \brief Returns the ring that Java sends commands through
+     */
+    command_ring & get_command_ring();
+
+    /*!
+     * \brief Returns the materials for entity skins, which are 64x64 in the fallback
+     */
+    material_store & get_entity_materials();
+
+    /*!
+     * \brief Returns the materials for GUI item icons, which are 16x16 in the fallback
+     */
+    material_store & get_item_icon_materials();
+
+    /*!
+     * \brief Returns the arena for this frame. Anything that's only needed while building a frame (draw lists,
+     * visible chunks, sort keys) should be allocated from here, not the heap
+     */
+    frame_arena & get_frame_arena();
+
+    const frame_arenas::frame_stats & get_last_frame_stats() const;
+
+    /*!
+     * \brief Returns the threads that do work off the render thread, like sorting
+     */
+    worker_pool & get_workers();
+
+    /*!
+     * \brief Returns the sorter that keeps translucent faces in back-to-front order. Chunks give it their translucent
+     * faces when they're built
+     */
+    translucency_sorter & get_translucency_sorter();
+
+    /*!
+     * \brief Returns the OIT render targets. They only exist when the settings ask for OIT
+     */
+    weighted_blended_oit & get_translucent_oit();
+
+    /*!
+     * \brief Returns the light engine. Chunk sections and block changes go in, and lightmap coordinates for each block
+     * come out
+     */
+    light_engine & get_light_engine();
+
+    /*!
+     * \brief Returns the block lights that get sorted into clusters for per-pixel lighting
+     */
+    clustered_lights & get_block_lights();
+
+    /*!
+     * \brief Returns the bounding boxes of every loaded chunk. Whatever loads and unloads chunks keeps this up to date
+     */
+    chunk_bounds & get_chunk_bounds();
+
+    /*!
+     * \brief Returns the sun's shadow cascades
+     */
+    shadow_cascades & get_shadows();
+
+    /*
+     * Inherited from iring_command_handler. Called on the render thread while the command ring is being processed
+     */
+
+    virtual void on_set_gui_screen(mc_gui_screen & screen);
+
+    virtual void on_render(mc_render_command & command);
+
+    virtual void on_add_texture_location(mc_texture_atlas_location & location);
+
 private:
     static pthread_t render_thread;
 
@@ -117,6 +197,36 @@ private:
 
     config nova_config;
 
+    command_ring commands;
+
+    // These need a GL context, so they're made once the window is open
+    std::unique_ptr<material_store> entity_materials;
+    std::unique_ptr<material_store> item_icon_materials;
+
+    /*!
+     * \brief Memory for things that only last a frame. Only the render thread touches this
+     */
+    frame_arenas frame_memory;
+
+    worker_pool workers;
+
+    translucency_sorter translucent_faces;
+
+    weighted_blended_oit translucent_oit;
+
+    light_engine lighting;
+
+    clustered_lights block_lights;
+
+    chunk_bounds chunks;
+
+    shadow_cascades shadows;
+
+    /*!
+     * \brief The most recent render command Minecraft sent us
+     */
+    mc_render_command last_render_command;
+
     void enable_debug();
 };
 
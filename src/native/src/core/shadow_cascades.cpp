@@ -0,0 +1,377 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cmath>
+#include <sstream>
+#include "shadow_cascades.h"
+#include "gl/gl_state_cache.h"
+#include "utils/async_log.h"
+
+const uint32_t shadow_cascades::NUM_CASCADES;
+const float shadow_cascades::SPLIT_LAMBDA = 0.75f;
+const float shadow_cascades::CASTER_DISTANCE = 256.0f;
+const float shadow_cascades::SUN_ANGLE_TOLERANCE = 0.005f;
+const float shadow_cascades::CASTER_CELL_FRACTION = 0.25f;
+const GLenum shadow_cascades::DEPTH_FORMAT = GL_DEPTH_COMPONENT32F;
+const GLuint shadow_cascades::CASCADE_BUFFER_BINDING;
+const GLuint shadow_cascades::SHADOW_MAP_TEXTURE_UNIT;
+
+static_assert(sizeof(glm::mat4) == 64, "The cascade buffer has to match the std430 layout in the shader");
+
+shadow_cascades::shadow_cascades() : gpu_data() {
+    for(cascade & current : cascades) {
+        current.split_near = 0;
+        current.split_far = 0;
+        current.radius = 0;
+        current.texel_size = 0;
+        current.view = glm::mat4(1.0f);
+        current.projection = glm::mat4(1.0f);
+        current.view_projection = glm::mat4(1.0f);
+    }
+}
+
+shadow_cascades::~shadow_cascades() {
+    if(cascade_buffer != 0) {
+        gl_state_cache::get().delete_buffers(1, &cascade_buffer);
+    }
+}
+
+std::vector<float> shadow_cascades::compute_splits(float near_plane, float far_plane) {
+    std::vector<float> splits(NUM_CASCADES + 1);
+
+    // Logarithmic splits give every cascade the same texels per pixel, but make the first one tiny. Blending in some
+    // even splits gives it a more useful size
+    for(uint32_t i = 0; i <= NUM_CASCADES; i++) {
+        const float fraction = (float) i / NUM_CASCADES;
+        const float logarithmic = near_plane * std::pow(far_plane / near_plane, fraction);
+        const float even = near_plane + (far_plane - near_plane) * fraction;
+        splits[i] = SPLIT_LAMBDA * logarithmic + (1.0f - SPLIT_LAMBDA) * even;
+    }
+
+    // The blend can be a hair off at the ends
+    splits[0] = near_plane;
+    splits[NUM_CASCADES] = far_plane;
+
+    return splits;
+}
+
+void shadow_cascades::update(const camera & view_camera, const glm::vec3 & sun_direction, const chunk_bounds & chunks) {
+    const glm::vec3 sun = glm::normalize(sun_direction);
+    const light_basis basis = make_light_basis(sun);
+
+    // Every list is stale if the sun moved too far or the chunks changed. Otherwise they're only stale if their
+    // cascade moved to another cell
+    const bool sun_moved = !caster_caches[0].valid || glm::dot(sun, caster_sun_direction) < std::cos(SUN_ANGLE_TOLERANCE);
+    const bool chunks_changed = chunks.get_generation() != caster_chunk_generation;
+    if(sun_moved) {
+        caster_sun_direction = sun;
+        caster_basis = basis;
+    }
+
+    if(sun_moved || chunks_changed) {
+        caster_chunk_generation = chunks.get_generation();
+        for(caster_cache & cache : caster_caches) {
+            cache.valid = false;
+        }
+    }
+
+    const std::vector<float> splits = compute_splits(view_camera.near_plane, view_camera.far_plane);
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        cascade & current = cascades[i];
+        current.split_near = splits[i];
+        current.split_far = splits[i + 1];
+
+        float radius;
+        const float center_distance = fit_sphere(view_camera, current.split_near, current.split_far, radius);
+        const glm::vec3 center = view_camera.position + view_camera.forward * center_distance;
+        place_cascade(current, basis, center, radius);
+
+        caster_cache & cache = caster_caches[i];
+        const glm::ivec3 cell = get_caster_cell(center, radius);
+        if(!cache.valid || cache.cell != cell || cache.radius != radius) {
+            find_casters(current, cell, chunks);
+
+            cache.valid = true;
+            cache.cell = cell;
+            cache.radius = radius;
+            num_caster_rebuilds++;
+        }
+
+        gpu_data.view_projections[i] = current.view_projection;
+        gpu_data.split_fars[i] = current.split_far;
+    }
+
+    updated = true;
+}
+
+shadow_cascades::light_basis shadow_cascades::make_light_basis(const glm::vec3 & sun_direction) {
+    // The sun goes around the z axis, so z is always sideways to it and the basis doesn't spin as the day goes on.
+    // It only needs something else if the sun is ever pointing along z
+    const glm::vec3 reference = std::abs(sun_direction.z) > 0.99f ? glm::vec3(0, 1, 0) : glm::vec3(0, 0, 1);
+
+    light_basis basis;
+    basis.back = -sun_direction;
+    basis.right = glm::normalize(glm::cross(reference, basis.back));
+    basis.up = glm::cross(basis.back, basis.right);
+    return basis;
+}
+
+float shadow_cascades::fit_sphere(const camera & view_camera, float split_near, float split_far, float & radius) {
+    // The slice's corners are at (+-d * tan_x, +-d * tan_y, d) for both split distances d. The center that's equally
+    // far from the near and far corners is on the view axis at (near + far) * (1 + k^2) / 2, where k is how far the
+    // corners are off the axis per unit of distance. That only depends on the splits and the field of view, so the
+    // sphere doesn't change size when the camera turns
+    const float tan_y = std::tan(view_camera.vertical_fov * 0.5f);
+    const float corner_slope_squared = tan_y * tan_y * (1.0f + view_camera.aspect * view_camera.aspect);
+
+    float center_distance = (split_near + split_far) * (1.0f + corner_slope_squared) * 0.5f;
+    if(center_distance > split_far) {
+        center_distance = split_far;
+    }
+
+    const float far_offset = split_far - center_distance;
+    radius = std::sqrt(far_offset * far_offset + split_far * split_far * corner_slope_squared);
+
+    // Round up a bit, so floating point noise can't make it a tiny bit different from one frame to the next
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    return center_distance;
+}
+
+void shadow_cascades::place_cascade(cascade & current, const light_basis & basis, const glm::vec3 & center,
+                                   float radius) {
+    // The projection is a texel wider than the sphere on each side, so snapping can't push any of the sphere off it
+    current.radius = radius;
+    current.texel_size = 2.0f * radius / (resolution - 2);
+    const float half_width = current.texel_size * resolution * 0.5f;
+
+    // Only ever move the cascade by whole texels, so every texel keeps covering the same part of the world
+    const float center_x = std::floor(glm::dot(basis.right, center) / current.texel_size) * current.texel_size;
+    const float center_y = std::floor(glm::dot(basis.up, center) / current.texel_size) * current.texel_size;
+
+    // The eye is out towards the sun, far enough that everything up to CASTER_DISTANCE away from the sphere is in front
+    // of it
+    const float eye_z = glm::dot(basis.back, center) + radius + CASTER_DISTANCE;
+
+    glm::mat4 view(1.0f);
+    view[0][0] = basis.right.x;
+    view[1][0] = basis.right.y;
+    view[2][0] = basis.right.z;
+    view[3][0] = -center_x;
+    view[0][1] = basis.up.x;
+    view[1][1] = basis.up.y;
+    view[2][1] = basis.up.z;
+    view[3][1] = -center_y;
+    view[0][2] = basis.back.x;
+    view[1][2] = basis.back.y;
+    view[2][2] = basis.back.z;
+    view[3][2] = -eye_z;
+
+    // glm::ortho(-half_width, half_width, -half_width, half_width, 0, depth), written out so it's obvious nothing else
+    // is in there
+    const float depth = CASTER_DISTANCE + 2.0f * radius;
+    glm::mat4 projection(1.0f);
+    projection[0][0] = 1.0f / half_width;
+    projection[1][1] = 1.0f / half_width;
+    projection[2][2] = -2.0f / depth;
+    projection[3][2] = -1.0f;
+
+    current.view = view;
+    current.projection = projection;
+    current.view_projection = projection * view;
+}
+
+glm::ivec3 shadow_cascades::get_caster_cell(const glm::vec3 & center, float radius) const {
+    const float cell_size = radius * CASTER_CELL_FRACTION;
+    return glm::ivec3((int) std::floor(glm::dot(caster_basis.right, center) / cell_size),
+                      (int) std::floor(glm::dot(caster_basis.up, center) / cell_size),
+                      (int) std::floor(glm::dot(caster_basis.back, center) / cell_size));
+}
+
+void shadow_cascades::find_casters(cascade & current, const glm::ivec3 & cell, const chunk_bounds & chunks) {
+    const float radius = current.radius;
+    const float cell_size = radius * CASTER_CELL_FRACTION;
+    const glm::vec3 cell_center = (glm::vec3(cell) + glm::vec3(0.5f)) * cell_size;
+
+    // While this list is used, the cascade's sphere can be anywhere in the cell, and the projection reaches up to two
+    // texels past the sphere. The sun can also be up to SUN_ANGLE_TOLERANCE off from caster_basis, which swings the
+    // far ends of the cascade around its center by up to their distance times the angle
+    const float half_width = radius + 2.0f * current.texel_size;
+    const float farthest_point = std::sqrt(2.0f * half_width * half_width +
+                                           (radius + CASTER_DISTANCE) * (radius + CASTER_DISTANCE));
+    const float slack = cell_size * 0.5f + 2.0f * current.texel_size + farthest_point * SUN_ANGLE_TOLERANCE;
+
+    const glm::vec3 region_min = cell_center - glm::vec3(radius + slack);
+    glm::vec3 region_max = cell_center + glm::vec3(radius + slack);
+    region_max.z += CASTER_DISTANCE;
+
+    const glm::vec3 & right = caster_basis.right;
+    const glm::vec3 & up = caster_basis.up;
+    const glm::vec3 & back = caster_basis.back;
+
+    const std::vector<aabb> & boxes = chunks.get_boxes();
+    const std::vector<uint64_t> & ids = chunks.get_ids();
+
+    current.casters.clear();
+    for(uint32_t i = 0; i < boxes.size(); i++) {
+        const aabb & box = boxes[i];
+        const glm::vec3 center = (box.min + box.max) * 0.5f;
+        const glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+        // The box in light space is the center moved over, and the extents projected onto each light space axis
+        const float light_x = glm::dot(right, center);
+        const float extent_x = std::abs(right.x) * extent.x + std::abs(right.y) * extent.y + std::abs(right.z) * extent.z;
+        if(light_x + extent_x < region_min.x || light_x - extent_x > region_max.x) {
+            continue;
+        }
+
+        const float light_y = glm::dot(up, center);
+        const float extent_y = std::abs(up.x) * extent.x + std::abs(up.y) * extent.y + std::abs(up.z) * extent.z;
+        if(light_y + extent_y < region_min.y || light_y - extent_y > region_max.y) {
+            continue;
+        }
+
+        const float light_z = glm::dot(back, center);
+        const float extent_z = std::abs(back.x) * extent.x + std::abs(back.y) * extent.y + std::abs(back.z) * extent.z;
+        if(light_z + extent_z < region_min.z || light_z - extent_z > region_max.z) {
+            continue;
+        }
+
+        current.casters.push_back(ids[i]);
+    }
+}
+
+const shadow_cascades::cascade & shadow_cascades::get_cascade(uint32_t index) const {
+    return cascades[index];
+}
+
+uint64_t shadow_cascades::get_num_caster_rebuilds() const {
+    return num_caster_rebuilds;
+}
+
+bool shadow_cascades::resize(int resolution) {
+    if(!shadow_map) {
+        shadow_map = std::unique_ptr<texture2D_array>(new texture2D_array());
+        for(std::unique_ptr<gl_framebuffer> & framebuffer : framebuffers) {
+            framebuffer = std::unique_ptr<gl_framebuffer>(new gl_framebuffer());
+        }
+    }
+
+    shadow_map->allocate(resolution, resolution, NUM_CASCADES, DEPTH_FORMAT);
+
+    // Shaders get a sampler2DArrayShadow, which compares depths and filters the results
+    const GLuint texture = shadow_map->get_gl_name();
+    glTextureParameteri(texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTextureParameteri(texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Depth only, so nothing gets drawn to any color attachments
+    const GLenum no_draw_buffers[] = {GL_NONE};
+
+    enabled = true;
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        framebuffers[i]->attach_texture_layer(GL_DEPTH_ATTACHMENT, texture, (GLint) i);
+        framebuffers[i]->set_draw_buffers(1, no_draw_buffers);
+        enabled = framebuffers[i]->check_complete() && enabled;
+    }
+
+    if(!enabled) {
+        NOVA_LOG_ERROR("Can't render to a {}x{} shadow map, so there won't be any shadows", resolution, resolution);
+    }
+
+    // Texels are a different size now, so the cascades need to snap differently
+    this->resolution = resolution;
+    for(caster_cache & cache : caster_caches) {
+        cache.valid = false;
+    }
+
+    return enabled;
+}
+
+void shadow_cascades::release() {
+    for(std::unique_ptr<gl_framebuffer> & framebuffer : framebuffers) {
+        framebuffer.reset();
+    }
+
+    shadow_map.reset();
+    enabled = false;
+}
+
+bool shadow_cascades::is_ready() const {
+    return enabled && updated;
+}
+
+void shadow_cascades::begin_cascade(uint32_t index) {
+    gl_state_cache & state = gl_state_cache::get();
+    framebuffers[index]->bind();
+    state.set_viewport(0, 0, resolution, resolution);
+
+    const GLfloat farthest = 1.0f;
+    glClearNamedFramebufferfv(framebuffers[index]->get_gl_name(), GL_DEPTH, 0, &farthest);
+
+    state.set_blend_enabled(false);
+    state.set_depth_test_enabled(true);
+    state.set_depth_write_enabled(true);
+}
+
+void shadow_cascades::end_shadow_pass(GLsizei window_width, GLsizei window_height) {
+    gl_state_cache & state = gl_state_cache::get();
+    state.bind_framebuffer(0);
+    state.set_viewport(0, 0, window_width, window_height);
+
+    // Drawing the casters might have turned blending on, and nothing after this expects it to be on. Depth goes back
+    // off too, since begin_cascade turned it on and the window's framebuffer only gets its color cleared, so the GUI
+    // would fail the depth test
+    state.set_blend_enabled(false);
+    state.set_depth_test_enabled(false);
+    state.set_depth_write_enabled(false);
+
+    if(cascade_buffer == 0) {
+        glCreateBuffers(1, &cascade_buffer);
+        glNamedBufferStorage(cascade_buffer, sizeof(gpu_cascades), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    glNamedBufferSubData(cascade_buffer, 0, sizeof(gpu_cascades), &gpu_data);
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, CASCADE_BUFFER_BINDING, cascade_buffer);
+
+    shadow_map->bind(GL_TEXTURE0 + SHADOW_MAP_TEXTURE_UNIT);
+}
+
+texture2D_array * shadow_cascades::get_shadow_map() {
+    return shadow_map.get();
+}
+
+std::string shadow_cascades::get_glsl_declarations() {
+    std::stringstream glsl;
+
+    glsl << "layout(std430, binding = " << CASCADE_BUFFER_BINDING << ") readonly buffer nova_shadow_cascades {\n"
+         << "    mat4 nova_shadow_matrices[" << NUM_CASCADES << "];\n"
+         << "    float nova_cascade_splits[" << NUM_CASCADES << "];\n"
+         << "};\n"
+         << "layout(binding = " << SHADOW_MAP_TEXTURE_UNIT << ") uniform sampler2DArrayShadow nova_shadow_map;\n"
+         << "float nova_get_shadow(vec3 world_position, float view_depth) {\n"
+         << "    int cascade = 0;\n"
+         << "    while(cascade < " << NUM_CASCADES - 1 << " && view_depth > nova_cascade_splits[cascade]) {\n"
+         << "        cascade++;\n"
+         << "    }\n"
+         << "    vec3 coord = (nova_shadow_matrices[cascade] * vec4(world_position, 1.0)).xyz * 0.5 + 0.5;\n"
+         << "    return texture(nova_shadow_map, vec4(coord.xy, float(cascade), coord.z));\n"
+         << "}\n";
+
+    return glsl.str();
+}
+
+void shadow_cascades::on_config_change(const nova_settings & new_settings) {
+    if(!shadow_map || new_settings.shadow_map_resolution != resolution) {
+        resize(new_settings.shadow_map_resolution);
+        NOVA_LOG_INFO("Shadow cascades are {}x{}", resolution, resolution);
+    }
+}
+
+void shadow_cascades::on_config_loaded(nlohmann::json &) {
+    // Nothing read-only to read
+}
@@ -0,0 +1,264 @@
+/*!
+ * \brief Defines cascaded shadow maps for the sun, and the lists of chunks that cast shadows into each cascade
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_SHADOW_CASCADES_H
+#define RENDERER_SHADOW_CASCADES_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk_bounds.h"
+#include "config/config.h"
+#include "gl/objects/gl_framebuffer.h"
+#include "gl/objects/texture2D_array.h"
+
+/*!
+ * \brief Splits the view into NUM_CASCADES slices by distance and gives each one its own layer of the shadow map, so
+ * shadows close to the camera get a lot more texels than shadows far away
+ *
+ * The slices are split partway between evenly and logarithmically (see SPLIT_LAMBDA). Each cascade is an orthographic
+ * projection looking along the sun's direction, fitted around a sphere that holds its whole slice. The sphere is the
+ * same size no matter which way the camera is looking, and its center is snapped to whole shadow map texels, so
+ * shadow edges don't crawl or shimmer as the camera moves and turns.
+ *
+ * Drawing every chunk into every cascade would be drawing the world NUM_CASCADES more times, so each cascade keeps a
+ * list of the chunks that can cast shadows into it. Finding those means going through every chunk's box, so the lists
+ * are kept until the sun moves more than SUN_ANGLE_TOLERANCE, a chunk is added or removed, or the camera moves far
+ * enough that a cascade leaves the area its list was made for. That area is a little bigger than the cascade, so the
+ * lists still cover it while the camera moves around inside it.
+ *
+ * Shadow casters can be up to CASTER_DISTANCE blocks towards the sun from the slice they shadow. Anything further out
+ * than that doesn't cast a shadow.
+ *
+ * The shadow map is an array texture with one layer per cascade, and its size comes from the "shadowMapResolution"
+ * setting. Shaders read the shadows with #get_glsl_declarations
+ */
+class shadow_cascades : public iconfig_listener {
+public:
+    /*!
+     * \brief Where the camera is and which way it's looking
+     */
+    struct camera {
+        glm::vec3 position;
+        glm::vec3 forward;      //!< Has to be normalized
+        float vertical_fov;     //!< In radians
+        float aspect;           //!< Width / height
+        float near_plane;
+        float far_plane;        //!< Nothing further than this gets shadows
+    };
+
+    struct cascade {
+        float split_near;       //!< The distance from the camera that this cascade starts at
+        float split_far;        //!< The distance from the camera that this cascade ends at
+        float radius;           //!< The radius of the sphere around the cascade's slice, in blocks
+        float texel_size;       //!< How wide one shadow map texel is, in blocks
+
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 view_projection;
+
+        /*!
+         * \brief The IDs of the chunks that cast shadows into this cascade, from the chunk_bounds the last #update used
+         */
+        std::vector<uint64_t> casters;
+    };
+
+    static const uint32_t NUM_CASCADES = 4;
+
+    /*!
+     * \brief How logarithmic the splits are. 0 is evenly spaced, 1 is fully logarithmic
+     */
+    static const float SPLIT_LAMBDA;
+
+    /*!
+     * \brief How far towards the sun from a cascade a chunk can be and still cast a shadow into it, in blocks
+     */
+    static const float CASTER_DISTANCE;
+
+    /*!
+     * \brief How far the sun can move, in radians, before the caster lists are made again
+     */
+    static const float SUN_ANGLE_TOLERANCE;
+
+    /*!
+     * \brief How big the cells that a cascade's caster list is made for are, as a fraction of the cascade's radius.
+     * Bigger cells mean the lists are made less often but have more chunks that don't end up casting anything
+     */
+    static const float CASTER_CELL_FRACTION;
+
+    static const GLenum DEPTH_FORMAT;
+
+    static const GLuint CASCADE_BUFFER_BINDING = 8;
+    static const GLuint SHADOW_MAP_TEXTURE_UNIT = 9;
+
+    /*!
+     * \brief Doesn't touch OpenGL. The shadow map is made in #resize, and the cascade buffer the first time the cascades
+     * are bound
+     */
+    shadow_cascades();
+
+    ~shadow_cascades();
+
+    shadow_cascades(const shadow_cascades & other) = delete;
+    shadow_cascades & operator=(const shadow_cascades & other) = delete;
+
+    /*!
+     * \brief Fits the cascades to the camera and the sun, and makes the caster lists again if they're stale
+     *
+     * \param view_camera The camera that the shadows are seen from
+     * \param sun_direction The direction the sun's light goes in, so straight down at noon. Doesn't have to be
+     * normalized
+     * \param chunks Every loaded chunk
+     */
+    void update(const camera & view_camera, const glm::vec3 & sun_direction, const chunk_bounds & chunks);
+
+    /*!
+     * \brief Returns the distances from the camera where the cascades start and end: NUM_CASCADES + 1 of them, from the
+     * near plane to the far plane
+     */
+    static std::vector<float> compute_splits(float near_plane, float far_plane);
+
+    const cascade & get_cascade(uint32_t index) const;
+
+    /*!
+     * \brief Returns how many times the caster lists have been made, for tests and benchmarks
+     */
+    uint64_t get_num_caster_rebuilds() const;
+
+    /*!
+     * \brief Makes the shadow map the given number of texels on each side
+     *
+     * \return True if every cascade's framebuffer is complete. If not, shadows stay off and the error is logged
+     */
+    bool resize(int resolution);
+
+    /*!
+     * \brief Frees the shadow map and turns shadows off
+     */
+    void release();
+
+    /*!
+     * \brief Returns true once there's a shadow map and #update has placed the cascades
+     */
+    bool is_ready() const;
+
+    /*!
+     * \brief Binds a cascade's layer of the shadow map and clears it. Draw the cascade's casters with its
+     * view_projection after this
+     */
+    void begin_cascade(uint32_t index);
+
+    /*!
+     * \brief Goes back to the window's framebuffer and viewport with blending, depth testing, and depth writes off,
+     * and binds the shadow map and the cascade buffer for the passes that read shadows
+     *
+     * \param window_width The width of the window, so the viewport can go back to it
+     * \param window_height The height of the window
+     */
+    void end_shadow_pass(GLsizei window_width, GLsizei window_height);
+
+    texture2D_array * get_shadow_map();
+
+    /*!
+     * \brief Returns a shader snippet with the cascade buffer, the shadow map sampler, and
+     * nova_get_shadow(vec3 world_position, float view_depth), which returns 0 in shadow and 1 in the sun
+     */
+    static std::string get_glsl_declarations();
+
+    /*
+     * Inherited from iconfig_listener
+     */
+
+    virtual void on_config_change(const nova_settings & new_settings);
+
+    virtual void on_config_loaded(nlohmann::json & config);
+
+private:
+    /*!
+     * \brief Directions that make up a space looking down the sun's rays. Light space z points towards the sun
+     */
+    struct light_basis {
+        glm::vec3 right;
+        glm::vec3 up;
+        glm::vec3 back;
+    };
+
+    /*!
+     * \brief Where a cascade was when its caster list was made. If it moves to another cell or changes size, the list
+     * is stale
+     */
+    struct caster_cache {
+        bool valid = false;
+        glm::ivec3 cell;
+        float radius = 0;
+    };
+
+    /*!
+     * \brief How the cascades look in the shaders' cascade buffer
+     */
+    struct gpu_cascades {
+        glm::mat4 view_projections[NUM_CASCADES];
+        float split_fars[NUM_CASCADES];
+    };
+
+    cascade cascades[NUM_CASCADES];
+    caster_cache caster_caches[NUM_CASCADES];
+
+    /*!
+     * \brief The sun direction and light space that the current caster lists were made in. They only change when the
+     * lists are all made again, so small sun movements don't change which cells the cascades are in
+     */
+    glm::vec3 caster_sun_direction;
+    light_basis caster_basis;
+
+    /*!
+     * \brief The chunk_bounds generation that the current caster lists were made from
+     */
+    uint64_t caster_chunk_generation = 0;
+
+    uint64_t num_caster_rebuilds = 0;
+    bool updated = false;
+
+    /*!
+     * \brief The shadow map's size. Cascades are snapped to texels of this size even before there's a shadow map
+     */
+    int resolution = 2048;
+    bool enabled = false;
+
+    gpu_cascades gpu_data;
+
+    std::unique_ptr<texture2D_array> shadow_map;
+    std::unique_ptr<gl_framebuffer> framebuffers[NUM_CASCADES];
+    GLuint cascade_buffer = 0;
+
+    static light_basis make_light_basis(const glm::vec3 & sun_direction);
+
+    /*!
+     * \brief Returns how far along the camera's view the center of the sphere around a slice is, and sets radius to
+     * the sphere's radius
+     */
+    static float fit_sphere(const camera & view_camera, float split_near, float split_far, float & radius);
+
+    /*!
+     * \brief Makes the cascade's matrices for a sphere, snapping its center to whole texels
+     */
+    void place_cascade(cascade & current, const light_basis & basis, const glm::vec3 & center, float radius);
+
+    /*!
+     * \brief Finds the cell of caster_basis space that a sphere's center is in
+     */
+    glm::ivec3 get_caster_cell(const glm::vec3 & center, float radius) const;
+
+    /*!
+     * \brief Makes a cascade's caster list: every chunk that overlaps the box around its cell, stretched out
+     * CASTER_DISTANCE towards the sun
+     */
+    void find_casters(cascade & current, const glm::ivec3 & cell, const chunk_bounds & chunks);
+};
+
+#endif //RENDERER_SHADOW_CASCADES_H
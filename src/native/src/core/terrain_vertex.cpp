@@ -0,0 +1,140 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include "terrain_vertex.h"
+
+static_assert(sizeof(packed_terrain_vertex) == 16, "packed_terrain_vertex has to be 16 bytes");
+static_assert(offsetof(packed_terrain_vertex, lightmap) == 6, "The vertex attributes expect the lightmap at byte 6");
+static_assert(offsetof(packed_terrain_vertex, uv) == 8, "The vertex attributes expect the UV at byte 8");
+static_assert(offsetof(packed_terrain_vertex, normal) == 12, "The vertex attributes expect the normal at byte 12");
+static_assert(offsetof(packed_terrain_vertex, tangent) == 14, "The vertex attributes expect the tangent at byte 14");
+
+namespace terrain_vertex {
+    static float clamp(float value, float min, float max) {
+        return value < min ? min : (value > max ? max : value);
+    }
+
+    static uint16_t to_unorm16(float value) {
+        return (uint16_t) std::lround(clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+
+    static uint8_t to_unorm8(float value) {
+        return (uint8_t) std::lround(clamp(value, 0.0f, 1.0f) * 255.0f);
+    }
+
+    static int8_t to_snorm8(float value) {
+        return (int8_t) std::lround(clamp(value, -1.0f, 1.0f) * 127.0f);
+    }
+
+    static float from_snorm8(int8_t value) {
+        // Same as GL does it, so -128 and -127 are both -1
+        float unpacked = value / 127.0f;
+        return unpacked < -1.0f ? -1.0f : unpacked;
+    }
+
+    /*!
+     * \brief Like sign(), but zero counts as positive. Otherwise directions on the folded edges would lose their sign
+     */
+    static float sign_not_zero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    static void pack_direction(const glm::vec3 & direction, int8_t * packed) {
+        glm::vec2 encoded = octahedral_encode(direction);
+        packed[0] = to_snorm8(encoded.x);
+        packed[1] = to_snorm8(encoded.y);
+    }
+
+    static glm::vec3 unpack_direction(const int8_t * packed) {
+        return octahedral_decode(glm::vec2(from_snorm8(packed[0]), from_snorm8(packed[1])));
+    }
+
+    packed_terrain_vertex pack(const glm::vec3 & position, const glm::vec2 & uv, const glm::vec2 & lightmap,
+                               const glm::vec3 & normal, const glm::vec3 & tangent) {
+        packed_terrain_vertex vertex = {};
+
+        const float position_range = POSITION_MAX - POSITION_MIN;
+        vertex.position[0] = to_unorm16((position.x - POSITION_MIN) / position_range);
+        vertex.position[1] = to_unorm16((position.y - POSITION_MIN) / position_range);
+        vertex.position[2] = to_unorm16((position.z - POSITION_MIN) / position_range);
+
+        vertex.lightmap[0] = to_unorm8(lightmap.x);
+        vertex.lightmap[1] = to_unorm8(lightmap.y);
+
+        vertex.uv[0] = to_unorm16(uv.x);
+        vertex.uv[1] = to_unorm16(uv.y);
+
+        pack_direction(normal, vertex.normal);
+        pack_direction(tangent, vertex.tangent);
+
+        return vertex;
+    }
+
+    glm::vec3 unpack_position(const packed_terrain_vertex & vertex) {
+        const float scale = (POSITION_MAX - POSITION_MIN) / 65535.0f;
+        return glm::vec3(POSITION_MIN + vertex.position[0] * scale,
+                         POSITION_MIN + vertex.position[1] * scale,
+                         POSITION_MIN + vertex.position[2] * scale);
+    }
+
+    glm::vec3 unpack_normal(const packed_terrain_vertex & vertex) {
+        return unpack_direction(vertex.normal);
+    }
+
+    glm::vec3 unpack_tangent(const packed_terrain_vertex & vertex) {
+        return unpack_direction(vertex.tangent);
+    }
+
+    glm::vec2 octahedral_encode(const glm::vec3 & direction) {
+        const float l1_norm = std::fabs(direction.x) + std::fabs(direction.y) + std::fabs(direction.z);
+        if(l1_norm == 0.0f) {
+            // No direction at all. Call it up, rather than dividing by zero
+            return glm::vec2(0.0f, 0.0f);
+        }
+
+        glm::vec2 encoded(direction.x / l1_norm, direction.y / l1_norm);
+
+        // The bottom half of the octahedron gets folded out over the corners of the top half
+        if(direction.z < 0.0f) {
+            encoded = glm::vec2((1.0f - std::fabs(encoded.y)) * sign_not_zero(encoded.x),
+                                (1.0f - std::fabs(encoded.x)) * sign_not_zero(encoded.y));
+        }
+
+        return encoded;
+    }
+
+    glm::vec3 octahedral_decode(const glm::vec2 & encoded) {
+        glm::vec3 direction(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+
+        // Fold the corners back under
+        const float fold = direction.z < 0.0f ? -direction.z : 0.0f;
+        direction.x += direction.x >= 0.0f ? -fold : fold;
+        direction.y += direction.y >= 0.0f ? -fold : fold;
+
+        return glm::normalize(direction);
+    }
+
+    std::string get_glsl_decode_functions() {
+        std::stringstream glsl;
+
+        // The float literals need a decimal point, so GLSL doesn't think they're ints
+        glsl.setf(std::ios::fixed);
+        glsl.precision(1);
+
+        glsl << "vec3 nova_decode_position(vec3 packed_position) {\n"
+             << "    return vec3(" << POSITION_MIN << ") + packed_position * " << POSITION_MAX - POSITION_MIN << ";\n"
+             << "}\n"
+             << "vec3 nova_decode_direction(vec2 encoded) {\n"
+             << "    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));\n"
+             << "    float fold = max(-direction.z, 0.0);\n"
+             << "    direction.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(direction.xy, vec2(0.0)));\n"
+             << "    return normalize(direction);\n"
+             << "}\n";
+
+        return glsl.str();
+    }
+}
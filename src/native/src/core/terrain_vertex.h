@@ -0,0 +1,98 @@
+/*!
+ * \brief Defines the packed vertex that terrain is stored in, and functions to pack vertices into it
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_TERRAIN_VERTEX_H
+#define RENDERER_TERRAIN_VERTEX_H
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+
+/*!
+ * \brief A terrain vertex, squashed down to 16 bytes
+ *
+ * The float format (ivertex_buffer::format::POS_UV_LIGHTMAPUV_NORMAL_TANGENT) is 13 floats, or 52 bytes, per vertex.
+ * There's a LOT of terrain, and most of those bytes are wasted: positions only have to cover one chunk, UVs only
+ * have to cover the atlas, lightmap values only go up to 15, and normals and tangents are unit vectors. This fits the
+ * same thing in 16 bytes:
+ *
+ *  - The position is relative to the chunk, with each axis as a 16-bit unorm that covers #POSITION_MIN to
+ *  #POSITION_MAX. That's a bit over 1/2048th of a block of precision
+ *  - The block and sky light are 8-bit unorms, so smooth lighting still works
+ *  - The UV is two 16-bit unorms, which is enough to hit any texel of a 16k atlas
+ *  - The normal and tangent are octahedral-encoded as two 8-bit snorms each. That's off by a degree or so at worst,
+ *  and exact for the six axis directions, which is most of what Minecraft has. The bitangent is always
+ *  cross(normal, tangent)
+ *
+ * Its attributes are described in vertex_layouts.h. Every attribute is normalized by the vertex array, so shaders get
+ * the position, UV, and lightmap in [0, 1] and the normal and tangent in [-1, 1]. #get_glsl_decode_functions has the
+ * GLSL to turn those back into real values.
+ *
+ * The members are in this order so that each one starts at a multiple of its component size
+ */
+struct packed_terrain_vertex {
+    uint16_t position[3];   //!< Attribute 0, at byte 0
+    uint8_t lightmap[2];    //!< Attribute 2, at byte 6. Block light, then sky light
+    uint16_t uv[2];         //!< Attribute 1, at byte 8
+    int8_t normal[2];       //!< Attribute 3, at byte 12
+    int8_t tangent[2];      //!< Attribute 4, at byte 14
+};
+
+namespace terrain_vertex {
+    /*!
+     * \brief The smallest position a packed vertex can have, on every axis
+     *
+     * Some blocks stick out of their block space a little, and some model vertices hang off the edge of the chunk,
+     * so the range covers half a chunk on each side of the chunk too
+     */
+    const float POSITION_MIN = -8.0f;
+
+    /*!
+     * \brief The largest position a packed vertex can have, on every axis
+     */
+    const float POSITION_MAX = 24.0f;
+
+    /*!
+     * \brief Packs a vertex
+     *
+     * Anything outside the range it can be packed into is clamped
+     *
+     * \param position The vertex's position relative to the chunk's minimum corner
+     * \param uv The vertex's atlas UV, in [0, 1]
+     * \param lightmap The block and sky light, in [0, 1]
+     * \param normal The vertex's normal. Doesn't have to be normalized
+     * \param tangent The vertex's tangent. Doesn't have to be normalized
+     */
+    packed_terrain_vertex pack(const glm::vec3 & position, const glm::vec2 & uv, const glm::vec2 & lightmap,
+                               const glm::vec3 & normal, const glm::vec3 & tangent);
+
+    glm::vec3 unpack_position(const packed_terrain_vertex & vertex);
+
+    glm::vec3 unpack_normal(const packed_terrain_vertex & vertex);
+
+    glm::vec3 unpack_tangent(const packed_terrain_vertex & vertex);
+
+    /*!
+     * \brief Maps a direction onto an octahedron, then unfolds the octahedron into [-1, 1]^2
+     */
+    glm::vec2 octahedral_encode(const glm::vec3 & direction);
+
+    /*!
+     * \brief Turns an octahedral-encoded direction back into a unit vector
+     */
+    glm::vec3 octahedral_decode(const glm::vec2 & encoded);
+
+    /*!
+     * \brief Returns GLSL functions that turn the normalized attributes back into real values
+     *
+     * You get nova_decode_position(vec3), which gives back the chunk-relative position, and
+     * nova_decode_direction(vec2), which works for both the normal and the tangent. The lightmap and UV don't need
+     * decoding
+     */
+    std::string get_glsl_decode_functions();
+}
+
+#endif //RENDERER_TERRAIN_VERTEX_H
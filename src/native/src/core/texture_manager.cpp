@@ -4,8 +4,10 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <easylogging++.h>
 #include "texture_manager.h"
+#include "utils/async_log.h"
 
 texture_manager::texture_manager() {
     LOG(INFO) << "Creating the Texture Manager";
@@ -20,86 +22,327 @@ texture_manager::~texture_manager() {
 }
 
 void texture_manager::reset() {
-    if(atlases.empty()) {
-        // Nothing to deallocate, let's just return
-        return;
-    }
-    // Gather all the textures into a list so we only need one call to delete them
-    std::vector<GLuint> texture_ids(atlases.size());
-    for(auto tex : atlases) {
-        texture_ids.push_back(tex.second.get_gl_name());
-    }
-
-    glDeleteTextures((GLsizei) texture_ids.size(), texture_ids.data());
+    location_names.clear();
+    name_offsets_by_id.clear();
+    locations_by_id.clear();
+    sorted_ids.clear();
 
+    // Each atlas deletes its own texture
     atlases.clear();
-    locations.clear();
 }
 
 void texture_manager::add_texture(mc_atlas_texture & new_texture, atlas_type type, texture_type data_type) {
-    // TODO:
-    // Create an OpenGL texture from the given texture
-    // Save it to the list of atlas textures
-    LOG(DEBUG) << "Creating a Texture2D for this atlas";
-    texture2D texture;
-
-    LOG(DEBUG) << "Converting the pixel data to a float";
-    std::vector<float> pixel_data((size_t) (new_texture.width * new_texture.height * new_texture.num_components));
-    for(int i = 0; i < new_texture.width * new_texture.height * new_texture.num_components; i++) {
-        pixel_data[i] = float(new_texture.texture_data[i]) / 255.0f;
-    }
-
-    LOG(DEBUG) << "Added all pixel data";
-
-    std::vector<int> dimensions = {new_texture.width, new_texture.height};
-
-    GLenum format = GL_RGB;
+    pixel_format format = pixel_format::RGBA;
     switch(new_texture.num_components) {
         case 1:
-            format = GL_RED;
+            format = pixel_format::RED;
             break;
         case 2:
-            format = GL_RG;
+            format = pixel_format::RG;
             break;
         case 3:
-            format = GL_RGB;
+            format = pixel_format::RGB;
             break;
         case 4:
-            format = GL_RGBA;
+            format = pixel_format::RGBA;
             break;
         default:
             LOG(ERROR) << "Unsupported number of components. You have " << new_texture.num_components << " components "
             << ", but I need a number in [1,4]";
+            return;
+    }
+
+    int row_stride = new_texture.width * new_texture.num_components;
+    add_texture(new_texture.texture_data, row_stride * new_texture.height, new_texture.width, new_texture.height,
+                row_stride, format, type, data_type);
+}
+
+/*!
+ * \brief Returns what a layer of the given type holds before anything is uploaded to it
+ */
+static const float * get_neutral_color(texture_manager::texture_type type) {
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    static const float flat_normal[] = {0.5f, 0.5f, 1.0f, 1.0f};
+    static const float no_specular[] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    switch(type) {
+        case texture_manager::texture_type::NORMAL:
+            return flat_normal;
+        case texture_manager::texture_type::SPECULAR:
+            return no_specular;
+        case texture_manager::texture_type::ALBEDO:
+        default:
+            return white;
+    }
+}
+
+bool texture_manager::add_texture(const unsigned char * pixel_data, int length, int width, int height, int row_stride,
+                                  pixel_format format, atlas_type type, texture_type data_type) {
+    GLenum gl_format = GL_RGBA;
+    GLenum gl_type = GL_UNSIGNED_BYTE;
+    int bytes_per_pixel = 4;
+
+    switch(format) {
+        case pixel_format::RGBA:
+            break;
+        case pixel_format::BGRA:
+            gl_format = GL_BGRA;
+            break;
+        case pixel_format::ABGR:
+            // Read each pixel as a single 32-bit integer with red in the most significant byte. On a little-endian
+            // machine that's exactly the byte order A, B, G, R
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+#else
+            gl_type = GL_UNSIGNED_INT_8_8_8_8;
+#endif
+            break;
+        case pixel_format::RGB:
+            gl_format = GL_RGB;
+            bytes_per_pixel = 3;
+            break;
+        case pixel_format::BGR:
+            gl_format = GL_BGR;
+            bytes_per_pixel = 3;
+            break;
+        case pixel_format::RG:
+            gl_format = GL_RG;
+            bytes_per_pixel = 2;
+            break;
+        case pixel_format::RED:
+            gl_format = GL_RED;
+            bytes_per_pixel = 1;
+            break;
+        default:
+            LOG(ERROR) << "Unsupported pixel format " << (int) format;
+            return false;
+    }
+
+    if(pixel_data == nullptr || width <= 0 || height <= 0) {
+        LOG(ERROR) << "Can't add a " << width << "x" << height << " texture with no data";
+        return false;
+    }
+
+    if(row_stride < width * bytes_per_pixel || row_stride % bytes_per_pixel != 0) {
+        LOG(ERROR) << "Row stride " << row_stride << " doesn't work for a texture that's " << width << " pixels wide with "
+                   << bytes_per_pixel << " bytes per pixel";
+        return false;
+    }
+
+    // The last row doesn't need to be padded out to the full stride
+    long required_length = (long) row_stride * (height - 1) + (long) width * bytes_per_pixel;
+    if(length < required_length) {
+        LOG(ERROR) << "A " << width << "x" << height << " texture needs " << required_length << " bytes, but I only got "
+                   << length;
+        return false;
     }
 
-    texture.set_data(pixel_data, dimensions, format);
+    const int num_layers = (int) texture_type::NUM_TEXTURE_TYPES;
+    if((int) data_type < 0 || (int) data_type >= num_layers) {
+        LOG(ERROR) << "Unsupported texture type " << (int) data_type;
+        return false;
+    }
+
+    // Every layer is stored as RGBA8, whatever it was uploaded as, so all the layers can live in one texture. OpenGL
+    // fills in the components that the data doesn't have
+    texture2D_array & atlas = atlases[type];
+    const bool had_storage = atlas.get_width() > 0;
+    if(atlas.allocate(width, height, num_layers, GL_RGBA8)) {
+        if(had_storage) {
+            LOG(WARNING) << "Atlas " << (int) type << " is now " << width << "x" << height
+                         << ". Every layer of an atlas has to be the same size, so its other layers were reset";
+        }
+
+        for(int layer = 0; layer < num_layers; layer++) {
+            atlas.clear_layer(layer, get_neutral_color((texture_type) layer));
+        }
+    }
+
+    atlas.set_layer_data((int) data_type, pixel_data, row_stride / bytes_per_pixel, gl_format, gl_type);
     LOG(DEBUG) << "Texture data sent to GPU";
 
-    atlases[std::pair<atlas_type, texture_type>(type, data_type)] = texture;
-    LOG(DEBUG) << "Texture added to atlas";
+    return true;
 }
 
 void texture_manager::add_texture_location(mc_texture_atlas_location &location) {
-    std::string tex_name(location.name);
-    glm::vec2 min_uv(location.min_u, location.min_v);
-    glm::vec2 max_uv(location.max_u, location.max_v);
+    const int name_offset = 0;
+    const float uv_rect[] = {location.min_u, location.max_u, location.min_v, location.max_v};
+
+    add_texture_locations(location.name, (int) strlen(location.name) + 1, &name_offset, uv_rect, 1);
+}
+
+bool texture_manager::texture_locations_are_valid(const char * names, int names_length, const int * name_offsets,
+                                                  const float * uv_rects, int count) {
+    if(names == nullptr || name_offsets == nullptr || uv_rects == nullptr || names_length <= 0) {
+        LOG(ERROR) << "A batch of " << count << " texture locations is missing its names, offsets or UVs. Ignoring it";
+        return false;
+    }
+
+    for(int i = 0; i < count; i++) {
+        if(name_offsets[i] < 0 || name_offsets[i] >= names_length ||
+                memchr(names + name_offsets[i], '\0', (size_t) (names_length - name_offsets[i])) == nullptr) {
+            LOG(ERROR) << "Texture location " << i << " has a name that's outside of the names block. Ignoring all "
+                       << count << " texture locations";
+            return false;
+        }
+    }
 
-    texture_location tex_loc = {
-            min_uv,
-            max_uv
+    return true;
+}
+
+void texture_manager::add_texture_locations(const char * names, int names_length, const int * name_offsets,
+                                            const float * uv_rects, int count) {
+    if(count <= 0 || !texture_locations_are_valid(names, names_length, name_offsets, uv_rects, count)) {
+        return;
+    }
+
+    auto batch_name = [names, name_offsets](int index) {
+        return names + name_offsets[index];
     };
 
-    locations[tex_name] = tex_loc;
+    // Find the copies of each name in the batch. Sorting stably by name puts them next to each other in the order they
+    // were sent, so the first copy of a run is where the name shows up first and the last copy has the location that
+    // wins. Every other copy gets skipped
+    std::vector<int> batch_order((std::size_t) count);
+    for(int i = 0; i < count; i++) {
+        batch_order[i] = i;
+    }
+    std::stable_sort(batch_order.begin(), batch_order.end(), [&batch_name](int a, int b) {
+        return strcmp(batch_name(a), batch_name(b)) < 0;
+    });
+
+    std::vector<int> last_copy((std::size_t) count, -1);
+    for(int run_start = 0; run_start < count;) {
+        int run_end = run_start + 1;
+        while(run_end < count && strcmp(batch_name(batch_order[run_start]), batch_name(batch_order[run_end])) == 0) {
+            run_end++;
+        }
+
+        last_copy[batch_order[run_start]] = batch_order[run_end - 1];
+        run_start = run_end;
+    }
+
+    // New names get IDs in the order they were sent. Only the old IDs are sorted until the merge at the end
+    const std::size_t num_sorted = sorted_ids.size();
+    std::size_t num_added = 0;
+    for(int i = 0; i < count; i++) {
+        if(last_copy[i] < 0) {
+            continue;
+        }
+
+        const float * uv_rect = &uv_rects[last_copy[i] * 4];
+        texture_location location = {
+                glm::vec2(uv_rect[0], uv_rect[2]),
+                glm::vec2(uv_rect[1], uv_rect[3])
+        };
+
+        // Names we already know keep their IDs, so anyone holding on to an ID sees the new location
+        const char * name = batch_name(i);
+        auto existing = find_sorted_position(name, num_sorted);
+        if(existing != sorted_ids.begin() + num_sorted && strcmp(get_location_name(*existing), name) == 0) {
+            locations_by_id[*existing] = location;
+            continue;
+        }
+
+        sorted_ids.push_back((texture_id) locations_by_id.size());
+        name_offsets_by_id.push_back((unsigned int) location_names.size());
+        location_names.insert(location_names.end(), name, name + strlen(name) + 1);
+        locations_by_id.push_back(location);
+        num_added++;
+    }
+
+    // Sort the new IDs by name, then merge them in with the IDs we already had. The batch has no copies left, and none
+    // of its new names were already known, so every name stays unique
+    auto by_name = [this](texture_id a, texture_id b) {
+        return strcmp(get_location_name(a), get_location_name(b)) < 0;
+    };
+    std::sort(sorted_ids.begin() + num_sorted, sorted_ids.end(), by_name);
+    std::inplace_merge(sorted_ids.begin(), sorted_ids.begin() + num_sorted, sorted_ids.end(), by_name);
+
+    NOVA_LOG_DEBUG("Got {} texture locations, {} of them new, {} total", count, num_added, locations_by_id.size());
 }
 
+void texture_manager::queue_texture_locations(const char * names, int names_length, const int * name_offsets,
+                                              const float * uv_rects, int count) {
+    if(count <= 0 || !texture_locations_are_valid(names, names_length, name_offsets, uv_rects, count)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queued_locations_lock);
+
+    const int base_offset = (int) queued_names.size();
+    queued_names.insert(queued_names.end(), names, names + names_length);
+    for(int i = 0; i < count; i++) {
+        queued_name_offsets.push_back(base_offset + name_offsets[i]);
+    }
+    queued_uv_rects.insert(queued_uv_rects.end(), uv_rects, uv_rects + count * 4);
+}
+
+void texture_manager::add_queued_texture_locations() {
+    std::vector<char> names;
+    std::vector<int> name_offsets;
+    std::vector<float> uv_rects;
+    {
+        std::lock_guard<std::mutex> lock(queued_locations_lock);
+        if(queued_name_offsets.empty()) {
+            return;
+        }
+
+        names.swap(queued_names);
+        name_offsets.swap(queued_name_offsets);
+        uv_rects.swap(queued_uv_rects);
+    }
+
+    // Later batches come later in the block, so their locations win over earlier ones with the same name
+    add_texture_locations(names.data(), (int) names.size(), name_offsets.data(), uv_rects.data(),
+                          (int) name_offsets.size());
+}
+
+std::vector<texture_manager::texture_id>::const_iterator texture_manager::find_sorted_position(const char * texture_name) const {
+    return find_sorted_position(texture_name, sorted_ids.size());
+}
+
+std::vector<texture_manager::texture_id>::const_iterator
+texture_manager::find_sorted_position(const char * texture_name, std::size_t num_sorted) const {
+    return std::lower_bound(sorted_ids.begin(), sorted_ids.begin() + num_sorted, texture_name,
+                            [this](texture_id id, const char * name) {
+        return strcmp(get_location_name(id), name) < 0;
+    });
+}
+
+const char * texture_manager::get_location_name(texture_id id) const {
+    return &location_names[name_offsets_by_id[id]];
+}
+
+texture_manager::texture_id texture_manager::get_texture_id(const std::string & texture_name) const {
+    auto position = find_sorted_position(texture_name.c_str());
+    if(position != sorted_ids.end() && texture_name == get_location_name(*position)) {
+        return *position;
+    }
+
+    return INVALID_TEXTURE_ID;
+}
 
 const texture_manager::texture_location &texture_manager::get_texture_location(const std::string &texture_name) {
-    return locations[texture_name];
+    return get_texture_location(get_texture_id(texture_name));
+}
+
+const texture_manager::texture_location & texture_manager::get_texture_location(texture_id id) const {
+    static const texture_location no_location = {glm::vec2(0), glm::vec2(0)};
+
+    if(id >= locations_by_id.size()) {
+        return no_location;
+    }
+
+    return locations_by_id[id];
+}
+
+texture2D_array & texture_manager::get_texture_atlas(atlas_type atlas) {
+    return atlases[atlas];
 }
 
-texture2D & texture_manager::get_texture_atlas(atlas_type atlas, texture_type type) {
-    auto key = std::pair<atlas_type, texture_type>(atlas, type);
-    return atlases[key];
+std::size_t texture_manager::get_location_names_size() const {
+    return location_names.size();
 }
 
 int texture_manager::get_max_texture_size() {
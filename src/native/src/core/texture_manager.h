@@ -9,9 +9,11 @@
 #include <string>
 #include <glm/glm.hpp>
 #include <map>
+#include <mutex>
+#include <vector>
 #include "mc/mc_objects.h"
 #include <glad/glad.h>
-#include "gl/objects/texture2D.h"
+#include "gl/objects/texture2D_array.h"
 
 /*!
  * \brief Holds all the textures that the Nova Renderer can deal with
@@ -37,6 +39,12 @@
  * texture" or "I really need the entity texture". I'm going to be using texture atlases as much as possible. Anyway,
  * I'll ask the texture manager for a certain texture atlas, and the texture manager will give it back to me. Then, I
  * can bind that texture and render my pants off.
+ *
+ * \par Atlas layers:
+ * Each atlas is a single 2D array texture, with one layer per texture_type. The albedo, normals, and specular data for
+ * a tile are at the same UVs in their layers, so one bind gives a shader everything it needs for a material and
+ * terrain never has to switch textures between passes. Layers that haven't been uploaded hold a neutral value: white
+ * albedo, flat normals, and no specular.
  */
 class texture_manager {
 public:
@@ -60,6 +68,23 @@ public:
         ALBEDO = 0,     //!< The texture holds albedo information. I expect at least one albedo texture for each atlas
         NORMAL = 1,     //!< The texture holds normals. I expect there will only be a normals texture for terrain and entities. Maybe particles later on
         SPECULAR = 2,   //!< The texture holds specular data. Same expectations as normals
+        NUM_TEXTURE_TYPES = 3,
+    };
+
+    /*!
+     * \brief Identifies how the bytes of each pixel are laid out in memory
+     *
+     * Java's BufferedImages are usually ABGR or BGR, so Nova accepts those directly instead of making Java shuffle the
+     * bytes around first
+     */
+    enum class pixel_format {
+        RGBA = 0,       //!< Four bytes per pixel: red, green, blue, alpha
+        BGRA = 1,       //!< Four bytes per pixel: blue, green, red, alpha
+        ABGR = 2,       //!< Four bytes per pixel: alpha, blue, green, red. What BufferedImage.TYPE_4BYTE_ABGR uses
+        RGB = 3,        //!< Three bytes per pixel: red, green, blue
+        BGR = 4,        //!< Three bytes per pixel: blue, green, red. What BufferedImage.TYPE_3BYTE_BGR uses
+        RG = 5,         //!< Two bytes per pixel: red, green
+        RED = 6,        //!< One byte per pixel
     };
 
     /*!
@@ -71,10 +96,23 @@ public:
      * have. if you're making the terrain, you know you need the terrain texture.
      */
     struct texture_location {
-        glm::ivec2 min;     //!< The minimum UV coordinate of the requested texture in its atlas
-        glm::ivec2 max;     //!< The maximum UV coordinate of the requested texture in its atlas
+        glm::vec2 min;      //!< The minimum UV coordinate of the requested texture in its atlas
+        glm::vec2 max;      //!< The maximum UV coordinate of the requested texture in its atlas
     };
 
+    /*!
+     * \brief A small integer that identifies a texture location
+     *
+     * Look up the ID of a texture name once, with #get_texture_id, then use the ID whenever you need the texture's
+     * location. IDs stay valid until #reset is called.
+     */
+    typedef unsigned int texture_id;
+
+    /*!
+     * \brief The ID returned for a texture name that we don't know about
+     */
+    static const texture_id INVALID_TEXTURE_ID = 0xFFFFFFFF;
+
     /*!
      * \brief Initializes the texture_manager. Doesn't do anything special.
      *
@@ -105,6 +143,30 @@ public:
      */
     void add_texture(mc_atlas_texture & new_texture, atlas_type type, texture_type data_type);
 
+    /*!
+     * \brief Adds a texture to this resource manager, uploading it straight from the given memory
+     *
+     * The pixel data isn't copied or converted on the CPU. It's handed to OpenGL as-is, and OpenGL is told how to read
+     * it. That means the memory can belong to Java (a direct ByteBuffer, for instance) and only needs to stay alive for
+     * the duration of this call.
+     *
+     * The texture becomes the data_type layer of the atlas. Every layer of an atlas is the same size, so if this
+     * texture is a different size than the atlas, the atlas is remade at the new size and its other layers go back to
+     * their neutral values.
+     *
+     * \param pixel_data The first byte of the first row of the texture
+     * \param length The number of bytes available at pixel_data. Used to make sure we don't read past the end
+     * \param width The width of the texture, in pixels
+     * \param height The height of the texture, in pixels
+     * \param row_stride The number of bytes from the start of one row to the start of the next. Must be a multiple of
+     * the size of one pixel
+     * \param format How the bytes of each pixel are laid out
+     *
+     * \return True if the texture was uploaded, false if the parameters don't make sense
+     */
+    bool add_texture(const unsigned char * pixel_data, int length, int width, int height, int row_stride,
+                     pixel_format format, atlas_type type, texture_type data_type);
+
     /*!
      * \brief Adds the given texture location to the list of texture locations
      *
@@ -112,23 +174,77 @@ public:
      */
     void add_texture_location(mc_texture_atlas_location & location);
 
+    /*!
+     * \brief Adds a whole bunch of texture locations at once
+     *
+     * When a resource pack is loaded there are thousands of sprites. Rather than make one call and one string
+     * allocation per sprite, Java packs all the names into a single block of memory and sends them over along with
+     * their UV rectangles in one call. The names get copied into our name table in one go.
+     *
+     * If a name is already known, its location is replaced and it keeps its ID. If a name is in the batch more than
+     * once, the location that was sent last wins. Only names that aren't in the table yet get copied into it, so
+     * sending the same atlas again on every resource reload doesn't make the table any bigger
+     *
+     * This changes the table that #get_texture_location reads, so only the render thread should call it. Other threads
+     * should use #queue_texture_locations
+     *
+     * \param names All the texture names, each one followed by a null terminator
+     * \param names_length The size of names, in bytes
+     * \param name_offsets The offset of each texture's name in names
+     * \param uv_rects Four floats per texture: min_u, max_u, min_v, max_v
+     * \param count The number of textures
+     */
+    void add_texture_locations(const char * names, int names_length, const int * name_offsets, const float * uv_rects,
+                               int count);
+
+    /*!
+     * \brief Copies a batch of texture locations so the render thread can add them in
+     * #add_queued_texture_locations. Safe to call from any thread
+     *
+     * Takes the same parameters as #add_texture_locations, and ignores the batch if they don't make sense
+     */
+    void queue_texture_locations(const char * names, int names_length, const int * name_offsets,
+                                 const float * uv_rects, int count);
+
+    /*!
+     * \brief Adds every batch that #queue_texture_locations got since the last call, all in one go. Only the render
+     * thread should call this
+     */
+    void add_queued_texture_locations();
+
+    /*!
+     * \brief Returns how many bytes of names are in the texture location table, for tests
+     */
+    std::size_t get_location_names_size() const;
+
+    /*!
+     * \brief Returns the ID of the texture with the given name, or INVALID_TEXTURE_ID if there's no such texture
+     *
+     * This is a binary search over the sorted name table, so do it once and remember the ID
+     */
+    texture_id get_texture_id(const std::string & texture_name) const;
+
     /*!
      * \brief Retrieves the texture location for a texture with a specific name
      *
      * \param texture_name The MC resource location of the texture to get the location of. This name should be the
      * exact MC name of the texture
-     * \return The location of the requested texture
+     * \return The location of the requested texture, or a location with all zeros if there's no such texture
      */
     const texture_location & get_texture_location(const std::string &texture_name);
 
     /*!
-     * \brief Returns a pointer to the specified atlas
+     * \brief Retrieves the texture location for the texture with the given ID. This is just an array lookup
+     */
+    const texture_location & get_texture_location(texture_id id) const;
+
+    /*!
+     * \brief Returns the specified atlas
      *
      * \param atlas The type of atlas to get
-     * \param type The type of data that should be in the atlas
-     * \return A pointer to the atlas texture
+     * \return The atlas texture. Layer (int) texture_type holds that type of data
      */
-    texture2D & get_texture_atlas(atlas_type atlas, texture_type type);
+    texture2D_array & get_texture_atlas(atlas_type atlas);
 
     /*!
      * \brief Returns the maximum texture size supported by OpenGL on the current platform
@@ -140,8 +256,44 @@ public:
     int get_max_texture_size();
 
 private:
-    std::map<std::pair<atlas_type, texture_type>, texture2D> atlases;
-    std::map<std::string, texture_location> locations;
+    std::map<atlas_type, texture2D_array> atlases;
+    /*
+     * The texture location table. All the names live in one big block of null-terminated strings. Everything else is
+     * indexed by texture_id, except sorted_ids, which holds every ID sorted by name so we can binary search it
+     */
+    std::vector<char> location_names;
+    std::vector<unsigned int> name_offsets_by_id;
+    std::vector<texture_location> locations_by_id;
+    std::vector<texture_id> sorted_ids;
+
+    /*
+     * Batches from #queue_texture_locations, all appended together, waiting for the render thread. The offsets are
+     * already relative to the start of queued_names
+     */
+    std::mutex queued_locations_lock;
+    std::vector<char> queued_names;
+    std::vector<int> queued_name_offsets;
+    std::vector<float> queued_uv_rects;
+
+    /*!
+     * \brief Makes sure every name in a batch is inside the names block and terminated, so reading them never goes
+     * off the end of it. Logs why if not
+     */
+    static bool texture_locations_are_valid(const char * names, int names_length, const int * name_offsets,
+                                            const float * uv_rects, int count);
+
+    /*!
+     * \brief Finds where the given name is, or would be, in sorted_ids
+     */
+    std::vector<texture_id>::const_iterator find_sorted_position(const char * texture_name) const;
+
+    /*!
+     * \brief Finds where the given name is, or would be, in the first num_sorted IDs of sorted_ids
+     */
+    std::vector<texture_id>::const_iterator find_sorted_position(const char * texture_name,
+                                                                 std::size_t num_sorted) const;
+
+    const char * get_location_name(texture_id id) const;
 
     int max_texture_size = -1;
 };
@@ -0,0 +1,301 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "translucency_sorter.h"
+
+const float translucency_sorter::SUB_BLOCK_SIZE = 0.5f;
+const float translucency_sorter::CELL_GROWTH_DISTANCE = 16.0f;
+const uint32_t translucency_sorter::MIN_FACES_PER_JOB = 2048;
+
+/*!
+ * \brief Each radix pass looks at this many bits of the key, so four passes cover all 32. A chunk only has a few
+ * hundred translucent faces, so small histograms that are cheap to clear beat fewer passes
+ */
+static const uint32_t RADIX_BITS = 8;
+static const uint32_t RADIX_BUCKETS = 1 << RADIX_BITS;
+static const uint32_t RADIX_PASSES = 4;
+
+/*!
+ * \brief The same quad as the shared quad index buffer, so chunks can use the same vertices either way
+ */
+static const uint32_t QUAD_INDICES[6] = {0, 1, 2, 2, 3, 0};
+
+/*!
+ * \brief Sorts values by keys, smallest key first. keys and values have to have room for 2 * count elements, since the
+ * second half is used as scratch space
+ *
+ * \return The values, in order. This is either the first or second half of values
+ */
+static uint32_t * radix_sort(uint32_t * keys, uint32_t * values, uint32_t count) {
+    uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS] = {};
+    for(uint32_t i = 0; i < count; i++) {
+        for(uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][(keys[i] >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    uint32_t * keys_in = keys;
+    uint32_t * values_in = values;
+    uint32_t * keys_out = keys + count;
+    uint32_t * values_out = values + count;
+
+    for(uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+        uint32_t * histogram = histograms[pass];
+        const uint32_t shift = pass * RADIX_BITS;
+
+        // If every key has the same digit, this pass wouldn't move anything. That happens a lot, since the faces in
+        // a chunk are all about the same distance away so their high bits match
+        if(histogram[(keys_in[0] >> shift) & (RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for(uint32_t bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+            const uint32_t bucket_size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_size;
+        }
+
+        for(uint32_t i = 0; i < count; i++) {
+            const uint32_t destination = histogram[(keys_in[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+            keys_out[destination] = keys_in[i];
+            values_out[destination] = values_in[i];
+        }
+
+        std::swap(keys_in, keys_out);
+        std::swap(values_in, values_out);
+    }
+
+    return values_in;
+}
+
+translucency_sorter::translucency_sorter(worker_pool * workers) : workers(workers) {}
+
+void translucency_sorter::set_chunk_faces(uint64_t chunk_id, const glm::ivec3 & origin,
+                                          const std::vector<glm::vec3> & face_centers, uint32_t first_vertex) {
+    if(face_centers.empty()) {
+        remove_chunk(chunk_id);
+        return;
+    }
+
+    const uint32_t num_indices = (uint32_t) face_centers.size() * 6;
+
+    auto existing = chunks.find(chunk_id);
+    if(existing == chunks.end()) {
+        existing = chunks.emplace(chunk_id, chunk_faces{}).first;
+        existing->second.range = allocate_range(num_indices);
+
+    } else {
+        num_faces -= (uint32_t) existing->second.face_centers.size();
+        if(existing->second.range.num_indices != num_indices) {
+            free_range(existing->second.range);
+            existing->second.range = allocate_range(num_indices);
+        }
+    }
+
+    chunk_faces & chunk = existing->second;
+    chunk.origin = origin;
+    chunk.face_centers = face_centers;
+    chunk.first_vertex = first_vertex;
+    chunk.is_sorted = false;
+
+    chunk.bounds_min = face_centers[0];
+    chunk.bounds_max = face_centers[0];
+    for(const glm::vec3 & center : face_centers) {
+        chunk.bounds_min = glm::min(chunk.bounds_min, center);
+        chunk.bounds_max = glm::max(chunk.bounds_max, center);
+    }
+
+    num_faces += (uint32_t) face_centers.size();
+}
+
+void translucency_sorter::remove_chunk(uint64_t chunk_id) {
+    auto existing = chunks.find(chunk_id);
+    if(existing == chunks.end()) {
+        return;
+    }
+
+    num_faces -= (uint32_t) existing->second.face_centers.size();
+    free_range(existing->second.range);
+    chunks.erase(existing);
+}
+
+uint32_t translucency_sorter::sort(const glm::dvec3 & camera) {
+    camera_position = camera;
+    chunks_to_sort.clear();
+    changed_ranges.clear();
+    batches.clear();
+
+    uint32_t faces_to_sort = 0;
+    for(auto & entry : chunks) {
+        if(needs_sort(entry.second)) {
+            chunks_to_sort.push_back(&entry.second);
+            changed_ranges.push_back(entry.second.range);
+            faces_to_sort += (uint32_t) entry.second.face_centers.size();
+        }
+    }
+
+    if(workers == nullptr || faces_to_sort < MIN_FACES_PER_JOB * 2) {
+        for(chunk_faces * chunk : chunks_to_sort) {
+            sort_chunk(*chunk);
+        }
+        return (uint32_t) chunks_to_sort.size();
+    }
+
+    // Give each worker at least MIN_FACES_PER_JOB faces, so the jobs are worth the trouble of waking a thread up
+    uint32_t faces_in_batch = 0;
+    for(uint32_t i = 0; i < chunks_to_sort.size(); i++) {
+        if(batches.empty() || faces_in_batch >= MIN_FACES_PER_JOB) {
+            batches.push_back(sort_batch{this, i, 0});
+            faces_in_batch = 0;
+        }
+
+        batches.back().num_chunks++;
+        faces_in_batch += (uint32_t) chunks_to_sort[i]->face_centers.size();
+    }
+
+    // This thread would just be waiting, so it sorts the first batch itself
+    job_group sorts;
+    for(uint32_t i = 1; i < batches.size(); i++) {
+        workers->submit(sort_batch_job, &batches[i], &sorts);
+    }
+    sort_batch_job(&batches[0]);
+    sorts.wait();
+
+    return (uint32_t) chunks_to_sort.size();
+}
+
+translucency_sorter::index_range translucency_sorter::get_range(uint64_t chunk_id) const {
+    auto existing = chunks.find(chunk_id);
+    if(existing == chunks.end()) {
+        return index_range{0, 0};
+    }
+
+    return existing->second.range;
+}
+
+const std::vector<translucency_sorter::index_range> & translucency_sorter::get_changed_ranges() const {
+    return changed_ranges;
+}
+
+const std::vector<uint32_t> & translucency_sorter::get_indices() const {
+    return indices;
+}
+
+uint32_t translucency_sorter::get_num_faces() const {
+    return num_faces;
+}
+
+translucency_sorter::index_range translucency_sorter::allocate_range(uint32_t num_indices) {
+    for(auto free = free_ranges.begin(); free != free_ranges.end(); ++free) {
+        if(free->num_indices >= num_indices) {
+            const index_range range{free->first_index, num_indices};
+
+            free->first_index += num_indices;
+            free->num_indices -= num_indices;
+            if(free->num_indices == 0) {
+                free_ranges.erase(free);
+            }
+
+            return range;
+        }
+    }
+
+    const index_range range{(uint32_t) indices.size(), num_indices};
+    indices.resize(indices.size() + num_indices);
+    return range;
+}
+
+void translucency_sorter::free_range(const index_range & range) {
+    // Keep the free ranges in order so neighbors can be merged, otherwise the index array slowly turns into confetti
+    auto next = std::lower_bound(free_ranges.begin(), free_ranges.end(), range,
+                                 [](const index_range & a, const index_range & b) {
+                                     return a.first_index < b.first_index;
+                                 });
+    next = free_ranges.insert(next, range);
+
+    auto following = next + 1;
+    if(following != free_ranges.end() && next->first_index + next->num_indices == following->first_index) {
+        next->num_indices += following->num_indices;
+        free_ranges.erase(following);
+    }
+
+    if(next != free_ranges.begin()) {
+        auto previous = next - 1;
+        if(previous->first_index + previous->num_indices == next->first_index) {
+            previous->num_indices += next->num_indices;
+            next = free_ranges.erase(next) - 1;
+        }
+    }
+
+    // Don't hang on to free space at the very end
+    if(next->first_index + next->num_indices == indices.size()) {
+        indices.resize(next->first_index);
+        free_ranges.erase(next);
+    }
+}
+
+bool translucency_sorter::needs_sort(chunk_faces & chunk) {
+    const glm::vec3 camera(camera_position - glm::dvec3(chunk.origin));
+
+    // The closest the camera could be to any of the chunk's faces
+    const glm::vec3 closest = glm::min(glm::max(camera, chunk.bounds_min), chunk.bounds_max);
+    const float distance = glm::length(camera - closest);
+
+    const float cell_size = SUB_BLOCK_SIZE + std::floor(distance / CELL_GROWTH_DISTANCE);
+    const glm::ivec3 cell(glm::floor(camera / cell_size));
+
+    if(chunk.is_sorted && cell_size == chunk.last_cell_size && cell == chunk.last_cell) {
+        return false;
+    }
+
+    chunk.is_sorted = true;
+    chunk.last_cell = cell;
+    chunk.last_cell_size = cell_size;
+    return true;
+}
+
+void translucency_sorter::sort_chunk(const chunk_faces & chunk) {
+    // Each worker keeps its scratch space between sorts, so once it's seen the biggest chunk it stops allocating
+    static thread_local std::vector<uint32_t> keys;
+    static thread_local std::vector<uint32_t> values;
+
+    const uint32_t count = (uint32_t) chunk.face_centers.size();
+    if(keys.size() < count * 2) {
+        keys.resize(count * 2);
+        values.resize(count * 2);
+    }
+
+    const glm::vec3 camera(camera_position - glm::dvec3(chunk.origin));
+    for(uint32_t i = 0; i < count; i++) {
+        const glm::vec3 to_face = chunk.face_centers[i] - camera;
+        const float distance_squared = glm::dot(to_face, to_face);
+
+        // Positive floats sort the same way as their bits do. Flipping the bits puts the farthest face first
+        uint32_t distance_bits;
+        std::memcpy(&distance_bits, &distance_squared, sizeof(distance_bits));
+        keys[i] = ~distance_bits;
+        values[i] = i;
+    }
+
+    const uint32_t * order = radix_sort(keys.data(), values.data(), count);
+
+    uint32_t * out = &indices[chunk.range.first_index];
+    for(uint32_t i = 0; i < count; i++) {
+        const uint32_t first_vertex = chunk.first_vertex + order[i] * 4;
+        for(uint32_t corner = 0; corner < 6; corner++) {
+            *out++ = first_vertex + QUAD_INDICES[corner];
+        }
+    }
+}
+
+void translucency_sorter::sort_batch_job(void * batch_pointer) {
+    const sort_batch & batch = *static_cast<sort_batch *>(batch_pointer);
+    for(uint32_t i = batch.first_chunk; i < batch.first_chunk + batch.num_chunks; i++) {
+        batch.sorter->sort_chunk(*batch.sorter->chunks_to_sort[i]);
+    }
+}
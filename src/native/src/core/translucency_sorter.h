@@ -0,0 +1,154 @@
+/*!
+ * \brief Defines a class that keeps every chunk's translucent faces sorted back to front
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_TRANSLUCENCY_SORTER_H
+#define RENDERER_TRANSLUCENCY_SORTER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "utils/worker_pool.h"
+
+/*!
+ * \brief Sorts the translucent faces (water, glass, ice, stained glass...) of each chunk by how far they are from the
+ * camera, so they can be drawn back to front
+ *
+ * Each chunk tells me where the centers of its translucent quads are, and I give it a range of the index array. Every
+ * time the camera moves I radix sort the chunk's quads by depth and write six indices per quad into its range, the
+ * farthest quad first. The range is laid out just like the shared quad index buffer (0, 1, 2, 2, 3, 0 for each quad)
+ * so the chunk's vertices don't need to change at all.
+ *
+ * Sorting every face every frame would be a lot of work with an ocean in view, so a chunk only gets re-sorted once the
+ * camera moves into a new cell. The cells are half a block across near the chunk and get bigger the farther away the
+ * chunk is, since the order of far-away faces barely changes as the camera moves. The chunks that do need sorting get
+ * split into batches and sorted on the worker threads.
+ *
+ * Only the render thread should call any of this
+ */
+class translucency_sorter {
+public:
+    /*!
+     * \brief Part of the index array that belongs to one chunk
+     */
+    struct index_range {
+        uint32_t first_index;
+        uint32_t num_indices;
+    };
+
+    /*!
+     * \brief How big a camera cell is next to a chunk, in blocks
+     */
+    static const float SUB_BLOCK_SIZE;
+
+    /*!
+     * \brief Cells get one block bigger every this many blocks away from a chunk
+     */
+    static const float CELL_GROWTH_DISTANCE;
+
+    /*!
+     * \brief If a sort has fewer faces than this, I do it on the calling thread instead of waking up a worker
+     */
+    static const uint32_t MIN_FACES_PER_JOB;
+
+    /*!
+     * \param workers The threads to sort on. If it's nullptr, everything gets sorted on the calling thread
+     */
+    translucency_sorter(worker_pool * workers);
+
+    /*!
+     * \brief Sets the translucent faces for a chunk, replacing any it had before
+     *
+     * \param chunk_id Something that's unique for each chunk, like its packed position
+     * \param origin The world position of the chunk's corner
+     * \param face_centers The center of each translucent quad, relative to origin, in the order the quads' vertices are
+     * in the chunk's vertex buffer
+     * \param first_vertex Where the chunk's first translucent vertex is in its vertex buffer
+     */
+    void set_chunk_faces(uint64_t chunk_id, const glm::ivec3 & origin, const std::vector<glm::vec3> & face_centers,
+                         uint32_t first_vertex);
+
+    /*!
+     * \brief Forgets about a chunk and gives its index range back
+     */
+    void remove_chunk(uint64_t chunk_id);
+
+    /*!
+     * \brief Re-sorts every chunk that the camera moved relative to, and waits for them all to finish
+     *
+     * \return How many chunks were re-sorted
+     */
+    uint32_t sort(const glm::dvec3 & camera_position);
+
+    /*!
+     * \brief Returns the index range for a chunk. If I don't know about the chunk, the range is empty
+     */
+    index_range get_range(uint64_t chunk_id) const;
+
+    /*!
+     * \brief Returns the ranges that changed in the last call to #sort, so only those have to be uploaded
+     */
+    const std::vector<index_range> & get_changed_ranges() const;
+
+    /*!
+     * \brief Returns every chunk's indices. Anything outside of a chunk's range is garbage
+     */
+    const std::vector<uint32_t> & get_indices() const;
+
+    uint32_t get_num_faces() const;
+
+private:
+    struct chunk_faces {
+        glm::ivec3 origin;
+        std::vector<glm::vec3> face_centers;
+        uint32_t first_vertex;
+        index_range range;
+
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+
+        bool is_sorted = false;
+        glm::ivec3 last_cell;
+        float last_cell_size = 0;
+    };
+
+    /*!
+     * \brief A few chunks for one worker to sort. The batches live in this class so they outlast their jobs
+     */
+    struct sort_batch {
+        translucency_sorter * sorter;
+        uint32_t first_chunk;
+        uint32_t num_chunks;
+    };
+
+    worker_pool * workers;
+
+    std::unordered_map<uint64_t, chunk_faces> chunks;
+
+    std::vector<uint32_t> indices;
+    std::vector<index_range> free_ranges;
+    uint32_t num_faces = 0;
+
+    glm::dvec3 camera_position;
+    std::vector<chunk_faces *> chunks_to_sort;
+    std::vector<sort_batch> batches;
+    std::vector<index_range> changed_ranges;
+
+    index_range allocate_range(uint32_t num_indices);
+
+    void free_range(const index_range & range);
+
+    /*!
+     * \brief Figures out if the camera has moved far enough from a chunk's faces that they need to be sorted again
+     */
+    bool needs_sort(chunk_faces & chunk);
+
+    void sort_chunk(const chunk_faces & chunk);
+
+    static void sort_batch_job(void * batch);
+};
+
+#endif //RENDERER_TRANSLUCENCY_SORTER_H
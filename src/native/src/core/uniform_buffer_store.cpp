@@ -30,9 +30,9 @@ void uniform_buffer_store::set_bind_points(nlohmann::json& config) {
     }
 }
 
-void uniform_buffer_store::on_config_change(nlohmann::json& new_config) {
-    cam_data.viewHeight = new_config["viewWidth"];
-    cam_data.viewWidth = new_config["viewHeight"];
+void uniform_buffer_store::on_config_change(const nova_settings& new_settings) {
+    cam_data.viewWidth = new_settings.view_width;
+    cam_data.viewHeight = new_settings.view_height;
 
     upload_data();
 }
@@ -29,7 +29,7 @@ public:
     /*
      * Inherited from iconfig_listener
      */
-    virtual void on_config_change(nlohmann::json& new_config);
+    virtual void on_config_change(const nova_settings& new_settings);
 
     virtual void on_config_loaded(nlohmann::json& config);
 private:
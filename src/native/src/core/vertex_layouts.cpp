@@ -0,0 +1,42 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <sstream>
+#include "vertex_layouts.h"
+
+constexpr ivertex_buffer::format vertex_layout<pos_vertex>::data_format;
+constexpr vertex_attribute vertex_layout<pos_vertex>::attributes[];
+
+constexpr ivertex_buffer::format vertex_layout<pos_uv_vertex>::data_format;
+constexpr vertex_attribute vertex_layout<pos_uv_vertex>::attributes[];
+
+constexpr ivertex_buffer::format vertex_layout<pos_uv_lightmapuv_normal_tangent_vertex>::data_format;
+constexpr vertex_attribute vertex_layout<pos_uv_lightmapuv_normal_tangent_vertex>::attributes[];
+
+constexpr ivertex_buffer::format vertex_layout<packed_terrain_vertex>::data_format;
+constexpr vertex_attribute vertex_layout<packed_terrain_vertex>::attributes[];
+
+std::string get_glsl_input(const vertex_attribute & attribute) {
+    std::stringstream glsl;
+    glsl << "layout(location = " << attribute.location << ") in ";
+
+    // Integers that aren't normalized stay integers, so they need an integer type in the shader too
+    const bool is_integer = attribute.type != component_type::float32 && !attribute.normalized;
+    if(attribute.num_components == 1) {
+        if(!is_integer) {
+            glsl << "float";
+        } else {
+            glsl << (attribute.type == component_type::int8 ? "int" : "uint");
+        }
+
+    } else {
+        if(is_integer) {
+            glsl << (attribute.type == component_type::int8 ? "i" : "u");
+        }
+        glsl << "vec" << attribute.num_components;
+    }
+
+    glsl << " " << attribute.name << ";\n";
+    return glsl.str();
+}
@@ -0,0 +1,191 @@
+/*!
+ * \brief Defines the vertex structs Nova uses, and a compile-time description of each one's attributes
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_VERTEX_LAYOUTS_H
+#define RENDERER_VERTEX_LAYOUTS_H
+
+#include <cstddef>
+#include <string>
+#include "interfaces/ivertex_buffer.h"
+#include "terrain_vertex.h"
+
+/*!
+ * \brief The type of each component of a vertex attribute
+ */
+enum class component_type {
+    float32,
+    uint16,
+    uint8,
+    int8
+};
+
+constexpr std::size_t get_component_size(component_type type) {
+    return type == component_type::float32 ? 4 : (type == component_type::uint16 ? 2 : 1);
+}
+
+/*!
+ * \brief Describes one vertex attribute: where it is in the vertex, what it's made of, and what shaders call it
+ */
+struct vertex_attribute {
+    unsigned int location;
+    const char * name;
+    unsigned int num_components;
+    component_type type;
+
+    /*!
+     * \brief If true, integer components are turned into floats in [0, 1] (or [-1, 1] if signed). If false, integer
+     * components stay integers and the shader gets a uvec or ivec
+     */
+    bool normalized;
+
+    std::size_t offset;
+};
+
+/*!
+ * \brief Describes the attributes of the vertex struct Vertex
+ *
+ * Every vertex struct gets a specialization with:
+ *  - data_format, the ivertex_buffer::format it's uploaded as
+ *  - attributes, a constexpr array of vertex_attribute, with each offset coming from offsetof so it can't be wrong
+ *
+ * The stride is always sizeof(Vertex). Everything else (the vertex array setup in gl_vertex_buffer and the shader
+ * inputs from get_glsl_inputs) comes from the attributes, so a vertex struct only has to be described once.
+ *
+ * Each specialization is checked with is_valid_layout, so an attribute that hangs off the end of its vertex or
+ * overlaps another one won't compile
+ */
+template<typename Vertex>
+struct vertex_layout;
+
+/*!
+ * \brief A vertex with just a position
+ */
+struct pos_vertex {
+    float position[3];
+};
+
+/*!
+ * \brief A vertex with a position and a texture coordinate
+ */
+struct pos_uv_vertex {
+    float position[3];
+    float uv[2];
+};
+
+/*!
+ * \brief A full-fat vertex for terrain and entities, all floats. packed_terrain_vertex is the same thing in 16 bytes
+ */
+struct pos_uv_lightmapuv_normal_tangent_vertex {
+    float position[3];
+    float uv[2];
+    float lightmap_uv[2];
+    float normal[3];
+    float tangent[3];
+};
+
+template<>
+struct vertex_layout<pos_vertex> {
+    static constexpr ivertex_buffer::format data_format = ivertex_buffer::format::POS;
+    static constexpr vertex_attribute attributes[] = {
+            {0, "position", 3, component_type::float32, false, offsetof(pos_vertex, position)}
+    };
+};
+
+template<>
+struct vertex_layout<pos_uv_vertex> {
+    static constexpr ivertex_buffer::format data_format = ivertex_buffer::format::POS_UV;
+    static constexpr vertex_attribute attributes[] = {
+            {0, "position", 3, component_type::float32, false, offsetof(pos_uv_vertex, position)},
+            {1, "uv", 2, component_type::float32, false, offsetof(pos_uv_vertex, uv)}
+    };
+};
+
+template<>
+struct vertex_layout<pos_uv_lightmapuv_normal_tangent_vertex> {
+    typedef pos_uv_lightmapuv_normal_tangent_vertex vertex;
+
+    static constexpr ivertex_buffer::format data_format = ivertex_buffer::format::POS_UV_LIGHTMAPUV_NORMAL_TANGENT;
+    static constexpr vertex_attribute attributes[] = {
+            {0, "position", 3, component_type::float32, false, offsetof(vertex, position)},
+            {1, "uv", 2, component_type::float32, false, offsetof(vertex, uv)},
+            {2, "lightmap_uv", 2, component_type::float32, false, offsetof(vertex, lightmap_uv)},
+            {3, "normal", 3, component_type::float32, false, offsetof(vertex, normal)},
+            {4, "tangent", 3, component_type::float32, false, offsetof(vertex, tangent)}
+    };
+};
+
+/*!
+ * \brief The packed terrain vertex uses the same locations as the float one, so a shader only has to decode it
+ */
+template<>
+struct vertex_layout<packed_terrain_vertex> {
+    static constexpr ivertex_buffer::format data_format = ivertex_buffer::format::TERRAIN_PACKED;
+    static constexpr vertex_attribute attributes[] = {
+            {0, "position", 3, component_type::uint16, true, offsetof(packed_terrain_vertex, position)},
+            {1, "uv", 2, component_type::uint16, true, offsetof(packed_terrain_vertex, uv)},
+            {2, "lightmap_uv", 2, component_type::uint8, true, offsetof(packed_terrain_vertex, lightmap)},
+            {3, "normal", 2, component_type::int8, true, offsetof(packed_terrain_vertex, normal)},
+            {4, "tangent", 2, component_type::int8, true, offsetof(packed_terrain_vertex, tangent)}
+    };
+};
+
+template<typename Vertex>
+constexpr std::size_t get_num_attributes() {
+    return sizeof(vertex_layout<Vertex>::attributes) / sizeof(vertex_attribute);
+}
+
+/*!
+ * \brief Returns true if every attribute of Vertex fits inside the vertex, and no two attributes share bytes or a
+ * location
+ */
+template<typename Vertex>
+constexpr bool is_valid_layout() {
+    const vertex_attribute * attributes = vertex_layout<Vertex>::attributes;
+
+    for(std::size_t i = 0; i < get_num_attributes<Vertex>(); i++) {
+        const std::size_t end = attributes[i].offset + attributes[i].num_components * get_component_size(attributes[i].type);
+        if(attributes[i].num_components < 1 || attributes[i].num_components > 4 || end > sizeof(Vertex)) {
+            return false;
+        }
+
+        for(std::size_t j = i + 1; j < get_num_attributes<Vertex>(); j++) {
+            const std::size_t other_end =
+                    attributes[j].offset + attributes[j].num_components * get_component_size(attributes[j].type);
+            if(attributes[i].location == attributes[j].location ||
+               (attributes[i].offset < other_end && attributes[j].offset < end)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static_assert(is_valid_layout<pos_vertex>(), "pos_vertex's layout doesn't match the struct");
+static_assert(is_valid_layout<pos_uv_vertex>(), "pos_uv_vertex's layout doesn't match the struct");
+static_assert(is_valid_layout<pos_uv_lightmapuv_normal_tangent_vertex>(),
+              "pos_uv_lightmapuv_normal_tangent_vertex's layout doesn't match the struct");
+static_assert(is_valid_layout<packed_terrain_vertex>(), "packed_terrain_vertex's layout doesn't match the struct");
+
+/*!
+ * \brief Returns the GLSL declaration of one attribute, like "layout(location = 1) in vec2 uv;"
+ */
+std::string get_glsl_input(const vertex_attribute & attribute);
+
+/*!
+ * \brief Returns the GLSL declarations of all of Vertex's attributes, for the top of a vertex shader
+ */
+template<typename Vertex>
+std::string get_glsl_inputs() {
+    std::string glsl;
+    for(const vertex_attribute & attribute : vertex_layout<Vertex>::attributes) {
+        glsl += get_glsl_input(attribute);
+    }
+
+    return glsl;
+}
+
+#endif //RENDERER_VERTEX_LAYOUTS_H
@@ -0,0 +1,154 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "weighted_blended_oit.h"
+#include "gl/gl_state_cache.h"
+#include "utils/async_log.h"
+
+const GLenum weighted_blended_oit::ACCUMULATION_FORMAT = GL_RGBA16F;
+const GLenum weighted_blended_oit::REVEALAGE_FORMAT = GL_R8;
+const std::string weighted_blended_oit::COMPOSITE_PROGRAM_NAME = "oit_composite";
+
+weighted_blended_oit::weighted_blended_oit(shaderpack & shaders) : shaders(shaders) {
+    composite_program = shaders.get_program_id(COMPOSITE_PROGRAM_NAME);
+    glCreateVertexArrays(1, &empty_vertex_array);
+}
+
+weighted_blended_oit::~weighted_blended_oit() {
+    gl_state_cache::get().delete_vertex_arrays(1, &empty_vertex_array);
+}
+
+bool weighted_blended_oit::is_enabled() const {
+    return enabled;
+}
+
+bool weighted_blended_oit::resize(int width, int height) {
+    if(!framebuffer) {
+        framebuffer = std::unique_ptr<gl_framebuffer>(new gl_framebuffer());
+        accumulation = std::unique_ptr<texture2D>(new texture2D());
+        revealage = std::unique_ptr<texture2D>(new texture2D());
+    }
+
+    // If the size changes, the textures get new names, so they have to be attached again either way
+    accumulation->allocate(width, height, ACCUMULATION_FORMAT);
+    revealage->allocate(width, height, REVEALAGE_FORMAT);
+
+    framebuffer->attach_texture(GL_COLOR_ATTACHMENT0, accumulation->get_gl_name());
+    framebuffer->attach_texture(GL_COLOR_ATTACHMENT1, revealage->get_gl_name());
+
+    const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    framebuffer->set_draw_buffers(2, draw_buffers);
+
+    enabled = framebuffer->check_complete();
+    if(!enabled) {
+        NOVA_LOG_ERROR("Can't render to the OIT targets at {}x{}, so translucent things won't be drawn with OIT",
+                       width, height);
+    }
+
+    return enabled;
+}
+
+void weighted_blended_oit::release() {
+    framebuffer.reset();
+    accumulation.reset();
+    revealage.reset();
+    enabled = false;
+}
+
+void weighted_blended_oit::begin_translucent_pass() {
+    gl_state_cache & state = gl_state_cache::get();
+    framebuffer->bind();
+    state.set_viewport(0, 0, accumulation->get_width(), accumulation->get_height());
+
+    // Nothing's been accumulated, and everything is fully revealed
+    const GLfloat no_color[] = {0, 0, 0, 0};
+    const GLfloat fully_revealed[] = {1, 0, 0, 0};
+    glClearNamedFramebufferfv(framebuffer->get_gl_name(), GL_COLOR, 0, no_color);
+    glClearNamedFramebufferfv(framebuffer->get_gl_name(), GL_COLOR, 1, fully_revealed);
+
+    // Accumulation adds up, revealage multiplies by (1 - alpha)
+    state.set_blend_enabled(true);
+    state.set_blend_func(0, GL_ONE, GL_ONE);
+    state.set_blend_func(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+    // Translucent things shouldn't hide each other
+    state.set_depth_write_enabled(false);
+}
+
+void weighted_blended_oit::composite(GLsizei window_width, GLsizei window_height) {
+    gl_state_cache & state = gl_state_cache::get();
+    state.bind_framebuffer(0);
+
+    state.set_viewport(0, 0, window_width, window_height);
+
+    state.set_blend_enabled(true);
+    state.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    state.set_depth_test_enabled(false);
+
+    shaders.get_shader(composite_program).bind();
+    accumulation->bind(GL_TEXTURE0);
+    revealage->bind(GL_TEXTURE1);
+
+    state.bind_vertex_array(empty_vertex_array);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Put things back the way the GUI and next frame's opaque passes expect them. Depth testing is already off, which
+    // is how they have it
+    state.set_blend_enabled(false);
+    state.set_depth_write_enabled(true);
+}
+
+std::string weighted_blended_oit::get_glsl_output_functions() {
+    // The weight is equation 10 from the paper: close, opaque fragments count for more. It's clamped so a lot of
+    // layers can't overflow the half floats
+    return R"(
+layout(location = 0) out vec4 nova_accumulation;
+layout(location = 1) out float nova_revealage;
+
+void nova_write_translucent(vec4 color) {
+    float depth_weight = 1.0 - gl_FragCoord.z * 0.9;
+    float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * depth_weight * depth_weight * depth_weight,
+                         1e-2, 3e3);
+
+    nova_accumulation = vec4(color.rgb * color.a, color.a) * weight;
+    nova_revealage = color.a;
+}
+)";
+}
+
+texture2D * weighted_blended_oit::get_accumulation() {
+    return accumulation.get();
+}
+
+texture2D * weighted_blended_oit::get_revealage() {
+    return revealage.get();
+}
+
+gl_framebuffer * weighted_blended_oit::get_framebuffer() {
+    return framebuffer.get();
+}
+
+void weighted_blended_oit::on_config_change(const nova_settings & new_settings) {
+    if(new_settings.transparency == nova_settings::transparency_mode::weighted_blended) {
+        // Shaderpacks only need the composite program if OIT is on, so it isn't loaded until then
+        if(!shaders.add_optional_program(COMPOSITE_PROGRAM_NAME)) {
+            NOVA_LOG_ERROR("The shaderpack doesn't have a working {} program, so translucent things are drawn sorted "
+                           "back to front", COMPOSITE_PROGRAM_NAME);
+            release();
+            return;
+        }
+
+        resize(new_settings.view_width, new_settings.view_height);
+        NOVA_LOG_INFO("Drawing translucent things with weighted blended OIT");
+
+    } else if(framebuffer) {
+        release();
+        shaders.remove_optional_program(COMPOSITE_PROGRAM_NAME);
+        NOVA_LOG_INFO("Drawing translucent things sorted back to front");
+    }
+}
+
+void weighted_blended_oit::on_config_loaded(nlohmann::json &) {
+    // Nothing read-only to read
+}
@@ -0,0 +1,131 @@
+/*!
+ * \brief Defines the render targets and passes for weighted blended order-independent transparency
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_WEIGHTED_BLENDED_OIT_H
+#define RENDERER_WEIGHTED_BLENDED_OIT_H
+
+#include <memory>
+#include <string>
+#include "config/config.h"
+#include "shaderpack_loading/shaderpack.h"
+#include "gl/objects/gl_framebuffer.h"
+#include "gl/objects/texture2D.h"
+
+/*!
+ * \brief Draws translucent things in any order, then blends them all onto the screen at once
+ *
+ * This is McGuire and Bavoil's weighted blended OIT. Instead of blending each translucent fragment over the last one,
+ * every fragment adds its premultiplied color, weighted by how close and how opaque it is, to the accumulation target,
+ * and multiplies the revealage target by how much it lets through. Both of those are commutative, so the order
+ * fragments show up in doesn't matter and nothing has to be sorted. The composite pass divides the accumulated color
+ * by the total weight and blends it over the scene using the revealage.
+ *
+ * It's only an approximation: several layers of very different colors come out a bit muddy. That's why it's a
+ * setting ("transparencyMode": "weightedBlended") and not the only way to draw translucent things. When it's off, the
+ * render targets are freed. The shaderpack's composite program is only loaded when it's on, and if the shaderpack
+ * doesn't have one, OIT stays off.
+ *
+ * Translucent shaders write their colors with nova_write_translucent, from #get_glsl_output_functions
+ */
+class weighted_blended_oit : public iconfig_listener {
+public:
+    /*!
+     * \brief The format of the accumulation target. Half floats, since the weights get big
+     */
+    static const GLenum ACCUMULATION_FORMAT;
+
+    /*!
+     * \brief The format of the revealage target. It only ever goes from 1 down to 0
+     */
+    static const GLenum REVEALAGE_FORMAT;
+
+    /*!
+     * \brief The name of the composite program in the shaderpack
+     */
+    static const std::string COMPOSITE_PROGRAM_NAME;
+
+    weighted_blended_oit(shaderpack & shaders);
+
+    ~weighted_blended_oit();
+
+    weighted_blended_oit(const weighted_blended_oit & other) = delete;
+    weighted_blended_oit & operator=(const weighted_blended_oit & other) = delete;
+
+    /*!
+     * \brief Returns true if the settings ask for OIT and the render targets are good to go
+     */
+    bool is_enabled() const;
+
+    /*!
+     * \brief Makes the render targets the given size
+     *
+     * \return True if the framebuffer is complete. If it isn't, OIT stays off and the error is logged
+     */
+    bool resize(int width, int height);
+
+    /*!
+     * \brief Frees the render targets and turns OIT off
+     */
+    void release();
+
+    /*!
+     * \brief Binds the OIT framebuffer and clears it, and sets up blending and depth for drawing translucent things
+     *
+     * Draw every translucent thing after this, in whatever order you want
+     */
+    void begin_translucent_pass();
+
+    /*!
+     * \brief Blends everything drawn since #begin_translucent_pass onto the window's framebuffer
+     *
+     * Afterwards the viewport covers the window again, blending is off, and depth writes are back on, which is what
+     * the rest of the frame expects
+     *
+     * \param window_width The width of the window's framebuffer, in pixels
+     * \param window_height The height of the window's framebuffer, in pixels
+     */
+    void composite(GLsizei window_width, GLsizei window_height);
+
+    /*!
+     * \brief Returns a fragment shader snippet that declares the two OIT outputs and nova_write_translucent(vec4 color),
+     * which writes a non-premultiplied color to them
+     *
+     * Paste it after the #version line of a translucent fragment shader
+     */
+    static std::string get_glsl_output_functions();
+
+    texture2D * get_accumulation();
+
+    texture2D * get_revealage();
+
+    gl_framebuffer * get_framebuffer();
+
+    /*
+     * Inherited from iconfig_listener
+     */
+
+    virtual void on_config_change(const nova_settings & new_settings);
+
+    virtual void on_config_loaded(nlohmann::json & config);
+
+private:
+    shaderpack & shaders;
+    shaderpack::program_id composite_program;
+
+    /*!
+     * \brief The composite pass draws one big triangle whose corners come from gl_VertexID, so its vertex array is
+     * empty
+     */
+    GLuint empty_vertex_array;
+
+    std::unique_ptr<gl_framebuffer> framebuffer;
+    std::unique_ptr<texture2D> accumulation;
+    std::unique_ptr<texture2D> revealage;
+
+    bool enabled = false;
+};
+
+#endif //RENDERER_WEIGHTED_BLENDED_OIT_H
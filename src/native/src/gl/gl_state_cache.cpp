@@ -0,0 +1,346 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "gl_state_cache.h"
+
+const unsigned int gl_state_cache::MAX_TEXTURE_UNITS;
+const GLuint gl_state_cache::UNKNOWN;
+const unsigned int gl_state_cache::NUM_BUFFER_TARGETS;
+const unsigned int gl_state_cache::NUM_TEXTURE_TARGETS;
+
+const GLenum gl_state_cache::BUFFER_TARGETS[] = {
+        GL_ARRAY_BUFFER,
+        GL_UNIFORM_BUFFER,
+        GL_SHADER_STORAGE_BUFFER,
+        GL_COPY_READ_BUFFER,
+        GL_COPY_WRITE_BUFFER,
+        GL_PIXEL_UNPACK_BUFFER,
+        GL_PIXEL_PACK_BUFFER,
+        GL_DRAW_INDIRECT_BUFFER
+};
+
+const GLenum gl_state_cache::TEXTURE_TARGETS[] = {
+        GL_TEXTURE_2D,
+        GL_TEXTURE_2D_ARRAY,
+        GL_TEXTURE_3D,
+        GL_TEXTURE_CUBE_MAP
+};
+
+gl_state_cache & gl_state_cache::get() {
+    static gl_state_cache cache;
+    return cache;
+}
+
+gl_state_cache::gl_state_cache() {
+    invalidate();
+}
+
+void gl_state_cache::use_program(GLuint program) {
+    if(changes(this->program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void gl_state_cache::bind_vertex_array(GLuint vertex_array) {
+    if(changes(this->vertex_array, vertex_array)) {
+        glBindVertexArray(vertex_array);
+    }
+}
+
+void gl_state_cache::bind_buffer(GLenum target, GLuint buffer) {
+    if(target == GL_ELEMENT_ARRAY_BUFFER) {
+        // If we don't know which vertex array is bound, we can't know which element buffer is bound either
+        if(vertex_array == UNKNOWN) {
+            stats.issued++;
+            glBindBuffer(target, buffer);
+            return;
+        }
+
+        auto element_buffer = element_buffers.emplace(vertex_array, UNKNOWN).first;
+        if(changes(element_buffer->second, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+        return;
+    }
+
+    int target_index = find_buffer_target(target);
+    if(target_index < 0) {
+        stats.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if(changes(buffers[target_index], buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void gl_state_cache::bind_buffer_base(GLenum target, GLuint index, GLuint buffer) {
+    const uint64_t key = ((uint64_t) target << 32) | index;
+    auto indexed_buffer = indexed_buffers.emplace(key, UNKNOWN).first;
+    if(!changes(indexed_buffer->second, buffer)) {
+        return;
+    }
+
+    glBindBufferBase(target, index, buffer);
+
+    int target_index = find_buffer_target(target);
+    if(target_index >= 0) {
+        buffers[target_index] = buffer;
+    }
+}
+
+void gl_state_cache::set_element_buffer(GLuint vertex_array, GLuint buffer) {
+    auto element_buffer = element_buffers.emplace(vertex_array, UNKNOWN).first;
+    if(changes(element_buffer->second, buffer)) {
+        glVertexArrayElementBuffer(vertex_array, buffer);
+    }
+}
+
+void gl_state_cache::bind_texture(unsigned int unit, GLenum target, GLuint texture) {
+    int target_index = find_texture_target(target);
+    if(unit >= MAX_TEXTURE_UNITS || target_index < 0) {
+        // Not something we keep track of. Bind it anyways, and forget which unit is active since we just changed it
+        stats.issued++;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        active_texture_unit = UNKNOWN;
+        return;
+    }
+
+    if(textures[unit][target_index] == texture) {
+        stats.elided++;
+        return;
+    }
+
+    if(changes(active_texture_unit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    textures[unit][target_index] = texture;
+    stats.issued++;
+    glBindTexture(target, texture);
+}
+
+void gl_state_cache::bind_texture(GLenum target, GLuint texture) {
+    if(active_texture_unit == UNKNOWN) {
+        // Pick a unit so we know where the texture ended up
+        bind_texture(0, target, texture);
+    } else {
+        bind_texture(active_texture_unit, target, texture);
+    }
+}
+
+void gl_state_cache::unbind_texture(GLenum target, GLuint texture) {
+    int target_index = find_texture_target(target);
+    if(target_index < 0) {
+        return;
+    }
+
+    for(unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        if(textures[unit][target_index] == texture) {
+            bind_texture(unit, target, 0);
+        }
+    }
+}
+
+void gl_state_cache::set_blend_enabled(bool enabled) {
+    set_capability(GL_BLEND, blend_enabled, enabled);
+}
+
+void gl_state_cache::set_blend_func(GLenum source_factor, GLenum destination_factor) {
+    if(blend_source_factor == source_factor && blend_destination_factor == destination_factor) {
+        stats.elided++;
+        return;
+    }
+
+    blend_source_factor = source_factor;
+    blend_destination_factor = destination_factor;
+    stats.issued++;
+    glBlendFunc(source_factor, destination_factor);
+}
+
+void gl_state_cache::set_blend_func(GLuint draw_buffer, GLenum source_factor, GLenum destination_factor) {
+    blend_source_factor = UNKNOWN;
+    blend_destination_factor = UNKNOWN;
+    stats.issued++;
+    glBlendFunci(draw_buffer, source_factor, destination_factor);
+}
+
+void gl_state_cache::set_depth_test_enabled(bool enabled) {
+    set_capability(GL_DEPTH_TEST, depth_test_enabled, enabled);
+}
+
+void gl_state_cache::set_depth_write_enabled(bool enabled) {
+    if(changes(depth_write_enabled, enabled ? 1 : 0)) {
+        glDepthMask((GLboolean) (enabled ? GL_TRUE : GL_FALSE));
+    }
+}
+
+void gl_state_cache::set_depth_func(GLenum func) {
+    if(changes(depth_func, func)) {
+        glDepthFunc(func);
+    }
+}
+
+void gl_state_cache::set_viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if(viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height) {
+        stats.elided++;
+        return;
+    }
+
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+    stats.issued++;
+    glViewport(x, y, width, height);
+}
+
+void gl_state_cache::bind_framebuffer(GLuint framebuffer) {
+    if(changes(this->framebuffer, framebuffer)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+}
+
+void gl_state_cache::delete_program(GLuint program) {
+    // Deleting the program in use doesn't unbind it, but it's going away as soon as something else is used
+    if(this->program == program) {
+        this->program = UNKNOWN;
+    }
+
+    glDeleteProgram(program);
+}
+
+void gl_state_cache::delete_vertex_arrays(GLsizei count, const GLuint * vertex_arrays) {
+    for(GLsizei i = 0; i < count; i++) {
+        if(vertex_array == vertex_arrays[i]) {
+            vertex_array = 0;
+        }
+
+        element_buffers.erase(vertex_arrays[i]);
+    }
+
+    glDeleteVertexArrays(count, vertex_arrays);
+}
+
+void gl_state_cache::delete_buffers(GLsizei count, const GLuint * buffers) {
+    for(GLsizei i = 0; i < count; i++) {
+        for(GLuint & bound_buffer : this->buffers) {
+            if(bound_buffer == buffers[i]) {
+                bound_buffer = 0;
+            }
+        }
+
+        for(auto & indexed_buffer : indexed_buffers) {
+            if(indexed_buffer.second == buffers[i]) {
+                indexed_buffer.second = 0;
+            }
+        }
+
+        // GL only unbinds a deleted element buffer from the vertex array that's bound right now. Any other vertex
+        // array that has it keeps it, so we don't know what they have any more
+        for(auto & element_buffer : element_buffers) {
+            if(element_buffer.second == buffers[i]) {
+                element_buffer.second = element_buffer.first == vertex_array ? 0 : UNKNOWN;
+            }
+        }
+    }
+
+    glDeleteBuffers(count, buffers);
+}
+
+void gl_state_cache::delete_textures(GLsizei count, const GLuint * textures) {
+    for(GLsizei i = 0; i < count; i++) {
+        for(auto & unit : this->textures) {
+            for(GLuint & bound_texture : unit) {
+                if(bound_texture == textures[i]) {
+                    bound_texture = 0;
+                }
+            }
+        }
+    }
+
+    glDeleteTextures(count, textures);
+}
+
+void gl_state_cache::delete_framebuffers(GLsizei count, const GLuint * framebuffers) {
+    // Deleting the bound framebuffer puts the window's framebuffer back
+    for(GLsizei i = 0; i < count; i++) {
+        if(framebuffer == framebuffers[i]) {
+            framebuffer = 0;
+        }
+    }
+
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void gl_state_cache::invalidate() {
+    program = UNKNOWN;
+    vertex_array = UNKNOWN;
+
+    for(GLuint & buffer : buffers) {
+        buffer = UNKNOWN;
+    }
+    indexed_buffers.clear();
+    element_buffers.clear();
+
+    active_texture_unit = UNKNOWN;
+    for(auto & unit : textures) {
+        for(GLuint & texture : unit) {
+            texture = UNKNOWN;
+        }
+    }
+
+    blend_enabled = -1;
+    blend_source_factor = UNKNOWN;
+    blend_destination_factor = UNKNOWN;
+    depth_test_enabled = -1;
+    depth_write_enabled = -1;
+    depth_func = UNKNOWN;
+
+    for(GLint & value : viewport) {
+        value = -1;
+    }
+
+    framebuffer = UNKNOWN;
+}
+
+const gl_state_cache::counters & gl_state_cache::get_counters() const {
+    return stats;
+}
+
+void gl_state_cache::reset_counters() {
+    stats = counters();
+}
+
+int gl_state_cache::find_buffer_target(GLenum target) {
+    for(unsigned int i = 0; i < NUM_BUFFER_TARGETS; i++) {
+        if(BUFFER_TARGETS[i] == target) {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+int gl_state_cache::find_texture_target(GLenum target) {
+    for(unsigned int i = 0; i < NUM_TEXTURE_TARGETS; i++) {
+        if(TEXTURE_TARGETS[i] == target) {
+            return (int) i;
+        }
+    }
+
+    return -1;
+}
+
+void gl_state_cache::set_capability(GLenum capability, int & cached, bool enabled) {
+    if(changes(cached, enabled ? 1 : 0)) {
+        if(enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+}
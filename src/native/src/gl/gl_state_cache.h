@@ -0,0 +1,217 @@
+/*!
+ * \brief Defines a shadow copy of the OpenGL state, so we only tell the driver about things that actually change
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_GL_STATE_CACHE_H
+#define RENDERER_GL_STATE_CACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <glad/glad.h>
+
+/*!
+ * \brief Remembers what's bound to the OpenGL context, and skips any bind or state change that wouldn't change anything
+ *
+ * Every call into the driver costs something, even when it's a no-op. Once there's a world to draw, the same shader,
+ * vertex array, and textures get bound over and over, so everything that binds goes through here instead of calling
+ * glBindWhatever itself.
+ *
+ * This only works if EVERYTHING goes through here. If something binds behind the cache's back, the cache will think
+ * the old thing is still bound and skip binding it again. If you really have to call GL directly (maybe some library
+ * does it for you), call #invalidate afterwards.
+ *
+ * Deleting an object unbinds it everywhere, so delete things with the delete_* functions here too.
+ *
+ * Nova has one context and only the render thread touches it, so there's one of these and it isn't thread safe.
+ */
+class gl_state_cache {
+public:
+    /*!
+     * \brief How many state changes were made, and how many were skipped because they wouldn't have changed anything
+     */
+    struct counters {
+        uint64_t issued = 0;
+        uint64_t elided = 0;
+    };
+
+    /*!
+     * \brief The most texture units the cache keeps track of. GL 4.5 guarantees at least this many
+     */
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+    /*!
+     * \brief Returns the cache for Nova's context
+     */
+    static gl_state_cache & get();
+
+    gl_state_cache();
+
+    void use_program(GLuint program);
+
+    void bind_vertex_array(GLuint vertex_array);
+
+    /*!
+     * \brief Binds a buffer to the given target
+     *
+     * The element array buffer is part of the vertex array's state, so the cache remembers it per vertex array
+     */
+    void bind_buffer(GLenum target, GLuint buffer);
+
+    /*!
+     * \brief Binds a buffer to an indexed binding point, like a uniform buffer or shader storage buffer binding
+     *
+     * glBindBufferBase binds the buffer to the target's generic binding point too, so this keeps track of that as well
+     */
+    void bind_buffer_base(GLenum target, GLuint index, GLuint buffer);
+
+    /*!
+     * \brief Sets a vertex array's element array buffer without binding the vertex array, like
+     * glVertexArrayElementBuffer
+     *
+     * It's the same state #bind_buffer changes for GL_ELEMENT_ARRAY_BUFFER, so both of them keep it up to date
+     */
+    void set_element_buffer(GLuint vertex_array, GLuint buffer);
+
+    /*!
+     * \brief Binds a texture to the given texture unit, making that unit active if it needs to
+     *
+     * \param unit The index of the texture unit. This is 0 for GL_TEXTURE0, not GL_TEXTURE0 itself
+     */
+    void bind_texture(unsigned int unit, GLenum target, GLuint texture);
+
+    /*!
+     * \brief Binds a texture to whichever texture unit is active, for when you want to change the texture and don't care
+     * where it's bound
+     */
+    void bind_texture(GLenum target, GLuint texture);
+
+    /*!
+     * \brief Unbinds the texture from every texture unit it's bound to
+     */
+    void unbind_texture(GLenum target, GLuint texture);
+
+    void set_blend_enabled(bool enabled);
+
+    void set_blend_func(GLenum source_factor, GLenum destination_factor);
+
+    /*!
+     * \brief Sets the blend function for one draw buffer, when different render targets need to blend differently
+     *
+     * I don't keep track of each draw buffer's blend function, so this always goes to the driver, and the next call
+     * to the other set_blend_func always does too
+     */
+    void set_blend_func(GLuint draw_buffer, GLenum source_factor, GLenum destination_factor);
+
+    void set_depth_test_enabled(bool enabled);
+
+    void set_depth_write_enabled(bool enabled);
+
+    void set_depth_func(GLenum func);
+
+    void set_viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /*!
+     * \brief Binds a framebuffer for both drawing and reading. 0 is the window's framebuffer
+     */
+    void bind_framebuffer(GLuint framebuffer);
+
+    void delete_program(GLuint program);
+
+    void delete_vertex_arrays(GLsizei count, const GLuint * vertex_arrays);
+
+    void delete_buffers(GLsizei count, const GLuint * buffers);
+
+    void delete_textures(GLsizei count, const GLuint * textures);
+
+    void delete_framebuffers(GLsizei count, const GLuint * framebuffers);
+
+    /*!
+     * \brief Forgets everything, so the next call for each piece of state goes to the driver no matter what
+     */
+    void invalidate();
+
+    const counters & get_counters() const;
+
+    void reset_counters();
+
+private:
+    /*!
+     * \brief Means "I don't know what's bound here", so the next bind always gets through
+     */
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+    /*!
+     * \brief The buffer targets that we keep track of. Anything else goes straight through to the driver
+     */
+    static const GLenum BUFFER_TARGETS[];
+    static const unsigned int NUM_BUFFER_TARGETS = 8;
+
+    /*!
+     * \brief The texture targets that we keep track of, per texture unit
+     */
+    static const GLenum TEXTURE_TARGETS[];
+    static const unsigned int NUM_TEXTURE_TARGETS = 4;
+
+    counters stats;
+
+    GLuint program;
+    GLuint vertex_array;
+
+    /*!
+     * \brief Everything but the element array buffer, which is in element_buffers
+     */
+    GLuint buffers[NUM_BUFFER_TARGETS];
+
+    /*!
+     * \brief The buffer bound to each indexed binding point we've seen. The key is the target in the upper 32 bits and
+     * the index in the lower 32
+     */
+    std::unordered_map<uint64_t, GLuint> indexed_buffers;
+
+    /*!
+     * \brief The element array buffer bound to each vertex array we've seen
+     */
+    std::unordered_map<GLuint, GLuint> element_buffers;
+
+    unsigned int active_texture_unit;
+    GLuint textures[MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+
+    // Blend and depth state. These are ints rather than bools so they can be unknown too
+    int blend_enabled;
+    GLenum blend_source_factor;
+    GLenum blend_destination_factor;
+    int depth_test_enabled;
+    int depth_write_enabled;
+    GLenum depth_func;
+
+    GLint viewport[4];
+
+    GLuint framebuffer;
+
+    /*!
+     * \brief Counts a state change, and returns true if it needs to go to the driver
+     *
+     * If it does, the cached value is updated to the new value
+     */
+    template<typename T>
+    bool changes(T & cached, T new_value) {
+        if(cached == new_value) {
+            stats.elided++;
+            return false;
+        }
+
+        cached = new_value;
+        stats.issued++;
+        return true;
+    }
+
+    static int find_buffer_target(GLenum target);
+
+    static int find_texture_target(GLenum target);
+
+    void set_capability(GLenum capability, int & cached, bool enabled);
+};
+
+#endif //RENDERER_GL_STATE_CACHE_H
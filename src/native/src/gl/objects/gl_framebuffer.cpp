@@ -0,0 +1,72 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "gl_framebuffer.h"
+#include "gl/gl_state_cache.h"
+#include "utils/async_log.h"
+
+gl_framebuffer::gl_framebuffer() {
+    glCreateFramebuffers(1, &gl_name);
+}
+
+gl_framebuffer::~gl_framebuffer() {
+    gl_state_cache::get().delete_framebuffers(1, &gl_name);
+}
+
+void gl_framebuffer::attach_texture(GLenum attachment, GLuint texture) {
+    glNamedFramebufferTexture(gl_name, attachment, texture, 0);
+}
+
+void gl_framebuffer::attach_texture_layer(GLenum attachment, GLuint texture, GLint layer) {
+    glNamedFramebufferTextureLayer(gl_name, attachment, texture, 0, layer);
+}
+
+void gl_framebuffer::set_draw_buffers(GLsizei count, const GLenum * draw_buffers) {
+    glNamedFramebufferDrawBuffers(gl_name, count, draw_buffers);
+}
+
+bool gl_framebuffer::check_complete() const {
+    const GLenum status = glCheckNamedFramebufferStatus(gl_name, GL_FRAMEBUFFER);
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        NOVA_LOG_ERROR("Framebuffer {} isn't complete: {}", gl_name, get_status_name(status));
+        return false;
+    }
+
+    return true;
+}
+
+void gl_framebuffer::bind() {
+    gl_state_cache::get().bind_framebuffer(gl_name);
+}
+
+GLuint gl_framebuffer::get_gl_name() const {
+    return gl_name;
+}
+
+const char * gl_framebuffer::get_status_name(GLenum status) {
+    switch(status) {
+        case GL_FRAMEBUFFER_COMPLETE:
+            return "complete";
+        case GL_FRAMEBUFFER_UNDEFINED:
+            return "undefined";
+        case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
+            return "an attachment is incomplete";
+        case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
+            return "nothing is attached";
+        case GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER:
+            return "a draw buffer has nothing attached";
+        case GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER:
+            return "the read buffer has nothing attached";
+        case GL_FRAMEBUFFER_UNSUPPORTED:
+            return "the driver doesn't support this combination of formats";
+        case GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE:
+            return "the attachments have different sample counts";
+        case GL_FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS:
+            return "the attachments have different layer counts";
+        case 0:
+            return "glCheckNamedFramebufferStatus failed";
+        default:
+            return "something else somehow";
+    }
+}
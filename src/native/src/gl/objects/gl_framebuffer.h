@@ -0,0 +1,73 @@
+/*!
+ * \brief Defines an OpenGL framebuffer object, for rendering into textures
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_GL_FRAMEBUFFER_H
+#define RENDERER_GL_FRAMEBUFFER_H
+
+#include <glad/glad.h>
+
+/*!
+ * \brief A framebuffer that textures get attached to
+ *
+ * Attaching things uses direct state access, so nothing gets bound until you call #bind. Binding goes through the GL
+ * state cache, and so does deleting, so the cache always knows which framebuffer is bound.
+ *
+ * A framebuffer that isn't complete can't be drawn to, and what counts as complete is up to the driver, so call
+ * #check_complete once everything's attached and have a plan for when it says no
+ */
+class gl_framebuffer {
+public:
+    gl_framebuffer();
+
+    ~gl_framebuffer();
+
+    gl_framebuffer(const gl_framebuffer & other) = delete;
+    gl_framebuffer & operator=(const gl_framebuffer & other) = delete;
+
+    /*!
+     * \brief Attaches the first mip level of a texture
+     *
+     * \param attachment Where to attach it, like GL_COLOR_ATTACHMENT0 or GL_DEPTH_ATTACHMENT
+     * \param texture The GL name of the texture. 0 detaches whatever's there
+     */
+    void attach_texture(GLenum attachment, GLuint texture);
+
+    /*!
+     * \brief Attaches one layer of the first mip level of an array texture
+     *
+     * \param attachment Where to attach it, like GL_COLOR_ATTACHMENT0 or GL_DEPTH_ATTACHMENT
+     * \param texture The GL name of the array texture
+     * \param layer Which layer to draw into
+     */
+    void attach_texture_layer(GLenum attachment, GLuint texture, GLint layer);
+
+    /*!
+     * \brief Sets which color attachments fragment shader outputs go to. Output 0 goes to draw_buffers[0], and so on
+     */
+    void set_draw_buffers(GLsizei count, const GLenum * draw_buffers);
+
+    /*!
+     * \brief Asks the driver if this framebuffer can be drawn to, and logs why not if it can't
+     */
+    bool check_complete() const;
+
+    /*!
+     * \brief Binds this framebuffer for drawing and reading
+     */
+    void bind();
+
+    GLuint get_gl_name() const;
+
+    /*!
+     * \brief Returns the name of a glCheckFramebufferStatus result, for error messages
+     */
+    static const char * get_status_name(GLenum status);
+
+private:
+    GLuint gl_name;
+};
+
+#endif //RENDERER_GL_FRAMEBUFFER_H
@@ -0,0 +1,56 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cstdint>
+#include <vector>
+#include "gl_quad_index_buffer.h"
+
+const unsigned int gl_quad_index_buffer::MAX_QUADS;
+const unsigned int gl_quad_index_buffer::INDICES_PER_QUAD;
+const unsigned int gl_quad_index_buffer::VERTICES_PER_QUAD;
+
+static_assert(gl_quad_index_buffer::MAX_QUADS * gl_quad_index_buffer::VERTICES_PER_QUAD == 65536,
+              "The quad indices should reach every vertex a 16-bit index can");
+
+gl_quad_index_buffer & gl_quad_index_buffer::get() {
+    // Never deleted. Deleting it at exit would happen after the context was already gone
+    static gl_quad_index_buffer * instance = new gl_quad_index_buffer();
+    return *instance;
+}
+
+gl_quad_index_buffer::gl_quad_index_buffer() {
+    std::vector<uint16_t> indices(MAX_QUADS * INDICES_PER_QUAD);
+    for(unsigned int quad = 0; quad < MAX_QUADS; quad++) {
+        const uint16_t first_vertex = (uint16_t) (quad * VERTICES_PER_QUAD);
+        uint16_t * quad_indices = &indices[quad * INDICES_PER_QUAD];
+
+        quad_indices[0] = first_vertex;
+        quad_indices[1] = (uint16_t) (first_vertex + 1);
+        quad_indices[2] = (uint16_t) (first_vertex + 2);
+        quad_indices[3] = (uint16_t) (first_vertex + 2);
+        quad_indices[4] = (uint16_t) (first_vertex + 3);
+        quad_indices[5] = first_vertex;
+    }
+
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, indices.size() * sizeof(uint16_t), indices.data(), 0);
+}
+
+GLuint gl_quad_index_buffer::get_buffer() const {
+    return buffer;
+}
+
+void gl_quad_index_buffer::draw_quads(unsigned int num_indices) {
+    const unsigned int indices_per_batch = MAX_QUADS * INDICES_PER_QUAD;
+    const GLint vertices_per_batch = (GLint) (MAX_QUADS * VERTICES_PER_QUAD);
+
+    GLint base_vertex = 0;
+    while(num_indices > 0) {
+        const unsigned int batch_indices = num_indices < indices_per_batch ? num_indices : indices_per_batch;
+        glDrawElementsBaseVertex(GL_TRIANGLES, batch_indices, GL_UNSIGNED_SHORT, nullptr, base_vertex);
+
+        num_indices -= batch_indices;
+        base_vertex += vertices_per_batch;
+    }
+}
@@ -0,0 +1,57 @@
+/*!
+ * \brief Defines the index buffer that every quad-based mesh shares
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_GL_QUAD_INDEX_BUFFER_H
+#define RENDERER_GL_QUAD_INDEX_BUFFER_H
+
+#include <glad/glad.h>
+
+/*!
+ * \brief An index buffer that turns every four vertices into a quad, made of two triangles
+ *
+ * Terrain is almost all quads, and every quad's indices are the same as the last quad's plus four. Storing them for
+ * every chunk is a waste of memory, so chunks use this one instead.
+ *
+ * Quad q uses vertices 4q to 4q + 3, in the order Minecraft gives them: 0, 1, 2 and 2, 3, 0. The indices are 16 bits
+ * and only cover #MAX_QUADS quads, which is all 65536 vertices a 16-bit index can reach. Meshes with more quads
+ * than that get drawn in batches of #MAX_QUADS, with each batch's base vertex moved ahead by 65536. See
+ * #draw_quads.
+ *
+ * There's one for the context, and it lives as long as the context does
+ */
+class gl_quad_index_buffer {
+public:
+    /*!
+     * \brief How many quads the buffer has indices for
+     */
+    static const unsigned int MAX_QUADS = 16384;
+
+    static const unsigned int INDICES_PER_QUAD = 6;
+
+    static const unsigned int VERTICES_PER_QUAD = 4;
+
+    /*!
+     * \brief Returns the buffer, making it the first time
+     */
+    static gl_quad_index_buffer & get();
+
+    GLuint get_buffer() const;
+
+    /*!
+     * \brief Draws the first num_indices quad indices with whatever vertex array is bound. The vertex array has to be
+     * using this buffer as its element buffer
+     *
+     * Takes indices rather than quads so it can be a drop-in for glDrawElements
+     */
+    static void draw_quads(unsigned int num_indices);
+
+private:
+    GLuint buffer;
+
+    gl_quad_index_buffer();
+};
+
+#endif //RENDERER_GL_QUAD_INDEX_BUFFER_H
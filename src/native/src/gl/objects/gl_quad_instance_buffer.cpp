@@ -0,0 +1,98 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cstddef>
+#include <vector>
+#include <easylogging++.h>
+#include "gl_quad_instance_buffer.h"
+#include "gl/gl_state_cache.h"
+
+uint16_t to_unorm16(float value) {
+    if(value <= 0.0f) {
+        return 0;
+    } else if(value >= 1.0f) {
+        return 65535;
+    }
+
+    return (uint16_t) (value * 65535.0f + 0.5f);
+}
+
+gl_quad_instance_buffer::gl_quad_instance_buffer(unsigned int capacity) : capacity(capacity) {
+    glCreateVertexArrays(1, &vertex_array);
+
+    // The corners of every quad, in triangle strip order
+    const float unit_quad[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            0.0f, 1.0f,
+            1.0f, 1.0f
+    };
+
+    glCreateBuffers(1, &unit_quad_buffer);
+    glNamedBufferStorage(unit_quad_buffer, sizeof(unit_quad), unit_quad, 0);
+
+    // Start out with every instance zeroed out, so anything we haven't written yet draws nothing
+    std::vector<quad_instance> empty_instances(capacity, quad_instance{});
+
+    glCreateBuffers(1, &instance_buffer);
+    glNamedBufferStorage(instance_buffer, capacity * sizeof(quad_instance), empty_instances.data(),
+                         GL_DYNAMIC_STORAGE_BIT);
+
+    // Binding 0 is the unit quad, once per vertex. Binding 1 is the instances, once per quad
+    glVertexArrayVertexBuffer(vertex_array, 0, unit_quad_buffer, 0, 2 * sizeof(float));
+    glVertexArrayVertexBuffer(vertex_array, 1, instance_buffer, 0, sizeof(quad_instance));
+    glVertexArrayBindingDivisor(vertex_array, 1, 1);
+
+    enable_attribute(0, 0);     // Corner
+    glVertexArrayAttribFormat(vertex_array, 0, 2, GL_FLOAT, GL_FALSE, 0);
+
+    enable_attribute(1, 1);     // Rect
+    glVertexArrayAttribFormat(vertex_array, 1, 4, GL_SHORT, GL_FALSE, offsetof(quad_instance, x));
+
+    enable_attribute(2, 1);     // UV rect
+    glVertexArrayAttribFormat(vertex_array, 2, 4, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(quad_instance, min_u));
+
+    enable_attribute(3, 1);     // Color
+    glVertexArrayAttribFormat(vertex_array, 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(quad_instance, color));
+
+    enable_attribute(4, 1);     // Atlas
+    glVertexArrayAttribIFormat(vertex_array, 4, 1, GL_UNSIGNED_SHORT, offsetof(quad_instance, atlas));
+}
+
+gl_quad_instance_buffer::~gl_quad_instance_buffer() {
+    gl_state_cache & state = gl_state_cache::get();
+    state.delete_buffers(1, &instance_buffer);
+    state.delete_buffers(1, &unit_quad_buffer);
+    state.delete_vertex_arrays(1, &vertex_array);
+}
+
+void gl_quad_instance_buffer::set_instances(unsigned int first, const quad_instance * instances, unsigned int count) {
+    if(first + count > capacity) {
+        LOG(ERROR) << "Tried to write quads " << first << " through " << first + count << " of a buffer that only holds "
+                   << capacity << " quads";
+        return;
+    }
+
+    glNamedBufferSubData(instance_buffer, first * sizeof(quad_instance), count * sizeof(quad_instance), instances);
+}
+
+void gl_quad_instance_buffer::draw(unsigned int count) {
+    if(count > capacity) {
+        count = capacity;
+    }
+
+    if(count > 0) {
+        gl_state_cache::get().bind_vertex_array(vertex_array);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    }
+}
+
+unsigned int gl_quad_instance_buffer::get_capacity() const {
+    return capacity;
+}
+
+void gl_quad_instance_buffer::enable_attribute(GLuint attribute, GLuint binding) {
+    glEnableVertexArrayAttrib(vertex_array, attribute);
+    glVertexArrayAttribBinding(vertex_array, attribute, binding);
+}
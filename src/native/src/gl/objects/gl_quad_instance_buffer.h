@@ -0,0 +1,93 @@
+/*!
+ * \brief Defines a buffer of 2D quads that are drawn with instancing
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_GL_QUAD_INSTANCE_BUFFER_H
+#define RENDERER_GL_QUAD_INSTANCE_BUFFER_H
+
+#include <cstdint>
+#include <glad/glad.h>
+
+/*!
+ * \brief A single textured, tinted rectangle, packed into 24 bytes
+ *
+ * Each quad used to be four vertices of five floats, plus six indices: 92 bytes. Now the four corners come from a unit
+ * quad that lives on the GPU forever, and each quad only needs to say where it goes and what it looks like.
+ *
+ * Attribute locations in the shader:
+ *  - 0: vec2 corner, from the unit quad. (0, 0) is the top left corner and (1, 1) is the bottom right
+ *  - 1: vec4 rect, from x, y, width, height
+ *  - 2: vec4 uv_rect, from min_u, min_v, max_u, max_v, normalized to [0, 1]
+ *  - 3: vec4 color, from color, normalized to [0, 1]
+ *  - 4: uint atlas
+ */
+struct quad_instance {
+    int16_t x;              //!< The left edge of the quad, in GUI pixels
+    int16_t y;              //!< The top edge of the quad, in GUI pixels
+    int16_t width;          //!< A quad with no width or height draws nothing
+    int16_t height;
+
+    uint16_t min_u;         //!< UVs in the atlas, as unorm16. 65535 is 1.0
+    uint16_t min_v;
+    uint16_t max_u;
+    uint16_t max_v;
+
+    uint8_t color[4];       //!< RGBA tint, multiplied with the texture
+
+    uint16_t atlas;         //!< Which atlas to sample from. The meaning is up to the shader
+    uint16_t reserved;
+};
+
+static_assert(sizeof(quad_instance) == 24, "quad_instance must stay tightly packed, the shader depends on it");
+
+/*!
+ * \brief Converts a texture coordinate in [0, 1] to the unorm16 that quad_instance stores
+ */
+uint16_t to_unorm16(float value);
+
+/*!
+ * \brief Holds a fixed number of quad instances on the GPU, and draws some number of them in a single instanced draw
+ *
+ * Like the other buffers, this needs a GL context, so don't make one before the window exists
+ */
+class gl_quad_instance_buffer {
+public:
+    /*!
+     * \brief Creates the unit quad, the instance buffer, and a vertex array that ties them together
+     *
+     * \param capacity The most quads this buffer can hold
+     */
+    gl_quad_instance_buffer(unsigned int capacity);
+
+    ~gl_quad_instance_buffer();
+
+    /*!
+     * \brief Overwrites some of the instances in this buffer
+     *
+     * \param first The index of the first instance to overwrite
+     * \param instances The new instances
+     * \param count How many instances to overwrite. first + count must not be more than the capacity
+     */
+    void set_instances(unsigned int first, const quad_instance * instances, unsigned int count);
+
+    /*!
+     * \brief Draws the first count instances
+     */
+    void draw(unsigned int count);
+
+    unsigned int get_capacity() const;
+
+private:
+    GLuint vertex_array;
+    GLuint unit_quad_buffer;
+    GLuint instance_buffer;
+
+    unsigned int capacity;
+
+    void enable_attribute(GLuint attribute, GLuint binding);
+};
+
+
+#endif //RENDERER_GL_QUAD_INSTANCE_BUFFER_H
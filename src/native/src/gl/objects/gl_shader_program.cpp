@@ -3,8 +3,11 @@
  * \date 17-May-16.
  */
 
+#include <algorithm>
 #include <easylogging++.h>
+#include <glm/gtc/type_ptr.hpp>
 #include "gl_shader_program.h"
+#include "gl/gl_state_cache.h"
 
 gl_shader_program::gl_shader_program(std::string name) : linked(false) {
     this->name = name;
@@ -13,6 +16,8 @@ gl_shader_program::gl_shader_program(std::string name) : linked(false) {
 gl_shader_program::gl_shader_program(gl_shader_program && other) :
         uniform_locations(std::move(other.uniform_locations)),
         attribute_locations(std::move(other.attribute_locations)),
+        uniforms(std::move(other.uniforms)),
+        uniform_block_indices(std::move(other.uniform_block_indices)),
         name(std::move(other.name)) {
     if(!other.linked) {
         throw shader_program_not_linked_exception("Trying to move shader program " + other.name + " but it isn't finished building yet");
@@ -31,6 +36,23 @@ gl_shader_program::gl_shader_program(gl_shader_program && other) :
     other.added_shaders.clear();
 }
 
+gl_shader_program & gl_shader_program::operator=(gl_shader_program && other) {
+    if(!other.linked) {
+        throw shader_program_not_linked_exception(other.name);
+    }
+
+    // Swap instead of copy, so that the other shader deletes our old program when it's destroyed
+    std::swap(gl_name, other.gl_name);
+    std::swap(linked, other.linked);
+    std::swap(uniform_locations, other.uniform_locations);
+    std::swap(attribute_locations, other.attribute_locations);
+    std::swap(uniforms, other.uniforms);
+    std::swap(uniform_block_indices, other.uniform_block_indices);
+    name = other.name;
+
+    return *this;
+}
+
 void gl_shader_program::add_shader(GLenum shader_type, std::istream & shader_file_stream) {
     if(linked) {
         throw shader_program_already_linked_exception();
@@ -47,13 +69,17 @@ void gl_shader_program::add_shader(GLenum shader_type, std::istream & shader_fil
 
     glCompileShader(shader_name);
 
-    if(!check_for_shader_errors(shader_name)) {
-        added_shaders.push_back(shader_name);
+    if(check_for_shader_errors(shader_name)) {
+        throw shader_compilation_failure_exception();
     }
+
+    added_shaders.push_back(shader_name);
 }
 
 void gl_shader_program::link() {
-    linked = true;
+    if(linked) {
+        throw shader_program_already_linked_exception();
+    }
 
     gl_name = glCreateProgram();
     LOG(INFO) << "Created shader program " << gl_name;
@@ -64,11 +90,21 @@ void gl_shader_program::link() {
 
     glLinkProgram(gl_name);
     if(check_for_linking_errors()) {
+        // With hot reloading this happens every time someone saves a typo, so clean up everything. Nothing's linked,
+        // so the destructor won't try to delete the program again
         glDeleteProgram(gl_name);
+        gl_name = 0;
+
+        for(GLuint shader : added_shaders) {
+            glDeleteShader(shader);
+        }
+        added_shaders.clear();
 
         throw program_linking_failure_exception();
     }
 
+    linked = true;
+
     LOG(INFO) << "Program " << gl_name << " linked successfully";
 
     for(GLuint shader : added_shaders) {
@@ -78,7 +114,7 @@ void gl_shader_program::link() {
     }
 
     // No errors during linking? Let's get locations for our variables
-    set_uniform_locations();
+    reflect_program_interface();
 }
 
 std::string gl_shader_program::read_shader_file(std::istream & shader_file_stream) {
@@ -143,12 +179,76 @@ bool gl_shader_program::check_for_shader_errors(GLuint shader_to_check) {
     return false;
 }
 
-void gl_shader_program::set_uniform_locations() {
-    for(const std::string &name : uniform_names) {
-        int location = glGetUniformLocation(gl_name, name.c_str());
-        uniform_locations.emplace(name, location);
+void gl_shader_program::reflect_program_interface() {
+    GLint num_uniforms = 0;
+    GLint max_name_length = 0;
+    glGetProgramInterfaceiv(gl_name, GL_UNIFORM, GL_ACTIVE_RESOURCES, &num_uniforms);
+    glGetProgramInterfaceiv(gl_name, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+
+    GLint num_blocks = 0;
+    GLint max_block_name_length = 0;
+    glGetProgramInterfaceiv(gl_name, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &num_blocks);
+    glGetProgramInterfaceiv(gl_name, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &max_block_name_length);
+
+    GLint num_inputs = 0;
+    GLint max_input_name_length = 0;
+    glGetProgramInterfaceiv(gl_name, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &num_inputs);
+    glGetProgramInterfaceiv(gl_name, GL_PROGRAM_INPUT, GL_MAX_NAME_LENGTH, &max_input_name_length);
+
+    std::vector<GLchar> name_buffer((size_t) std::max(std::max(max_name_length, max_block_name_length), max_input_name_length) + 1);
+
+    const GLenum uniform_properties[] = {GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX};
+    for(GLint i = 0; i < num_uniforms; i++) {
+        GLint values[4];
+        glGetProgramResourceiv(gl_name, GL_UNIFORM, (GLuint) i, 4, uniform_properties, 4, nullptr, values);
+
+        if(values[3] != -1) {
+            // Members of uniform blocks don't have locations, they live in a UBO
+            continue;
+        }
+
+        glGetProgramResourceName(gl_name, GL_UNIFORM, (GLuint) i, (GLsizei) name_buffer.size(), nullptr, name_buffer.data());
+        std::string uniform_name(name_buffer.data());
+
+        // Arrays are reported as "name[0]", but everyone's going to ask for them by "name"
+        std::size_t bracket_pos = uniform_name.find('[');
+        if(bracket_pos != std::string::npos) {
+            uniform_name = uniform_name.substr(0, bracket_pos);
+        }
+
+        uniform_id id = get_uniform_id(uniform_name);
+        if(id >= uniforms.size()) {
+            uniforms.resize(id + 1);
+        }
+
+        uniforms[id].location = values[0];
+        uniforms[id].type = (GLenum) values[1];
+        uniforms[id].array_size = values[2];
+        uniform_locations[uniform_name] = values[0];
+
+        LOG(TRACE) << "Set location of variable " << uniform_name << " to " << values[0];
+    }
+
+    for(GLint i = 0; i < num_blocks; i++) {
+        glGetProgramResourceName(gl_name, GL_UNIFORM_BLOCK, (GLuint) i, (GLsizei) name_buffer.size(), nullptr, name_buffer.data());
+
+        uniform_id id = get_uniform_id(name_buffer.data());
+        if(id >= uniform_block_indices.size()) {
+            uniform_block_indices.resize(id + 1, GL_INVALID_INDEX);
+        }
+
+        uniform_block_indices[id] = (GLuint) i;
+
+        LOG(TRACE) << "Uniform block " << name_buffer.data() << " has index " << i;
+    }
+
+    const GLenum input_properties[] = {GL_LOCATION};
+    for(GLint i = 0; i < num_inputs; i++) {
+        GLint location;
+        glGetProgramResourceiv(gl_name, GL_PROGRAM_INPUT, (GLuint) i, 1, input_properties, 1, nullptr, &location);
+        glGetProgramResourceName(gl_name, GL_PROGRAM_INPUT, (GLuint) i, (GLsizei) name_buffer.size(), nullptr, name_buffer.data());
 
-        LOG(TRACE) << "Set location of variable " << name << " to " << location;
+        attribute_locations[name_buffer.data()] = location;
     }
 }
 
@@ -167,6 +267,8 @@ bool gl_shader_program::check_for_linking_errors() {
             LOG(ERROR) << "Error linking program " << gl_name << ":\n" << info_log;
         }
 
+        free(info_log);
+
         return true;
     }
 
@@ -174,22 +276,97 @@ bool gl_shader_program::check_for_linking_errors() {
 }
 
 void gl_shader_program::bind() noexcept {
-    //LOG(INFO) << "Binding program " << name;
-    glUseProgram(gl_name);
+    gl_state_cache::get().use_program(gl_name);
 }
 
 int gl_shader_program::get_uniform_location(std::string &uniform_name) const noexcept {
-    LOG(INFO) << "Geting uniform location for uniform " << uniform_name;
-    return 0;
+    auto location = uniform_locations.find(uniform_name);
+    if(location == uniform_locations.end()) {
+        return -1;
+    }
+
+    return location->second;
 }
 
 int gl_shader_program::get_attribute_location(std::string &attribute_name) const noexcept {
-    LOG(INFO) << "Getting attribute location for attribute " << attribute_name;
-    return 0;
+    auto location = attribute_locations.find(attribute_name);
+    if(location == attribute_locations.end()) {
+        return -1;
+    }
+
+    return location->second;
+}
+
+GLuint gl_shader_program::get_gl_name() const noexcept {
+    return gl_name;
+}
+
+GLuint gl_shader_program::get_uniform_block_index(uniform_id block) const noexcept {
+    if(block >= uniform_block_indices.size()) {
+        return GL_INVALID_INDEX;
+    }
+
+    return uniform_block_indices[block];
 }
 
 void gl_shader_program::set_uniform_data(GLuint location, int data) noexcept {
-    LOG(INFO) << "Setting uniform data for uniform at location " << location << " to " << data;
+    glProgramUniform1i(gl_name, (GLint) location, data);
+}
+
+uniform_id gl_shader_program::get_uniform_id(const std::string & uniform_name) {
+    // Only ever touched from the render thread, since that's the only place programs get linked
+    static std::unordered_map<std::string, uniform_id> interned_names;
+
+    auto id = interned_names.find(uniform_name);
+    if(id != interned_names.end()) {
+        return id->second;
+    }
+
+    uniform_id new_id = (uniform_id) interned_names.size();
+    interned_names.emplace(uniform_name, new_id);
+    return new_id;
+}
+
+void gl_shader_program::set_uniform(uniform_id uniform, int value) noexcept {
+    GLint location = prepare_upload(uniform, value);
+    if(location >= 0) {
+        glProgramUniform1i(gl_name, location, value);
+    }
+}
+
+void gl_shader_program::set_uniform(uniform_id uniform, float value) noexcept {
+    GLint location = prepare_upload(uniform, value);
+    if(location >= 0) {
+        glProgramUniform1f(gl_name, location, value);
+    }
+}
+
+void gl_shader_program::set_uniform(uniform_id uniform, const glm::vec2 & value) noexcept {
+    GLint location = prepare_upload(uniform, value);
+    if(location >= 0) {
+        glProgramUniform2fv(gl_name, location, 1, glm::value_ptr(value));
+    }
+}
+
+void gl_shader_program::set_uniform(uniform_id uniform, const glm::vec3 & value) noexcept {
+    GLint location = prepare_upload(uniform, value);
+    if(location >= 0) {
+        glProgramUniform3fv(gl_name, location, 1, glm::value_ptr(value));
+    }
+}
+
+void gl_shader_program::set_uniform(uniform_id uniform, const glm::vec4 & value) noexcept {
+    GLint location = prepare_upload(uniform, value);
+    if(location >= 0) {
+        glProgramUniform4fv(gl_name, location, 1, glm::value_ptr(value));
+    }
+}
+
+void gl_shader_program::set_uniform(uniform_id uniform, const glm::mat4 & value) noexcept {
+    GLint location = prepare_upload(uniform, value);
+    if(location >= 0) {
+        glProgramUniformMatrix4fv(gl_name, location, 1, GL_FALSE, glm::value_ptr(value));
+    }
 }
 
 std::vector<GLuint> &gl_shader_program::get_added_shaders() {
@@ -203,7 +380,7 @@ std::vector<std::string> &gl_shader_program::get_uniform_names() {
 gl_shader_program::~gl_shader_program() {
     if(linked) {
         LOG(INFO) << "Deleting program " << gl_name;
-        glDeleteProgram(gl_name);
+        gl_state_cache::get().delete_program(gl_name);
     } else {
         for(GLuint shader : added_shaders) {
             glDeleteShader(shader);
@@ -212,7 +389,7 @@ gl_shader_program::~gl_shader_program() {
 }
 
 void gl_shader_program::link_to_uniform_buffer(const gl_uniform_buffer &buffer) noexcept {
-    GLuint buffer_index = glGetUniformBlockIndex(gl_name, buffer.get_name().c_str());
+    GLuint buffer_index = get_uniform_block_index(get_uniform_id(buffer.get_name()));
     if(buffer_index == GL_INVALID_INDEX) {
         LOG(ERROR) << buffer.get_name() << " is not a valid identifier for program " << gl_name;
         // return;
@@ -224,21 +401,25 @@ void gl_shader_program::link_to_uniform_buffer(const gl_uniform_buffer &buffer)
 shader_file_not_found_exception::shader_file_not_found_exception(std::string file_name) :
         msg( "Could not open shader file " + file_name ) {}
 
-const char * shader_file_not_found_exception::what() noexcept {
+const char * shader_file_not_found_exception::what() const noexcept {
     return msg.c_str();
 }
 
-const char * shader_program_already_linked_exception::what() noexcept {
+const char * shader_compilation_failure_exception::what() const noexcept {
+    return "Shader failed to compile";
+}
+
+const char * shader_program_already_linked_exception::what() const noexcept {
     return "Program was already linked";
 }
 
-const char * program_linking_failure_exception::what() noexcept {
+const char * program_linking_failure_exception::what() const noexcept {
     return "Program failed to link";
 }
 
 shader_program_not_linked_exception::shader_program_not_linked_exception(std::string name) :
     msg("Tried to move shader " + name + ", but it's not complete yet") {}
 
-const char * shader_program_not_linked_exception::what() noexcept {
+const char * shader_program_not_linked_exception::what() const noexcept {
     return msg.c_str();
 }
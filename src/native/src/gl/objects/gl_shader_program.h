@@ -8,21 +8,37 @@
 #ifndef RENDERER_GL_SHADER_H
 #define RENDERER_GL_SHADER_H
 
+#include <cstring>
 #include <istream>
 #include <unordered_map>
 #include <vector>
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include "gl_uniform_buffer.h"
 
+/*!
+ * \brief A small integer that stands in for the name of a uniform variable or uniform block
+ *
+ * Uniform names are interned once, when you ask for the ID. Every program uses the same ID for the same name, so you
+ * can look up an ID at startup and use it with whatever program is bound. Setting a uniform by ID is a plain array
+ * index, no string hashing involved.
+ */
+typedef unsigned int uniform_id;
+
 class shader_program_already_linked_exception : public std::exception {
 public:
-    virtual const char * what() noexcept;
+    virtual const char * what() const noexcept override;
 };
 
 class program_linking_failure_exception : public std::exception {
 public:
-    virtual const char * what() noexcept;
+    virtual const char * what() const noexcept override;
+};
+
+class shader_compilation_failure_exception : public std::exception {
+public:
+    virtual const char * what() const noexcept override;
 };
 
 class shader_file_not_found_exception : public std::exception {
@@ -33,7 +49,7 @@ public:
      * \param file_name The name of the file that could not be found
      */
     shader_file_not_found_exception(std::string file_name);
-    virtual const char * what() noexcept;
+    virtual const char * what() const noexcept override;
 private:
     std::string msg;
 };
@@ -46,7 +62,7 @@ public:
      * \param name The name of the shader program that is not linked
      */
     shader_program_not_linked_exception(std::string name);
-    virtual const char * what() noexcept;
+    virtual const char * what() const noexcept override;
 private:
     std::string msg;
 };
@@ -74,7 +90,18 @@ public:
      */
     gl_shader_program(gl_shader_program && other);
 
-    gl_shader_program() {};
+    gl_shader_program() : linked(false), gl_name(0) {};
+
+    /*!
+     * \brief Move assignment operator
+     *
+     * Takes over the other program's OpenGL program and gives it ours, so the program that used to live here gets
+     * deleted when the other shader goes out of scope. This is how hot reloading swaps a freshly built program into
+     * the shaderpack without anyone holding a reference to the program noticing.
+     *
+     * Just like the move constructor, this throws if the other shader isn't linked yet
+     */
+    gl_shader_program & operator=(gl_shader_program && other);
 
     /*!
      * \brief Deletes this shader and all it holds dear
@@ -90,6 +117,8 @@ public:
      * \param source_file_name The name of the file to read the shader source from. Right now this file path is
      * relative to the working directory. Upon release this file path will be relative to the root of the current
      * shaderpack. Shaderpacks aren't implemented yet, so I can't really make this work the proper way yet
+     *
+     * \throws shader_compilation_failure_exception if the shader doesn't compile
      */
     void add_shader(GLenum shader_type, std::istream & shader_file_stream);
 
@@ -107,15 +136,19 @@ public:
 
     void link_to_uniform_buffer(const gl_uniform_buffer & buffer) noexcept;
 
+    /*!
+     * \brief Returns the OpenGL name of this program, or 0 if it isn't linked
+     */
+    GLuint get_gl_name() const noexcept;
+
     /*!
      * \brief Gets the locaiton of the given uniform variable
      *
-     * This is kinda GL-specific, but I'm only using OpenGL so I'm not all that worried at this point
+     * This is kinda GL-specific, but I'm only using OpenGL so I'm not all that worried at this point. This hashes the
+     * uniform name, so don't call it every frame. Use #get_uniform_id and the typed #set_uniform methods instead
      *
      * \param uniform_name The name of the uniform variable to get
-     * \return The OpenGL location of the given uniform
-     *
-     * \throws std::invalid_value if the given uniform name isn't in this shader
+     * \return The OpenGL location of the given uniform, or -1 if the uniform isn't active in this program
      */
     int get_uniform_location(std::string & uniform_name) const noexcept;
 
@@ -125,12 +158,16 @@ public:
     * This is kinda GL-specific, but I'm only using OpenGL so I'm not all that worried at this point
     *
     * \param uniform_name The name of the attribute variable to get
-    * \return The OpenGL location of the given attribute
-    *
-    * \throws std::invalid_value if the given attribute name isn't in this shader
+    * \return The OpenGL location of the given attribute, or -1 if the attribute isn't active in this program
     */
     int get_attribute_location(std::string & attribute_name) const noexcept;
 
+    /*!
+     * \brief Returns the index of the uniform block with the given ID, or GL_INVALID_INDEX if this program doesn't
+     * have that block
+     */
+    GLuint get_uniform_block_index(uniform_id block) const noexcept;
+
     /*!
      * \brief Sets the given integer as the data for the uniform variable with the given location
      *
@@ -139,6 +176,30 @@ public:
      */
     void set_uniform_data(unsigned int location, int data) noexcept;
 
+    /*!
+     * \brief Interns the given uniform or uniform block name, returning the ID that every program uses for it
+     *
+     * Call this once at startup and hang on to the ID
+     */
+    static uniform_id get_uniform_id(const std::string & uniform_name);
+
+    /*!
+     * \brief Sets the value of the uniform with the given ID
+     *
+     * These don't need the program to be bound. If the uniform isn't active in this program, or it already has the
+     * given value, nothing is sent to the driver. Only uniforms that aren't arrays remember their values, so setting
+     * an array uniform always uploads its first element
+     *
+     * \param uniform The ID of the uniform to set, from #get_uniform_id
+     * \param value The new value of the uniform
+     */
+    void set_uniform(uniform_id uniform, int value) noexcept;
+    void set_uniform(uniform_id uniform, float value) noexcept;
+    void set_uniform(uniform_id uniform, const glm::vec2 & value) noexcept;
+    void set_uniform(uniform_id uniform, const glm::vec3 & value) noexcept;
+    void set_uniform(uniform_id uniform, const glm::vec4 & value) noexcept;
+    void set_uniform(uniform_id uniform, const glm::mat4 & value) noexcept;
+
     /*
      * Testing functions
      *
@@ -151,10 +212,33 @@ public:
     std::vector<std::string> & get_uniform_names();
 
 private:
+    /*!
+     * \brief Everything we know about a single active uniform, along with the last value we sent for it
+     */
+    struct uniform_slot {
+        GLint location = -1;
+        GLenum type = 0;
+        GLint array_size = 0;
+        bool has_value = false;
+        unsigned char value[sizeof(glm::mat4)];
+    };
+
     std::string name;   //!< Mostly useful for debugging
 
-    std::unordered_map<std::string, GLuint> uniform_locations;
-    std::unordered_map<std::string, GLuint> attribute_locations;
+    std::unordered_map<std::string, GLint> uniform_locations;
+    std::unordered_map<std::string, GLint> attribute_locations;
+
+    /*!
+     * \brief All the uniforms in this program, indexed by uniform_id. Slots for uniforms this program doesn't have
+     * have a location of -1
+     */
+    std::vector<uniform_slot> uniforms;
+
+    /*!
+     * \brief The index of each uniform block in this program, indexed by uniform_id
+     */
+    std::vector<GLuint> uniform_block_indices;
+
     bool linked;
 
     GLuint gl_name;
@@ -167,9 +251,43 @@ private:
 
     bool check_for_shader_errors(GLuint shader_to_check);
 
-    void set_uniform_locations();
+    /*!
+     * \brief Asks OpenGL about every active uniform, uniform block, and input of the freshly linked program and fills
+     * in the lookup tables
+     */
+    void reflect_program_interface();
 
     bool check_for_linking_errors();
+
+    /*!
+     * \brief Decides whether the given value needs to be sent to the given uniform, remembering it if so
+     *
+     * \return The location to upload the value to, or -1 if the upload can be skipped
+     */
+    template <typename T>
+    GLint prepare_upload(uniform_id uniform, const T & value) noexcept {
+        static_assert(sizeof(T) <= sizeof(uniform_slot::value), "Uniform value is too big to cache");
+
+        if(uniform >= uniforms.size()) {
+            return -1;
+        }
+
+        uniform_slot & slot = uniforms[uniform];
+        if(slot.location < 0) {
+            return -1;
+        }
+
+        if(slot.array_size == 1) {
+            if(slot.has_value && memcmp(slot.value, &value, sizeof(T)) == 0) {
+                return -1;
+            }
+
+            memcpy(slot.value, &value, sizeof(T));
+            slot.has_value = true;
+        }
+
+        return slot.location;
+    }
 };
 
 
@@ -0,0 +1,125 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <easylogging++.h>
+#include "gl_staging_buffer.h"
+#include "gl/gl_state_cache.h"
+
+const GLsizeiptr gl_staging_buffer::ALIGNMENT;
+
+/*!
+ * \brief How long to wait on a fence before complaining about it, in nanoseconds
+ */
+static const GLuint64 FENCE_TIMEOUT = 1000 * 1000 * 1000;
+
+gl_staging_buffer::gl_staging_buffer(GLsizeiptr capacity) : capacity(capacity) {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, capacity, nullptr, flags);
+    mapped_data = static_cast<uint8_t *>(glMapNamedBufferRange(buffer, 0, capacity, flags));
+
+    if(mapped_data == nullptr) {
+        LOG(ERROR) << "Couldn't map a " << capacity << " byte staging buffer. Nothing can be allocated from it";
+    }
+}
+
+gl_staging_buffer::~gl_staging_buffer() {
+    for(fenced_region & region : fences) {
+        glDeleteSync(region.sync);
+    }
+
+    if(mapped_data != nullptr) {
+        glUnmapNamedBuffer(buffer);
+    }
+
+    gl_state_cache::get().delete_buffers(1, &buffer);
+}
+
+gl_staging_buffer::allocation gl_staging_buffer::allocate(GLsizeiptr size) {
+    allocation result;
+    if(mapped_data == nullptr || size <= 0 || size > capacity) {
+        LOG(ERROR) << "Can't allocate " << size << " bytes from a " << capacity << " byte staging buffer";
+        return result;
+    }
+
+    const GLsizeiptr aligned_size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    // Allocations don't wrap, so one that doesn't fit before the end of the ring skips to the start
+    GLsizeiptr offset = (GLsizeiptr) (head % capacity);
+    uint64_t skipped = 0;
+    if(offset + aligned_size > capacity) {
+        skipped = (uint64_t) (capacity - offset);
+        offset = 0;
+    }
+
+    bool stalled = false;
+    while(head + skipped + aligned_size - tail > (uint64_t) capacity) {
+        stalled = true;
+        if(!wait_for_oldest_fence()) {
+            LOG(ERROR) << "The staging buffer is full of allocations that were never copied anywhere";
+            return result;
+        }
+    }
+
+    if(stalled) {
+        num_stalls++;
+    }
+
+    head += skipped + aligned_size;
+
+    result.data = mapped_data + offset;
+    result.offset = offset;
+    result.size = size;
+    return result;
+}
+
+void gl_staging_buffer::copy_to(const allocation & source, GLuint destination, GLintptr destination_offset) {
+    if(source.data == nullptr) {
+        return;
+    }
+
+    // The mapping is coherent, so whatever was written to source.data is already visible to the copy
+    glCopyNamedBufferSubData(buffer, destination, source.offset, destination_offset, source.size);
+
+    // The fence covers everything allocated so far, not just this allocation. Anything before this one that was
+    // copied already has its own fence, and anything that wasn't copied is a bug anyways
+    fenced_region region = {glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), head};
+    fences.push_back(region);
+}
+
+GLsizeiptr gl_staging_buffer::get_capacity() const {
+    return capacity;
+}
+
+uint64_t gl_staging_buffer::get_num_stalls() const {
+    return num_stalls;
+}
+
+bool gl_staging_buffer::wait_for_oldest_fence() {
+    if(fences.empty()) {
+        return false;
+    }
+
+    fenced_region & oldest = fences.front();
+    while(true) {
+        GLenum result = glClientWaitSync(oldest.sync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        if(result == GL_WAIT_FAILED) {
+            LOG(ERROR) << "Waiting on a staging buffer fence failed. Assuming the GPU is done with it";
+            break;
+        }
+
+        LOG(WARNING) << "Still waiting for the GPU to finish with part of the staging buffer";
+    }
+
+    glDeleteSync(oldest.sync);
+    tail = oldest.end;
+    fences.pop_front();
+
+    return true;
+}
@@ -0,0 +1,106 @@
+/*!
+ * \brief Defines a persistently mapped ring buffer that data goes through on its way to other buffers
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_GL_STAGING_BUFFER_H
+#define RENDERER_GL_STAGING_BUFFER_H
+
+#include <cstdint>
+#include <deque>
+#include <glad/glad.h>
+
+/*!
+ * \brief A chunk of GPU-visible memory that you can write into, then copy into a real buffer
+ *
+ * The point of this is to let things like chunk meshers write their vertices straight into memory the GPU can read,
+ * instead of building them up in a std::vector and having the driver copy that vector somewhere else. Allocate
+ * however many bytes you need, write into the allocation, then hand it to #copy_to (or
+ * gl_vertex_buffer::set_data_from_staging), which copies it on the GPU.
+ *
+ * The whole buffer is mapped once, persistently and coherently, and allocations go around it like a ring. Every
+ * copy puts a fence behind it. When the ring runs out of room, #allocate waits on the oldest fences until enough of
+ * the ring is free again. That only happens when the GPU is really far behind, so make the ring big enough to hold a
+ * couple frames' worth of uploads.
+ *
+ * Every allocation has to be copied before the ring comes back around to it, since the ring doesn't know an
+ * allocation is done with until a copy fences it
+ */
+class gl_staging_buffer {
+public:
+    /*!
+     * \brief Some space in the staging buffer
+     */
+    struct allocation {
+        void * data = nullptr;      //!< Where to write. nullptr if the allocation failed
+        GLintptr offset = 0;        //!< Where data is in the staging buffer
+        GLsizeiptr size = 0;
+    };
+
+    /*!
+     * \brief How many bytes each allocation is aligned to. Big enough for anything that goes into a vertex
+     */
+    static const GLsizeiptr ALIGNMENT = 16;
+
+    /*!
+     * \param capacity How many bytes the ring can hold
+     */
+    gl_staging_buffer(GLsizeiptr capacity);
+
+    ~gl_staging_buffer();
+
+    gl_staging_buffer(const gl_staging_buffer & other) = delete;
+    gl_staging_buffer & operator=(const gl_staging_buffer & other) = delete;
+
+    /*!
+     * \brief Gets size bytes of the ring, waiting for the GPU if it has to
+     *
+     * \return The allocation, with a nullptr data if size is bigger than the whole ring or if the ring is full of
+     * allocations that haven't been copied yet
+     */
+    allocation allocate(GLsizeiptr size);
+
+    /*!
+     * \brief Copies the allocation into destination, starting destination_offset bytes in, then fences the ring up to
+     * the end of the allocation
+     */
+    void copy_to(const allocation & source, GLuint destination, GLintptr destination_offset);
+
+    GLsizeiptr get_capacity() const;
+
+    /*!
+     * \brief Returns how many times #allocate had to wait for the GPU. If this keeps going up, the ring is too small
+     */
+    uint64_t get_num_stalls() const;
+
+private:
+    /*!
+     * \brief Everything in the ring before end is free once sync is signaled
+     */
+    struct fenced_region {
+        GLsync sync;
+        uint64_t end;
+    };
+
+    GLuint buffer = 0;
+    uint8_t * mapped_data = nullptr;
+    GLsizeiptr capacity;
+
+    // Positions only ever go up, so head - tail is how much of the ring is in use even after it wraps around
+    uint64_t head = 0;  //!< Where the next allocation goes
+    uint64_t tail = 0;  //!< Where the oldest allocation that might still be in use starts
+
+    std::deque<fenced_region> fences;
+
+    uint64_t num_stalls = 0;
+
+    /*!
+     * \brief Waits for the oldest fence, and frees everything it covers
+     *
+     * \return False if there weren't any fences to wait for
+     */
+    bool wait_for_oldest_fence();
+};
+
+#endif //RENDERER_GL_STAGING_BUFFER_H
@@ -4,41 +4,64 @@
  */
 
 #include "gl_uniform_buffer.h"
+#include "utils/async_log.h"
+#include "gl/gl_state_cache.h"
 
-gl_uniform_buffer::gl_uniform_buffer(GLuint size) {
-    glGenBuffers(1, &gl_name);
-    bind();
-    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+gl_uniform_buffer::gl_uniform_buffer(GLuint size) : size(size) {
+    glCreateBuffers(1, &gl_name);
+    glNamedBufferStorage(gl_name, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
 }
 
 gl_uniform_buffer::gl_uniform_buffer(gl_uniform_buffer &&old) noexcept {
     gl_name = old.gl_name;
     bind_point = old.bind_point;
+    size = old.size;
+    name = std::move(old.name);
     old.gl_name = 0;
     old.bind_point = 0;
+    old.size = 0;
 }
 
 gl_uniform_buffer::~gl_uniform_buffer() {
-    LOG(TRACE) << "Deleting buffer " << gl_name;
-    glDeleteBuffers(1, &gl_name);
+    if(gl_name != 0) {
+        LOG(TRACE) << "Deleting buffer " << gl_name;
+        gl_state_cache::get().delete_buffers(1, &gl_name);
+    }
 }
 
 void gl_uniform_buffer::bind() {
-    LOG(TRACE) << "Binding buffer " << gl_name;
-    glBindBuffer(GL_UNIFORM_BUFFER, gl_name);
+    NOVA_LOG_TRACE("Binding buffer {}", gl_name);
+    gl_state_cache::get().bind_buffer(GL_UNIFORM_BUFFER, gl_name);
 }
 
 void gl_uniform_buffer::set_bind_point(GLuint bind_point) {
-    LOG(TRACE) << "Setting buffer " << gl_name << " to bind point " << bind_point;
-    glBindBufferBase(GL_UNIFORM_BUFFER, bind_point, gl_name);
+    NOVA_LOG_TRACE("Setting buffer {} to bind point {}", gl_name, bind_point);
+    gl_state_cache::get().bind_buffer_base(GL_UNIFORM_BUFFER, bind_point, gl_name);
     this->bind_point = bind_point;
 }
 
 void gl_uniform_buffer::operator=(gl_uniform_buffer && old) noexcept {
+    if(gl_name != 0) {
+        gl_state_cache::get().delete_buffers(1, &gl_name);
+    }
+
     gl_name = old.gl_name;
     bind_point = old.bind_point;
+    size = old.size;
+    name = std::move(old.name);
     old.gl_name = 0;
     old.bind_point = 0;
+    old.size = 0;
+}
+
+void gl_uniform_buffer::send_data(const void * data, GLuint num_bytes) {
+    if(num_bytes > size) {
+        LOG(ERROR) << "Tried to send " << num_bytes << " bytes to uniform buffer " << name << ", which only holds "
+                   << size << " bytes";
+        return;
+    }
+
+    glNamedBufferSubData(gl_name, 0, num_bytes, data);
 }
 
 void gl_uniform_buffer::set_name(std::string name) noexcept {
@@ -65,22 +65,27 @@ public:
      * Note that absolutely no checking is done to make sure you're uploading the right data. You better know what
      * you're doing.
      *
-     * Note also that this function binds the UBO, so you don't need to bind it yourself.
+     * This doesn't bind anything. The data goes straight into the buffer with glNamedBufferSubData. (This used to map
+     * the buffer and never unmap it, which is an error the next time anyone draws with it)
      */
     template <typename T>
-    void send_data(T data) {
-        bind();
-        GLvoid * p = glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
-
-        memcpy(p, &data, sizeof(T));
-        //glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    void send_data(const T & data) {
+        send_data(&data, sizeof(T));
     };
 
+    /*!
+     * \brief Uploads the given bytes to the start of this UBO
+     *
+     * If there are more bytes than the buffer holds, nothing is uploaded and an error is logged
+     */
+    void send_data(const void * data, GLuint num_bytes);
+
     void operator=(gl_uniform_buffer && old) noexcept;
 
 private:
-    GLuint gl_name;
-    GLuint bind_point;
+    GLuint gl_name = 0;
+    GLuint bind_point = 0;
+    GLuint size = 0;
     std::string name;
 };
 
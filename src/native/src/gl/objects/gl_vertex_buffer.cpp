@@ -3,14 +3,20 @@
  * \date 13-May-16.
  */
 
+#include <cstddef>
 #include <stdexcept>
 #include <easylogging++.h>
 #include "gl_vertex_buffer.h"
+#include "gl_quad_index_buffer.h"
+#include "gl/gl_state_cache.h"
+#include "utils/async_log.h"
 
 gl_vertex_buffer::gl_vertex_buffer() {
     vertex_array = 0xFFFFFFFF;
     vertex_buffer = 0xFFFFFFFF;
     indices = 0xFFFFFFFF;
+    num_indices = 0;
+    mapped = false;
     create();
 }
 
@@ -19,101 +25,393 @@ gl_vertex_buffer::~gl_vertex_buffer() {
 }
 
 void gl_vertex_buffer::create() {
-    glGenVertexArrays(1, &vertex_array);
-    glBindVertexArray(vertex_array);
-    glGenBuffers(1, &vertex_buffer);
-    glGenBuffers(1, &indices);
+    glCreateVertexArrays(1, &vertex_array);
+    enabled_attributes = 0;
+
+    // The buffers get their real storage in set_data and set_index_array, when we know how big they are
+    vertex_buffer_size = 0;
+    index_buffer_size = 0;
+    vertex_storage_flags = 0;
+    index_storage_flags = 0;
+    glCreateBuffers(1, &vertex_buffer);
+    glCreateBuffers(1, &indices);
+
+    gl_state_cache::get().set_element_buffer(vertex_array, indices);
+    index_type = GL_UNSIGNED_SHORT;
+    uses_quad_indices = false;
 }
 
 void gl_vertex_buffer::destroy() {
+    // Deleting a mapped buffer unmaps it
+    mapped = false;
+
     if(vertex_buffer != 0xFFFFFFFF) {
-        glDeleteBuffers(1, &vertex_buffer);
+        gl_state_cache::get().delete_buffers(1, &vertex_buffer);
         vertex_buffer = 0xFFFFFFFF;
     }
 
     if(indices != 0xFFFFFFFF) {
-        glDeleteBuffers(1, &indices);
+        gl_state_cache::get().delete_buffers(1, &indices);
         indices = 0xFFFFFFFF;
     }
+
+    if(vertex_array != 0xFFFFFFFF) {
+        gl_state_cache::get().delete_vertex_arrays(1, &vertex_array);
+        vertex_array = 0xFFFFFFFF;
+    }
+}
+
+void gl_vertex_buffer::set_data(const std::vector<float> & data, format data_format, usage data_usage) {
+    set_data(data.data(), data.size() * sizeof(float), data_format, data_usage);
+}
+
+void gl_vertex_buffer::set_data(const void * data, std::size_t num_bytes, format data_format, usage data_usage) {
+    if(data == nullptr && num_bytes > 0) {
+        LOG(ERROR) << "Tried to set " << num_bytes << " bytes of vertex data from a null pointer";
+        return;
+    }
+
+    if(reserve_vertex_buffer((GLsizeiptr) num_bytes, data_format, translate_usage(data_usage), data)) {
+        return;
+    }
+
+    // The buffer was already the right size and we're allowed to change it, so just overwrite what's there
+    if(num_bytes > 0) {
+        glNamedBufferSubData(vertex_buffer, 0, (GLsizeiptr) num_bytes, data);
+    }
+}
+
+void gl_vertex_buffer::set_data_from_staging(gl_staging_buffer & staging, const gl_staging_buffer::allocation & data,
+                                             format data_format, usage data_usage) {
+    if(data.data == nullptr) {
+        LOG(ERROR) << "Tried to set vertex data from a staging allocation that failed";
+        return;
+    }
+
+    // Copies don't care whether a buffer is dynamic, so an old buffer of the right size can always take the data
+    reserve_vertex_buffer(data.size, data_format, translate_usage(data_usage), nullptr);
+    staging.copy_to(data, vertex_buffer, 0);
+}
+
+void * gl_vertex_buffer::map_data(std::size_t num_bytes, format data_format, usage data_usage) {
+    if(mapped) {
+        LOG(ERROR) << "Tried to map a vertex buffer that's already mapped";
+        return nullptr;
+    }
+
+    if(num_bytes == 0) {
+        LOG(ERROR) << "Tried to map zero bytes of a vertex buffer";
+        return nullptr;
+    }
+
+    reserve_vertex_buffer((GLsizeiptr) num_bytes, data_format, translate_usage(data_usage) | GL_MAP_WRITE_BIT, nullptr);
+
+    // Invalidating tells the driver we don't care what was there before, so it doesn't have to read it back
+    void * data = glMapNamedBufferRange(vertex_buffer, 0, (GLsizeiptr) num_bytes,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(data == nullptr) {
+        LOG(ERROR) << "Couldn't map " << num_bytes << " bytes of a vertex buffer";
+        return nullptr;
+    }
+
+    mapped = true;
+    return data;
+}
+
+void gl_vertex_buffer::unmap_data() {
+    if(!mapped) {
+        LOG(ERROR) << "Tried to unmap a vertex buffer that isn't mapped";
+        return;
+    }
+
+    if(glUnmapNamedBuffer(vertex_buffer) == GL_FALSE) {
+        // Very rare, and only happens when something like a mode switch trashes video memory
+        LOG(WARNING) << "A vertex buffer's data got corrupted while it was mapped. Write the data again";
+    }
+
+    mapped = false;
 }
 
-void gl_vertex_buffer::set_data(std::vector<float> data, format data_format, usage data_usage) {
+bool gl_vertex_buffer::reserve_vertex_buffer(GLsizeiptr size, format data_format, GLbitfield storage_flags,
+                                             const void * initial_data) {
     this->data_format = data_format;
 
-    glBindVertexArray(vertex_array);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    GLenum buffer_usage = translate_usage(data_usage);
-    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), buffer_usage);
+    // Without any data, we're about to write the whole thing some other way, so an old buffer of the right size is
+    // fine as long as it's allowed to change. With data, a static buffer gets the data when it's made
+    const bool can_change = initial_data == nullptr || (storage_flags & GL_DYNAMIC_STORAGE_BIT) != 0;
+    if(size == vertex_buffer_size && storage_flags == vertex_storage_flags && can_change) {
+        enable_vertex_attributes(data_format);
+        glVertexArrayVertexBuffer(vertex_array, 0, vertex_buffer, 0, get_stride(data_format));
+        return false;
+    }
+
+    make_storage(vertex_buffer, vertex_buffer_size, vertex_storage_flags, initial_data, size, storage_flags);
 
+    // New buffer, so the vertex array needs to hear about it
+    glVertexArrayVertexBuffer(vertex_array, 0, vertex_buffer, 0, get_stride(data_format));
     enable_vertex_attributes(data_format);
+    return true;
 }
 
-GLenum gl_vertex_buffer::translate_usage(const usage data_usage) const {
+void gl_vertex_buffer::set_sub_data(unsigned int first_float, const float * data, unsigned int num_floats) {
+    if((first_float + num_floats) * sizeof(float) > (std::size_t) vertex_buffer_size) {
+        LOG(ERROR) << "Tried to write floats " << first_float << " through " << first_float + num_floats
+                   << " of a vertex buffer that's only " << vertex_buffer_size << " bytes";
+        return;
+    }
+
+    if((vertex_storage_flags & GL_DYNAMIC_STORAGE_BIT) == 0) {
+        LOG(ERROR) << "Tried to change part of a static vertex buffer. Use usage::dynamic_draw if it needs to change";
+        return;
+    }
+
+    glNamedBufferSubData(vertex_buffer, first_float * sizeof(float), num_floats * sizeof(float), data);
+}
+
+GLbitfield gl_vertex_buffer::translate_usage(const usage data_usage) const {
     switch(data_usage) {
         case usage::dynamic_draw:
-            return GL_DYNAMIC_DRAW;
+            return GL_DYNAMIC_STORAGE_BIT;
         case usage::static_draw:
-            return GL_STATIC_DRAW;
+            // Static buffers can't be changed after they're made. Giving them new data makes a new buffer
+            return 0;
         default:
             // In case something bad happens
             throw std::invalid_argument("data_usage value unsupported");
     }
 }
 
+void gl_vertex_buffer::make_storage(GLuint & buffer, GLsizeiptr & buffer_size, GLbitfield & storage_flags,
+                                    const void * data, GLsizeiptr size, GLbitfield new_storage_flags) {
+    // Buffer storage can't be resized, so make a new buffer. Zero sized storage isn't allowed either, so empty
+    // buffers get a single byte
+    gl_state_cache::get().delete_buffers(1, &buffer);
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size > 0 ? size : 1, size > 0 ? data : nullptr, new_storage_flags);
+
+    buffer_size = size;
+    storage_flags = new_storage_flags;
+}
+
 void gl_vertex_buffer::set_active() {
-    glBindVertexArray(vertex_array);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+    // The vertex array already knows about the vertex buffer and the index buffer, so binding it is all we need. It
+    // used to bind all three every time
+    gl_state_cache::get().bind_vertex_array(vertex_array);
+}
+
+void gl_vertex_buffer::set_index_array(const std::vector<unsigned short> & data, usage data_usage) {
+    set_index_array(data.data(), data.size(), data_usage);
 }
 
-void gl_vertex_buffer::set_index_array(std::vector<unsigned short> data, usage data_usage) {
-    glBindVertexArray(vertex_array);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
-    GLenum buffer_usage = translate_usage(data_usage);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.size() * sizeof(unsigned short), data.data(), buffer_usage);
+void gl_vertex_buffer::set_index_array(const unsigned short * data, std::size_t count, usage data_usage) {
+    if(data == nullptr && count > 0) {
+        LOG(ERROR) << "Tried to set " << count << " indices from a null pointer";
+        return;
+    }
+
+    GLsizeiptr size = (GLsizeiptr) (count * sizeof(unsigned short));
+    GLbitfield storage_flags = translate_usage(data_usage);
+    if(reserve_index_buffer(size, storage_flags, data)) {
+        glNamedBufferSubData(indices, 0, size, data);
+    }
+
+    index_type = GL_UNSIGNED_SHORT;
+    num_indices = (unsigned int) count;
+}
 
-    num_indices = (unsigned int) data.size();
+void gl_vertex_buffer::set_index_array(const std::vector<unsigned int> & data, usage data_usage) {
+    set_index_array(data.data(), data.size(), data_usage);
+}
+
+void gl_vertex_buffer::set_index_array(const unsigned int * data, std::size_t count, usage data_usage) {
+    if(data == nullptr && count > 0) {
+        LOG(ERROR) << "Tried to set " << count << " indices from a null pointer";
+        return;
+    }
+
+    unsigned int max_index = 0;
+    for(std::size_t i = 0; i < count; i++) {
+        max_index = data[i] > max_index ? data[i] : max_index;
+    }
+
+    if(max_index > 0xFFFF) {
+        // Too many vertices for 16 bits, so keep all 32
+        GLsizeiptr size = (GLsizeiptr) (count * sizeof(unsigned int));
+        if(reserve_index_buffer(size, translate_usage(data_usage), data)) {
+            glNamedBufferSubData(indices, 0, size, data);
+        }
+
+        index_type = GL_UNSIGNED_INT;
+        num_indices = (unsigned int) count;
+        return;
+    }
+
+    // Every index fits in 16 bits, so only use 16. Narrowing them straight into a mapped buffer saves making a copy
+    // on the heap
+    GLsizeiptr size = (GLsizeiptr) (count * sizeof(unsigned short));
+    reserve_index_buffer(size, translate_usage(data_usage) | GL_MAP_WRITE_BIT, nullptr);
+
+    if(size > 0) {
+        unsigned short * narrow_indices = static_cast<unsigned short *>(
+                glMapNamedBufferRange(indices, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if(narrow_indices == nullptr) {
+            LOG(ERROR) << "Couldn't map an index buffer to write " << count << " indices to it";
+            num_indices = 0;
+            return;
+        }
+
+        for(std::size_t i = 0; i < count; i++) {
+            narrow_indices[i] = (unsigned short) data[i];
+        }
+        glUnmapNamedBuffer(indices);
+    }
+
+    index_type = GL_UNSIGNED_SHORT;
+    num_indices = (unsigned int) count;
+}
+
+void gl_vertex_buffer::use_quad_indices(unsigned int num_quads) {
+    if(!uses_quad_indices) {
+        gl_state_cache::get().set_element_buffer(vertex_array, gl_quad_index_buffer::get().get_buffer());
+        uses_quad_indices = true;
+    }
+
+    index_type = GL_UNSIGNED_SHORT;
+    num_indices = num_quads * gl_quad_index_buffer::INDICES_PER_QUAD;
+}
+
+GLenum gl_vertex_buffer::get_index_type() const {
+    return index_type;
+}
+
+bool gl_vertex_buffer::reserve_index_buffer(GLsizeiptr size, GLbitfield storage_flags, const void * initial_data) {
+    bool needs_data = false;
+
+    const bool can_change = initial_data == nullptr || (storage_flags & GL_DYNAMIC_STORAGE_BIT) != 0;
+    if(size == index_buffer_size && storage_flags == index_storage_flags && can_change) {
+        needs_data = initial_data != nullptr && size > 0;
+    } else {
+        make_storage(indices, index_buffer_size, index_storage_flags, initial_data, size, storage_flags);
+        if(!uses_quad_indices) {
+            gl_state_cache::get().set_element_buffer(vertex_array, indices);
+        }
+    }
+
+    if(uses_quad_indices) {
+        // Back to our own indices
+        gl_state_cache::get().set_element_buffer(vertex_array, indices);
+        uses_quad_indices = false;
+    }
+
+    return needs_data;
 }
 
 void gl_vertex_buffer::draw() {
-    if(num_indices > 0) {
-        glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, 0);
+    draw(num_indices);
+}
+
+void gl_vertex_buffer::draw(unsigned int num_indices) {
+    if(mapped) {
+        NOVA_LOG_ERROR("Tried to draw a vertex buffer that's still mapped. Call unmap_data first");
+        return;
+    }
+
+    if(num_indices > this->num_indices) {
+        num_indices = this->num_indices;
+    }
+
+    if(num_indices == 0) {
+        return;
+    }
+
+    if(uses_quad_indices) {
+        gl_quad_index_buffer::draw_quads(num_indices);
+    } else {
+        glDrawElements(GL_TRIANGLES, num_indices, index_type, nullptr);
     }
 }
 
-void gl_vertex_buffer::enable_vertex_attributes(format data_format) {
+GLsizei gl_vertex_buffer::get_stride(format data_format) {
     switch(data_format) {
         case format::POS:
-            // We only need to set up positional data
-            // Positions are always at vertex attribute 0
-            glEnableVertexAttribArray(0);   // Position
-
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+            return sizeof(pos_vertex);
+        case format::POS_UV:
+            return sizeof(pos_uv_vertex);
+        case format::TERRAIN_PACKED:
+            return sizeof(packed_terrain_vertex);
+        case format::POS_UV_LIGHTMAPUV_NORMAL_TANGENT:
+        default:
+            return sizeof(pos_uv_lightmapuv_normal_tangent_vertex);
+    }
+}
 
+void gl_vertex_buffer::enable_vertex_attributes(format data_format) {
+    // The offsets used to be hand-written here, and they were all 0. Now they come from the vertex structs themselves
+    switch(data_format) {
+        case format::POS:
+            enable_attributes(vertex_layout<pos_vertex>::attributes, get_num_attributes<pos_vertex>());
             break;
 
         case format::POS_UV:
-            glEnableVertexAttribArray(0);   // Position
-            glEnableVertexAttribArray(1);   // Texture UV
-
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GL_FLOAT), (void*)0);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GL_FLOAT), (void*)0);
-
+            enable_attributes(vertex_layout<pos_uv_vertex>::attributes, get_num_attributes<pos_uv_vertex>());
             break;
 
         case format::POS_UV_LIGHTMAPUV_NORMAL_TANGENT:
-            glEnableVertexAttribArray(0);   // Position
-            glEnableVertexAttribArray(1);   // Texture UV
-            glEnableVertexAttribArray(2);   // Lightmap UV
-            glEnableVertexAttribArray(3);   // Normal
-            glEnableVertexAttribArray(4);   // Tangent
-
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 13 * sizeof(GL_FLOAT), (void*)0);
-            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 13 * sizeof(GL_FLOAT), (void*)0);
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 13 * sizeof(GL_FLOAT), (void*)0);
-            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 13 * sizeof(GL_FLOAT), (void*)0);
-            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 13 * sizeof(GL_FLOAT), (void*)0);
+            enable_attributes(vertex_layout<pos_uv_lightmapuv_normal_tangent_vertex>::attributes,
+                              get_num_attributes<pos_uv_lightmapuv_normal_tangent_vertex>());
+            break;
 
+        case format::TERRAIN_PACKED:
+            enable_attributes(vertex_layout<packed_terrain_vertex>::attributes,
+                              get_num_attributes<packed_terrain_vertex>());
             break;
     }
 }
+
+void gl_vertex_buffer::enable_attributes(const vertex_attribute * attributes, std::size_t num_attributes) {
+    uint32_t new_enabled_attributes = 0;
+
+    // Every attribute reads from the buffer at binding 0
+    for(std::size_t i = 0; i < num_attributes; i++) {
+        const vertex_attribute & attribute = attributes[i];
+        const GLenum type = translate_component_type(attribute.type);
+
+        glEnableVertexArrayAttrib(vertex_array, attribute.location);
+        if(attribute.type != component_type::float32 && !attribute.normalized) {
+            // Integers that stay integers need the I version, or GL turns them into floats anyways
+            glVertexArrayAttribIFormat(vertex_array, attribute.location, attribute.num_components, type,
+                                       (GLuint) attribute.offset);
+        } else {
+            glVertexArrayAttribFormat(vertex_array, attribute.location, attribute.num_components, type,
+                                      (GLboolean) (attribute.normalized ? GL_TRUE : GL_FALSE),
+                                      (GLuint) attribute.offset);
+        }
+        glVertexArrayAttribBinding(vertex_array, attribute.location, 0);
+
+        new_enabled_attributes |= 1u << attribute.location;
+    }
+
+    // If the format changed, the old format's extra attributes would still be reading from the buffer
+    const uint32_t stale_attributes = enabled_attributes & ~new_enabled_attributes;
+    for(GLuint location = 0; location < 32; location++) {
+        if((stale_attributes & (1u << location)) != 0) {
+            glDisableVertexArrayAttrib(vertex_array, location);
+        }
+    }
+
+    enabled_attributes = new_enabled_attributes;
+}
+
+GLenum gl_vertex_buffer::translate_component_type(component_type type) {
+    switch(type) {
+        case component_type::uint16:
+            return GL_UNSIGNED_SHORT;
+        case component_type::uint8:
+            return GL_UNSIGNED_BYTE;
+        case component_type::int8:
+            return GL_BYTE;
+        case component_type::float32:
+        default:
+            return GL_FLOAT;
+    }
+}
@@ -7,14 +7,25 @@
 #define RENDERER_GL_VERTEX_BUFFER_H
 
 
+#include <cstdint>
 #include "interfaces/ivertex_buffer.h"
+#include "core/vertex_layouts.h"
+#include "gl_staging_buffer.h"
 #include <glad/glad.h>
 
 /*!
  * \brief Represents a buffer which holds vertex information
  *
  * Buffers of this type can hold positions, positions and texture coordinates, or positions, texture coordinates,
- * lightmap coordinates, normals, and tangents.
+ * lightmap coordinates, normals, and tangents. That last one can also be packed into a packed_terrain_vertex. Each
+ * format's vertex array setup comes from its vertex_layout.
+ *
+ * Everything here uses direct state access, so changing a buffer never binds anything. The only thing that binds is
+ * #set_active.
+ *
+ * There are three ways to get vertices in here. #set_data copies them from wherever they are. #map_data lets you write
+ * them straight into the buffer. #set_data_from_staging copies them from a gl_staging_buffer on the GPU, which is best
+ * for lots of buffers at once, like chunks.
  */
 class gl_vertex_buffer : public ivertex_buffer {
 public:
@@ -25,28 +36,123 @@ public:
 
     void destroy();
 
-    void set_data(std::vector<float> data, format data_format, usage data_usage);
+    void set_data(const std::vector<float> & data, format data_format, usage data_usage);
+
+    void set_data(const void * data, std::size_t num_bytes, format data_format, usage data_usage);
+
+    /*!
+     * \brief Sets this vertex buffer's data to an allocation from a staging buffer, copying it on the GPU
+     *
+     * This is how chunk meshers should upload: allocate from the staging buffer, write the vertices into the
+     * allocation, then call this. The vertices never touch the heap, and the driver never has to copy them
+     */
+    void set_data_from_staging(gl_staging_buffer & staging, const gl_staging_buffer::allocation & data,
+                               format data_format, usage data_usage);
+
+    void * map_data(std::size_t num_bytes, format data_format, usage data_usage);
+
+    void unmap_data();
+
+    void set_sub_data(unsigned int first_float, const float * data, unsigned int num_floats);
+
+    void set_index_array(const std::vector<unsigned short> & data, usage data_usage);
+
+    void set_index_array(const unsigned short * data, std::size_t count, usage data_usage);
+
+    void set_index_array(const std::vector<unsigned int> & data, usage data_usage);
 
-    void set_index_array(std::vector<unsigned short> data, usage data_usage);
+    void set_index_array(const unsigned int * data, std::size_t count, usage data_usage);
+
+    void use_quad_indices(unsigned int num_quads);
+
+    /*!
+     * \brief Returns GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, depending on how big the indices are
+     */
+    GLenum get_index_type() const;
 
     void set_active();
 
     void draw();
+
+    void draw(unsigned int num_indices);
 private:
     GLuint vertex_buffer;
     GLuint indices;
 
-    GLenum translate_usage(const usage data_usage) const;
+    GLsizeiptr vertex_buffer_size;
+    GLsizeiptr index_buffer_size;
+    GLbitfield vertex_storage_flags;
+    GLbitfield index_storage_flags;
+
+    /*!
+     * \brief Returns the buffer storage flags for the given usage
+     */
+    GLbitfield translate_usage(const usage data_usage) const;
+
+    /*!
+     * \brief Makes sure the vertex buffer is size bytes, has the given storage flags, and is hooked up to the vertex
+     * array with data_format's attributes
+     *
+     * \param initial_data If this isn't nullptr and a new buffer is needed, the new buffer starts out with this data.
+     * If it is nullptr, an old buffer is kept even if it's static, since the caller is about to fill it in with a copy
+     * or a map
+     *
+     * \return True if a new buffer was made
+     */
+    bool reserve_vertex_buffer(GLsizeiptr size, format data_format, GLbitfield storage_flags,
+                               const void * initial_data);
+
+    /*!
+     * \brief Makes sure the index buffer is size bytes and has the given storage flags, and points the vertex array
+     * back at it if it was using the quad indices
+     *
+     * \return True if the old buffer was kept and initial_data still needs to be written into it
+     */
+    bool reserve_index_buffer(GLsizeiptr size, GLbitfield storage_flags, const void * initial_data);
+
+    /*!
+     * \brief Replaces buffer with a new buffer that has the given size, data, and storage flags
+     */
+    void make_storage(GLuint & buffer, GLsizeiptr & buffer_size, GLbitfield & storage_flags, const void * data,
+                      GLsizeiptr size, GLbitfield new_storage_flags);
+
+    /*!
+     * \brief Returns how many bytes there are between the start of one vertex and the start of the next
+     */
+    static GLsizei get_stride(format data_format);
 
     /*!
      * \brief Enables all the proper OpenGL vertex attributes for the given format
      *
-     * Enables the proper vertex attribute array bind points and the vertex attribute pointers
+     * Sets the format of each attribute on the vertex array itself, so nothing needs to be bound
      */
     void enable_vertex_attributes(format data_format);
 
+    /*!
+     * \brief Enables the given attributes, and disables any that were enabled before but aren't in the list
+     */
+    void enable_attributes(const vertex_attribute * attributes, std::size_t num_attributes);
+
+    static GLenum translate_component_type(component_type type);
+
     unsigned int vertex_array;
     unsigned int num_indices;
+    GLenum index_type;
+
+    /*!
+     * \brief True if the vertex array's element buffer is the shared gl_quad_index_buffer rather than our own
+     */
+    bool uses_quad_indices;
+
+    /*!
+     * \brief A bit for each attribute location that's enabled on the vertex array
+     */
+    uint32_t enabled_attributes;
+
+    /*!
+     * \brief True between #map_data and #unmap_data
+     */
+    bool mapped;
 };
 
 
@@ -3,10 +3,34 @@
 //
 
 #include "texture2D.h"
+#include "gl/gl_state_cache.h"
 #include <stdexcept>
 
 texture2D::texture2D() {
-    glGenTextures(1, &gl_name);
+    glCreateTextures(GL_TEXTURE_2D, 1, &gl_name);
+}
+
+texture2D::~texture2D() {
+    release_bindless_handle();
+    gl_state_cache::get().delete_textures(1, &gl_name);
+}
+
+/*!
+ * \brief Returns the sized internal format for float data with the given components
+ */
+static GLenum get_float_internal_format(GLenum format) {
+    switch(format) {
+        case GL_RED:
+            return GL_R32F;
+        case GL_RG:
+            return GL_RG32F;
+        case GL_RGB:
+            return GL_RGB32F;
+        case GL_RGBA:
+            return GL_RGBA32F;
+        default:
+            throw std::invalid_argument("Float textures need GL_RED, GL_RG, GL_RGB, or GL_RGBA data");
+    }
 }
 
 void texture2D::set_data(std::vector<float> & pixel_data, std::vector<int> & dimensions, GLenum format) {
@@ -15,11 +39,42 @@ void texture2D::set_data(std::vector<float> & pixel_data, std::vector<int> & dim
         throw std::invalid_argument("Can't create a texture2D without 2 dimensions!");
     }
 
-    GLint previous_texture;
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
-    glBindTexture(GL_TEXTURE_2D, gl_name);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, dimensions[0], dimensions[1], 0, format, GL_FLOAT, pixel_data.data());
-    glBindTexture(GL_TEXTURE_2D, (GLuint) previous_texture);
+    set_data(pixel_data.data(), dimensions[0], dimensions[1], dimensions[0], get_float_internal_format(format), format,
+             GL_FLOAT);
+}
+
+void texture2D::set_data(const void * pixel_data, int width, int height, int row_length, GLenum internal_format,
+                         GLenum format, GLenum type) {
+    allocate(width, height, internal_format);
+
+    // Rows are tightly packed bytes, not the four-byte aligned rows OpenGL expects by default
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length == width ? 0 : row_length);
+
+    glTextureSubImage2D(gl_name, 0, 0, 0, width, height, format, type, pixel_data);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void texture2D::allocate(int width, int height, GLenum internal_format) {
+    if(has_storage) {
+        if(width == this->width && height == this->height && (GLint) internal_format == format) {
+            return;
+        }
+
+        // Texture storage can't change size or format once it's made, so we need a whole new texture
+        release_bindless_handle();
+        gl_state_cache::get().delete_textures(1, &gl_name);
+        glCreateTextures(GL_TEXTURE_2D, 1, &gl_name);
+    }
+
+    glTextureStorage2D(gl_name, 1, internal_format, width, height);
+
+    this->width = width;
+    this->height = height;
+    this->format = internal_format;
+    has_storage = true;
 }
 
 void texture2D::bind(unsigned int location) {
@@ -27,17 +82,11 @@ void texture2D::bind(unsigned int location) {
         throw std::invalid_argument("location must be a valid OpenGL texture location");
     }
 
-    if(location != current_location) {
-        glActiveTexture(location);
-        glBindTexture(GL_TEXTURE_2D, gl_name);
-        current_location = location;
-    }
+    gl_state_cache::get().bind_texture(location - GL_TEXTURE0, GL_TEXTURE_2D, gl_name);
 }
 
 void texture2D::unbind() {
-    glActiveTexture((GLenum) current_location);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    current_location = -1;
+    gl_state_cache::get().unbind_texture(GL_TEXTURE_2D, gl_name);
 }
 
 int texture2D::get_width() {
@@ -59,3 +108,23 @@ void texture2D::set_filtering_parameters(texture_filtering_params &params) {
 const unsigned int &texture2D::get_gl_name() {
     return gl_name;
 }
+
+bool texture2D::is_bindless_supported() {
+    return GLAD_GL_ARB_bindless_texture != 0;
+}
+
+GLuint64 texture2D::get_bindless_handle() {
+    if(bindless_handle == 0) {
+        bindless_handle = glGetTextureHandleARB(gl_name);
+        glMakeTextureHandleResidentARB(bindless_handle);
+    }
+
+    return bindless_handle;
+}
+
+void texture2D::release_bindless_handle() {
+    if(bindless_handle != 0) {
+        glMakeTextureHandleNonResidentARB(bindless_handle);
+        bindless_handle = 0;
+    }
+}
@@ -33,6 +33,8 @@ class texture_bind_exception : public std::exception {};
 
 /*!
  * \brief Represents a two-dimensional OpenGL texture
+ *
+ * Changing the texture uses direct state access, so it never disturbs what's bound. Only #bind binds anything.
  */
 class texture2D {
 public:
@@ -41,17 +43,21 @@ public:
      */
     texture2D();
 
+    /*!
+     * \brief Deletes the texture, making its bindless handle non-resident first if it has one
+     */
+    ~texture2D();
+
+    // There's only one texture on the GPU, so there can only be one of these
+    texture2D(const texture2D & other) = delete;
+    texture2D & operator=(const texture2D & other) = delete;
+
     /*!
      * \copydoc itexture::bind(unsigned int)
      *
-     * For best performance, call this function once, do ABSOLUTELY EVERYTHING you need to do to this texture, then
-     * unbind it
-     *
-     * It's worth noting that, if you give me the location that this texture is already bound to, this function won't
-     * make any GL calls. For that reason, it is ABSOLUTELY IMPERATIVE that you call unbind. Always. Forever. When this
-     * texture is no longer active, call unbind. Do it. You're going to forget, and you'll be really sad you can't find
-     * the problem, then you're going to find the bit of code that doesn't bind the texture if it's already bound and
-     * you'll see this comment and you'll understand what you did wrong.
+     * Binding goes through the GL state cache, so if this texture is already bound to that location, this doesn't
+     * make any GL calls. That means you don't have to unbind textures when you're done with them anymore: whatever
+     * gets bound to the location next replaces this texture either way.
      *
      * \param location The location to bind this texture to
      *
@@ -59,6 +65,9 @@ public:
      */
     virtual void bind(unsigned int location);
 
+    /*!
+     * \brief Unbinds this texture from every location it's bound to
+     */
     virtual void unbind();
 
     /*!
@@ -69,10 +78,39 @@ public:
      *
      * \param pixel_data The raw pixel_data
      * \param dimensions An array of the dimensions in this texture. For a texture2D that array MUST have two elements
-     * \param format The format of the texture data
+     * \param format The components in the texture data, such as GL_RGBA. The texture stores them as 32-bit floats
      */
     virtual void set_data(std::vector<float> & pixel_data, std::vector<int> & dimensions, GLenum format);
 
+    /*!
+     * \brief Sets this texture's data from raw memory, without converting it first
+     *
+     * The data is read exactly as it's laid out, so it can come straight from wherever it lives (such as Java). Rows
+     * may be padded: row_length tells OpenGL how many pixels there are from the start of one row to the next.
+     *
+     * The texture has immutable storage, so if the size or internal format changes this makes a new texture and
+     * get_gl_name changes. Otherwise the data is uploaded into the texture that's already there. Either way, nothing
+     * gets bound.
+     *
+     * \param pixel_data The first byte of the first row
+     * \param width The width of the texture, in pixels
+     * \param height The height of the texture, in pixels
+     * \param row_length The number of pixels from the start of one row to the start of the next row
+     * \param internal_format The format that the GPU should store the texture in, such as GL_RGBA8
+     * \param format The components in the pixel data, such as GL_BGRA
+     * \param type The data type of the components, such as GL_UNSIGNED_BYTE
+     */
+    virtual void set_data(const void * pixel_data, int width, int height, int row_length, GLenum internal_format,
+                          GLenum format, GLenum type);
+
+    /*!
+     * \brief Makes sure this texture has storage of the given size and format, without uploading anything
+     *
+     * This is all a texture that gets rendered into needs. Like set_data, this makes a new texture if the size or
+     * format changed
+     */
+    void allocate(int width, int height, GLenum internal_format);
+
     virtual void set_filtering_parameters(texture_filtering_params & params);
 
     /*!
@@ -101,12 +139,41 @@ public:
      */
     const unsigned int &get_gl_name();
 
+    /*!
+     * \brief Returns true if the driver supports ARB_bindless_texture, so #get_bindless_handle will work
+     */
+    static bool is_bindless_supported();
+
+    /*!
+     * \brief Returns a bindless handle for this texture, making it resident if it isn't already
+     *
+     * A shader can sample a texture through its handle without the texture being bound to anything. Only call this
+     * if #is_bindless_supported says so, and only once the texture has its data: OpenGL doesn't let you change a
+     * texture's storage or parameters once it has a handle. If set_data has to make new storage, the old handle is
+     * released and you'll need to ask for a new one.
+     */
+    GLuint64 get_bindless_handle();
+
 private:
-    int width;
-    int height;
-    GLint format;
+    int width = 0;
+    int height = 0;
+    GLint format = 0;
     GLuint gl_name;
-    GLint current_location = -1;
+
+    /*!
+     * \brief True once glTextureStorage2D has been called on gl_name
+     */
+    bool has_storage = false;
+
+    /*!
+     * \brief The resident bindless handle for this texture, or 0 if it doesn't have one
+     */
+    GLuint64 bindless_handle = 0;
+
+    /*!
+     * \brief Makes the bindless handle non-resident, if there is one. The handle itself lives as long as the texture
+     */
+    void release_bindless_handle();
 };
 
 
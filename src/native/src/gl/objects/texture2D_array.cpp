@@ -0,0 +1,88 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <stdexcept>
+#include "texture2D_array.h"
+#include "gl/gl_state_cache.h"
+
+texture2D_array::texture2D_array() {
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &gl_name);
+}
+
+texture2D_array::~texture2D_array() {
+    gl_state_cache::get().delete_textures(1, &gl_name);
+}
+
+bool texture2D_array::allocate(int width, int height, int num_layers, GLenum internal_format) {
+    if(has_storage) {
+        if(width == this->width && height == this->height && num_layers == this->num_layers &&
+                internal_format == format) {
+            return false;
+        }
+
+        gl_state_cache::get().delete_textures(1, &gl_name);
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &gl_name);
+    }
+
+    glTextureStorage3D(gl_name, 1, internal_format, width, height, num_layers);
+
+    this->width = width;
+    this->height = height;
+    this->num_layers = num_layers;
+    this->format = internal_format;
+    has_storage = true;
+
+    return true;
+}
+
+void texture2D_array::clear_layer(int layer, const float * color) {
+    glClearTexSubImage(gl_name, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_FLOAT, color);
+}
+
+void texture2D_array::set_layer_data(int layer, const void * pixel_data, int row_length, GLenum format, GLenum type) {
+    if(!has_storage || layer < 0 || layer >= num_layers) {
+        throw std::out_of_range("Tried to upload to a layer that doesn't exist");
+    }
+
+    // Rows are tightly packed bytes, not the four-byte aligned rows OpenGL expects by default
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length == width ? 0 : row_length);
+
+    glTextureSubImage3D(gl_name, 0, 0, 0, layer, width, height, 1, format, type, pixel_data);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void texture2D_array::bind(unsigned int location) {
+    if(location < GL_TEXTURE0 || location > GL_TEXTURE31) {
+        throw std::invalid_argument("location must be a valid OpenGL texture location");
+    }
+
+    gl_state_cache::get().bind_texture(location - GL_TEXTURE0, GL_TEXTURE_2D_ARRAY, gl_name);
+}
+
+void texture2D_array::unbind() {
+    gl_state_cache::get().unbind_texture(GL_TEXTURE_2D_ARRAY, gl_name);
+}
+
+int texture2D_array::get_width() const {
+    return width;
+}
+
+int texture2D_array::get_height() const {
+    return height;
+}
+
+int texture2D_array::get_num_layers() const {
+    return num_layers;
+}
+
+GLenum texture2D_array::get_format() const {
+    return format;
+}
+
+GLuint texture2D_array::get_gl_name() const {
+    return gl_name;
+}
@@ -0,0 +1,103 @@
+/*!
+ * \brief Defines a 2D array texture, where every layer is the same size
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_TEXTURE2D_ARRAY_H
+#define RENDERER_TEXTURE2D_ARRAY_H
+
+#include <glad/glad.h>
+
+/*!
+ * \brief Represents an OpenGL GL_TEXTURE_2D_ARRAY with immutable storage
+ *
+ * All the layers share a size and a format, so a UV coordinate means the same thing in every layer. The texture manager
+ * uses one of these per atlas, with one layer per kind of data (albedo, normals, specular), so a shader can read all of
+ * a tile's material data from a single bound texture.
+ *
+ * Like texture2D, changing the texture uses direct state access and never binds anything
+ */
+class texture2D_array {
+public:
+    /*!
+     * \brief Creates the texture object. It doesn't have any storage until #allocate is called
+     */
+    texture2D_array();
+
+    /*!
+     * \brief Deletes the texture
+     */
+    ~texture2D_array();
+
+    // The texture belongs to exactly one of these, so copies would delete it twice
+    texture2D_array(const texture2D_array & other) = delete;
+    texture2D_array & operator=(const texture2D_array & other) = delete;
+
+    /*!
+     * \brief Gives this texture storage for the given number of layers
+     *
+     * If the texture already has storage of exactly this size and format, nothing happens and the layers keep their
+     * contents. Otherwise, since immutable storage can't be resized, the old texture is deleted and a new one is made.
+     *
+     * \return True if new storage was made, which means every layer's old contents are gone
+     */
+    bool allocate(int width, int height, int num_layers, GLenum internal_format);
+
+    /*!
+     * \brief Sets every pixel in the layer to the given color
+     *
+     * \param color RGBA, as floats
+     */
+    void clear_layer(int layer, const float * color);
+
+    /*!
+     * \brief Uploads the data for one layer from raw memory, without converting it first
+     *
+     * The data must be the same size as the texture. Rows may be padded: row_length tells OpenGL how many pixels there
+     * are from the start of one row to the next.
+     *
+     * \param layer The layer to upload to
+     * \param pixel_data The first byte of the first row
+     * \param row_length The number of pixels from the start of one row to the start of the next row
+     * \param format The components in the pixel data, such as GL_BGRA
+     * \param type The data type of the components, such as GL_UNSIGNED_BYTE
+     */
+    void set_layer_data(int layer, const void * pixel_data, int row_length, GLenum format, GLenum type);
+
+    /*!
+     * \brief Binds this texture to the given texture unit, through the GL state cache
+     *
+     * \param location The location to bind this texture to, such as GL_TEXTURE0
+     */
+    void bind(unsigned int location);
+
+    /*!
+     * \brief Unbinds this texture from every location it's bound to
+     */
+    void unbind();
+
+    int get_width() const;
+
+    int get_height() const;
+
+    int get_num_layers() const;
+
+    GLenum get_format() const;
+
+    /*!
+     * \brief Returns the OpenGL identifier used to identify this texture. Changes whenever #allocate makes new storage
+     */
+    GLuint get_gl_name() const;
+
+private:
+    GLuint gl_name;
+
+    int width = 0;
+    int height = 0;
+    int num_layers = 0;
+    GLenum format = 0;
+    bool has_storage = false;
+};
+
+#endif //RENDERER_TEXTURE2D_ARRAY_H
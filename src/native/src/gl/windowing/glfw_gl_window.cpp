@@ -4,6 +4,7 @@
 
 #include "glfw_gl_window.h"
 #include "io/key_forwarder.h"
+#include "gl/gl_state_cache.h"
 #include "core/nova_renderer.h"
 #include "utils/utils.h"
 #include <easylogging++.h>
@@ -54,7 +55,7 @@ int glfw_gl_window::init() {
     LOG(INFO) << "Vendor: " << vendor;
 
     glfwGetFramebufferSize(window, &window_dimensions.x, &window_dimensions.y);
-    glViewport(0, 0, window_dimensions.x, window_dimensions.y);
+    gl_state_cache::get().set_viewport(0, 0, window_dimensions.x, window_dimensions.y);
 
     glfwSetKeyCallback(window, key_callback);
 
@@ -99,12 +100,12 @@ void glfw_gl_window::end_frame() {
 
 void glfw_gl_window::set_framebuffer_size(glm::ivec2 new_framebuffer_size) {
     window_dimensions = new_framebuffer_size;
-    glViewport(0, 0, window_dimensions.x, window_dimensions.y);
+    gl_state_cache::get().set_viewport(0, 0, window_dimensions.x, window_dimensions.y);
 }
 
-void glfw_gl_window::on_config_change(nlohmann::json& new_config) {
+void glfw_gl_window::on_config_change(const nova_settings& new_settings) {
     LOG(INFO) << "gl_glfw_window received the updated config";
-    glfwSetWindowSize(window, new_config["viewWidth"], new_config["viewHeight"]);
+    glfwSetWindowSize(window, new_settings.view_width, new_settings.view_height);
 }
 
 void glfw_gl_window::on_config_loaded(nlohmann::json &config) {
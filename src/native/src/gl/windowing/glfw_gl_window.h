@@ -42,7 +42,7 @@ public:
      * iconfig_change_listener methods
      */
 
-    void on_config_change(nlohmann::json& new_config);
+    void on_config_change(const nova_settings& new_settings);
 
     void on_config_loaded(nlohmann::json& config);
 private:
@@ -5,8 +5,12 @@
 #ifndef RENDERER_IVERTEX_BUFFER_H
 #define RENDERER_IVERTEX_BUFFER_H
 
+#include <cstddef>
 #include <vector>
 
+template<typename Vertex>
+struct vertex_layout;
+
 /*!
  * \brief Interface to abstract away vertex buffers between GL and Vulkan
  *
@@ -32,7 +36,14 @@ public:
         /*!
          * \brief The vertex buffer has positions, texture coordinates, and normals (Terrain and entities)
          */
-        POS_UV_LIGHTMAPUV_NORMAL_TANGENT
+        POS_UV_LIGHTMAPUV_NORMAL_TANGENT,
+
+        /*!
+         * \brief The same attributes as POS_UV_LIGHTMAPUV_NORMAL_TANGENT, packed into 16 bytes (Terrain)
+         *
+         * Each vertex is a packed_terrain_vertex
+         */
+        TERRAIN_PACKED
     };
 
     /*!
@@ -66,12 +77,98 @@ public:
      * \param data The interleaved vertex data
      * \param data_format The format of the data (\see format)
      */
-    virtual void set_data(std::vector<float> data, format data_format, usage data_usage) = 0;
+    virtual void set_data(const std::vector<float> & data, format data_format, usage data_usage) = 0;
+
+    /*!
+     * \brief Sets the given bytes as this vertex buffer's data, for formats that aren't made of floats
+     *
+     * \param data The interleaved vertex data
+     * \param num_bytes How many bytes of vertex data there are
+     * \param data_format The format of the data (\see format)
+     */
+    virtual void set_data(const void * data, std::size_t num_bytes, format data_format, usage data_usage) = 0;
+
+    /*!
+     * \brief Sets the given vertices as this vertex buffer's data
+     *
+     * The format comes from the vertex type's vertex_layout, so include core/vertex_layouts.h to use this
+     */
+    template<typename Vertex>
+    void set_vertices(const Vertex * vertices, std::size_t count, usage data_usage) {
+        set_data(vertices, count * sizeof(Vertex), vertex_layout<Vertex>::data_format, data_usage);
+    }
+
+    template<typename Vertex>
+    void set_vertices(const std::vector<Vertex> & vertices, usage data_usage) {
+        set_vertices(vertices.data(), vertices.size(), data_usage);
+    }
+
+    /*!
+     * \brief Makes this buffer num_bytes big, and gives you a pointer you can write its new data to
+     *
+     * Whatever was in the buffer before is gone. Write all num_bytes of the new data, then call #unmap_data before
+     * drawing the buffer. The pointer is write-only, so never read from it, it might be uncached video memory.
+     *
+     * If the GPU is still drawing from the buffer, mapping it waits for the GPU to finish. Map buffers that aren't in
+     * flight, like a freshly meshed chunk's
+     *
+     * \return Where to write, or nullptr if the buffer couldn't be mapped
+     */
+    virtual void * map_data(std::size_t num_bytes, format data_format, usage data_usage) = 0;
+
+    /*!
+     * \brief Finishes writing the data from #map_data
+     */
+    virtual void unmap_data() = 0;
+
+    /*!
+     * \brief Like #map_data, but for count vertices of the given type
+     */
+    template<typename Vertex>
+    Vertex * map_vertices(std::size_t count, usage data_usage) {
+        return static_cast<Vertex *>(map_data(count * sizeof(Vertex), vertex_layout<Vertex>::data_format, data_usage));
+    }
+
+    /*!
+     * \brief Overwrites part of this vertex buffer's data, leaving the rest of it alone
+     *
+     * The buffer must already have data from #set_data, and the new data has to fit inside it. This is for buffers
+     * that only change a little bit at a time, like the GUI
+     *
+     * \param first_float The index of the first float to overwrite
+     * \param data The new data
+     * \param num_floats How many floats to overwrite
+     */
+    virtual void set_sub_data(unsigned int first_float, const float * data, unsigned int num_floats) = 0;
 
     /*!
      * \brief Sets the index array for this vertex buffer, so that anything using it knows how to handle itself
      */
-    virtual void set_index_array(std::vector<unsigned short> data, usage data_usage) = 0;
+    virtual void set_index_array(const std::vector<unsigned short> & data, usage data_usage) = 0;
+
+    /*!
+     * \brief Sets the index array from count indices at data
+     */
+    virtual void set_index_array(const unsigned short * data, std::size_t count, usage data_usage) = 0;
+
+    /*!
+     * \brief Sets the index array from 32-bit indices
+     *
+     * If every index fits in 16 bits, the buffer only stores 16 bits of each one. Only meshes with more than 65536
+     * vertices pay for 32-bit indices
+     */
+    virtual void set_index_array(const std::vector<unsigned int> & data, usage data_usage) = 0;
+
+    virtual void set_index_array(const unsigned int * data, std::size_t count, usage data_usage) = 0;
+
+    /*!
+     * \brief Draws this buffer's vertices as quads, four vertices at a time, without storing any indices
+     *
+     * Uses an index buffer that every quad mesh shares. Setting an index array afterwards goes back to using it
+     *
+     * \param num_quads How many quads there are
+     */
+    virtual void use_quad_indices(unsigned int num_quads) = 0;
 
     /*!
      * \brief Sets this vertex buffer as the one currently being drawn, allowing it to actually be drawn
@@ -85,6 +182,13 @@ public:
      */
     virtual void draw() = 0;
 
+    /*!
+     * \brief Draws the first num_indices indices of this buffer
+     *
+     * For buffers that have room for more geometry than they're using right now
+     */
+    virtual void draw(unsigned int num_indices) = 0;
+
     /*!
      * \brief Returns the format of this vertex buffer
      *
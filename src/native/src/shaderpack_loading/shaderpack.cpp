@@ -6,6 +6,7 @@
 #include "shaderpack.h"
 #include "gl/objects/gl_shader_program.h"
 
+#include <algorithm>
 #include <fstream>
 #include <utility>
 #include <easylogging++.h>
@@ -37,17 +38,65 @@ void shaderpack::load_folder_shaderpack(std::string shaderpack_name) {
 
     // Shaders are at "$shaderpack_name/shaders", so let's go there
 
-    const std::string shaders_base_dir = "shaderpacks/" + shaderpack_name + "/" + SHADERPACK_FOLDER_NAME + "/";
+    shaders_base_dir = "shaderpacks/" + shaderpack_name + "/" + SHADERPACK_FOLDER_NAME + "/";
 
     LOG(INFO) << "Loading shaders from folder " << shaders_base_dir;
 
     for(const std::string & shader_name : default_shader_names) {
         load_program(shaders_base_dir, shader_name);
     }
+
+    for(const std::string & shader_name : optional_shader_names) {
+        if(!try_loading_program(shaders_base_dir, shader_name)) {
+            LOG(WARNING) << "Keeping the " << shader_name << " program from the last shaderpack";
+        }
+    }
+
+    watcher.watch(shaders_base_dir);
 }
 
 void shaderpack::load_program(const std::string shader_path, const std::string shader_name) {
+    // Assign rather than emplace, so that loading a different shaderpack replaces the programs from the old one
+    shaders[shader_name] = build_program(shader_path, shader_name);
+}
+
+bool shaderpack::try_loading_program(const std::string & shader_path, const std::string & shader_name) {
+    try {
+        gl_shader_program program = build_program(shader_path, shader_name);
+
+        if(ubo_store != nullptr) {
+            ubo_store->register_all_buffers_with_shader(program);
+        }
+
+        shaders[shader_name] = std::move(program);
+        return true;
+
+    } catch(std::exception & e) {
+        LOG(ERROR) << "Could not load program " << shader_name << ": " << e.what();
+        return false;
+    }
+}
 
+bool shaderpack::add_optional_program(const std::string & shader_name) {
+    if(!try_loading_program(shaders_base_dir, shader_name)) {
+        return false;
+    }
+
+    if(std::find(optional_shader_names.begin(), optional_shader_names.end(), shader_name) ==
+            optional_shader_names.end()) {
+        optional_shader_names.push_back(shader_name);
+    }
+
+    return true;
+}
+
+void shaderpack::remove_optional_program(const std::string & shader_name) {
+    // The program itself stays in the map, so pointers to it stay good. It just isn't loaded from new shaderpacks
+    optional_shader_names.erase(std::remove(optional_shader_names.begin(), optional_shader_names.end(), shader_name),
+                                optional_shader_names.end());
+}
+
+gl_shader_program shaderpack::build_program(const std::string & shader_path, const std::string & shader_name) const {
     gl_shader_program program(shader_name);
 
     const std::string full_shader_path = shader_path + shader_name;
@@ -57,11 +106,40 @@ void shaderpack::load_program(const std::string shader_path, const std::string s
 
     program.link();
 
-    shaders.emplace(shader_name, std::move(program));
-
     // Only load vertex and fragment shaders for now
 
     // TODO: Support geometry and tessellation shaders
+
+    return program;
+}
+
+void shaderpack::reload_changed_programs() {
+    for(const std::string & program_name : watcher.take_changed_programs()) {
+        auto old_program = shaders.find(program_name);
+        if(old_program == shaders.end()) {
+            // Not a program we use. Maybe the shaderpack author is writing a new one?
+            continue;
+        }
+
+        LOG(INFO) << "Reloading program " << program_name;
+
+        try {
+            gl_shader_program new_program = build_program(shaders_base_dir, program_name);
+
+            if(ubo_store != nullptr) {
+                ubo_store->register_all_buffers_with_shader(new_program);
+            }
+
+            // The old program ends up in new_program and is deleted at the end of this scope
+            old_program->second = std::move(new_program);
+
+            LOG(INFO) << "Reloaded program " << program_name;
+
+        } catch(std::exception & e) {
+            LOG(ERROR) << "Could not reload program " << program_name << ": " << e.what()
+                       << ". Keeping the old version";
+        }
+    }
 }
 
 void shaderpack::load_shader(const std::string &shader_name,
@@ -106,8 +184,8 @@ bool shaderpack::try_loading_shader(const std::string &shader_name, gl_shader_pr
     return false;
 }
 
-void shaderpack::on_config_change(nlohmann::json &new_config) {
-    std::string new_shaderpack_name = new_config["loadedShaderpack"];
+void shaderpack::on_config_change(const nova_settings &new_settings) {
+    const std::string & new_shaderpack_name = new_settings.loaded_shaderpack;
     if(new_shaderpack_name != name) {
         LOG(INFO) << "Switched to shaderpack " << new_shaderpack_name;
         load_shaderpack(new_shaderpack_name);
@@ -118,7 +196,34 @@ gl_shader_program & shaderpack::get_shader(std::string shader_name) {
     return shaders[shader_name];
 }
 
+shaderpack::program_id shaderpack::get_program_id(const std::string & shader_name) {
+    auto id = program_ids.find(shader_name);
+    if(id != program_ids.end()) {
+        return id->second;
+    }
+
+    program_id new_id = (program_id) program_names.size();
+    program_ids.emplace(shader_name, new_id);
+    program_names.push_back(shader_name);
+    programs_by_id.push_back(nullptr);
+
+    return new_id;
+}
+
+gl_shader_program & shaderpack::get_shader(program_id id) {
+    gl_shader_program * program = programs_by_id[id];
+    if(program == nullptr) {
+        // First time anyone asked for this program. Look it up by name and remember where it is
+        program = &shaders[program_names[id]];
+        programs_by_id[id] = program;
+    }
+
+    return *program;
+}
+
 void shaderpack::link_up_uniform_buffers(uniform_buffer_store &ubo_store) {
+    this->ubo_store = &ubo_store;
+
     for(auto & shader : shaders) {
         ubo_store.register_all_buffers_with_shader(shader.second);
     }
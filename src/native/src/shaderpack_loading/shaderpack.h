@@ -12,41 +12,120 @@
 
 #include "gl/objects/gl_shader_program.h"
 #include "config/config.h"
+#include "shaderpack_watcher.h"
 
 /*!
  * \brief Represents a single shaderpack in all its glory
  */
 class shaderpack : public iconfig_listener {
 public:
+    /*!
+     * \brief A small integer that identifies a program, so the renderer doesn't have to hash a string to find a
+     * program every frame
+     */
+    typedef unsigned int program_id;
+
     shaderpack();
 
     gl_shader_program & get_shader(std::string shader_name);
 
+    /*!
+     * \brief Returns the ID of the program with the given name. Call this once, then use the ID with #get_shader
+     *
+     * IDs stay valid across shaderpack loads and hot reloads, and you can ask for the ID of a program that hasn't been
+     * loaded yet
+     */
+    program_id get_program_id(const std::string & shader_name);
+
+    /*!
+     * \brief Returns the program with the given ID. This is just an array lookup
+     */
+    gl_shader_program & get_shader(program_id id);
+
     /**
      * iconfig_change_listener methods
      */
 
-    void on_config_change(nlohmann::json& new_config);
+    void on_config_change(const nova_settings& new_settings);
 
     void on_config_loaded(nlohmann::json& config);
 
     void link_up_uniform_buffers(uniform_buffer_store &ubo_store);
 
+    /*!
+     * \brief Rebuilds every program whose source files changed on disk since the last time this method was called
+     *
+     * Must be called from the render thread, since that's where the GL context lives. Each changed program is built
+     * from scratch off to the side. Only if it compiles and links successfully is it swapped in for the old program,
+     * so a typo in a shader just logs an error and the old version keeps on rendering.
+     */
+    void reload_changed_programs();
+
+    /*!
+     * \brief Loads a program that only some settings need, like the OIT composite program, from the current
+     * shaderpack. It gets loaded from every shaderpack after this too, until #remove_optional_program
+     *
+     * \return True if the program was loaded. If the shaderpack doesn't have it, or it doesn't build, the error is
+     * logged and this returns false
+     */
+    bool add_optional_program(const std::string & shader_name);
+
+    /*!
+     * \brief Stops loading the given program from new shaderpacks
+     */
+    void remove_optional_program(const std::string & shader_name);
+
 private:
     const std::string SHADERPACK_FOLDER_NAME = "shaders";
 
     std::vector<std::string> default_shader_names;
 
+    /*!
+     * \brief Programs from #add_optional_program. If a new shaderpack doesn't have one, the old version is kept
+     */
+    std::vector<std::string> optional_shader_names;
+
     std::unordered_map<std::string, gl_shader_program> shaders;
 
+    /*
+     * Programs are never erased from the map, only reassigned, so pointers to them stay valid
+     */
+    std::unordered_map<std::string, program_id> program_ids;
+    std::vector<std::string> program_names;
+    std::vector<gl_shader_program *> programs_by_id;
+
     std::string name;
 
+    std::string shaders_base_dir;
+
+    shaderpack_watcher watcher;
+
+    /*!
+     * \brief The UBO store we were linked up with, so that reloaded programs can be linked up too
+     */
+    uniform_buffer_store * ubo_store = nullptr;
+
     void load_zip_shaderpack(std::string shaderpack_name);
 
     void load_folder_shaderpack(std::string shaderpack_name);
 
     void load_program(const std::string shader_path, const std::string shader_name);
 
+    /*!
+     * \brief Compiles and links the program with the given name from the files in the given folder
+     *
+     * \throws shader_file_not_found_exception, shader_compilation_failure_exception, or
+     * program_linking_failure_exception if the program can't be built
+     */
+    gl_shader_program build_program(const std::string & shader_path, const std::string & shader_name) const;
+
+    /*!
+     * \brief Builds a program and swaps it in for the old one, if there was one
+     *
+     * \return True if the program was built. If not, the error is logged and the old program is kept
+     */
+    bool try_loading_program(const std::string & shader_path, const std::string & shader_name);
+
     void load_shader(const std::string &shader_name, gl_shader_program & program, GLenum shader_type) const;
 
     bool try_loading_shader(const std::string &shader_name, gl_shader_program & program, GLenum shader_type,
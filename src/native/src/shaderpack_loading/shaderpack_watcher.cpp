@@ -0,0 +1,155 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "shaderpack_watcher.h"
+
+#include <easylogging++.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * \brief How long the watch thread waits for a notification before checking if it should stop, in milliseconds
+ */
+const int WATCH_POLL_TIMEOUT = 250;
+
+shaderpack_watcher::shaderpack_watcher() : has_changes(false), should_stop(false) {
+    pthread_mutex_init(&changed_programs_lock, nullptr);
+}
+
+shaderpack_watcher::~shaderpack_watcher() {
+    stop();
+    pthread_mutex_destroy(&changed_programs_lock);
+}
+
+void shaderpack_watcher::watch(const std::string & folder) {
+    stop();
+
+#ifdef __linux__
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(notify_fd < 0) {
+        LOG(ERROR) << "Could not initialize inotify, shaderpack hot reloading is disabled";
+        return;
+    }
+
+    // Editors love to save by writing a temp file and moving it over the original, so IN_MOVED_TO and IN_CREATE are
+    // just as important as IN_CLOSE_WRITE
+    watch_descriptor = inotify_add_watch(notify_fd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if(watch_descriptor < 0) {
+        LOG(ERROR) << "Could not watch folder " << folder << ", shaderpack hot reloading is disabled";
+        close(notify_fd);
+        notify_fd = -1;
+        return;
+    }
+
+    watched_folder = folder;
+    should_stop.store(false);
+    pthread_create(&watch_thread, nullptr, run_watch_loop, this);
+    is_watching = true;
+
+    LOG(INFO) << "Watching " << folder << " for shader changes";
+#else
+    LOG(INFO) << "Shaderpack hot reloading is only supported on Linux";
+#endif
+}
+
+void shaderpack_watcher::stop() {
+    if(!is_watching) {
+        return;
+    }
+
+    should_stop.store(true);
+    pthread_join(watch_thread, nullptr);
+
+#ifdef __linux__
+    inotify_rm_watch(notify_fd, watch_descriptor);
+    close(notify_fd);
+#endif
+
+    notify_fd = -1;
+    watch_descriptor = -1;
+    is_watching = false;
+
+    // Changes from the old folder don't mean anything for whatever we watch next
+    pthread_mutex_lock(&changed_programs_lock);
+    changed_programs.clear();
+    has_changes.store(false);
+    pthread_mutex_unlock(&changed_programs_lock);
+}
+
+std::set<std::string> shaderpack_watcher::take_changed_programs() {
+    std::set<std::string> programs;
+
+    // Skip the lock on the common path where nothing changed
+    if(!has_changes.load()) {
+        return programs;
+    }
+
+    pthread_mutex_lock(&changed_programs_lock);
+    programs.swap(changed_programs);
+    has_changes.store(false);
+    pthread_mutex_unlock(&changed_programs_lock);
+
+    return programs;
+}
+
+void shaderpack_watcher::mark_file_changed(const std::string & file_name) {
+    std::size_t extension_pos = file_name.rfind('.');
+    if(extension_pos == std::string::npos) {
+        return;
+    }
+
+    std::string extension = file_name.substr(extension_pos);
+    if(extension != ".vert" && extension != ".vsh" && extension != ".frag" && extension != ".fsh") {
+        // Probably an editor's swap file or something. Either way, not a shader
+        return;
+    }
+
+    std::string program_name = file_name.substr(0, extension_pos);
+    LOG(DEBUG) << "Shader file " << file_name << " changed, program " << program_name << " needs to be rebuilt";
+
+    pthread_mutex_lock(&changed_programs_lock);
+    changed_programs.insert(program_name);
+    has_changes.store(true);
+    pthread_mutex_unlock(&changed_programs_lock);
+}
+
+void shaderpack_watcher::watch_loop() {
+#ifdef __linux__
+    // Big enough for a bunch of events at once. inotify events are variable-length, so we need to be careful to
+    // align the buffer properly
+    alignas(inotify_event) char event_buffer[4096];
+
+    pollfd poll_fd = {notify_fd, POLLIN, 0};
+
+    while(!should_stop.load()) {
+        int num_ready = poll(&poll_fd, 1, WATCH_POLL_TIMEOUT);
+        if(num_ready <= 0) {
+            continue;
+        }
+
+        ssize_t bytes_read = read(notify_fd, event_buffer, sizeof(event_buffer));
+        if(bytes_read <= 0) {
+            continue;
+        }
+
+        for(char * ptr = event_buffer; ptr < event_buffer + bytes_read; ) {
+            const inotify_event * event = reinterpret_cast<const inotify_event *>(ptr);
+            if(event->len > 0 && !(event->mask & IN_ISDIR)) {
+                mark_file_changed(event->name);
+            }
+
+            ptr += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+void * shaderpack_watcher::run_watch_loop(void * watcher) {
+    static_cast<shaderpack_watcher *>(watcher)->watch_loop();
+    return nullptr;
+}
@@ -0,0 +1,86 @@
+/*!
+ * \brief Watches the folder of the loaded shaderpack so shaders can be reloaded without restarting Minecraft
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_SHADERPACK_WATCHER_H
+#define RENDERER_SHADERPACK_WATCHER_H
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <pthread.h>
+
+/*!
+ * \brief Watches a shaderpack's shader folder for changes, and remembers which programs had their source change
+ *
+ * The watcher runs in its own thread. It blocks on the OS file notification API (inotify on Linux) and, whenever a
+ * shader file is written, moved into, or created in the watched folder, it records the name of the program that file
+ * belongs to. `shaders/gui.vert` and `shaders/gui.frag` both belong to the program `gui`.
+ *
+ * The watcher doesn't touch OpenGL at all. Only the render thread has a GL context, so the render thread calls
+ * #take_changed_programs once per frame and rebuilds whatever programs come back. Since the changed programs are kept
+ * in a set, an editor that writes a file three times in a row only causes one rebuild.
+ *
+ * On platforms without inotify the watcher never reports any changes. Shaderpacks still load fine, you just have to
+ * restart to see your changes, like in the good old days.
+ */
+class shaderpack_watcher {
+public:
+    shaderpack_watcher();
+
+    /*!
+     * \brief Stops watching whatever folder we're watching and joins the watch thread
+     */
+    ~shaderpack_watcher();
+
+    /*!
+     * \brief Starts watching the given folder. If we were already watching a folder, we stop watching that one first
+     *
+     * \param folder The folder to watch. Should be the shaders folder of the current shaderpack
+     */
+    void watch(const std::string & folder);
+
+    /*!
+     * \brief Stops watching the current folder, if any
+     */
+    void stop();
+
+    /*!
+     * \brief Returns the names of all the programs that have changed since the last call to this method, then forgets
+     * about them
+     *
+     * This is cheap when nothing has changed, so it's fine to call every frame
+     */
+    std::set<std::string> take_changed_programs();
+
+private:
+    pthread_t watch_thread;
+    pthread_mutex_t changed_programs_lock;
+
+    std::set<std::string> changed_programs;
+    std::atomic<bool> has_changes;
+    std::atomic<bool> should_stop;
+
+    std::string watched_folder;
+    int notify_fd = -1;
+    int watch_descriptor = -1;
+    bool is_watching = false;
+
+    /*!
+     * \brief Runs on the watch thread. Waits for file notifications until #stop is called
+     */
+    void watch_loop();
+
+    /*!
+     * \brief Records that the given file has changed
+     *
+     * \param file_name The name of the changed file, relative to the watched folder
+     */
+    void mark_file_changed(const std::string & file_name);
+
+    static void * run_watch_loop(void * watcher);
+};
+
+#endif //RENDERER_SHADERPACK_WATCHER_H
@@ -0,0 +1,115 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <cstdint>
+#include <memory>
+#include <pthread.h>
+#include <easylogging++.h>
+#include "async_log_test.h"
+#include "test_utils.h"
+#include "utils/async_log.h"
+
+static const log_site test_site = {log_level::info, "{} says {} is {} ({}) at {}", __FILE__, __LINE__, "test_site"};
+static const log_site no_args_site = {log_level::debug, "Nothing to see here", __FILE__, __LINE__, "no_args_site"};
+
+static void test_format_record() {
+    std::unique_ptr<log_ring> ring(new log_ring());
+
+    unsigned int id = 42;
+    std::string name = "glDrawArrays";
+    bool written = async_log::write_to(*ring, &test_site, id, name, -3, 0.5f, "a string literal", 7);
+    assert(written);
+
+    const log_ring::record_header * record = ring->peek();
+    assert(record != nullptr);
+    assert(record->site == &test_site);
+
+    // Extra arguments are dropped, and every {} that has an argument gets filled in
+    assert(async_log::format_record(*record) == "42 says glDrawArrays is -3 (0.5) at a string literal");
+
+    ring->pop(record);
+    assert(ring->peek() == nullptr);
+}
+
+static void test_ring_is_cache_line_aligned() {
+    for(int i = 0; i < 4; i++) {
+        std::unique_ptr<log_ring> ring(new log_ring());
+        assert(reinterpret_cast<uintptr_t>(ring.get()) % 64 == 0);
+    }
+}
+
+static void test_ring_wraps() {
+    std::unique_ptr<log_ring> ring(new log_ring());
+
+    // Enough records to go around the ring a few times. Reading as we go means nothing gets dropped
+    for(int i = 0; i < 10000; i++) {
+        assert(async_log::write_to(*ring, &test_site, i, "x", i * 2, 1.0, "y"));
+
+        const log_ring::record_header * record = ring->peek();
+        assert(record != nullptr);
+        assert(async_log::format_record(*record) == std::to_string(i) + " says x is " + std::to_string(i * 2) + " (1) at y");
+        ring->pop(record);
+    }
+
+    assert(ring->peek() == nullptr);
+    assert(ring->get_num_dropped() == 0);
+}
+
+static void test_full_ring_drops() {
+    std::unique_ptr<log_ring> ring(new log_ring());
+
+    unsigned int num_written = 0;
+    for(unsigned int i = 0; i < log_ring::CAPACITY; i++) {
+        if(async_log::write_to(*ring, &no_args_site)) {
+            num_written++;
+        }
+    }
+
+    // Each record without arguments is just a header, padded to sixteen bytes
+    assert(num_written == log_ring::CAPACITY / 16);
+    assert(ring->get_num_dropped() == log_ring::CAPACITY - num_written);
+
+    // Once the logging thread catches up there's room again
+    const log_ring::record_header * record = ring->peek();
+    assert(async_log::format_record(*record) == "Nothing to see here");
+    ring->pop(record);
+    assert(async_log::write_to(*ring, &no_args_site));
+}
+
+static void test_flush() {
+    NOVA_LOG_INFO("Testing the async log: {} {}", 1, "two");
+
+    // This would hang forever if the logging thread wasn't running
+    async_log::flush();
+
+    assert(async_log::get_num_dropped() == 0);
+}
+
+static void * log_from_thread(void *) {
+    NOVA_LOG_INFO("Logging from a thread that's about to exit");
+    return nullptr;
+}
+
+static void test_exited_thread_ring_is_freed() {
+    async_log::flush();
+    const std::size_t num_rings = async_log::get_num_rings();
+
+    pthread_t thread;
+    pthread_create(&thread, nullptr, log_from_thread, nullptr);
+    pthread_join(thread, nullptr);
+
+    // The thread's message still gets written, and then its ring goes away
+    async_log::flush();
+    assert(async_log::get_num_rings() == num_rings);
+}
+
+void async_log_test::run_all() {
+    run_test(test_format_record, "test_format_record");
+    run_test(test_ring_is_cache_line_aligned, "test_ring_is_cache_line_aligned");
+    run_test(test_ring_wraps, "test_ring_wraps");
+    run_test(test_full_ring_drops, "test_full_ring_drops");
+    run_test(test_flush, "test_flush");
+    run_test(test_exited_thread_ring_is_freed, "test_exited_thread_ring_is_freed");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_ASYNC_LOG_TEST_H
+#define RENDERER_ASYNC_LOG_TEST_H
+
+namespace async_log_test {
+    void run_all();
+};
+
+#endif //RENDERER_ASYNC_LOG_TEST_H
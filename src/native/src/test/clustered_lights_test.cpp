@@ -0,0 +1,216 @@
+/*!
+ * \brief Tests for light clustering, and a benchmark with ten thousand lights
+ *
+ * \date 19-Oct-26
+ */
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <easylogging++.h>
+#include "clustered_lights_test.h"
+#include "test_utils.h"
+#include "core/clustered_lights.h"
+
+static const uint32_t CLUSTERS_X = clustered_lights::CLUSTERS_X;
+static const uint32_t CLUSTERS_Y = clustered_lights::CLUSTERS_Y;
+static const uint32_t CLUSTERS_Z = clustered_lights::CLUSTERS_Z;
+
+/*!
+ * \brief A 70 degree camera at the origin, looking down -z
+ */
+static clustered_lights::camera make_camera() {
+    clustered_lights::camera view_camera;
+    view_camera.view = glm::mat4(1.0f);
+    view_camera.vertical_fov = 70.0f * 3.14159265f / 180.0f;
+    view_camera.aspect = 16.0f / 9.0f;
+    view_camera.near_plane = 0.1f;
+    view_camera.far_plane = 256.0f;
+    view_camera.view_width = 1600;
+    view_camera.view_height = 900;
+    return view_camera;
+}
+
+static clustered_lights::point_light make_light(float x, float y, float z, float radius) {
+    clustered_lights::point_light light;
+    light.position = glm::vec3(x, y, z);
+    light.radius = radius;
+    light.color = glm::vec3(1.0f, 0.8f, 0.6f);
+    light.intensity = 1.0f;
+    return light;
+}
+
+static uint32_t get_slice(const clustered_lights::camera & view_camera, float depth) {
+    return (uint32_t) (std::log(depth / view_camera.near_plane) * CLUSTERS_Z /
+                       std::log(view_camera.far_plane / view_camera.near_plane));
+}
+
+/*!
+ * \brief Makes the same lights every time, so the benchmark is comparable between runs
+ */
+static void add_random_lights(clustered_lights & lights, uint32_t count) {
+    uint32_t seed = 12345;
+    auto next_float = [&seed]() {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) / 16777216.0f;
+    };
+
+    for(uint32_t i = 0; i < count; i++) {
+        const float x = next_float() * 256.0f - 128.0f;
+        const float y = next_float() * 64.0f - 32.0f;
+        const float z = next_float() * 256.0f - 128.0f;
+        const float radius = 2.0f + next_float() * 13.0f;
+        lights.add_light(make_light(x, y, z, radius));
+    }
+}
+
+static void test_light_in_front_lands_in_its_cluster() {
+    const clustered_lights::camera view_camera = make_camera();
+    clustered_lights lights;
+    lights.add_light(make_light(0, 0, -10, 0.5f));
+
+    // Nothing worth uploading until the clusters are built
+    assert(!lights.has_clusters());
+    assert(lights.build(view_camera) == 1);
+    assert(lights.has_clusters());
+    assert(lights.get_visible_lights()[0].position_radius == glm::vec4(0, 0, -10, 0.5f));
+
+    // Right in the middle of the screen, which is the edge between the middle two columns
+    const uint32_t slice = get_slice(view_camera, 10.0f);
+    const clustered_lights::cluster & left = lights.get_cluster(CLUSTERS_X / 2 - 1, CLUSTERS_Y / 2, slice);
+    const clustered_lights::cluster & right = lights.get_cluster(CLUSTERS_X / 2, CLUSTERS_Y / 2, slice);
+    assert(left.count == 1);
+    assert(right.count == 1);
+    assert(lights.get_light_indices()[left.offset] == 0);
+
+    assert(lights.get_cluster(0, 0, slice).count == 0);
+    assert(lights.get_cluster(CLUSTERS_X / 2, CLUSTERS_Y / 2, 0).count == 0);
+    assert(lights.get_cluster(CLUSTERS_X / 2, CLUSTERS_Y / 2, CLUSTERS_Z - 1).count == 0);
+
+    // Two columns, for however many slices the light is deep
+    const uint32_t num_slices = get_slice(view_camera, 10.5f) - get_slice(view_camera, 9.5f) + 1;
+    assert(lights.get_light_indices().size() == 2 * num_slices);
+}
+
+static void test_lights_outside_view_are_culled() {
+    const clustered_lights::camera view_camera = make_camera();
+    clustered_lights lights;
+    lights.add_light(make_light(0, 0, 10, 1));        // Behind the camera
+    lights.add_light(make_light(0, 0, -300, 1));      // Past the far plane
+    lights.add_light(make_light(-100, 0, -10, 1));    // Off to the left
+    lights.add_light(make_light(0, 100, -10, 1));     // Above
+    assert(lights.build(view_camera) == 0);
+    assert(lights.get_light_indices().empty());
+
+    // A light around the camera touches everything close by
+    lights.add_light(make_light(0, 0, 0.5f, 2));
+    assert(lights.build(view_camera) == 1);
+    assert(lights.get_cluster(0, 0, 0).count == 1);
+    assert(lights.get_cluster(CLUSTERS_X - 1, CLUSTERS_Y - 1, 0).count == 1);
+}
+
+static void test_camera_position_moves_lights() {
+    clustered_lights::camera view_camera = make_camera();
+    view_camera.view[3] = glm::vec4(-100, -64, -100, 1);
+
+    clustered_lights lights;
+    lights.add_light(make_light(100, 64, 90, 1));
+    lights.add_light(make_light(100, 64, 110, 1));
+    assert(lights.build(view_camera) == 1);
+    assert(lights.get_visible_lights()[0].position_radius == glm::vec4(0, 0, -10, 1));
+}
+
+static void test_clusters_have_a_limit() {
+    const clustered_lights::camera view_camera = make_camera();
+    clustered_lights lights;
+    for(int i = 0; i < 200; i++) {
+        lights.add_light(make_light(0, 0, -10, 0.5f));
+    }
+
+    assert(lights.build(view_camera) == 200);
+    const uint32_t slice = get_slice(view_camera, 10.0f);
+    assert(lights.get_cluster(CLUSTERS_X / 2, CLUSTERS_Y / 2, slice).count ==
+           clustered_lights::MAX_LIGHTS_PER_CLUSTER);
+    assert(lights.get_num_dropped() >= 2 * (200 - clustered_lights::MAX_LIGHTS_PER_CLUSTER));
+}
+
+static void test_simd_matches_scalar() {
+    if(!clustered_lights::is_simd_supported()) {
+        LOG(INFO) << "Not built with SSE, so there's nothing to compare";
+        return;
+    }
+
+    clustered_lights::camera view_camera = make_camera();
+    view_camera.view[3] = glm::vec4(3, -2, 5, 1);
+
+    clustered_lights simd;
+    clustered_lights scalar;
+    scalar.set_simd_enabled(false);
+
+    // Not a multiple of four, so the leftovers go through the scalar path
+    add_random_lights(simd, 2003);
+    add_random_lights(scalar, 2003);
+
+    assert(simd.build(view_camera) == scalar.build(view_camera));
+    assert(simd.get_light_indices() == scalar.get_light_indices());
+    for(uint32_t z = 0; z < CLUSTERS_Z; z++) {
+        for(uint32_t y = 0; y < CLUSTERS_Y; y++) {
+            for(uint32_t x = 0; x < CLUSTERS_X; x++) {
+                assert(simd.get_cluster(x, y, z).offset == scalar.get_cluster(x, y, z).offset);
+                assert(simd.get_cluster(x, y, z).count == scalar.get_cluster(x, y, z).count);
+            }
+        }
+    }
+}
+
+static double time_builds(clustered_lights & lights, const clustered_lights::camera & view_camera, int num_builds) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i = 0; i < num_builds; i++) {
+        lights.build(view_camera);
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / num_builds;
+}
+
+/*!
+ * \brief Ten thousand lights the size of torches, scattered around the camera
+ */
+static void benchmark_10k_lights() {
+    const clustered_lights::camera view_camera = make_camera();
+    clustered_lights lights;
+    add_random_lights(lights, 10000);
+
+    const double simd_time = time_builds(lights, view_camera, 20);
+
+    uint32_t busiest_cluster = 0;
+    for(uint32_t z = 0; z < CLUSTERS_Z; z++) {
+        for(uint32_t y = 0; y < CLUSTERS_Y; y++) {
+            for(uint32_t x = 0; x < CLUSTERS_X; x++) {
+                busiest_cluster = std::max(busiest_cluster, lights.get_cluster(x, y, z).count);
+            }
+        }
+    }
+
+    const uint32_t num_visible = (uint32_t) lights.get_visible_lights().size();
+    const uint32_t num_indices = (uint32_t) lights.get_light_indices().size();
+    assert(num_visible > 0);
+    assert(busiest_cluster <= clustered_lights::MAX_LIGHTS_PER_CLUSTER);
+
+    lights.set_simd_enabled(false);
+    const double scalar_time = time_builds(lights, view_camera, 20);
+
+    LOG(INFO) << "10k lights: " << num_visible << " visible, " << num_indices << " indices, at most "
+              << busiest_cluster << " in one cluster, " << lights.get_num_dropped() << " dropped. Building took "
+              << simd_time << "ms with SSE" << (clustered_lights::is_simd_supported() ? "" : " (not built in)")
+              << " and " << scalar_time << "ms without";
+}
+
+void clustered_lights_test::run_all() {
+    run_test(test_light_in_front_lands_in_its_cluster, "test_light_in_front_lands_in_its_cluster");
+    run_test(test_lights_outside_view_are_culled, "test_lights_outside_view_are_culled");
+    run_test(test_camera_position_moves_lights, "test_camera_position_moves_lights");
+    run_test(test_clusters_have_a_limit, "test_clusters_have_a_limit");
+    run_test(test_simd_matches_scalar, "test_simd_matches_scalar");
+    run_test(benchmark_10k_lights, "benchmark_10k_lights");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_CLUSTERED_LIGHTS_TEST_H
+#define RENDERER_CLUSTERED_LIGHTS_TEST_H
+
+namespace clustered_lights_test {
+    void run_all();
+};
+
+#endif //RENDERER_CLUSTERED_LIGHTS_TEST_H
@@ -0,0 +1,210 @@
+/*!
+ * \brief Writes commands into the ring the way the Java side does, including broken ones, and checks what comes out
+ *
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "command_ring_test.h"
+#include "test_utils.h"
+#include "core/command_ring.h"
+
+/*!
+ * \brief Remembers everything the ring decoded
+ */
+class recording_handler : public iring_command_handler {
+public:
+    std::vector<std::vector<std::string>> screens;
+    std::vector<std::string> texture_names;
+    int num_renders = 0;
+
+    virtual void on_set_gui_screen(mc_gui_screen & screen) {
+        std::vector<std::string> text;
+        for(int i = 0; i < screen.num_buttons; i++) {
+            text.push_back(screen.buttons[i].text);
+        }
+        screens.push_back(text);
+    }
+
+    virtual void on_render(mc_render_command &) {
+        num_renders++;
+    }
+
+    virtual void on_add_texture_location(mc_texture_atlas_location & location) {
+        texture_names.push_back(location.name);
+    }
+};
+
+/*!
+ * \brief Builds one command at a time, like the Java side does
+ */
+class command_writer {
+public:
+    command_writer(command_ring & ring) : ring(ring) {
+        command_ring_header * header = static_cast<command_ring_header *>(ring.get_memory());
+        data = static_cast<unsigned char *>(ring.get_memory()) + header->data_offset;
+    }
+
+    void begin(ring_command_type type) {
+        command.clear();
+        put<uint16_t>((uint16_t) type);
+        put<uint16_t>(0);
+        put<uint32_t>(0);
+    }
+
+    template <typename T>
+    void put(T value) {
+        const unsigned char * bytes = reinterpret_cast<const unsigned char *>(&value);
+        command.insert(command.end(), bytes, bytes + sizeof(T));
+    }
+
+    void put_text(const std::string & text) {
+        command.insert(command.end(), text.begin(), text.end());
+        while(command.size() % 4 != 0) {
+            command.push_back(0);
+        }
+    }
+
+    /*!
+     * \brief Pads the command to eight bytes, fills in its size, and copies it into the ring
+     */
+    void end() {
+        while(command.size() % 8 != 0) {
+            command.push_back(0);
+        }
+
+        uint32_t size = (uint32_t) command.size();
+        memcpy(command.data() + 4, &size, sizeof(size));
+        memcpy(data + write_position, command.data(), command.size());
+        write_position += size;
+    }
+
+    uint32_t get_write_position() const {
+        return write_position;
+    }
+
+    void ring_doorbell() {
+        ring.ring_doorbell(write_position);
+    }
+
+private:
+    command_ring & ring;
+    unsigned char * data;
+    uint32_t write_position = 0;
+    std::vector<unsigned char> command;
+};
+
+static void write_texture_location(command_writer & writer, const std::string & name, uint16_t name_length) {
+    writer.begin(ring_command_type::ADD_TEXTURE_LOCATION);
+    for(int i = 0; i < 4; i++) {
+        writer.put<float>(0.5f);
+    }
+    writer.put<uint16_t>(name_length);
+    writer.put<uint16_t>(0);
+    writer.put_text(name);
+    writer.end();
+}
+
+static void write_screen(command_writer & writer, const std::vector<std::string> & text, uint16_t extra_length) {
+    writer.begin(ring_command_type::SET_GUI_SCREEN);
+    writer.put<int32_t>((int32_t) text.size());
+    for(const std::string & button_text : text) {
+        for(int i = 0; i < 4; i++) {
+            writer.put<int32_t>(10);
+        }
+        writer.put<uint8_t>(0);
+        writer.put<uint8_t>(0);
+        writer.put<uint16_t>((uint16_t) (button_text.size() + extra_length));
+        writer.put_text(button_text);
+    }
+    writer.end();
+}
+
+static void test_decode_commands() {
+    command_ring ring(4096);
+    command_writer writer(ring);
+
+    write_texture_location(writer, "minecraft:blocks/stone", 22);
+    write_screen(writer, {"Singleplayer", "Options"}, 0);
+    writer.begin(ring_command_type::RENDER);
+    writer.put<int64_t>(16);
+    writer.put<float>(1.0f);
+    writer.put<float>(2.0f);
+    writer.put<double>(3.0);
+    writer.put<double>(4.0);
+    writer.put<double>(5.0);
+    writer.end();
+    writer.ring_doorbell();
+
+    recording_handler handler;
+    assert(ring.process_commands(handler) == 3);
+    assert(handler.texture_names.size() == 1 && handler.texture_names[0] == "minecraft:blocks/stone");
+    assert(handler.screens.size() == 1);
+    assert(handler.screens[0][0] == "Singleplayer" && handler.screens[0][1] == "Options");
+    assert(handler.num_renders == 1);
+}
+
+static void test_drop_commands_with_lengths_past_their_end() {
+    command_ring ring(4096);
+    command_writer writer(ring);
+
+    // The name says it's way longer than the command is. The commands around it are still fine
+    write_texture_location(writer, "minecraft:blocks/dirt", 21);
+    write_texture_location(writer, "liar", 60000);
+    write_texture_location(writer, "minecraft:blocks/sand", 21);
+
+    // Same thing for a button's text. The screen before it in the batch is the one that gets shown
+    write_screen(writer, {"Done"}, 0);
+    write_screen(writer, {"Cancel", "Broken"}, 30000);
+    writer.ring_doorbell();
+
+    recording_handler handler;
+    assert(ring.process_commands(handler) == 5);
+    assert(handler.texture_names.size() == 2);
+    assert(handler.texture_names[0] == "minecraft:blocks/dirt");
+    assert(handler.texture_names[1] == "minecraft:blocks/sand");
+    assert(handler.screens.size() == 1);
+    assert(handler.screens[0].size() == 1 && handler.screens[0][0] == "Done");
+}
+
+static void test_drop_everything_when_size_is_wrong() {
+    command_ring ring(4096);
+    command_writer writer(ring);
+
+    write_texture_location(writer, "minecraft:blocks/stone", 22);
+    const uint32_t render_position = writer.get_write_position();
+    writer.begin(ring_command_type::RENDER);
+    writer.end();
+    writer.ring_doorbell();
+
+    // Say the render command is bigger than the whole ring
+    command_ring_header * header = static_cast<command_ring_header *>(ring.get_memory());
+    unsigned char * data = static_cast<unsigned char *>(ring.get_memory()) + header->data_offset;
+    uint32_t huge_size = 0xFFFFFFF8;
+    memcpy(data + render_position + 4, &huge_size, sizeof(huge_size));
+
+    recording_handler handler;
+    assert(ring.process_commands(handler) == 1);
+    assert(handler.texture_names.size() == 1);
+    assert(handler.num_renders == 0);
+
+    // Everything got skipped, so there's nothing left to read
+    assert(header->read_position.load() == header->write_position.load());
+    assert(ring.process_commands(handler) == 0);
+}
+
+static void test_memory_is_aligned() {
+    command_ring ring(4096);
+    assert((reinterpret_cast<uintptr_t>(ring.get_memory()) & 63) == 0);
+}
+
+void command_ring_test::run_all() {
+    run_test(test_decode_commands, "test_decode_commands");
+    run_test(test_drop_commands_with_lengths_past_their_end, "test_drop_commands_with_lengths_past_their_end");
+    run_test(test_drop_everything_when_size_is_wrong, "test_drop_everything_when_size_is_wrong");
+    run_test(test_memory_is_aligned, "test_memory_is_aligned");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_COMMAND_RING_TEST_H
+#define RENDERER_COMMAND_RING_TEST_H
+
+namespace command_ring_test {
+    void run_all();
+};
+
+#endif //RENDERER_COMMAND_RING_TEST_H
@@ -3,13 +3,160 @@
  * \date 21-Jun-16.
  */
 
+#include <algorithm>
+#include <assert.h>
+#include <easylogging++.h>
 #include "config.h"
+#include "config/config.h"
 #include "test_utils.h"
 
+/*!
+ * \brief Counts how many times it's been told about a config change
+ */
+class counting_listener : public iconfig_listener {
+public:
+    int num_changes = 0;
+
+    void on_config_change(const nova_settings &) {
+        num_changes++;
+    }
+
+    void on_config_loaded(nlohmann::json &) {}
+};
+
+static bool contains(const std::vector<std::string> & paths, const std::string & path) {
+    return std::find(paths.begin(), paths.end(), path) != paths.end();
+}
+
 static void test_output_config() {
     //config parser("config/config.json");
 }
 
+static void test_diff_finds_changed_paths() {
+    nlohmann::json old_settings = {
+            {"loadedShaderpack", "default"},
+            {"viewWidth", 800},
+            {"shaderpackOptions", {{"bloom", true}, {"shadowResolution", 1024}}},
+            {"removedOption", 1}
+    };
+
+    nlohmann::json new_settings = old_settings;
+    new_settings["shaderpackOptions"]["bloom"] = false;
+    new_settings["addedOption"] = "hello";
+    new_settings.erase("removedOption");
+
+    std::vector<std::string> changed = config::diff(old_settings, new_settings);
+
+    assert(changed.size() == 3);
+    assert(contains(changed, "/shaderpackOptions/bloom"));
+    assert(contains(changed, "/addedOption"));
+    assert(contains(changed, "/removedOption"));
+
+    assert(config::diff(old_settings, old_settings).empty());
+}
+
+static void test_listeners_only_hear_about_their_keys() {
+    config test_config("this/file/does/not/exist.json");
+    test_config.get_options()["settings"] = {
+            {"loadedShaderpack", "default"},
+            {"viewWidth", 800},
+            {"viewHeight", 480},
+            {"shaderpackOptions", {{"bloom", true}}}
+    };
+
+    counting_listener window;
+    counting_listener shaderpack;
+    counting_listener everything;
+    test_config.register_change_listener(&window, {"/viewWidth", "/viewHeight"});
+    test_config.register_change_listener(&shaderpack, {"/loadedShaderpack", "/shaderpackOptions"});
+    test_config.register_change_listener(&everything);
+
+    // The first update is the initial configuration, so everyone hears about it
+    test_config.update_config_changed();
+    assert(window.num_changes == 1);
+    assert(shaderpack.num_changes == 1);
+    assert(everything.num_changes == 1);
+
+    // Nothing changed, so nobody should hear anything
+    test_config.update_config_changed();
+    assert(window.num_changes == 1);
+    assert(shaderpack.num_changes == 1);
+    assert(everything.num_changes == 1);
+
+    // A shaderpack option shouldn't resize the window
+    test_config.get_options()["settings"]["shaderpackOptions"]["bloom"] = false;
+    test_config.update_config_changed();
+    assert(window.num_changes == 1);
+    assert(shaderpack.num_changes == 2);
+    assert(everything.num_changes == 2);
+
+    test_config.get_options()["settings"]["viewHeight"] = 720;
+    test_config.update_config_changed();
+    assert(window.num_changes == 2);
+    assert(shaderpack.num_changes == 2);
+    assert(everything.num_changes == 3);
+
+    LOG(INFO) << "Config listeners only heard about their own settings";
+}
+
+static void test_settings_fall_back_to_defaults() {
+    nlohmann::json settings_json = {
+            {"loadedShaderpack", 42},
+            {"viewWidth", 1920},
+            {"viewHeight", -5},
+            {"someShaderpackOption", true}
+    };
+
+    nova_settings settings = nova_settings::from_json(settings_json);
+
+    // Wrong type and out of range both get the schema's default
+    assert(settings.loaded_shaderpack == "default");
+    assert(settings.view_width == 1920);
+    assert(settings.view_height == 480);
+    assert(settings.shadow_map_resolution == 2048);
+    assert(nova_settings::from_json({{"shadowMapResolution", 128}}).shadow_map_resolution == 2048);
+
+    // Things the schema doesn't know about are still there
+    assert(settings.raw["someShaderpackOption"] == true);
+}
+
+static void test_transparency_mode_setting() {
+    assert(nova_settings::from_json(nlohmann::json::object()).transparency == nova_settings::transparency_mode::sorted);
+
+    nlohmann::json settings_json = {{"transparencyMode", "weightedBlended"}};
+    assert(nova_settings::from_json(settings_json).transparency ==
+           nova_settings::transparency_mode::weighted_blended);
+
+    // Modes we don't know about, and things that aren't strings, both get the default
+    settings_json["transparencyMode"] = "depthPeeling";
+    assert(nova_settings::from_json(settings_json).transparency == nova_settings::transparency_mode::sorted);
+
+    settings_json["transparencyMode"] = 1;
+    assert(nova_settings::from_json(settings_json).transparency == nova_settings::transparency_mode::sorted);
+}
+
+static void test_settings_are_swapped_on_change() {
+    config test_config("this/file/does/not/exist.json");
+    test_config.get_options()["settings"] = {{"viewWidth", 800}, {"viewHeight", 480}};
+    test_config.update_config_changed();
+
+    std::shared_ptr<const nova_settings> old_settings = test_config.get_settings();
+    assert(old_settings->view_width == 800);
+
+    test_config.get_options()["settings"]["viewWidth"] = 1280;
+    test_config.update_config_changed();
+
+    // Anyone holding on to the old settings still sees the old values
+    assert(old_settings->view_width == 800);
+    assert(test_config.get_settings()->view_width == 1280);
+    assert(test_config.get_settings()->view_height == 480);
+}
+
 void config_ns::run_all() {
     run_test(test_output_config, "test_output_config");
-}
\ No newline at end of file
+    run_test(test_diff_finds_changed_paths, "test_diff_finds_changed_paths");
+    run_test(test_listeners_only_hear_about_their_keys, "test_listeners_only_hear_about_their_keys");
+    run_test(test_settings_fall_back_to_defaults, "test_settings_fall_back_to_defaults");
+    run_test(test_transparency_mode_setting, "test_transparency_mode_setting");
+    run_test(test_settings_are_swapped_on_change, "test_settings_are_swapped_on_change");
+}
@@ -3,8 +3,8 @@
  * \date 21-Jun-16.
  */
 
-#ifndef RENDERER_CONFIG_H
-#define RENDERER_CONFIG_H
+#ifndef RENDERER_TEST_CONFIG_H
+#define RENDERER_TEST_CONFIG_H
 
 
 namespace config_ns {
@@ -12,4 +12,4 @@ namespace config_ns {
 };
 
 
-#endif //RENDERER_CONFIG_H
+#endif //RENDERER_TEST_CONFIG_H
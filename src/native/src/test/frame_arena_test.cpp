@@ -0,0 +1,122 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <cstdint>
+#include "frame_arena_test.h"
+#include "test_utils.h"
+#include "utils/frame_arena.h"
+#include "utils/heap_stats.h"
+
+static bool is_aligned(const void * memory, std::size_t alignment) {
+    return (reinterpret_cast<uintptr_t>(memory) & (alignment - 1)) == 0;
+}
+
+static void test_allocations_are_aligned() {
+    frame_arena arena(1024);
+
+    void * one_byte = arena.allocate(1, 1);
+    void * sixteen = arena.allocate(16, 16);
+    void * sixty_four = arena.allocate(8, 64);
+    assert(one_byte != nullptr && sixteen != nullptr && sixty_four != nullptr);
+    assert(is_aligned(sixteen, 16));
+    assert(is_aligned(sixty_four, 64));
+
+    // Giving back the newest allocation lets the next one reuse it
+    arena.deallocate(sixty_four, 8);
+    assert(arena.allocate(8, 64) == sixty_four);
+    assert(arena.get_num_heap_allocations() == 0);
+}
+
+static void test_overflow_grows_arena() {
+    frame_arena arena(256);
+
+    // More than the arena has, so some of these go to the heap
+    for(int i = 0; i < 16; i++) {
+        uint8_t * memory = static_cast<uint8_t *>(arena.allocate(100, 8));
+        assert(memory != nullptr && is_aligned(memory, 8));
+        memory[0] = memory[99] = (uint8_t) i;
+    }
+    assert(arena.get_num_heap_allocations() > 0);
+    assert(arena.get_bytes_used() >= 1600);
+
+    // After a reset, the arena should be big enough for the same frame without touching the heap
+    arena.reset();
+    assert(arena.get_capacity() >= 1600);
+    for(int i = 0; i < 16; i++) {
+        arena.allocate(100, 8);
+    }
+    assert(arena.get_num_heap_allocations() == 0);
+}
+
+static void test_frame_vector() {
+    frame_arena arena(64 * 1024);
+
+    frame_vector<int> numbers{arena_allocator<int>(arena)};
+    numbers.reserve(1000);
+    for(int i = 0; i < 1000; i++) {
+        numbers.push_back(i * 3);
+    }
+
+    // A rebound allocator still uses the same arena
+    frame_vector<uint64_t> more_numbers{arena_allocator<uint64_t>(numbers.get_allocator())};
+    more_numbers.resize(10, 7);
+
+    for(int i = 0; i < 1000; i++) {
+        assert(numbers[i] == i * 3);
+    }
+    assert(more_numbers[9] == 7);
+    assert(numbers.get_allocator() == more_numbers.get_allocator());
+    assert(arena.get_num_heap_allocations() == 0);
+    assert(arena.get_bytes_used() >= 1000 * sizeof(int) + 10 * sizeof(uint64_t));
+}
+
+static void test_frames_in_flight() {
+    frame_arenas arenas(4096);
+
+    // A frame's data should survive the next FRAMES_IN_FLIGHT - 1 frames
+    int * first_frame = static_cast<int *>(arenas.get_current().allocate(sizeof(int), alignof(int)));
+    *first_frame = 42;
+
+    for(unsigned int frame = 1; frame < frame_arenas::FRAMES_IN_FLIGHT; frame++) {
+        arenas.begin_frame();
+        int * data = static_cast<int *>(arenas.get_current().allocate(sizeof(int), alignof(int)));
+        *data = -1;
+        assert(*first_frame == 42);
+    }
+
+    // Now we're back around to the first frame's arena, which starts out empty
+    arenas.begin_frame();
+    assert(arenas.get_current().get_bytes_used() == 0);
+
+    // A frame that only uses its arena shouldn't allocate at all, once things are warmed up
+    for(int frame = 0; frame < 10; frame++) {
+        frame_vector<float> scratch{arena_allocator<float>(arenas.get_current())};
+        scratch.resize(512, 1.0f);
+        arenas.begin_frame();
+    }
+    assert(arenas.get_last_frame_stats().arena_heap_allocations == 0);
+    assert(arenas.get_last_frame_stats().heap_allocations == 0);
+    assert(arenas.get_last_frame_stats().arena_bytes_used >= 512 * sizeof(float));
+}
+
+static void test_heap_counting() {
+    if(!heap_stats::is_counting()) {
+        assert(heap_stats::get_thread_allocations() == 0);
+        return;
+    }
+
+    uint64_t before = heap_stats::get_thread_allocations();
+    int * number = new int(5);
+    assert(heap_stats::get_thread_allocations() == before + 1);
+    delete number;
+}
+
+void frame_arena_test::run_all() {
+    run_test(test_allocations_are_aligned, "test_allocations_are_aligned");
+    run_test(test_overflow_grows_arena, "test_overflow_grows_arena");
+    run_test(test_frame_vector, "test_frame_vector");
+    run_test(test_frames_in_flight, "test_frames_in_flight");
+    run_test(test_heap_counting, "test_heap_counting");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_FRAME_ARENA_TEST_H
+#define RENDERER_FRAME_ARENA_TEST_H
+
+namespace frame_arena_test {
+    void run_all();
+};
+
+#endif //RENDERER_FRAME_ARENA_TEST_H
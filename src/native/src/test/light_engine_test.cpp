@@ -0,0 +1,313 @@
+/*!
+ * \brief Tests for the light engine, plus benchmarks of the worst cases we know about: a big lava lake and a cave
+ * with a glowstone ceiling
+ *
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <chrono>
+#include <easylogging++.h>
+#include "light_engine_test.h"
+#include "test_utils.h"
+#include "core/light_engine.h"
+#include "utils/worker_pool.h"
+
+static const uint16_t AIR = 0;
+static const uint16_t STONE = 1;
+static const uint16_t WATER = 9;
+static const uint16_t LAVA = 11;
+static const uint16_t TORCH = 50;
+static const uint16_t GLOWSTONE = 89;
+
+static const light_engine::channel BLOCK_LIGHT = light_engine::BLOCK_LIGHT;
+static const light_engine::channel SKY_LIGHT = light_engine::SKY_LIGHT;
+
+static void set_vanilla_properties(light_engine & engine) {
+    engine.set_block_properties(STONE, {0, 15});
+    engine.set_block_properties(WATER, {0, 3});
+    engine.set_block_properties(LAVA, {15, 0});
+    engine.set_block_properties(TORCH, {14, 0});
+    engine.set_block_properties(GLOWSTONE, {15, 15});
+}
+
+static int get_section_index(int x, int y, int z) {
+    return x + z * 16 + y * 256;
+}
+
+/*!
+ * \brief Adds a horizontal area of sections, from the top down like a real column would be
+ */
+static void add_sections(light_engine & engine, int width, int height, const uint16_t * blocks) {
+    for(int y = height - 1; y >= 0; y--) {
+        for(int x = 0; x < width; x++) {
+            for(int z = 0; z < width; z++) {
+                engine.add_section(glm::ivec3(x, y, z), blocks);
+            }
+        }
+    }
+}
+
+static double get_milliseconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*!
+ * \brief Runs everything that's queued up and returns how long it took
+ */
+static double time_update(light_engine & engine) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    engine.update();
+    engine.wait();
+    return get_milliseconds_since(start);
+}
+
+static void test_torch_lights_up_area() {
+    light_engine engine(nullptr);
+    set_vanilla_properties(engine);
+    engine.add_section(glm::ivec3(0, 0, 0), nullptr);
+    engine.add_section(glm::ivec3(1, 0, 0), nullptr);
+
+    engine.set_block(glm::ivec3(14, 8, 8), TORCH);
+    engine.update();
+
+    assert(engine.get_light(glm::ivec3(14, 8, 8), BLOCK_LIGHT) == 14);
+    assert(engine.get_light(glm::ivec3(11, 8, 8), BLOCK_LIGHT) == 11);
+    assert(engine.get_light(glm::ivec3(12, 10, 10), BLOCK_LIGHT) == 8);
+
+    // Light goes across the border into the next section...
+    assert(engine.get_light(glm::ivec3(17, 8, 8), BLOCK_LIGHT) == 11);
+
+    // ...but not into sections that aren't loaded
+    assert(engine.get_light(glm::ivec3(14, 8, 17), BLOCK_LIGHT) == 0);
+
+    // Stone in the way means the light has to go around
+    engine.set_block(glm::ivec3(13, 8, 8), STONE);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(13, 8, 8), BLOCK_LIGHT) == 0);
+    assert(engine.get_light(glm::ivec3(12, 8, 8), BLOCK_LIGHT) == 10);
+
+    const glm::vec2 lightmap = engine.get_lightmap(glm::ivec3(14, 8, 8));
+    assert(lightmap.x == 14 / 15.0f);
+
+    std::vector<glm::ivec3> changed;
+    assert(engine.take_changed_sections(changed));
+    assert(changed.size() == 2);
+
+    changed.clear();
+    engine.take_changed_sections(changed);
+    assert(changed.empty());
+}
+
+static void test_removing_torch_makes_it_dark() {
+    light_engine engine(nullptr);
+    set_vanilla_properties(engine);
+    engine.add_section(glm::ivec3(0, 0, 0), nullptr);
+    engine.add_section(glm::ivec3(0, 1, 0), nullptr);
+
+    engine.set_block(glm::ivec3(3, 15, 3), TORCH);
+    engine.set_block(glm::ivec3(12, 15, 12), TORCH);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(3, 17, 3), BLOCK_LIGHT) == 12);
+
+    // Taking one torch away leaves the other one's light
+    engine.set_block(glm::ivec3(3, 15, 3), AIR);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(3, 15, 3), BLOCK_LIGHT) == 0);
+    assert(engine.get_light(glm::ivec3(12, 15, 12), BLOCK_LIGHT) == 14);
+
+    engine.set_block(glm::ivec3(12, 15, 12), AIR);
+    engine.update();
+    for(int y = 0; y < 32; y++) {
+        for(int x = 0; x < 16; x++) {
+            for(int z = 0; z < 16; z++) {
+                assert(engine.get_light(glm::ivec3(x, y, z), BLOCK_LIGHT) == 0);
+            }
+        }
+    }
+}
+
+static void test_sky_light() {
+    light_engine engine(nullptr);
+    set_vanilla_properties(engine);
+    add_sections(engine, 1, 2, nullptr);
+    engine.update();
+
+    // Open sky goes all the way down
+    assert(engine.get_light(glm::ivec3(8, 0, 8), SKY_LIGHT) == 15);
+
+    // A block in the way leaves a column lit from the side
+    engine.set_block(glm::ivec3(8, 20, 8), STONE);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(8, 21, 8), SKY_LIGHT) == 15);
+    assert(engine.get_light(glm::ivec3(8, 20, 8), SKY_LIGHT) == 0);
+    assert(engine.get_light(glm::ivec3(8, 5, 8), SKY_LIGHT) == 14);
+
+    // Water dims the light under it
+    engine.set_block(glm::ivec3(8, 20, 8), WATER);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(8, 20, 8), SKY_LIGHT) == 12);
+
+    engine.set_block(glm::ivec3(8, 20, 8), AIR);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(8, 5, 8), SKY_LIGHT) == 15);
+}
+
+static void test_sections_above_block_sky() {
+    light_engine engine(nullptr);
+    set_vanilla_properties(engine);
+    engine.add_section(glm::ivec3(0, 0, 0), nullptr);
+    engine.update();
+    assert(engine.get_light(glm::ivec3(4, 4, 4), SKY_LIGHT) == 15);
+
+    // A solid section on top means nothing gets in
+    std::vector<uint16_t> stone(light_engine::BLOCKS_PER_SECTION, STONE);
+    engine.add_section(glm::ivec3(0, 1, 0), stone.data());
+    engine.update();
+    assert(engine.get_light(glm::ivec3(4, 4, 4), SKY_LIGHT) == 0);
+    assert(engine.get_light(glm::ivec3(4, 15, 4), SKY_LIGHT) == 0);
+
+    // And taking it away opens the sky back up
+    engine.remove_section(glm::ivec3(0, 1, 0));
+    engine.update();
+    assert(engine.get_light(glm::ivec3(4, 4, 4), SKY_LIGHT) == 15);
+    assert(engine.get_num_sections() == 1);
+}
+
+static void test_workers_match_single_thread() {
+    worker_pool pool(2);
+    light_engine threaded(&pool);
+    light_engine single(nullptr);
+
+    std::vector<uint16_t> blocks(light_engine::BLOCKS_PER_SECTION, AIR);
+    for(int x = 0; x < 16; x++) {
+        for(int z = 0; z < 16; z++) {
+            blocks[get_section_index(x, 0, z)] = STONE;
+            blocks[get_section_index(x, 15, z)] = (x + z) % 5 == 0 ? AIR : STONE;
+        }
+    }
+    blocks[get_section_index(5, 6, 7)] = TORCH;
+
+    light_engine * engines[] = {&threaded, &single};
+    for(light_engine * engine : engines) {
+        set_vanilla_properties(*engine);
+        add_sections(*engine, 3, 2, blocks.data());
+        engine->update();
+        engine->wait();
+        engine->set_block(glm::ivec3(20, 10, 20), GLOWSTONE);
+        engine->set_block(glm::ivec3(5, 31, 5), STONE);
+        engine->update();
+        engine->wait();
+        assert(!engine->is_busy());
+    }
+
+    for(int x = 0; x < 48; x++) {
+        for(int y = 0; y < 32; y++) {
+            for(int z = 0; z < 48; z++) {
+                const glm::ivec3 position(x, y, z);
+                assert(threaded.get_light(position, BLOCK_LIGHT) == single.get_light(position, BLOCK_LIGHT));
+                assert(threaded.get_light(position, SKY_LIGHT) == single.get_light(position, SKY_LIGHT));
+            }
+        }
+    }
+}
+
+/*!
+ * \brief A 64x64 lake of lava on a stone floor, under open sky. Every block of the lake is a light source, and the
+ * light floods the whole area
+ */
+static void benchmark_lava_lake() {
+    worker_pool pool(1);
+    light_engine engine(&pool);
+    set_vanilla_properties(engine);
+
+    std::vector<uint16_t> lake(light_engine::BLOCKS_PER_SECTION, AIR);
+    for(int x = 0; x < 16; x++) {
+        for(int z = 0; z < 16; z++) {
+            for(int y = 0; y < 4; y++) {
+                lake[get_section_index(x, y, z)] = y < 2 ? STONE : LAVA;
+            }
+        }
+    }
+
+    std::vector<uint16_t> air(light_engine::BLOCKS_PER_SECTION, AIR);
+    for(int x = 0; x < 4; x++) {
+        for(int z = 0; z < 4; z++) {
+            engine.add_section(glm::ivec3(x, 1, z), air.data());
+            engine.add_section(glm::ivec3(x, 0, z), lake.data());
+        }
+    }
+
+    const double first_light = time_update(engine);
+    const uint64_t first_nodes = engine.get_num_nodes_visited();
+    assert(engine.get_light(glm::ivec3(32, 3, 32), BLOCK_LIGHT) == 15);
+    assert(engine.get_light(glm::ivec3(32, 10, 32), BLOCK_LIGHT) == 8);
+
+    // Dig out a lava block in the middle of the lake, then put it back
+    engine.set_block(glm::ivec3(32, 3, 32), STONE);
+    const double removal = time_update(engine);
+    assert(engine.get_light(glm::ivec3(32, 4, 32), BLOCK_LIGHT) == 13);
+
+    engine.set_block(glm::ivec3(32, 3, 32), LAVA);
+    const double add = time_update(engine);
+    assert(engine.get_light(glm::ivec3(32, 4, 32), BLOCK_LIGHT) == 14);
+
+    LOG(INFO) << "Lava lake: first light took " << first_light << "ms (" << first_nodes << " nodes). Removing a lava "
+              << "block took " << removal << "ms, putting it back took " << add << "ms";
+}
+
+/*!
+ * \brief A 64x64 cave that's 30 blocks tall with a ceiling of glowstone, so all the block light comes from above and
+ * there's no sky light until the ceiling gets a hole
+ */
+static void benchmark_glowstone_ceiling() {
+    worker_pool pool(1);
+    light_engine engine(&pool);
+    set_vanilla_properties(engine);
+
+    std::vector<uint16_t> ceiling(light_engine::BLOCKS_PER_SECTION, AIR);
+    std::vector<uint16_t> floor(light_engine::BLOCKS_PER_SECTION, AIR);
+    for(int x = 0; x < 16; x++) {
+        for(int z = 0; z < 16; z++) {
+            ceiling[get_section_index(x, 15, z)] = GLOWSTONE;
+            floor[get_section_index(x, 0, z)] = STONE;
+        }
+    }
+
+    for(int x = 0; x < 4; x++) {
+        for(int z = 0; z < 4; z++) {
+            engine.add_section(glm::ivec3(x, 1, z), ceiling.data());
+            engine.add_section(glm::ivec3(x, 0, z), floor.data());
+        }
+    }
+
+    const double first_light = time_update(engine);
+    const uint64_t first_nodes = engine.get_num_nodes_visited();
+    assert(engine.get_light(glm::ivec3(32, 30, 32), BLOCK_LIGHT) == 14);
+    assert(engine.get_light(glm::ivec3(32, 16, 32), BLOCK_LIGHT) == 0);
+    assert(engine.get_light(glm::ivec3(32, 30, 32), SKY_LIGHT) == 0);
+
+    // Break a hole in the ceiling, which lets the sky in and takes away one light source
+    engine.set_block(glm::ivec3(32, 31, 32), AIR);
+    const double hole = time_update(engine);
+    assert(engine.get_light(glm::ivec3(32, 20, 32), SKY_LIGHT) == 15);
+    assert(engine.get_light(glm::ivec3(32, 31, 32), BLOCK_LIGHT) == 14);
+    assert(engine.get_light(glm::ivec3(32, 30, 32), BLOCK_LIGHT) == 13);
+
+    engine.set_block(glm::ivec3(32, 31, 32), GLOWSTONE);
+    const double patch = time_update(engine);
+    assert(engine.get_light(glm::ivec3(32, 20, 32), SKY_LIGHT) == 0);
+
+    LOG(INFO) << "Glowstone ceiling: first light took " << first_light << "ms (" << first_nodes << " nodes). "
+              << "Breaking the ceiling took " << hole << "ms, patching it took " << patch << "ms";
+}
+
+void light_engine_test::run_all() {
+    run_test(test_torch_lights_up_area, "test_torch_lights_up_area");
+    run_test(test_removing_torch_makes_it_dark, "test_removing_torch_makes_it_dark");
+    run_test(test_sky_light, "test_sky_light");
+    run_test(test_sections_above_block_sky, "test_sections_above_block_sky");
+    run_test(test_workers_match_single_thread, "test_workers_match_single_thread");
+    run_test(benchmark_lava_lake, "benchmark_lava_lake");
+    run_test(benchmark_glowstone_ceiling, "benchmark_glowstone_ceiling");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_LIGHT_ENGINE_TEST_H
+#define RENDERER_LIGHT_ENGINE_TEST_H
+
+namespace light_engine_test {
+    void run_all();
+};
+
+#endif //RENDERER_LIGHT_ENGINE_TEST_H
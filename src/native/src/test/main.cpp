@@ -1,9 +1,21 @@
 #include <easylogging++.h>
 
 #include "core/nova.h"
+#include "core/nova_renderer.h"
 
+#include "async_log_test.h"
+#include "clustered_lights_test.h"
+#include "command_ring_test.h"
+#include "config.h"
+#include "frame_arena_test.h"
+#include "light_engine_test.h"
+#include "oit_test.h"
 #include "sanity.h"
 #include "shader_test.h"
+#include "shadow_test.h"
+#include "texture_test.h"
+#include "translucency_test.h"
+#include "vertex_test.h"
 
 void fill_render_command(mc_render_command &command);
 
@@ -14,8 +26,41 @@ int main() {
     LOG(INFO) << "Running sanity tests...";
     sanity::run_all();
 
-    //LOG(INFO) << "Running shader tests...";
-    //shader::run_all();
+    LOG(INFO) << "Running texture tests...";
+    texture::run_all();
+
+    LOG(INFO) << "Running config tests...";
+    config_ns::run_all();
+
+    LOG(INFO) << "Running command ring tests...";
+    command_ring_test::run_all();
+
+    LOG(INFO) << "Running async log tests...";
+    async_log_test::run_all();
+
+    LOG(INFO) << "Running frame arena tests...";
+    frame_arena_test::run_all();
+
+    LOG(INFO) << "Running vertex tests...";
+    vertex_test::run_all();
+
+    LOG(INFO) << "Running translucency tests...";
+    translucency_test::run_all();
+
+    LOG(INFO) << "Running OIT tests...";
+    oit_test::run_all();
+
+    LOG(INFO) << "Running light engine tests...";
+    light_engine_test::run_all();
+
+    LOG(INFO) << "Running clustered light tests...";
+    clustered_lights_test::run_all();
+
+    LOG(INFO) << "Running shadow tests...";
+    shadow_test::run_all();
+
+    LOG(INFO) << "Running shader tests...";
+    shader::run_all();
 
     LOG(INFO) << "Integration tests...";
 
@@ -28,7 +73,8 @@ int main() {
 
     gui_command.screen.num_buttons = 1;
 
-    send_change_gui_screen_command(&gui_command);
+    // The tests run on the render thread, so the screen can go straight to the renderer
+    nova_renderer::instance->on_set_gui_screen(gui_command.screen);
 
     while(!should_close()) {
         // Make a dummy render command
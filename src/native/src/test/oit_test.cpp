@@ -0,0 +1,199 @@
+/*!
+ * \brief Checks that the weighted blended OIT targets can be rendered to, and that drawing order doesn't matter
+ *
+ * Nothing here needs real hardware, so these work on a software driver like llvmpipe too
+ *
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <cmath>
+#include <sstream>
+#include "oit_test.h"
+#include "test_utils.h"
+#include "core/nova_renderer.h"
+#include "core/weighted_blended_oit.h"
+#include "gl/gl_state_cache.h"
+
+static const int WIDTH = 8;
+static const int HEIGHT = 4;
+
+/*!
+ * \brief Covers the whole framebuffer with one translucent color
+ */
+static gl_shader_program make_translucent_program() {
+    std::stringstream vertex_source(R"(#version 450
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.5, 1.0);
+}
+)");
+
+    std::stringstream fragment_source("#version 450\n" + weighted_blended_oit::get_glsl_output_functions() + R"(
+uniform vec4 tint;
+
+void main() {
+    nova_write_translucent(tint);
+}
+)");
+
+    gl_shader_program program("oit_test");
+    program.add_shader(GL_VERTEX_SHADER, vertex_source);
+    program.add_shader(GL_FRAGMENT_SHADER, fragment_source);
+    program.link();
+    return program;
+}
+
+/*!
+ * \brief Draws the given colors, in order, into freshly cleared OIT targets, then reads back the middle pixel
+ */
+static void draw_layers(weighted_blended_oit & oit, gl_shader_program & program, GLuint vertex_array,
+                        const std::vector<glm::vec4> & colors, float * accumulation, float & revealage) {
+    static const uniform_id TINT = gl_shader_program::get_uniform_id("tint");
+
+    oit.begin_translucent_pass();
+    gl_state_cache::get().set_depth_test_enabled(false);
+    program.bind();
+    gl_state_cache::get().bind_vertex_array(vertex_array);
+
+    for(const glm::vec4 & color : colors) {
+        program.set_uniform(TINT, color);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    std::vector<float> accumulation_pixels(WIDTH * HEIGHT * 4);
+    std::vector<float> revealage_pixels(WIDTH * HEIGHT);
+    glGetTextureImage(oit.get_accumulation()->get_gl_name(), 0, GL_RGBA, GL_FLOAT,
+                      (GLsizei) (accumulation_pixels.size() * sizeof(float)), accumulation_pixels.data());
+    glGetTextureImage(oit.get_revealage()->get_gl_name(), 0, GL_RED, GL_FLOAT,
+                      (GLsizei) (revealage_pixels.size() * sizeof(float)), revealage_pixels.data());
+
+    const int middle = (HEIGHT / 2) * WIDTH + WIDTH / 2;
+    for(int i = 0; i < 4; i++) {
+        accumulation[i] = accumulation_pixels[middle * 4 + i];
+    }
+    revealage = revealage_pixels[middle];
+
+    gl_state_cache::get().bind_framebuffer(0);
+}
+
+static void test_targets_are_complete() {
+    weighted_blended_oit oit(nova_renderer::instance->get_shaderpack());
+    assert(!oit.is_enabled());
+
+    assert(oit.resize(WIDTH, HEIGHT));
+    assert(oit.is_enabled());
+    assert(oit.get_accumulation()->get_format() == (GLint) weighted_blended_oit::ACCUMULATION_FORMAT);
+    assert(oit.get_revealage()->get_format() == (GLint) weighted_blended_oit::REVEALAGE_FORMAT);
+
+    // Resizing makes new textures, which have to be attached all over again
+    assert(oit.resize(WIDTH * 2, HEIGHT * 2));
+    assert(oit.get_accumulation()->get_width() == WIDTH * 2);
+
+    oit.release();
+    assert(!oit.is_enabled());
+    assert(oit.get_framebuffer() == nullptr);
+}
+
+static void test_settings_turn_oit_on_and_off() {
+    weighted_blended_oit oit(nova_renderer::instance->get_shaderpack());
+
+    nova_settings settings;
+    settings.view_width = WIDTH;
+    settings.view_height = HEIGHT;
+    settings.transparency = nova_settings::transparency_mode::weighted_blended;
+    oit.on_config_change(settings);
+    assert(oit.is_enabled());
+    assert(oit.get_revealage()->get_width() == WIDTH);
+
+    settings.transparency = nova_settings::transparency_mode::sorted;
+    oit.on_config_change(settings);
+    assert(!oit.is_enabled());
+    assert(oit.get_accumulation() == nullptr);
+}
+
+static void test_missing_composite_program_keeps_oit_off() {
+    // This shaderpack was never loaded, so it doesn't have a composite program
+    shaderpack empty_shaderpack;
+    weighted_blended_oit oit(empty_shaderpack);
+
+    nova_settings settings;
+    settings.view_width = WIDTH;
+    settings.view_height = HEIGHT;
+    settings.transparency = nova_settings::transparency_mode::weighted_blended;
+    oit.on_config_change(settings);
+    assert(!oit.is_enabled());
+    assert(oit.get_framebuffer() == nullptr);
+}
+
+static void test_order_does_not_matter() {
+    weighted_blended_oit oit(nova_renderer::instance->get_shaderpack());
+    assert(oit.resize(WIDTH, HEIGHT));
+
+    gl_shader_program program = make_translucent_program();
+    GLuint vertex_array;
+    glCreateVertexArrays(1, &vertex_array);
+
+    const glm::vec4 red(1, 0, 0, 0.5f);
+    const glm::vec4 blue(0, 0, 1, 0.25f);
+
+    float red_first[4];
+    float red_first_revealage;
+    draw_layers(oit, program, vertex_array, {red, blue}, red_first, red_first_revealage);
+
+    float blue_first[4];
+    float blue_first_revealage;
+    draw_layers(oit, program, vertex_array, {blue, red}, blue_first, blue_first_revealage);
+
+    // Each layer lets through 1 - alpha of what's behind it
+    const float eight_bit = 1.0f / 255.0f;
+    assert(std::abs(red_first_revealage - 0.5f * 0.75f) <= eight_bit);
+    // Both orders multiply to the same revealage, but it's rounded to 8 bits after each layer, so the orders can end
+    // up one step apart
+    assert(std::abs(std::round(red_first_revealage * 255.0f) - std::round(blue_first_revealage * 255.0f)) <= 1.0f);
+
+    for(int i = 0; i < 4; i++) {
+        assert(std::abs(red_first[i] - blue_first[i]) <= std::abs(red_first[i]) * 0.001f);
+    }
+
+    // Red is more opaque, so it should count for more of the average color
+    assert(red_first[3] > 0);
+    assert(red_first[0] / red_first[3] > red_first[2] / red_first[3]);
+
+    gl_state_cache::get().delete_vertex_arrays(1, &vertex_array);
+}
+
+static void test_composite_restores_state() {
+    weighted_blended_oit oit(nova_renderer::instance->get_shaderpack());
+    assert(oit.resize(WIDTH, HEIGHT));
+
+    GLint window_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, window_viewport);
+
+    oit.begin_translucent_pass();
+    oit.composite(window_viewport[2], window_viewport[3]);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    for(int i = 0; i < 4; i++) {
+        assert(viewport[i] == window_viewport[i]);
+    }
+
+    GLboolean depth_write = GL_FALSE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_write);
+    assert(depth_write == GL_TRUE);
+    assert(glIsEnabled(GL_BLEND) == GL_FALSE);
+    assert(glIsEnabled(GL_DEPTH_TEST) == GL_FALSE);
+
+    GLint framebuffer = -1;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    assert(framebuffer == 0);
+}
+
+void oit_test::run_all() {
+    run_test(test_targets_are_complete, "test_targets_are_complete");
+    run_test(test_settings_turn_oit_on_and_off, "test_settings_turn_oit_on_and_off");
+    run_test(test_missing_composite_program_keeps_oit_off, "test_missing_composite_program_keeps_oit_off");
+    run_test(test_order_does_not_matter, "test_order_does_not_matter");
+    run_test(test_composite_restores_state, "test_composite_restores_state");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_OIT_TEST_H
+#define RENDERER_OIT_TEST_H
+
+namespace oit_test {
+    void run_all();
+};
+
+#endif //RENDERER_OIT_TEST_H
@@ -11,6 +11,7 @@
 #include "core/nova_renderer.h"
 #include <easylogging++.h>
 #include <assert.h>
+#include <sstream>
 
 /*!
  * \brief Tests that the gl_shader_program constructor does not explode
@@ -91,11 +92,129 @@ static void test_parse_uniforms() {
     LOG(INFO) << "We have all the uniforms we should";
 }
 
+/*!
+ * \brief Links a little program with plain uniforms, an array, a uniform block, and a uniform that gets optimized out
+ */
+static gl_shader_program make_reflection_program() {
+    std::stringstream vertex_source(R"(#version 450
+uniform mat4 transform;
+uniform vec3 offsets[4];
+
+void main() {
+    gl_Position = transform * vec4(offsets[gl_VertexID & 3], 1.0);
+}
+)");
+
+    std::stringstream fragment_source(R"(#version 450
+uniform vec4 tint;
+uniform float strength;
+uniform int unused_value;
+
+layout(std140) uniform reflection_block {
+    vec4 block_color;
+};
+
+out vec4 color;
+
+void main() {
+    color = tint * strength + block_color;
+}
+)");
+
+    gl_shader_program program("reflection_test");
+    program.add_shader(GL_VERTEX_SHADER, vertex_source);
+    program.add_shader(GL_FRAGMENT_SHADER, fragment_source);
+    program.link();
+    return program;
+}
+
+static void test_reflect_uniforms() {
+    gl_shader_program program = make_reflection_program();
+
+    std::string tint = "tint";
+    std::string strength = "strength";
+    std::string transform = "transform";
+    std::string offsets = "offsets";
+    std::string unused_value = "unused_value";
+    std::string block_color = "block_color";
+
+    assert(program.get_uniform_location(tint) >= 0);
+    assert(program.get_uniform_location(strength) >= 0);
+    assert(program.get_uniform_location(transform) >= 0);
+
+    // Arrays are found by their name without the [0]
+    assert(program.get_uniform_location(offsets) >= 0);
+
+    // Optimized out uniforms and block members don't have locations
+    assert(program.get_uniform_location(unused_value) == -1);
+    assert(program.get_uniform_location(block_color) == -1);
+
+    assert(program.get_uniform_block_index(gl_shader_program::get_uniform_id("reflection_block")) != GL_INVALID_INDEX);
+    assert(program.get_uniform_block_index(gl_shader_program::get_uniform_id("not_a_block")) == GL_INVALID_INDEX);
+}
+
+static void test_set_uniforms() {
+    gl_shader_program program = make_reflection_program();
+
+    static const uniform_id TINT = gl_shader_program::get_uniform_id("tint");
+    static const uniform_id STRENGTH = gl_shader_program::get_uniform_id("strength");
+    static const uniform_id TRANSFORM = gl_shader_program::get_uniform_id("transform");
+    static const uniform_id OFFSETS = gl_shader_program::get_uniform_id("offsets");
+    static const uniform_id UNUSED_VALUE = gl_shader_program::get_uniform_id("unused_value");
+
+    std::string tint_name = "tint";
+    std::string strength_name = "strength";
+    std::string transform_name = "transform";
+    std::string offsets_name = "offsets";
+
+    const glm::vec4 tint(0.25f, 0.5f, 0.75f, 1.0f);
+    program.set_uniform(TINT, tint);
+    program.set_uniform(STRENGTH, 3.0f);
+
+    glm::mat4 transform(1.0f);
+    transform[3] = glm::vec4(1.0f, 2.0f, 3.0f, 1.0f);
+    program.set_uniform(TRANSFORM, transform);
+    program.set_uniform(OFFSETS, glm::vec3(4.0f, 5.0f, 6.0f));
+
+    // Setting a uniform this program doesn't have is fine, it just doesn't do anything
+    program.set_uniform(UNUSED_VALUE, 7);
+
+    glm::vec4 read_tint;
+    glGetUniformfv(program.get_gl_name(), program.get_uniform_location(tint_name), &read_tint[0]);
+    assert(read_tint == tint);
+
+    float read_strength = 0;
+    glGetUniformfv(program.get_gl_name(), program.get_uniform_location(strength_name), &read_strength);
+    assert(read_strength == 3.0f);
+
+    glm::mat4 read_transform;
+    glGetUniformfv(program.get_gl_name(), program.get_uniform_location(transform_name), &read_transform[0][0]);
+    assert(read_transform == transform);
+
+    // Setting an array uniform sets its first element
+    glm::vec3 read_offset;
+    glGetUniformfv(program.get_gl_name(), program.get_uniform_location(offsets_name), &read_offset[0]);
+    assert(read_offset == glm::vec3(4.0f, 5.0f, 6.0f));
+
+    // The last value is remembered, so setting it again doesn't go to the driver. Change it behind the program's back
+    // to see that
+    glProgramUniform1f(program.get_gl_name(), program.get_uniform_location(strength_name), 8.0f);
+    program.set_uniform(STRENGTH, 3.0f);
+    glGetUniformfv(program.get_gl_name(), program.get_uniform_location(strength_name), &read_strength);
+    assert(read_strength == 8.0f);
+
+    program.set_uniform(STRENGTH, 4.0f);
+    glGetUniformfv(program.get_gl_name(), program.get_uniform_location(strength_name), &read_strength);
+    assert(read_strength == 4.0f);
+}
+
 void shader::run_all() {
     run_test(test_create_shader, "test_create_shader");
     run_test(test_add_fragment_shader, "test_add_fragment_shader");
     run_test(test_add_vertex_shader, "test_add_vertex_shader");
     run_test(test_link_shader, "test_link_shader");
     run_test(test_parse_uniforms, "test_parse_uniforms");
+    run_test(test_reflect_uniforms, "test_reflect_uniforms");
+    run_test(test_set_uniforms, "test_set_uniforms");
 }
 
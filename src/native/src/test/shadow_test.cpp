@@ -0,0 +1,346 @@
+/*!
+ * \brief Tests for the shadow cascades and their caster lists, and a benchmark of making the lists
+ *
+ * \date 19-Oct-26
+ */
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <easylogging++.h>
+#include "shadow_test.h"
+#include "test_utils.h"
+#include "core/shadow_cascades.h"
+#include "gl/gl_state_cache.h"
+
+static const uint32_t NUM_CASCADES = shadow_cascades::NUM_CASCADES;
+
+static shadow_cascades::camera make_camera() {
+    shadow_cascades::camera view_camera;
+    view_camera.position = glm::vec3(8.3f, 80.6f, 8.7f);
+    view_camera.forward = glm::vec3(0, 0, -1);
+    view_camera.vertical_fov = 70.0f * 3.14159265f / 180.0f;
+    view_camera.aspect = 16.0f / 9.0f;
+    view_camera.near_plane = 0.1f;
+    view_camera.far_plane = 160.0f;
+    return view_camera;
+}
+
+/*!
+ * \brief Where the sun's light goes at the given angle from noon. It goes around the z axis, like Minecraft's
+ */
+static glm::vec3 get_sun_direction(float angle) {
+    return glm::vec3(std::sin(angle), -std::cos(angle), 0);
+}
+
+static uint64_t get_chunk_id(int x, int y, int z) {
+    return ((uint64_t) (x & 0xFFFFF) << 40) | ((uint64_t) (y & 0xFFFFF) << 20) | (uint64_t) (z & 0xFFFFF);
+}
+
+/*!
+ * \brief Adds width x width columns of 16 sections each, centered on the origin
+ */
+static void add_chunks(chunk_bounds & chunks, int width) {
+    for(int x = -width / 2; x < width / 2; x++) {
+        for(int z = -width / 2; z < width / 2; z++) {
+            for(int y = 0; y < 16; y++) {
+                const glm::vec3 corner(x * 16.0f, y * 16.0f, z * 16.0f);
+                chunks.set_chunk(get_chunk_id(x, y, z), {corner, corner + glm::vec3(16.0f)});
+            }
+        }
+    }
+}
+
+static glm::vec3 project(const glm::mat4 & view_projection, const glm::vec3 & position) {
+    const glm::vec4 projected = view_projection * glm::vec4(position, 1.0f);
+    return glm::vec3(projected.x, projected.y, projected.z) / projected.w;
+}
+
+static bool is_in_volume(const glm::vec3 & ndc, float tolerance) {
+    return std::abs(ndc.x) <= 1.0f + tolerance && std::abs(ndc.y) <= 1.0f + tolerance &&
+           std::abs(ndc.z) <= 1.0f + tolerance;
+}
+
+/*!
+ * \brief Every chunk with any of its corners or its center in a cascade's volume has to be in the cascade's caster
+ * list
+ */
+static void assert_casters_cover_cascades(const shadow_cascades & shadows, const chunk_bounds & chunks) {
+    const std::vector<aabb> & boxes = chunks.get_boxes();
+    const std::vector<uint64_t> & ids = chunks.get_ids();
+
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        const shadow_cascades::cascade & current = shadows.get_cascade(i);
+
+        for(uint32_t chunk = 0; chunk < boxes.size(); chunk++) {
+            const aabb & box = boxes[chunk];
+            bool inside = is_in_volume(project(current.view_projection, (box.min + box.max) * 0.5f), 0);
+            for(int corner = 0; corner < 8 && !inside; corner++) {
+                const glm::vec3 position(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+                                         corner & 4 ? box.max.z : box.min.z);
+                inside = is_in_volume(project(current.view_projection, position), 0);
+            }
+
+            if(inside) {
+                assert(std::find(current.casters.begin(), current.casters.end(), ids[chunk]) != current.casters.end());
+            }
+        }
+    }
+}
+
+static void test_chunk_bounds_stay_packed() {
+    chunk_bounds chunks;
+    chunks.set_chunk(1, {glm::vec3(0), glm::vec3(16)});
+    chunks.set_chunk(2, {glm::vec3(16, 0, 0), glm::vec3(32, 16, 16)});
+    chunks.set_chunk(3, {glm::vec3(32, 0, 0), glm::vec3(48, 16, 16)});
+    const uint64_t generation = chunks.get_generation();
+
+    // Setting the same box again isn't a change
+    chunks.set_chunk(2, {glm::vec3(16, 0, 0), glm::vec3(32, 16, 16)});
+    assert(chunks.get_generation() == generation);
+
+    chunks.remove_chunk(1);
+    assert(chunks.get_generation() != generation);
+    assert(chunks.get_num_chunks() == 2);
+    assert(chunks.get_ids()[0] == 3);
+    assert(chunks.get_boxes()[0].min == glm::vec3(32, 0, 0));
+
+    chunks.remove_chunk(3);
+    chunks.remove_chunk(3);
+    assert(chunks.get_num_chunks() == 1);
+    assert(chunks.get_ids()[0] == 2);
+}
+
+static void test_splits() {
+    const std::vector<float> splits = shadow_cascades::compute_splits(0.1f, 160.0f);
+    assert(splits.size() == NUM_CASCADES + 1);
+    assert(splits[0] == 0.1f);
+    assert(splits[NUM_CASCADES] == 160.0f);
+
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        assert(splits[i] < splits[i + 1]);
+    }
+
+    // Closer than evenly spaced, so the first cascade gets the detail
+    assert(splits[1] < 40.0f);
+}
+
+static void test_cascades_cover_their_slices() {
+    chunk_bounds chunks;
+    shadow_cascades shadows;
+    const shadow_cascades::camera view_camera = make_camera();
+    shadows.update(view_camera, get_sun_direction(0.4f), chunks);
+
+    const float tan_y = std::tan(view_camera.vertical_fov * 0.5f);
+    const float tan_x = tan_y * view_camera.aspect;
+
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        const shadow_cascades::cascade & current = shadows.get_cascade(i);
+        const float distances[] = {current.split_near, current.split_far};
+
+        // The camera looks down -z, so its right is +x and its up is +y
+        for(float distance : distances) {
+            for(int corner = 0; corner < 4; corner++) {
+                const glm::vec3 offset((corner & 1 ? 1 : -1) * distance * tan_x, (corner & 2 ? 1 : -1) * distance * tan_y,
+                                       -distance);
+                assert(is_in_volume(project(current.view_projection, view_camera.position + offset), 1e-4f));
+            }
+        }
+    }
+}
+
+static void test_cascades_are_texel_snapped() {
+    chunk_bounds chunks;
+    shadow_cascades shadows;
+    shadow_cascades::camera view_camera = make_camera();
+    shadows.update(view_camera, get_sun_direction(0.4f), chunks);
+
+    glm::vec2 old_offsets[NUM_CASCADES];
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        const shadow_cascades::cascade & current = shadows.get_cascade(i);
+        old_offsets[i] = glm::vec2(current.view[3][0], current.view[3][1]) / current.texel_size;
+
+        assert(std::abs(old_offsets[i].x - std::round(old_offsets[i].x)) < 1e-2f);
+        assert(std::abs(old_offsets[i].y - std::round(old_offsets[i].y)) < 1e-2f);
+    }
+
+    // Moving a little bit moves every cascade by whole texels, or not at all
+    view_camera.position += glm::vec3(0.37f, 0.11f, -0.23f);
+    shadows.update(view_camera, get_sun_direction(0.4f), chunks);
+
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        const shadow_cascades::cascade & current = shadows.get_cascade(i);
+        const glm::vec2 moved = glm::vec2(current.view[3][0], current.view[3][1]) / current.texel_size - old_offsets[i];
+        assert(std::abs(moved.x - std::round(moved.x)) < 1e-2f);
+        assert(std::abs(moved.y - std::round(moved.y)) < 1e-2f);
+    }
+}
+
+static void test_cascade_size_doesnt_change_when_camera_turns() {
+    chunk_bounds chunks;
+    shadow_cascades shadows;
+    shadow_cascades::camera view_camera = make_camera();
+    shadows.update(view_camera, get_sun_direction(0.4f), chunks);
+
+    float radii[NUM_CASCADES];
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        radii[i] = shadows.get_cascade(i).radius;
+    }
+
+    view_camera.forward = glm::normalize(glm::vec3(1.0f, -0.5f, 0.3f));
+    shadows.update(view_camera, get_sun_direction(0.4f), chunks);
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        assert(shadows.get_cascade(i).radius == radii[i]);
+    }
+}
+
+static void test_casters_are_culled_per_cascade() {
+    chunk_bounds chunks;
+    add_chunks(chunks, 32);
+
+    // A chunk way off to the side and one far below everything can't cast anything onto the view
+    chunks.set_chunk(1, {glm::vec3(10000, 64, 0), glm::vec3(10016, 80, 16)});
+    chunks.set_chunk(2, {glm::vec3(0, -2000, 0), glm::vec3(16, -1984, 16)});
+
+    shadow_cascades shadows;
+    shadows.update(make_camera(), get_sun_direction(0.4f), chunks);
+    assert_casters_cover_cascades(shadows, chunks);
+
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        const std::vector<uint64_t> & casters = shadows.get_cascade(i).casters;
+        assert(casters.size() < chunks.get_num_chunks());
+        assert(std::find(casters.begin(), casters.end(), 1) == casters.end());
+        assert(std::find(casters.begin(), casters.end(), 2) == casters.end());
+    }
+
+    // The closest cascade is the smallest
+    assert(shadows.get_cascade(0).casters.size() < shadows.get_cascade(NUM_CASCADES - 1).casters.size());
+}
+
+static void test_caster_lists_are_cached() {
+    chunk_bounds chunks;
+    add_chunks(chunks, 16);
+
+    shadow_cascades shadows;
+    shadow_cascades::camera view_camera = make_camera();
+    float sun_angle = 0.4f;
+    shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+    assert(shadows.get_num_caster_rebuilds() == NUM_CASCADES);
+
+    // Nothing changed, so nothing gets rebuilt
+    shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+    assert(shadows.get_num_caster_rebuilds() == NUM_CASCADES);
+
+    // Walking around and the sun moving a little bit only rebuild the odd list, and the lists still have everything
+    uint64_t num_rebuilds = shadows.get_num_caster_rebuilds();
+    for(int step = 0; step < 40; step++) {
+        view_camera.position += glm::vec3(0.25f, 0.0f, -0.1f);
+        sun_angle += shadow_cascades::SUN_ANGLE_TOLERANCE * 0.02f;
+        shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+        assert_casters_cover_cascades(shadows, chunks);
+    }
+    assert(shadows.get_num_caster_rebuilds() - num_rebuilds < 40 * NUM_CASCADES / 4);
+
+    // A new chunk means every list needs it
+    num_rebuilds = shadows.get_num_caster_rebuilds();
+    chunks.set_chunk(1, {glm::vec3(0, 256, 0), glm::vec3(16, 272, 16)});
+    shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+    assert(shadows.get_num_caster_rebuilds() == num_rebuilds + NUM_CASCADES);
+
+    // So does the sun moving a lot
+    num_rebuilds = shadows.get_num_caster_rebuilds();
+    sun_angle += 0.1f;
+    shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+    assert(shadows.get_num_caster_rebuilds() == num_rebuilds + NUM_CASCADES);
+    assert_casters_cover_cascades(shadows, chunks);
+}
+
+static void test_end_shadow_pass_restores_state() {
+    shadow_cascades shadows;
+    assert(shadows.resize(64));
+
+    GLint window_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, window_viewport);
+
+    for(uint32_t i = 0; i < NUM_CASCADES; i++) {
+        shadows.begin_cascade(i);
+    }
+
+    // Pretend a caster turned blending on
+    gl_state_cache::get().set_blend_enabled(true);
+    shadows.end_shadow_pass(window_viewport[2], window_viewport[3]);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    for(int i = 0; i < 4; i++) {
+        assert(viewport[i] == window_viewport[i]);
+    }
+
+    assert(glIsEnabled(GL_BLEND) == GL_FALSE);
+    assert(glIsEnabled(GL_DEPTH_TEST) == GL_FALSE);
+
+    GLboolean depth_write = GL_TRUE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_write);
+    assert(depth_write == GL_FALSE);
+
+    GLint framebuffer = -1;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    assert(framebuffer == 0);
+
+    // The shadow map deletes its own texture when it's released
+    const GLuint shadow_map = shadows.get_shadow_map()->get_gl_name();
+    shadows.release();
+    assert(glIsTexture(shadow_map) == GL_FALSE);
+}
+
+/*!
+ * \brief 32x32 columns of 16 sections each, which is a render distance of 16. Compares frames where the sun moved
+ * enough to rebuild every list to frames where only the camera moved
+ */
+static void benchmark_caster_lists() {
+    chunk_bounds chunks;
+    add_chunks(chunks, 32);
+
+    shadow_cascades shadows;
+    shadow_cascades::camera view_camera = make_camera();
+    float sun_angle = 0.4f;
+    shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+
+    const int num_frames = 100;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < num_frames; frame++) {
+        sun_angle += 0.01f;
+        shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+    }
+    const double rebuild_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                        .count() / num_frames;
+
+    const uint64_t num_rebuilds = shadows.get_num_caster_rebuilds();
+    start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < num_frames; frame++) {
+        view_camera.position += glm::vec3(0.05f, 0, 0);
+        shadows.update(view_camera, get_sun_direction(sun_angle), chunks);
+    }
+    const double cached_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                       .count() / num_frames;
+
+    LOG(INFO) << "Caster lists for " << chunks.get_num_chunks() << " chunks: " << rebuild_time << "ms a frame when "
+              << "the sun moves, " << cached_time << "ms when only the camera does ("
+              << shadows.get_num_caster_rebuilds() - num_rebuilds << " lists rebuilt in " << num_frames << " frames). "
+              << "Casters per cascade: " << shadows.get_cascade(0).casters.size() << ", "
+              << shadows.get_cascade(1).casters.size() << ", " << shadows.get_cascade(2).casters.size() << ", "
+              << shadows.get_cascade(3).casters.size();
+}
+
+void shadow_test::run_all() {
+    run_test(test_chunk_bounds_stay_packed, "test_chunk_bounds_stay_packed");
+    run_test(test_splits, "test_splits");
+    run_test(test_cascades_cover_their_slices, "test_cascades_cover_their_slices");
+    run_test(test_cascades_are_texel_snapped, "test_cascades_are_texel_snapped");
+    run_test(test_cascade_size_doesnt_change_when_camera_turns, "test_cascade_size_doesnt_change_when_camera_turns");
+    run_test(test_casters_are_culled_per_cascade, "test_casters_are_culled_per_cascade");
+    run_test(test_caster_lists_are_cached, "test_caster_lists_are_cached");
+    run_test(test_end_shadow_pass_restores_state, "test_end_shadow_pass_restores_state");
+    run_test(benchmark_caster_lists, "benchmark_caster_lists");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_SHADOW_TEST_H
+#define RENDERER_SHADOW_TEST_H
+
+namespace shadow_test {
+    void run_all();
+};
+
+#endif //RENDERER_SHADOW_TEST_H
@@ -0,0 +1,449 @@
+/*!
+ * \brief Contains tests for getting textures from Java into OpenGL
+ *
+ * \date 19-Oct-26
+ */
+
+#include "texture_test.h"
+#include "test_utils.h"
+#include "core/nova.h"
+#include "core/nova_renderer.h"
+#include "gl/gl_state_cache.h"
+#include "core/material_store.h"
+#include <easylogging++.h>
+#include <assert.h>
+
+/*!
+ * \brief Feeds a synthetic ABGR image with padded rows through add_texture_from_buffer, then reads it back from the
+ * GPU to make sure every pixel ended up where it should, in RGBA order
+ */
+static void test_add_texture_from_buffer() {
+    const int width = 16;
+    const int height = 8;
+    const int row_stride = width * 4 + 12;  // Pad each row, like a sub-image of a bigger buffer would be
+
+    // Fill the padding with garbage, so we notice if it gets uploaded
+    std::vector<unsigned char> abgr_data((size_t) (row_stride * height), 0xCD);
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            unsigned char * pixel = &abgr_data[y * row_stride + x * 4];
+            pixel[0] = (unsigned char) (255 - x);   // A
+            pixel[1] = (unsigned char) (x * y);     // B
+            pixel[2] = (unsigned char) (y * 16);    // G
+            pixel[3] = (unsigned char) (x * 16);    // R
+        }
+    }
+
+    bool added = add_texture_from_buffer(abgr_data.data(), (int) abgr_data.size(), width, height, row_stride,
+                                         (int) texture_manager::pixel_format::ABGR,
+                                         (int) texture_manager::atlas_type::GUI,
+                                         (int) texture_manager::texture_type::ALBEDO) != 0;
+    assert(added);
+
+    texture2D_array & atlas = nova_renderer::instance->get_texture_manager().get_texture_atlas(
+            texture_manager::atlas_type::GUI);
+    assert(atlas.get_width() == width);
+    assert(atlas.get_height() == height);
+    assert(atlas.get_num_layers() == (int) texture_manager::texture_type::NUM_TEXTURE_TYPES);
+
+    std::vector<unsigned char> rgba_data((size_t) (width * height * 4));
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureSubImage(atlas.get_gl_name(), 0, 0, 0, (GLint) texture_manager::texture_type::ALBEDO, width, height, 1,
+                         GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei) rgba_data.size(), rgba_data.data());
+
+    for(int y = 0; y < height; y++) {
+        for(int x = 0; x < width; x++) {
+            unsigned char * pixel = &rgba_data[(y * width + x) * 4];
+            assert(pixel[0] == (unsigned char) (x * 16));
+            assert(pixel[1] == (unsigned char) (y * 16));
+            assert(pixel[2] == (unsigned char) (x * y));
+            assert(pixel[3] == (unsigned char) (255 - x));
+        }
+    }
+
+    LOG(INFO) << "All pixels survived the trip to the GPU";
+}
+
+/*!
+ * \brief Makes sure a layer nobody uploaded to holds its neutral value, and that uploading one layer leaves the others
+ * alone
+ */
+static void test_atlas_layers() {
+    const int width = 4;
+    const int height = 4;
+
+    std::vector<unsigned char> red(width * height * 3, 0);
+    for(int i = 0; i < width * height; i++) {
+        red[i * 3] = 255;
+    }
+
+    bool added = add_texture_from_buffer(red.data(), (int) red.size(), width, height, width * 3,
+                                         (int) texture_manager::pixel_format::RGB,
+                                         (int) texture_manager::atlas_type::PARTICLES,
+                                         (int) texture_manager::texture_type::ALBEDO) != 0;
+    assert(added);
+
+    texture2D_array & atlas = nova_renderer::instance->get_texture_manager().get_texture_atlas(
+            texture_manager::atlas_type::PARTICLES);
+
+    std::vector<unsigned char> pixels((size_t) (width * height * 4));
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // RGB data gets an alpha of one
+    glGetTextureSubImage(atlas.get_gl_name(), 0, 0, 0, (GLint) texture_manager::texture_type::ALBEDO, width, height, 1,
+                         GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei) pixels.size(), pixels.data());
+    assert(pixels[0] == 255 && pixels[1] == 0 && pixels[2] == 0 && pixels[3] == 255);
+
+    // Nobody sent normals, so they point straight out of the surface
+    glGetTextureSubImage(atlas.get_gl_name(), 0, 0, 0, (GLint) texture_manager::texture_type::NORMAL, width, height, 1,
+                         GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei) pixels.size(), pixels.data());
+    assert(pixels[0] >= 127 && pixels[0] <= 128);
+    assert(pixels[1] >= 127 && pixels[1] <= 128);
+    assert(pixels[2] == 255);
+}
+
+/*!
+ * \brief Makes sure that a buffer too small for the given dimensions is rejected instead of read past its end
+ */
+static void test_reject_short_buffer() {
+    std::vector<unsigned char> rgb_data(8 * 8 * 3 - 1);
+
+    bool added = add_texture_from_buffer(rgb_data.data(), (int) rgb_data.size(), 8, 8, 8 * 3,
+                                         (int) texture_manager::pixel_format::RGB,
+                                         (int) texture_manager::atlas_type::GUI,
+                                         (int) texture_manager::texture_type::NORMAL) != 0;
+    assert(!added);
+}
+
+/*!
+ * \brief Binds the same texture to the same unit a few times, and makes sure only the first bind reaches the driver
+ */
+static void test_array_texture_is_deleted() {
+    GLuint gl_name;
+    {
+        texture2D_array array;
+        array.allocate(4, 4, 2, GL_RGBA8);
+        gl_name = array.get_gl_name();
+        assert(glIsTexture(gl_name) == GL_TRUE);
+    }
+
+    assert(glIsTexture(gl_name) == GL_FALSE);
+}
+
+static void test_rebinding_is_elided() {
+    texture2D_array & atlas = nova_renderer::instance->get_texture_manager().get_texture_atlas(
+            texture_manager::atlas_type::GUI);
+
+    gl_state_cache & state = gl_state_cache::get();
+    atlas.unbind();
+    state.reset_counters();
+
+    atlas.bind(GL_TEXTURE3);
+    gl_state_cache::counters after_first_bind = state.get_counters();
+    assert(after_first_bind.issued > 0);
+    assert(after_first_bind.elided == 0);
+
+    atlas.bind(GL_TEXTURE3);
+    atlas.bind(GL_TEXTURE3);
+    assert(state.get_counters().issued == after_first_bind.issued);
+    assert(state.get_counters().elided == 2);
+
+    // Unit 3 is still the active unit, so the cache is still right after this
+    GLint bound_texture = 0;
+    glActiveTexture(GL_TEXTURE3);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &bound_texture);
+    assert((GLuint) bound_texture == atlas.get_gl_name());
+
+    atlas.unbind();
+}
+
+/*!
+ * \brief glBindBufferBase changes the generic binding too, so the cache has to know about it
+ */
+static void test_buffer_base_keeps_cache_right() {
+    GLuint buffers[2];
+    glCreateBuffers(2, buffers);
+
+    gl_state_cache & state = gl_state_cache::get();
+    state.bind_buffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 3, buffers[1]);
+
+    GLint bound_buffer = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &bound_buffer);
+    assert((GLuint) bound_buffer == buffers[1]);
+    glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, 3, &bound_buffer);
+    assert((GLuint) bound_buffer == buffers[1]);
+
+    // The cache knows the generic binding changed, so binding the first buffer again gets through
+    state.bind_buffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &bound_buffer);
+    assert((GLuint) bound_buffer == buffers[0]);
+
+    // Binding the same buffer to the same index again is skipped
+    state.reset_counters();
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 3, buffers[1]);
+    assert(state.get_counters().issued == 0 && state.get_counters().elided == 1);
+
+    // Deleting a buffer unbinds it from its indexed binding too
+    state.delete_buffers(2, buffers);
+    state.reset_counters();
+    state.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 3, 0);
+    assert(state.get_counters().elided == 1);
+}
+
+static void test_element_buffer_keeps_cache_right() {
+    GLuint vertex_array;
+    glCreateVertexArrays(1, &vertex_array);
+    GLuint buffers[2];
+    glCreateBuffers(2, buffers);
+
+    gl_state_cache & state = gl_state_cache::get();
+    state.set_element_buffer(vertex_array, buffers[0]);
+
+    GLint element_buffer = 0;
+    glGetVertexArrayiv(vertex_array, GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_buffer);
+    assert((GLuint) element_buffer == buffers[0]);
+
+    // Setting it again is skipped, and so is binding the same buffer the old way
+    state.reset_counters();
+    state.set_element_buffer(vertex_array, buffers[0]);
+    state.bind_vertex_array(vertex_array);
+    state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffers[0]);
+    assert(state.get_counters().elided == 2);
+
+    // Binding a different one the old way is seen by the next set
+    state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    state.set_element_buffer(vertex_array, buffers[0]);
+    glGetVertexArrayiv(vertex_array, GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_buffer);
+    assert((GLuint) element_buffer == buffers[0]);
+
+    state.bind_vertex_array(0);
+    state.delete_buffers(2, buffers);
+    state.delete_vertex_arrays(1, &vertex_array);
+}
+
+/*!
+ * \brief Returns true if a fragment shader that samples a material with the store's GLSL compiles
+ */
+static bool material_glsl_compiles(const material_store & materials) {
+    std::string source = "#version 450\n" + materials.get_glsl_declarations() +
+            "flat in uint material;\n"
+            "in vec2 uv;\n"
+            "out vec4 color;\n"
+            "void main() {\n"
+            "    color = sample_material(material, uv);\n"
+            "}\n";
+    const char * source_chars = source.c_str();
+
+    GLuint shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(shader, 1, &source_chars, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    glDeleteShader(shader);
+
+    return compiled == GL_TRUE;
+}
+
+static void test_material_store() {
+    std::vector<unsigned char> skin(4 * 4 * 4, 200);
+
+    // The fallback works everywhere, so always test it
+    material_store fallback(8, 4, 4, true);
+    assert(!fallback.uses_bindless_textures());
+
+    material_store::material_id first = fallback.add_material(skin.data(), 4, 4);
+    material_store::material_id second = fallback.add_material(skin.data(), 4, 4);
+    assert(first == 0 && second == 1);
+    assert(fallback.get_material(second).layer == 1);
+
+    // Every layer of the fallback array is the same size
+    assert(fallback.add_material(skin.data(), 2, 2) == material_store::INVALID_MATERIAL_ID);
+    assert(fallback.get_num_materials() == 2);
+
+    fallback.upload();
+    assert(material_glsl_compiles(fallback));
+
+    // The fallback array goes away with its store
+    GLuint fallback_texture;
+    {
+        material_store short_lived(8, 4, 4, true);
+        fallback_texture = short_lived.get_fallback_textures()->get_gl_name();
+        assert(glIsTexture(fallback_texture) == GL_TRUE);
+    }
+    assert(glIsTexture(fallback_texture) == GL_FALSE);
+
+    if(texture2D::is_bindless_supported()) {
+        material_store bindless(8, 4, 4);
+        assert(bindless.uses_bindless_textures());
+
+        // Bindless textures can be any size
+        material_store::material_id big = bindless.add_material(skin.data(), 4, 4);
+        material_store::material_id small = bindless.add_material(skin.data(), 2, 2);
+        assert(big != material_store::INVALID_MATERIAL_ID && small != material_store::INVALID_MATERIAL_ID);
+        assert(bindless.get_material(big).albedo_handle != 0);
+        assert(bindless.get_material(big).albedo_handle != bindless.get_material(small).albedo_handle);
+
+        bindless.upload();
+        assert(material_glsl_compiles(bindless));
+    } else {
+        LOG(INFO) << "Bindless textures aren't supported here, so only the fallback was tested";
+    }
+}
+
+/*!
+ * \brief Sends the given names to a texture manager in one batch, the way Java packs them. Each texture's UV
+ * rectangle is all the given value, so the tests can tell which send a location came from
+ */
+static void add_locations(texture_manager & textures, const std::vector<std::string> & names,
+                          const std::vector<float> & values) {
+    std::vector<char> packed_names;
+    std::vector<int> name_offsets;
+    std::vector<float> uv_rects;
+    for(std::size_t i = 0; i < names.size(); i++) {
+        name_offsets.push_back((int) packed_names.size());
+        packed_names.insert(packed_names.end(), names[i].begin(), names[i].end());
+        packed_names.push_back('\0');
+        uv_rects.insert(uv_rects.end(), 4, values[i]);
+    }
+
+    textures.add_texture_locations(packed_names.data(), (int) packed_names.size(), name_offsets.data(),
+                                   uv_rects.data(), (int) names.size());
+}
+
+static float get_location_value(const texture_manager::texture_location & location) {
+    assert(location.min.x == location.max.y);
+    return location.min.x;
+}
+
+static float get_location_value(texture_manager & textures, const std::string & name) {
+    return get_location_value(textures.get_texture_location(name));
+}
+
+static float get_location_value(texture_manager & textures, texture_manager::texture_id id) {
+    return get_location_value(textures.get_texture_location(id));
+}
+
+static void test_duplicate_texture_locations() {
+    texture_manager textures;
+    add_locations(textures, {"minecraft:blocks/stone", "minecraft:blocks/dirt", "minecraft:blocks/stone"}, {1, 2, 3});
+
+    // The first ID is the one that's kept, but it has the location that was sent last
+    assert(textures.get_texture_id("minecraft:blocks/stone") == 0);
+    assert(textures.get_texture_id("minecraft:blocks/dirt") == 1);
+    assert(get_location_value(textures, "minecraft:blocks/stone") == 3);
+
+    // Sending a name again in a later batch updates it in place
+    add_locations(textures, {"minecraft:blocks/dirt", "minecraft:blocks/dirt"}, {4, 5});
+    assert(textures.get_texture_id("minecraft:blocks/dirt") == 1);
+    assert(get_location_value(textures, "minecraft:blocks/dirt") == 5);
+    assert(get_location_value(textures, textures.get_texture_id("minecraft:blocks/dirt")) == 5);
+
+    // The copies didn't leave any IDs behind: the next new name gets the very next one
+    add_locations(textures, {"minecraft:blocks/sand"}, {6});
+    assert(textures.get_texture_id("minecraft:blocks/sand") == 2);
+}
+
+static void test_reloading_texture_locations_keeps_the_table_size() {
+    texture_manager textures;
+    const std::vector<std::string> names = {"minecraft:blocks/stone", "minecraft:blocks/dirt", "minecraft:blocks/sand"};
+    add_locations(textures, names, {1, 2, 3});
+    const std::size_t names_size = textures.get_location_names_size();
+
+    // Every resource reload sends the whole atlas again
+    for(int reload = 0; reload < 10; reload++) {
+        add_locations(textures, names, {4, 5, 6});
+    }
+
+    assert(textures.get_location_names_size() == names_size);
+    assert(get_location_value(textures, "minecraft:blocks/sand") == 6);
+}
+
+static void test_queued_texture_locations() {
+    texture_manager textures;
+    const char names[] = "minecraft:blocks/stone\0minecraft:blocks/dirt";
+    const int name_offsets[] = {0, 23};
+    const float first_uv_rects[] = {1, 1, 1, 1, 2, 2, 2, 2};
+    const float second_uv_rects[] = {3, 3, 3, 3, 4, 4, 4, 4};
+
+    // Nothing changes until the render thread adds them, and then the later batch wins
+    textures.queue_texture_locations(names, sizeof(names), name_offsets, first_uv_rects, 2);
+    textures.queue_texture_locations(names, sizeof(names), name_offsets, second_uv_rects, 2);
+    assert(textures.get_texture_id("minecraft:blocks/stone") == texture_manager::INVALID_TEXTURE_ID);
+
+    textures.add_queued_texture_locations();
+    assert(get_location_value(textures, "minecraft:blocks/stone") == 3);
+    assert(get_location_value(textures, "minecraft:blocks/dirt") == 4);
+    assert(textures.get_location_names_size() == sizeof(names));
+
+    // Batches that don't make sense never get queued
+    textures.queue_texture_locations(nullptr, sizeof(names), name_offsets, first_uv_rects, 2);
+    textures.queue_texture_locations(names, sizeof(names), nullptr, first_uv_rects, 2);
+    textures.queue_texture_locations(names, sizeof(names), name_offsets, nullptr, 2);
+    textures.queue_texture_locations(names, sizeof(names), name_offsets, first_uv_rects, -1);
+    textures.add_queued_texture_locations();
+    assert(get_location_value(textures, "minecraft:blocks/stone") == 3);
+}
+
+static void test_texture_location_lookup_after_merge() {
+    texture_manager textures;
+    add_locations(textures, {"minecraft:items/stick", "minecraft:blocks/grass", "minecraft:items/apple"}, {1, 2, 3});
+
+    // These land before, between, and after the names we already have, and one of them is already there
+    add_locations(textures, {"minecraft:zombie", "minecraft:blocks/dirt", "minecraft:items/bow",
+                             "minecraft:items/stick", "a"}, {4, 5, 6, 7, 8});
+
+    assert(get_location_value(textures, "minecraft:blocks/grass") == 2);
+    assert(get_location_value(textures, "minecraft:items/apple") == 3);
+    assert(get_location_value(textures, "minecraft:zombie") == 4);
+    assert(get_location_value(textures, "minecraft:blocks/dirt") == 5);
+    assert(get_location_value(textures, "minecraft:items/bow") == 6);
+    assert(get_location_value(textures, "minecraft:items/stick") == 7);
+    assert(get_location_value(textures, "a") == 8);
+
+    // Old IDs don't move, and new names get the next ones in the order they were sent
+    assert(textures.get_texture_id("minecraft:items/stick") == 0);
+    assert(textures.get_texture_id("minecraft:zombie") == 3);
+    assert(textures.get_texture_id("a") == 6);
+}
+
+static void test_missing_texture_locations() {
+    texture_manager textures;
+    assert(textures.get_texture_id("minecraft:blocks/stone") == texture_manager::INVALID_TEXTURE_ID);
+
+    add_locations(textures, {"minecraft:blocks/stone", "minecraft:blocks/stone_slab"}, {1, 2});
+
+    // Names before, between, and after the ones we have, and prefixes of them
+    const char * missing[] = {"", "a", "minecraft:blocks/ston", "minecraft:blocks/stone_", "zzz"};
+    for(const char * name : missing) {
+        assert(textures.get_texture_id(name) == texture_manager::INVALID_TEXTURE_ID);
+        assert(get_location_value(textures, name) == 0);
+    }
+
+    assert(get_location_value(textures, texture_manager::INVALID_TEXTURE_ID) == 0);
+
+    // A batch with a name outside of its names block is ignored completely
+    const char names[] = "minecraft:blocks/dirt";
+    const int name_offsets[] = {0, 100};
+    const float uv_rects[8] = {};
+    textures.add_texture_locations(names, sizeof(names), name_offsets, uv_rects, 2);
+    assert(textures.get_texture_id("minecraft:blocks/dirt") == texture_manager::INVALID_TEXTURE_ID);
+}
+
+void texture::run_all() {
+    run_test(test_add_texture_from_buffer, "test_add_texture_from_buffer");
+    run_test(test_reject_short_buffer, "test_reject_short_buffer");
+    run_test(test_atlas_layers, "test_atlas_layers");
+    run_test(test_array_texture_is_deleted, "test_array_texture_is_deleted");
+    run_test(test_rebinding_is_elided, "test_rebinding_is_elided");
+    run_test(test_buffer_base_keeps_cache_right, "test_buffer_base_keeps_cache_right");
+    run_test(test_element_buffer_keeps_cache_right, "test_element_buffer_keeps_cache_right");
+    run_test(test_material_store, "test_material_store");
+    run_test(test_duplicate_texture_locations, "test_duplicate_texture_locations");
+    run_test(test_texture_location_lookup_after_merge, "test_texture_location_lookup_after_merge");
+    run_test(test_missing_texture_locations, "test_missing_texture_locations");
+    run_test(test_reloading_texture_locations_keeps_the_table_size,
+             "test_reloading_texture_locations_keeps_the_table_size");
+    run_test(test_queued_texture_locations, "test_queued_texture_locations");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_TEXTURE_TEST_H
+#define RENDERER_TEXTURE_TEST_H
+
+namespace texture {
+    void run_all();
+};
+
+#endif //RENDERER_TEXTURE_TEST_H
@@ -0,0 +1,154 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <atomic>
+#include "translucency_test.h"
+#include "test_utils.h"
+#include "core/translucency_sorter.h"
+#include "utils/worker_pool.h"
+
+/*!
+ * \brief Makes a flat sheet of water faces, like the top of an ocean chunk
+ */
+static std::vector<glm::vec3> make_water_surface() {
+    std::vector<glm::vec3> faces;
+    for(int x = 0; x < 16; x++) {
+        for(int z = 0; z < 16; z++) {
+            faces.push_back(glm::vec3(x + 0.5f, 15.0f, z + 0.5f));
+        }
+    }
+    return faces;
+}
+
+static void count_job(void * counter) {
+    static_cast<std::atomic<int> *>(counter)->fetch_add(1);
+}
+
+static void test_worker_pool() {
+    worker_pool pool(3);
+    assert(pool.get_num_threads() == 3);
+
+    std::atomic<int> counter(0);
+    job_group group;
+    for(int i = 0; i < 1000; i++) {
+        pool.submit(count_job, &counter, &group);
+    }
+    group.wait();
+
+    assert(group.is_done());
+    assert(counter.load() == 1000);
+}
+
+static void test_sorts_back_to_front() {
+    translucency_sorter sorter(nullptr);
+
+    // A row of glass panes going away from the camera, nearest first
+    std::vector<glm::vec3> faces;
+    for(int z = 0; z < 10; z++) {
+        faces.push_back(glm::vec3(0.5f, 0.5f, z + 0.5f));
+    }
+    sorter.set_chunk_faces(1, glm::ivec3(16, 0, 16), faces, 100);
+    assert(sorter.get_num_faces() == 10);
+
+    assert(sorter.sort(glm::dvec3(16.5, 0.5, 10.0)) == 1);
+
+    const translucency_sorter::index_range range = sorter.get_range(1);
+    assert(range.num_indices == 60);
+    assert(sorter.get_changed_ranges().size() == 1);
+
+    const std::vector<uint32_t> & indices = sorter.get_indices();
+    for(uint32_t i = 0; i < 10; i++) {
+        // The farthest face comes first, and each face uses its own four vertices
+        const uint32_t face = 9 - i;
+        const uint32_t * quad = &indices[range.first_index + i * 6];
+        assert(quad[0] == 100 + face * 4 && quad[1] == 101 + face * 4 && quad[2] == 102 + face * 4);
+        assert(quad[3] == quad[2] && quad[4] == 103 + face * 4 && quad[5] == quad[0]);
+    }
+
+    // Moving to the other side of the panes turns the order around
+    sorter.sort(glm::dvec3(16.5, 0.5, 40.0));
+    assert(indices[range.first_index] == 100);
+}
+
+static void test_skips_sort_in_same_cell() {
+    translucency_sorter sorter(nullptr);
+    sorter.set_chunk_faces(1, glm::ivec3(0, 48, 0), make_water_surface(), 0);
+
+    assert(sorter.sort(glm::dvec3(8.1, 64.1, 8.1)) == 1);
+    assert(sorter.sort(glm::dvec3(8.1, 64.1, 8.1)) == 0);
+    assert(sorter.get_changed_ranges().empty());
+
+    // A little wiggle inside the same half block doesn't need a sort...
+    assert(sorter.sort(glm::dvec3(8.2, 64.2, 8.2)) == 0);
+
+    // ...but going to the next one does
+    assert(sorter.sort(glm::dvec3(8.7, 64.2, 8.2)) == 1);
+
+    // Far away, cells are big enough that walking a block doesn't matter
+    sorter.sort(glm::dvec3(400.1, 64.1, 8.1));
+    assert(sorter.sort(glm::dvec3(401.1, 64.1, 8.1)) == 0);
+
+    // New faces always get sorted
+    sorter.set_chunk_faces(1, glm::ivec3(0, 48, 0), make_water_surface(), 0);
+    assert(sorter.sort(glm::dvec3(401.1, 64.1, 8.1)) == 1);
+}
+
+static void test_ranges_are_reused() {
+    translucency_sorter sorter(nullptr);
+    std::vector<glm::vec3> ten_faces(10, glm::vec3(1.0f));
+    std::vector<glm::vec3> five_faces(5, glm::vec3(1.0f));
+
+    sorter.set_chunk_faces(1, glm::ivec3(0), ten_faces, 0);
+    sorter.set_chunk_faces(2, glm::ivec3(0), ten_faces, 0);
+    assert(sorter.get_range(2).first_index == 60);
+
+    // The hole chunk 1 leaves behind gets filled before the array grows
+    sorter.remove_chunk(1);
+    sorter.set_chunk_faces(3, glm::ivec3(0), five_faces, 0);
+    assert(sorter.get_range(3).first_index == 0);
+    assert(sorter.get_indices().size() == 120);
+
+    // Chunks that change size move, chunks that don't stay put
+    sorter.set_chunk_faces(2, glm::ivec3(0), five_faces, 0);
+    assert(sorter.get_range(2).first_index == 30);
+    sorter.set_chunk_faces(2, glm::ivec3(0), five_faces, 20);
+    assert(sorter.get_range(2).first_index == 30);
+
+    sorter.remove_chunk(2);
+    sorter.remove_chunk(3);
+    assert(sorter.get_indices().empty());
+    assert(sorter.get_num_faces() == 0);
+    assert(sorter.get_range(3).num_indices == 0);
+}
+
+static void test_workers_match_single_thread() {
+    worker_pool pool(3);
+    translucency_sorter threaded(&pool);
+    translucency_sorter single(nullptr);
+
+    // An ocean: enough water that the sort gets split up between workers
+    const std::vector<glm::vec3> water = make_water_surface();
+    for(int x = 0; x < 8; x++) {
+        for(int z = 0; z < 8; z++) {
+            const uint64_t id = (uint64_t) (x * 8 + z);
+            threaded.set_chunk_faces(id, glm::ivec3(x * 16, 48, z * 16), water, (uint32_t) id * 1024);
+            single.set_chunk_faces(id, glm::ivec3(x * 16, 48, z * 16), water, (uint32_t) id * 1024);
+        }
+    }
+
+    for(int frame = 0; frame < 4; frame++) {
+        const glm::dvec3 camera(frame * 9.3, 70.0, frame * 5.1);
+        assert(threaded.sort(camera) == single.sort(camera));
+        assert(threaded.get_indices() == single.get_indices());
+    }
+}
+
+void translucency_test::run_all() {
+    run_test(test_worker_pool, "test_worker_pool");
+    run_test(test_sorts_back_to_front, "test_sorts_back_to_front");
+    run_test(test_skips_sort_in_same_cell, "test_skips_sort_in_same_cell");
+    run_test(test_ranges_are_reused, "test_ranges_are_reused");
+    run_test(test_workers_match_single_thread, "test_workers_match_single_thread");
+}
@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_TRANSLUCENCY_TEST_H
+#define RENDERER_TRANSLUCENCY_TEST_H
+
+namespace translucency_test {
+    void run_all();
+};
+
+#endif //RENDERER_TRANSLUCENCY_TEST_H
@@ -0,0 +1,391 @@
+/*!
+ * \brief Contains tests for vertex formats
+ *
+ * \date 19-Oct-26
+ */
+
+#include <assert.h>
+#include <cmath>
+#include <vector>
+#include <glad/glad.h>
+#include "vertex_test.h"
+#include "test_utils.h"
+#include "core/terrain_vertex.h"
+#include "core/vertex_layouts.h"
+#include "gl/objects/gl_quad_index_buffer.h"
+#include "gl/objects/gl_vertex_buffer.h"
+
+static bool close_to(const glm::vec3 & a, const glm::vec3 & b, float tolerance) {
+    return std::fabs(a.x - b.x) <= tolerance && std::fabs(a.y - b.y) <= tolerance && std::fabs(a.z - b.z) <= tolerance;
+}
+
+static void test_pack_terrain_vertex() {
+    glm::vec3 position(15.0625f, -0.5f, 3.3f);
+    glm::vec3 normal(0, 1, 0);
+    glm::vec3 tangent(-1, 0, 0);
+
+    packed_terrain_vertex vertex = terrain_vertex::pack(position, glm::vec2(0.25f, 1.0f), glm::vec2(1.0f, 0.0f), normal,
+                                                        tangent);
+
+    // Half a step of 32 blocks over 65535 steps
+    assert(close_to(terrain_vertex::unpack_position(vertex), position, 0.00025f));
+
+    assert(vertex.uv[0] == 16384 && vertex.uv[1] == 65535);
+    assert(vertex.lightmap[0] == 255 && vertex.lightmap[1] == 0);
+
+    // Axis directions come back exactly
+    assert(terrain_vertex::unpack_normal(vertex) == normal);
+    assert(terrain_vertex::unpack_tangent(vertex) == tangent);
+
+    // Anything out of range gets clamped rather than wrapping around
+    packed_terrain_vertex clamped = terrain_vertex::pack(glm::vec3(-100, 100, 8), glm::vec2(2, -1), glm::vec2(-1, 2),
+                                                         normal, tangent);
+    assert(clamped.position[0] == 0 && clamped.position[1] == 65535);
+    assert(clamped.uv[0] == 65535 && clamped.uv[1] == 0);
+    assert(clamped.lightmap[0] == 0 && clamped.lightmap[1] == 255);
+}
+
+static void test_octahedral_directions() {
+    const glm::vec3 axes[] = {
+            glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0),
+            glm::vec3(0, 1, 0), glm::vec3(0, -1, 0),
+            glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+    };
+    for(const glm::vec3 & axis : axes) {
+        packed_terrain_vertex vertex = terrain_vertex::pack(glm::vec3(0), glm::vec2(0), glm::vec2(0), axis, axis);
+        assert(terrain_vertex::unpack_normal(vertex) == axis);
+    }
+
+    // Go all over the sphere. 8 bits per component should never be more than a couple degrees off
+    for(int i = 0; i < 1000; i++) {
+        float theta = i * 2.39996f;
+        float z = 1.0f - 2.0f * (i + 0.5f) / 1000.0f;
+        float r = std::sqrt(1.0f - z * z);
+        glm::vec3 direction(r * std::cos(theta), r * std::sin(theta), z);
+
+        packed_terrain_vertex vertex = terrain_vertex::pack(glm::vec3(0), glm::vec2(0), glm::vec2(0), direction,
+                                                            direction);
+        glm::vec3 unpacked = terrain_vertex::unpack_normal(vertex);
+        assert(glm::dot(unpacked, direction) > 0.999f);
+        assert(std::fabs(glm::length(unpacked) - 1.0f) < 0.0001f);
+    }
+}
+
+/*!
+ * \brief Doesn't fit in its vertex, so its layout had better not be valid
+ */
+struct broken_vertex {
+    float position[3];
+};
+
+template<>
+struct vertex_layout<broken_vertex> {
+    static constexpr vertex_attribute attributes[] = {
+            {0, "position", 3, component_type::float32, false, 0},
+            {1, "uv", 2, component_type::float32, false, 8}
+    };
+};
+
+static_assert(!is_valid_layout<broken_vertex>(), "Attributes that overlap or overflow should be caught");
+
+/*!
+ * \brief Uploads a few vertices, then asks GL what it thinks the vertex array looks like and checks that against the
+ * layout
+ */
+template<typename Vertex>
+static void check_vertex_array_matches_layout(std::vector<Vertex> vertices) {
+    gl_vertex_buffer buffer;
+    buffer.set_vertices(vertices, ivertex_buffer::usage::static_draw);
+    assert(buffer.get_format() == vertex_layout<Vertex>::data_format);
+
+    buffer.set_active();
+    GLint vertex_array;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertex_array);
+    assert(vertex_array != 0);
+
+    GLint stride;
+    glGetVertexArrayIndexediv((GLuint) vertex_array, 0, GL_VERTEX_BINDING_STRIDE, &stride);
+    assert(stride == sizeof(Vertex));
+
+    GLuint used_locations = 0;
+    for(const vertex_attribute & attribute : vertex_layout<Vertex>::attributes) {
+        GLint enabled, size, type, normalized, offset;
+        glGetVertexArrayIndexediv((GLuint) vertex_array, attribute.location, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+        glGetVertexArrayIndexediv((GLuint) vertex_array, attribute.location, GL_VERTEX_ATTRIB_ARRAY_SIZE, &size);
+        glGetVertexArrayIndexediv((GLuint) vertex_array, attribute.location, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+        glGetVertexArrayIndexediv((GLuint) vertex_array, attribute.location, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED,
+                                  &normalized);
+        glGetVertexArrayIndexediv((GLuint) vertex_array, attribute.location, GL_VERTEX_ATTRIB_RELATIVE_OFFSET,
+                                  &offset);
+
+        assert(enabled == GL_TRUE);
+        assert(size == (GLint) attribute.num_components);
+        assert((normalized == GL_TRUE) == attribute.normalized);
+        assert(offset == (GLint) attribute.offset);
+        assert(get_component_size(attribute.type) == (type == GL_FLOAT ? 4 : (type == GL_UNSIGNED_SHORT ? 2 : 1)));
+
+        used_locations |= 1u << attribute.location;
+    }
+
+    // Nothing else should be turned on
+    for(GLuint location = 0; location < 8; location++) {
+        if((used_locations & (1u << location)) == 0) {
+            GLint enabled;
+            glGetVertexArrayIndexediv((GLuint) vertex_array, location, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+            assert(enabled == GL_FALSE);
+        }
+    }
+}
+
+static void test_vertex_arrays_match_layouts() {
+    check_vertex_array_matches_layout(std::vector<pos_vertex>(3));
+    check_vertex_array_matches_layout(std::vector<pos_uv_vertex>(3));
+    check_vertex_array_matches_layout(std::vector<pos_uv_lightmapuv_normal_tangent_vertex>(3));
+
+    check_vertex_array_matches_layout(std::vector<packed_terrain_vertex>{
+            terrain_vertex::pack(glm::vec3(0), glm::vec2(0), glm::vec2(0), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0)),
+            terrain_vertex::pack(glm::vec3(1), glm::vec2(1), glm::vec2(1), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0)),
+            terrain_vertex::pack(glm::vec3(2), glm::vec2(0), glm::vec2(1), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0))
+    });
+
+    // These used to be at offset 0, with a two component normal
+    const vertex_attribute * attributes = vertex_layout<pos_uv_lightmapuv_normal_tangent_vertex>::attributes;
+    assert(attributes[1].offset == 12 && attributes[2].offset == 20);
+    assert(attributes[3].offset == 28 && attributes[3].num_components == 3);
+    assert(attributes[4].offset == 40);
+    assert(sizeof(pos_uv_lightmapuv_normal_tangent_vertex) == 13 * sizeof(float));
+}
+
+static void test_format_change_disables_attributes() {
+    gl_vertex_buffer buffer;
+    buffer.set_vertices(std::vector<pos_uv_lightmapuv_normal_tangent_vertex>(3), ivertex_buffer::usage::dynamic_draw);
+    buffer.set_vertices(std::vector<pos_vertex>(3), ivertex_buffer::usage::dynamic_draw);
+
+    buffer.set_active();
+    GLint vertex_array;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertex_array);
+
+    GLint uv_enabled;
+    glGetVertexArrayIndexediv((GLuint) vertex_array, 1, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &uv_enabled);
+    assert(uv_enabled == GL_FALSE);
+}
+
+/*!
+ * \brief Reads the vertex buffer bound to the vertex array of the given buffer back from the GPU
+ */
+template<typename Vertex>
+static std::vector<Vertex> read_back_vertices(gl_vertex_buffer & buffer, std::size_t count) {
+    buffer.set_active();
+    GLint vertex_array;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertex_array);
+
+    GLint vertex_buffer;
+    glGetVertexArrayIndexediv((GLuint) vertex_array, 0, GL_VERTEX_BINDING_BUFFER, &vertex_buffer);
+
+    std::vector<Vertex> vertices(count);
+    glGetNamedBufferSubData((GLuint) vertex_buffer, 0, count * sizeof(Vertex), vertices.data());
+    return vertices;
+}
+
+static bool same_position(const pos_vertex & a, const pos_vertex & b) {
+    return a.position[0] == b.position[0] && a.position[1] == b.position[1] && a.position[2] == b.position[2];
+}
+
+static void test_upload_from_pointer() {
+    const pos_vertex vertices[] = {{{1, 2, 3}}, {{4, 5, 6}}, {{7, 8, 9}}};
+    const unsigned short indices[] = {0, 1, 2};
+
+    gl_vertex_buffer buffer;
+    buffer.set_vertices(vertices, 3, ivertex_buffer::usage::dynamic_draw);
+    buffer.set_index_array(indices, 3, ivertex_buffer::usage::dynamic_draw);
+
+    std::vector<pos_vertex> read_back = read_back_vertices<pos_vertex>(buffer, 3);
+    for(int i = 0; i < 3; i++) {
+        assert(same_position(read_back[i], vertices[i]));
+    }
+
+    GLint index_buffer;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &index_buffer);
+    unsigned short read_back_indices[3];
+    glGetNamedBufferSubData((GLuint) index_buffer, 0, sizeof(read_back_indices), read_back_indices);
+    assert(read_back_indices[0] == 0 && read_back_indices[1] == 1 && read_back_indices[2] == 2);
+}
+
+static void test_map_for_write() {
+    gl_vertex_buffer buffer;
+
+    // Twice, so the second time maps the buffer the first time made
+    for(int pass = 0; pass < 2; pass++) {
+        pos_vertex * vertices = buffer.map_vertices<pos_vertex>(4, ivertex_buffer::usage::static_draw);
+        assert(vertices != nullptr);
+        assert(buffer.map_data(16, ivertex_buffer::format::POS, ivertex_buffer::usage::static_draw) == nullptr);
+
+        for(int i = 0; i < 4; i++) {
+            vertices[i] = pos_vertex{{(float) i, (float) pass, 0}};
+        }
+        buffer.unmap_data();
+
+        std::vector<pos_vertex> read_back = read_back_vertices<pos_vertex>(buffer, 4);
+        for(int i = 0; i < 4; i++) {
+            assert(same_position(read_back[i], pos_vertex{{(float) i, (float) pass, 0}}));
+        }
+    }
+
+    assert(buffer.get_format() == ivertex_buffer::format::POS);
+}
+
+static void test_upload_from_staging() {
+    // Small enough that the uploads go around the ring a bunch of times
+    gl_staging_buffer staging(1024);
+    gl_vertex_buffer buffer;
+
+    for(int i = 0; i < 100; i++) {
+        const std::size_t count = (std::size_t) (i % 7) + 1;
+        gl_staging_buffer::allocation allocation = staging.allocate(count * sizeof(pos_vertex));
+        assert(allocation.data != nullptr);
+        assert(allocation.offset % gl_staging_buffer::ALIGNMENT == 0);
+        assert(allocation.offset + allocation.size <= staging.get_capacity());
+
+        pos_vertex * vertices = static_cast<pos_vertex *>(allocation.data);
+        for(std::size_t v = 0; v < count; v++) {
+            vertices[v] = pos_vertex{{(float) i, (float) v, 1}};
+        }
+
+        buffer.set_data_from_staging(staging, allocation, ivertex_buffer::format::POS,
+                                     ivertex_buffer::usage::static_draw);
+
+        std::vector<pos_vertex> read_back = read_back_vertices<pos_vertex>(buffer, count);
+        for(std::size_t v = 0; v < count; v++) {
+            assert(same_position(read_back[v], pos_vertex{{(float) i, (float) v, 1}}));
+        }
+    }
+
+    // Too big for the whole ring
+    assert(staging.allocate(2048).data == nullptr);
+}
+
+static GLuint get_element_buffer(gl_vertex_buffer & buffer) {
+    buffer.set_active();
+    GLint element_buffer;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_buffer);
+    return (GLuint) element_buffer;
+}
+
+static void test_index_width() {
+    gl_vertex_buffer buffer;
+
+    // Small indices only take 16 bits, even when they come in as 32
+    std::vector<unsigned int> small_indices = {0, 1, 2, 65535};
+    buffer.set_index_array(small_indices, ivertex_buffer::usage::static_draw);
+    assert(buffer.get_index_type() == GL_UNSIGNED_SHORT);
+
+    unsigned short narrow_indices[4];
+    glGetNamedBufferSubData(get_element_buffer(buffer), 0, sizeof(narrow_indices), narrow_indices);
+    for(int i = 0; i < 4; i++) {
+        assert(narrow_indices[i] == small_indices[i]);
+    }
+
+    // One index too big for 16 bits makes the whole mesh 32 bits
+    std::vector<unsigned int> big_indices = {0, 1, 2, 65536};
+    buffer.set_index_array(big_indices, ivertex_buffer::usage::dynamic_draw);
+    assert(buffer.get_index_type() == GL_UNSIGNED_INT);
+
+    unsigned int wide_indices[4];
+    glGetNamedBufferSubData(get_element_buffer(buffer), 0, sizeof(wide_indices), wide_indices);
+    for(int i = 0; i < 4; i++) {
+        assert(wide_indices[i] == big_indices[i]);
+    }
+
+    std::vector<unsigned short> short_indices = {3, 2, 1};
+    buffer.set_index_array(short_indices, ivertex_buffer::usage::dynamic_draw);
+    assert(buffer.get_index_type() == GL_UNSIGNED_SHORT);
+}
+
+static void test_quad_indices() {
+    GLuint quad_indices = gl_quad_index_buffer::get().get_buffer();
+
+    // The second quad should be 4, 5, 6 and 6, 7, 4
+    unsigned short second_quad[gl_quad_index_buffer::INDICES_PER_QUAD];
+    glGetNamedBufferSubData(quad_indices, gl_quad_index_buffer::INDICES_PER_QUAD * sizeof(unsigned short),
+                            sizeof(second_quad), second_quad);
+    const unsigned short expected[] = {4, 5, 6, 6, 7, 4};
+    for(unsigned int i = 0; i < gl_quad_index_buffer::INDICES_PER_QUAD; i++) {
+        assert(second_quad[i] == expected[i]);
+    }
+
+    gl_vertex_buffer buffer;
+    buffer.set_vertices(std::vector<pos_vertex>(8), ivertex_buffer::usage::static_draw);
+
+    buffer.use_quad_indices(2);
+    assert(get_element_buffer(buffer) == quad_indices);
+    assert(buffer.get_index_type() == GL_UNSIGNED_SHORT);
+
+    // Two buffers share the same indices
+    gl_vertex_buffer other_buffer;
+    other_buffer.use_quad_indices(1);
+    assert(get_element_buffer(other_buffer) == quad_indices);
+
+    // Going back to real indices stops using the quad indices. The same size buffer gets reused
+    std::vector<unsigned short> indices = {0, 1, 2};
+    buffer.set_index_array(indices, ivertex_buffer::usage::dynamic_draw);
+    GLuint new_indices = get_element_buffer(buffer);
+    assert(new_indices != quad_indices && new_indices != 0);
+    buffer.set_index_array(indices, ivertex_buffer::usage::dynamic_draw);
+    assert(get_element_buffer(buffer) == new_indices);
+}
+
+static bool vertex_shader_compiles(const std::string & source) {
+    const char * source_chars = source.c_str();
+
+    GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(shader, 1, &source_chars, nullptr);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    glDeleteShader(shader);
+
+    return compiled == GL_TRUE;
+}
+
+static void test_glsl_inputs() {
+    assert(get_glsl_inputs<pos_uv_vertex>() ==
+           "layout(location = 0) in vec3 position;\n"
+           "layout(location = 1) in vec2 uv;\n");
+
+    vertex_attribute material = {5, "material", 1, component_type::uint16, false, 0};
+    assert(get_glsl_input(material) == "layout(location = 5) in uint material;\n");
+
+    std::string source = "#version 450\n" + get_glsl_inputs<pos_uv_lightmapuv_normal_tangent_vertex>() +
+            "out vec3 world_normal;\n"
+            "void main() {\n"
+            "    world_normal = normal + tangent + vec3(uv + lightmap_uv, 0.0);\n"
+            "    gl_Position = vec4(position, 1.0);\n"
+            "}\n";
+    assert(vertex_shader_compiles(source));
+}
+
+static void test_decode_glsl_compiles() {
+    std::string source = "#version 450\n" + get_glsl_inputs<packed_terrain_vertex>() +
+            terrain_vertex::get_glsl_decode_functions() +
+            "out vec3 world_normal;\n"
+            "void main() {\n"
+            "    world_normal = nova_decode_direction(normal);\n"
+            "    gl_Position = vec4(nova_decode_position(position), 1.0);\n"
+            "}\n";
+    assert(vertex_shader_compiles(source));
+}
+
+void vertex_test::run_all() {
+    run_test(test_pack_terrain_vertex, "test_pack_terrain_vertex");
+    run_test(test_octahedral_directions, "test_octahedral_directions");
+    run_test(test_vertex_arrays_match_layouts, "test_vertex_arrays_match_layouts");
+    run_test(test_format_change_disables_attributes, "test_format_change_disables_attributes");
+    run_test(test_glsl_inputs, "test_glsl_inputs");
+    run_test(test_upload_from_pointer, "test_upload_from_pointer");
+    run_test(test_map_for_write, "test_map_for_write");
+    run_test(test_upload_from_staging, "test_upload_from_staging");
+    run_test(test_index_width, "test_index_width");
+    run_test(test_quad_indices, "test_quad_indices");
+    run_test(test_decode_glsl_compiles, "test_decode_glsl_compiles");
+}
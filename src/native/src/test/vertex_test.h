@@ -0,0 +1,12 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_VERTEX_TEST_H
+#define RENDERER_VERTEX_TEST_H
+
+namespace vertex_test {
+    void run_all();
+};
+
+#endif //RENDERER_VERTEX_TEST_H
@@ -0,0 +1,368 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include "async_log.h"
+
+#include <pthread.h>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <sstream>
+#include <vector>
+#include <easylogging++.h>
+
+const uint32_t log_ring::CAPACITY;
+
+log_ring::log_ring() : write_pos(0), read_pos(0), num_dropped(0) {}
+
+void * log_ring::operator new(std::size_t size) {
+    // Allocate enough to line up the ring and keep what malloc gave us right in front of it, for operator delete
+    void * allocation = malloc(size + alignof(log_ring) + sizeof(void *));
+    if(allocation == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    uintptr_t ring_address = (reinterpret_cast<uintptr_t>(allocation) + sizeof(void *) + alignof(log_ring) - 1) &
+                             ~(uintptr_t) (alignof(log_ring) - 1);
+    reinterpret_cast<void **>(ring_address)[-1] = allocation;
+    return reinterpret_cast<void *>(ring_address);
+}
+
+void log_ring::operator delete(void * memory) noexcept {
+    if(memory != nullptr) {
+        free(static_cast<void **>(memory)[-1]);
+    }
+}
+
+uint8_t * log_ring::begin_write(uint32_t size) {
+    const uint64_t write = write_pos.load(std::memory_order_relaxed);
+    const uint64_t read = read_pos.load(std::memory_order_acquire);
+
+    uint32_t offset = (uint32_t) (write & (CAPACITY - 1));
+    const uint32_t space_to_end = CAPACITY - offset;
+
+    // Records don't wrap, so if this one doesn't fit before the end it needs the space to the end too
+    const uint32_t needed = size <= space_to_end ? size : size + space_to_end;
+    if(size > CAPACITY || (write - read) + needed > CAPACITY) {
+        num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if(size > space_to_end) {
+        record_header wrap_marker = {space_to_end, 0, nullptr};
+        std::memcpy(&data[offset], &wrap_marker, sizeof(wrap_marker));
+        write_pos.store(write + space_to_end, std::memory_order_release);
+        offset = 0;
+    }
+
+    return &data[offset];
+}
+
+void log_ring::end_write(uint32_t size) {
+    write_pos.store(write_pos.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+const log_ring::record_header * log_ring::peek() {
+    while(true) {
+        const uint64_t read = read_pos.load(std::memory_order_relaxed);
+        if(read == write_pos.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        const record_header * record = reinterpret_cast<const record_header *>(&data[read & (CAPACITY - 1)]);
+        if(record->site != nullptr) {
+            return record;
+        }
+
+        // A wrap marker. Skip it and try again from the start of the ring
+        read_pos.store(read + record->size, std::memory_order_release);
+    }
+}
+
+void log_ring::pop(const record_header * record) {
+    read_pos.store(read_pos.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+}
+
+uint64_t log_ring::get_num_dropped() const {
+    return num_dropped.load(std::memory_order_relaxed);
+}
+
+namespace async_log {
+    /*!
+     * \brief How long the logging thread sleeps when every ring is empty
+     */
+    static const long IDLE_SLEEP_NANOSECONDS = 2 * 1000 * 1000;
+
+    static pthread_once_t start_once = PTHREAD_ONCE_INIT;
+    static pthread_t logging_thread;
+
+    /*!
+     * \brief Lets a ring be freed once its thread exits. Its destructor runs after the thread's thread_local
+     * destructors, so it's after the last thing the thread could log
+     */
+    static pthread_key_t thread_exit_key;
+
+    // Guards the list of rings, and the flush counters. The threads that write log messages only take this the first
+    // time they log something
+    static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_cond_t flush_requested = PTHREAD_COND_INITIALIZER;
+    static pthread_cond_t flush_finished = PTHREAD_COND_INITIALIZER;
+
+    // Every ring that might still have records in it. The list is leaked on purpose: threads can still log while
+    // static destructors run, after the logging thread has stopped, and they need a list to put their ring in
+    static std::vector<log_ring *> & rings = *new std::vector<log_ring *>();
+
+    // Rings whose threads have exited. They stay in rings until the logging thread has drained them one last time,
+    // then it frees them
+    static std::vector<log_ring *> & exited_rings = *new std::vector<log_ring *>();
+
+    // How many records the rings that were freed dropped, so get_num_dropped doesn't forget them
+    static uint64_t num_dropped_by_freed_rings = 0;
+
+    static uint64_t flushes_requested = 0;
+    static uint64_t flushes_finished = 0;
+    static bool stop_requested = false;
+    static bool stopped = false;
+
+    static thread_local log_ring * thread_ring = nullptr;
+
+    static el::Level to_easylogging_level(log_level level) {
+        switch(level) {
+            case log_level::trace:
+                return el::Level::Trace;
+            case log_level::debug:
+                return el::Level::Debug;
+            case log_level::info:
+                return el::Level::Info;
+            case log_level::warning:
+                return el::Level::Warning;
+            case log_level::error:
+            default:
+                return el::Level::Error;
+        }
+    }
+
+    /*!
+     * \brief Formats and logs every record that's in the ring right now
+     */
+    static void drain(log_ring & ring) {
+        const log_ring::record_header * record;
+        while((record = ring.peek()) != nullptr) {
+            const log_site * site = record->site;
+
+            // Giving easylogging the site's file and line means %loc still points at the NOVA_LOG call and not at this
+            // function
+            el::base::Writer(to_easylogging_level(site->level), site->file, site->line, site->function)
+                    .construct(1, ELPP_CURR_FILE_LOGGER_ID) << format_record(*record);
+
+            ring.pop(record);
+        }
+    }
+
+    static void * run_logging_thread(void *) {
+        std::vector<log_ring *> rings_to_drain;
+        std::vector<log_ring *> rings_to_free;
+
+        bool stopping = false;
+        while(!stopping) {
+            pthread_mutex_lock(&rings_lock);
+            if(flushes_finished == flushes_requested) {
+                timespec wake_time;
+                clock_gettime(CLOCK_REALTIME, &wake_time);
+                wake_time.tv_nsec += IDLE_SLEEP_NANOSECONDS;
+                if(wake_time.tv_nsec >= 1000 * 1000 * 1000) {
+                    wake_time.tv_sec += 1;
+                    wake_time.tv_nsec -= 1000 * 1000 * 1000;
+                }
+                pthread_cond_timedwait(&flush_requested, &rings_lock, &wake_time);
+            }
+
+            const uint64_t flush_number = flushes_requested;
+            stopping = stop_requested;
+            rings_to_drain = rings;
+
+            // These threads are gone, so once this drain is done nothing can be left in their rings
+            rings_to_free.swap(exited_rings);
+            pthread_mutex_unlock(&rings_lock);
+
+            for(log_ring * ring : rings_to_drain) {
+                drain(*ring);
+            }
+
+            pthread_mutex_lock(&rings_lock);
+            for(log_ring * ring : rings_to_free) {
+                rings.erase(std::find(rings.begin(), rings.end(), ring));
+                num_dropped_by_freed_rings += ring->get_num_dropped();
+            }
+
+            if(flushes_finished != flush_number) {
+                flushes_finished = flush_number;
+                pthread_cond_broadcast(&flush_finished);
+            }
+            pthread_mutex_unlock(&rings_lock);
+
+            for(log_ring * ring : rings_to_free) {
+                delete ring;
+            }
+            rings_to_free.clear();
+        }
+
+        return nullptr;
+    }
+
+    static void on_thread_exit(void * ring) {
+        pthread_mutex_lock(&rings_lock);
+        exited_rings.push_back(static_cast<log_ring *>(ring));
+        pthread_mutex_unlock(&rings_lock);
+
+        // If something logs after this, it gets a new ring, and pthreads calls this again for that one
+        thread_ring = nullptr;
+    }
+
+    static void flush_at_exit() {
+        // Write out everything that's left, then stop the logging thread before easylogging's statics go away
+        pthread_mutex_lock(&rings_lock);
+        stop_requested = true;
+        flushes_requested++;
+        pthread_cond_signal(&flush_requested);
+        pthread_mutex_unlock(&rings_lock);
+
+        pthread_join(logging_thread, nullptr);
+
+        pthread_mutex_lock(&rings_lock);
+        stopped = true;
+        pthread_mutex_unlock(&rings_lock);
+    }
+
+    static void start_logging_thread() {
+        pthread_key_create(&thread_exit_key, on_thread_exit);
+        pthread_create(&logging_thread, nullptr, run_logging_thread, nullptr);
+
+        // Easylogging's statics were made before this, so this runs before they're destroyed. Otherwise the logging
+        // thread could still be writing a message when they go away
+        std::atexit(flush_at_exit);
+    }
+
+    log_ring & get_thread_ring() {
+        if(thread_ring == nullptr) {
+            pthread_once(&start_once, start_logging_thread);
+
+            thread_ring = new log_ring();
+
+            pthread_mutex_lock(&rings_lock);
+            rings.push_back(thread_ring);
+            pthread_mutex_unlock(&rings_lock);
+
+            pthread_setspecific(thread_exit_key, thread_ring);
+        }
+
+        return *thread_ring;
+    }
+
+    void flush() {
+        pthread_once(&start_once, start_logging_thread);
+
+        pthread_mutex_lock(&rings_lock);
+        if(stopped) {
+            // Nothing's left to write it out. It's too late to log anything anyways
+            pthread_mutex_unlock(&rings_lock);
+            return;
+        }
+
+        const uint64_t flush_number = ++flushes_requested;
+        pthread_cond_signal(&flush_requested);
+
+        while(flushes_finished < flush_number) {
+            pthread_cond_wait(&flush_finished, &rings_lock);
+        }
+        pthread_mutex_unlock(&rings_lock);
+    }
+
+    uint64_t get_num_dropped() {
+        pthread_mutex_lock(&rings_lock);
+        uint64_t num_dropped = num_dropped_by_freed_rings;
+        for(log_ring * ring : rings) {
+            num_dropped += ring->get_num_dropped();
+        }
+        pthread_mutex_unlock(&rings_lock);
+
+        return num_dropped;
+    }
+
+    std::size_t get_num_rings() {
+        pthread_mutex_lock(&rings_lock);
+        const std::size_t num_rings = rings.size();
+        pthread_mutex_unlock(&rings_lock);
+
+        return num_rings;
+    }
+
+    /*!
+     * \brief Reads the argument at in and writes it to the stream
+     */
+    static void format_arg(const uint8_t *& in, std::ostream & out) {
+        const uint8_t tag = *in++;
+
+        switch(tag) {
+            case TAG_SIGNED: {
+                int64_t value;
+                std::memcpy(&value, in, 8);
+                in += 8;
+                out << value;
+                break;
+            }
+            case TAG_UNSIGNED: {
+                uint64_t value;
+                std::memcpy(&value, in, 8);
+                in += 8;
+                out << value;
+                break;
+            }
+            case TAG_DOUBLE: {
+                double value;
+                std::memcpy(&value, in, 8);
+                in += 8;
+                out << value;
+                break;
+            }
+            case TAG_POINTER: {
+                uint64_t value;
+                std::memcpy(&value, in, 8);
+                in += 8;
+                out << "0x" << std::hex << value << std::dec;
+                break;
+            }
+            case TAG_STRING: {
+                uint16_t length;
+                std::memcpy(&length, in, 2);
+                in += 2;
+                out.write(reinterpret_cast<const char *>(in), length);
+                in += length;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::string format_record(const log_ring::record_header & record) {
+        std::ostringstream text;
+
+        const uint8_t * args = reinterpret_cast<const uint8_t *>(&record) + sizeof(log_ring::record_header);
+        uint32_t args_left = record.num_args;
+
+        for(const char * c = record.site->format; *c != '\0'; c++) {
+            if(c[0] == '{' && c[1] == '}' && args_left > 0) {
+                format_arg(args, text);
+                args_left--;
+                c++;
+            } else {
+                text << *c;
+            }
+        }
+
+        return text.str();
+    }
+}
@@ -0,0 +1,324 @@
+/*!
+ * \brief Defines a logger that the render thread can call without ever formatting a string or taking a lock
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_ASYNC_LOG_H
+#define RENDERER_ASYNC_LOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/*!
+ * \brief How important a log message is. These map one-to-one onto easylogging's levels
+ */
+enum class log_level : uint8_t {
+    trace,
+    debug,
+    info,
+    warning,
+    error
+};
+
+/*!
+ * \brief Everything about a log message that's known at compile time
+ *
+ * Each NOVA_LOG_* call makes one of these as a function-local static, and its address is the message's format id. The
+ * ring only has to hold that pointer and the arguments.
+ */
+struct log_site {
+    log_level level;
+    const char * format;    //!< The message, with a {} wherever an argument goes
+    const char * file;
+    unsigned long line;
+    const char * function;
+};
+
+/*!
+ * \brief A lock-free ring of log records that exactly one thread writes to and the logging thread reads from
+ *
+ * Each record is a header followed by the arguments. An argument is a one byte tag, then either eight bytes of
+ * number or a two byte length and that many bytes of string. Records are padded to sixteen bytes, so there's always room for a header, and never wrap around
+ * the end of the ring. If a record doesn't fit before the end, the writer leaves a wrap marker and starts over at the
+ * beginning.
+ *
+ * If the ring is full the record is dropped and counted. Making the render thread wait for the disk is exactly what
+ * this is meant to avoid.
+ */
+class log_ring {
+public:
+    /*!
+     * \brief How many bytes each thread gets for log records. Must be a power of two
+     */
+    static const uint32_t CAPACITY = 64 * 1024;
+
+    struct record_header {
+        uint32_t size;              //!< The size of the whole record, including this header and the padding
+        uint32_t num_args;
+        const log_site * site;      //!< nullptr for the wrap marker
+    };
+
+    log_ring();
+
+    /*!
+     * \brief Plain new only lines things up to 16 bytes before C++17, which would let the positions share a cache line.
+     * These make sure a log_ring always lands on a cache line
+     */
+    static void * operator new(std::size_t size);
+    static void operator delete(void * memory) noexcept;
+
+    /*!
+     * \brief Finds room for a record of the given size
+     *
+     * \return A pointer to write the record to, or nullptr if there isn't room
+     */
+    uint8_t * begin_write(uint32_t size);
+
+    /*!
+     * \brief Hands the record from the last #begin_write to the logging thread
+     */
+    void end_write(uint32_t size);
+
+    /*!
+     * \brief Returns the next record, or nullptr if there aren't any. Only the logging thread calls this
+     */
+    const record_header * peek();
+
+    /*!
+     * \brief Lets the writer reuse the space the record from #peek was in
+     */
+    void pop(const record_header * record);
+
+    /*!
+     * \brief Returns how many records didn't fit in the ring and were thrown away
+     */
+    uint64_t get_num_dropped() const;
+
+private:
+    alignas(8) uint8_t data[CAPACITY];
+
+    // Both positions only ever count up, and are wrapped with a mask when used. They're on separate cache lines so the
+    // two threads don't fight over them
+    alignas(64) std::atomic<uint64_t> write_pos;
+    alignas(64) std::atomic<uint64_t> read_pos;
+
+    std::atomic<uint64_t> num_dropped;
+};
+
+/*!
+ * \brief Writes log messages to the per-thread rings and formats them into easylogging on a background thread
+ *
+ * Formatting a log message means allocating a string, turning numbers into text, and locking easylogging. That's fine
+ * for a shader failing to compile, but not for something the render thread says every frame, or for the GL debug
+ * callback, which drivers can call thousands of times a frame. With this, the calling thread only copies a pointer and
+ * the arguments into its own ring.
+ *
+ * Messages from one thread come out in the order they were written. Messages from different threads might be a little
+ * out of order relative to each other, and the time easylogging prints is the time they were formatted, which is a
+ * millisecond or so after they were written.
+ *
+ * Plain LOG(...) is still around on purpose, for things that happen once or rarely: startup, loading, and errors that
+ * might be the last thing Nova says before it goes down. LOG writes the message before it returns, so it makes it out
+ * even if the process dies right after, where a NOVA_LOG message could still be sitting in its ring. Use NOVA_LOG_* for
+ * anything that can happen every frame, or more than that. The two can come out a little out of order relative to
+ * each other, same as messages from different threads.
+ *
+ * A thread's ring is freed once the thread exits and the logging thread has written out everything that was in it.
+ * The logging thread is stopped when the process exits, after it writes out whatever's left. Anything logged after
+ * that, like from a static destructor, is never written, since easylogging might already be gone.
+ */
+namespace async_log {
+    /*!
+     * \brief Strings longer than this are cut off. It's long enough for every GL debug message I've seen
+     */
+    const uint16_t MAX_STRING_LENGTH = 1024;
+
+    enum arg_tag : uint8_t {
+        TAG_SIGNED,
+        TAG_UNSIGNED,
+        TAG_DOUBLE,
+        TAG_STRING,
+        TAG_POINTER
+    };
+
+    /*!
+     * \brief Returns the calling thread's ring, making it and starting the logging thread if needed
+     */
+    log_ring & get_thread_ring();
+
+    /*!
+     * \brief Blocks until the logging thread has formatted everything that was written before this was called
+     */
+    void flush();
+
+    /*!
+     * \brief Returns how many messages have been dropped because a ring was full, across every thread
+     */
+    uint64_t get_num_dropped();
+
+    /*!
+     * \brief Returns how many rings haven't been freed yet, for tests
+     */
+    std::size_t get_num_rings();
+
+    /*!
+     * \brief Formats a single record into text. The logging thread uses this, and so do the tests
+     */
+    std::string format_record(const log_ring::record_header & record);
+
+    namespace detail {
+        inline uint32_t pad(uint32_t size) {
+            return (size + 15u) & ~15u;
+        }
+
+        inline uint16_t clamp_length(std::size_t length) {
+            return (uint16_t) (length > MAX_STRING_LENGTH ? MAX_STRING_LENGTH : length);
+        }
+
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, uint32_t>::type
+        encoded_size(const T &) {
+            return 1 + 8;
+        }
+
+        inline uint32_t encoded_size(const char * value) {
+            return 1 + 2 + (value == nullptr ? 0 : clamp_length(std::strlen(value)));
+        }
+
+        inline uint32_t encoded_size(const std::string & value) {
+            return 1 + 2 + clamp_length(value.size());
+        }
+
+        inline uint32_t encoded_size(const void *) {
+            return 1 + 8;
+        }
+
+        inline void write_tagged(uint8_t *& out, arg_tag tag, const void * value) {
+            *out++ = tag;
+            std::memcpy(out, value, 8);
+            out += 8;
+        }
+
+        inline void write_string(uint8_t *& out, const char * value, uint16_t length) {
+            *out++ = TAG_STRING;
+            std::memcpy(out, &length, 2);
+            out += 2;
+            std::memcpy(out, value, length);
+            out += length;
+        }
+
+        template<typename T>
+        typename std::enable_if<std::is_floating_point<T>::value>::type encode(uint8_t *& out, const T & value) {
+            double as_double = value;
+            write_tagged(out, TAG_DOUBLE, &as_double);
+        }
+
+        template<typename T>
+        typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && std::is_signed<T>::value>::type
+        encode(uint8_t *& out, const T & value) {
+            int64_t as_int = (int64_t) value;
+            write_tagged(out, TAG_SIGNED, &as_int);
+        }
+
+        template<typename T>
+        typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && !std::is_signed<T>::value>::type
+        encode(uint8_t *& out, const T & value) {
+            uint64_t as_uint = (uint64_t) value;
+            write_tagged(out, TAG_UNSIGNED, &as_uint);
+        }
+
+        inline void encode(uint8_t *& out, const char * value) {
+            if(value == nullptr) {
+                write_string(out, "", 0);
+            } else {
+                write_string(out, value, clamp_length(std::strlen(value)));
+            }
+        }
+
+        inline void encode(uint8_t *& out, const std::string & value) {
+            write_string(out, value.data(), clamp_length(value.size()));
+        }
+
+        inline void encode(uint8_t *& out, const void * value) {
+            uint64_t as_uint = (uint64_t) (uintptr_t) value;
+            write_tagged(out, TAG_POINTER, &as_uint);
+        }
+
+        inline uint32_t total_size() {
+            return 0;
+        }
+
+        template<typename First, typename... Rest>
+        uint32_t total_size(const First & first, const Rest &... rest) {
+            return encoded_size(first) + total_size(rest...);
+        }
+
+        inline void encode_all(uint8_t *&) {}
+
+        template<typename First, typename... Rest>
+        void encode_all(uint8_t *& out, const First & first, const Rest &... rest) {
+            encode(out, first);
+            encode_all(out, rest...);
+        }
+    }
+
+    /*!
+     * \brief Copies a log message into the given ring
+     *
+     * \return false if the ring was full and the message was dropped
+     */
+    template<typename... Args>
+    bool write_to(log_ring & ring, const log_site * site, const Args &... args) {
+        const uint32_t size = detail::pad(sizeof(log_ring::record_header) + detail::total_size(args...));
+
+        uint8_t * record = ring.begin_write(size);
+        if(record == nullptr) {
+            return false;
+        }
+
+        log_ring::record_header header = {size, (uint32_t) sizeof...(args), site};
+        std::memcpy(record, &header, sizeof(header));
+
+        uint8_t * out = record + sizeof(header);
+        detail::encode_all(out, args...);
+
+        ring.end_write(size);
+        return true;
+    }
+
+    /*!
+     * \brief Copies a log message into the calling thread's ring. Use the NOVA_LOG_* macros instead of calling this
+     */
+    template<typename... Args>
+    void write(const log_site * site, const Args &... args) {
+        write_to(get_thread_ring(), site, args...);
+    }
+}
+
+// ##__VA_ARGS__ eats the comma when there aren't any arguments. GCC, Clang, and MSVC all understand it
+#define NOVA_LOG_AT(nova_level, format, ...) do { \
+        static const log_site nova_log_site = {nova_level, format, __FILE__, __LINE__, __func__}; \
+        async_log::write(&nova_log_site, ##__VA_ARGS__); \
+    } while(false)
+
+/*
+ * Debug and trace messages are compiled out of release builds, arguments and all, so they cost nothing there. Don't put
+ * anything with side effects in a log call.
+ */
+#ifdef NDEBUG
+#define NOVA_LOG_TRACE(...) do {} while(false)
+#define NOVA_LOG_DEBUG(...) do {} while(false)
+#else
+#define NOVA_LOG_TRACE(...) NOVA_LOG_AT(log_level::trace, __VA_ARGS__)
+#define NOVA_LOG_DEBUG(...) NOVA_LOG_AT(log_level::debug, __VA_ARGS__)
+#endif
+
+#define NOVA_LOG_INFO(...) NOVA_LOG_AT(log_level::info, __VA_ARGS__)
+#define NOVA_LOG_WARNING(...) NOVA_LOG_AT(log_level::warning, __VA_ARGS__)
+#define NOVA_LOG_ERROR(...) NOVA_LOG_AT(log_level::error, __VA_ARGS__)
+
+#endif //RENDERER_ASYNC_LOG_H
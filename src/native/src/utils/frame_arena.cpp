@@ -0,0 +1,148 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cstdlib>
+#include <new>
+#include "frame_arena.h"
+#include "heap_stats.h"
+#include "async_log.h"
+
+const unsigned int frame_arenas::FRAMES_IN_FLIGHT;
+
+/*!
+ * \brief Returns how far past address you have to go to get to an address aligned to alignment
+ */
+static std::size_t get_padding(const void * address, std::size_t alignment) {
+    const uintptr_t misalignment = reinterpret_cast<uintptr_t>(address) & (alignment - 1);
+    return misalignment == 0 ? 0 : alignment - misalignment;
+}
+
+frame_arena::frame_arena(std::size_t initial_capacity) : capacity(initial_capacity) {
+    block = new uint8_t[capacity];
+}
+
+frame_arena::~frame_arena() {
+    free_overflow();
+    delete[] block;
+}
+
+void * frame_arena::allocate(std::size_t size, std::size_t alignment) {
+    const std::size_t start = used + get_padding(block + used, alignment);
+    if(start + size <= capacity) {
+        last_allocation = start;
+        used = start + size;
+        return block + start;
+    }
+
+    return allocate_overflow(size, alignment);
+}
+
+void frame_arena::deallocate(void * memory, std::size_t size) {
+    if(memory == block + last_allocation && last_allocation + size == used) {
+        used = last_allocation;
+    }
+}
+
+void frame_arena::reset() {
+    if(overflow != nullptr) {
+        // Make the main block big enough for all of the last frame, plus some room to grow
+        const std::size_t needed = used + overflow_bytes;
+        const std::size_t new_capacity = needed + needed / 2;
+
+        NOVA_LOG_DEBUG("A frame needed {} bytes but the frame arena only had {}. Growing it to {} bytes", needed,
+                       capacity, new_capacity);
+
+        free_overflow();
+        delete[] block;
+        block = new uint8_t[new_capacity];
+        capacity = new_capacity;
+    }
+
+    used = 0;
+    last_allocation = 0;
+    num_heap_allocations = 0;
+}
+
+std::size_t frame_arena::get_capacity() const {
+    return capacity;
+}
+
+std::size_t frame_arena::get_bytes_used() const {
+    return used + overflow_bytes;
+}
+
+uint32_t frame_arena::get_num_heap_allocations() const {
+    return num_heap_allocations;
+}
+
+void * frame_arena::allocate_overflow(std::size_t size, std::size_t alignment) {
+    if(overflow != nullptr) {
+        uint8_t * data = reinterpret_cast<uint8_t *>(overflow + 1);
+        const std::size_t start = overflow->used + get_padding(data + overflow->used, alignment);
+        if(start + size <= overflow->capacity) {
+            overflow->used = start + size;
+            overflow_bytes += size;
+            return data + start;
+        }
+    }
+
+    // Room for the allocation no matter how it's aligned, and at least as much as the main block so this doesn't
+    // happen again too soon
+    const std::size_t block_capacity = size + alignment > capacity ? size + alignment : capacity;
+    overflow_block * new_block = static_cast<overflow_block *>(std::malloc(sizeof(overflow_block) + block_capacity));
+    if(new_block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    num_heap_allocations++;
+
+    new_block->next = overflow;
+    new_block->capacity = block_capacity;
+    uint8_t * data = reinterpret_cast<uint8_t *>(new_block + 1);
+    const std::size_t start = get_padding(data, alignment);
+    new_block->used = start + size;
+    overflow = new_block;
+
+    overflow_bytes += size;
+    return data + start;
+}
+
+void frame_arena::free_overflow() {
+    while(overflow != nullptr) {
+        overflow_block * next = overflow->next;
+        std::free(overflow);
+        overflow = next;
+    }
+
+    overflow_bytes = 0;
+}
+
+frame_arenas::frame_arenas(std::size_t initial_capacity) {
+    for(std::unique_ptr<frame_arena> & arena : arenas) {
+        arena = std::unique_ptr<frame_arena>(new frame_arena(initial_capacity));
+    }
+
+    heap_allocations_at_frame_start = heap_stats::get_thread_allocations();
+}
+
+void frame_arenas::begin_frame() {
+    frame_arena & finished = *arenas[current];
+    last_frame_stats.arena_heap_allocations = finished.get_num_heap_allocations();
+    last_frame_stats.arena_bytes_used = finished.get_bytes_used();
+    last_frame_stats.heap_allocations = heap_stats::get_thread_allocations() - heap_allocations_at_frame_start;
+
+    current = (current + 1) % FRAMES_IN_FLIGHT;
+    arenas[current]->reset();
+
+    // Growing the arena is part of the last frame's fault, so don't count it against this frame
+    heap_allocations_at_frame_start = heap_stats::get_thread_allocations();
+}
+
+frame_arena & frame_arenas::get_current() {
+    return *arenas[current];
+}
+
+const frame_arenas::frame_stats & frame_arenas::get_last_frame_stats() const {
+    return last_frame_stats;
+}
@@ -0,0 +1,196 @@
+/*!
+ * \brief Defines a bump allocator for things that only live for a frame, and an STL allocator that uses it
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_FRAME_ARENA_H
+#define RENDERER_FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*!
+ * \brief Hands out memory by bumping a pointer, and frees all of it at once
+ *
+ * Building a frame makes a bunch of lists (visible chunks, draw lists, sort keys) that are thrown away once the frame
+ * is done. Making those with the heap means a few malloc/free pairs per list per frame, which adds up. With this,
+ * allocating is adding to an offset and freeing is setting that offset back to 0.
+ *
+ * The arena has one big block. If a frame needs more than that, the extra allocations come from overflow blocks on the
+ * heap, and the next #reset replaces the big block with one that's big enough for everything. So after a frame or
+ * two of growing, a frame that doesn't need more than the frames before it never touches the heap.
+ *
+ * Not thread safe. Each arena belongs to one thread
+ */
+class frame_arena {
+public:
+    /*!
+     * \param initial_capacity How many bytes the main block starts out with
+     */
+    frame_arena(std::size_t initial_capacity);
+
+    ~frame_arena();
+
+    frame_arena(const frame_arena & other) = delete;
+    frame_arena & operator=(const frame_arena & other) = delete;
+
+    /*!
+     * \brief Returns size bytes aligned to alignment, which has to be a power of two
+     */
+    void * allocate(std::size_t size, std::size_t alignment);
+
+    /*!
+     * \brief Gives back an allocation. Only the most recent allocation can actually be reused, so this is mostly a
+     * no-op. It's worth calling anyways, since it lets a growing vector's old storage get reused
+     */
+    void deallocate(void * memory, std::size_t size);
+
+    /*!
+     * \brief Frees everything, and grows the main block if the last frame overflowed it
+     */
+    void reset();
+
+    std::size_t get_capacity() const;
+
+    /*!
+     * \brief Returns how many bytes were allocated since the last reset, including anything that overflowed
+     */
+    std::size_t get_bytes_used() const;
+
+    /*!
+     * \brief Returns how many times the arena went to the heap since the last reset
+     */
+    uint32_t get_num_heap_allocations() const;
+
+private:
+    /*!
+     * \brief The start of every overflow block. They're a linked list, so keeping track of them never allocates
+     */
+    struct overflow_block {
+        overflow_block * next;
+        std::size_t capacity;
+        std::size_t used;
+    };
+
+    uint8_t * block;
+    std::size_t capacity;
+    std::size_t used = 0;
+
+    /*!
+     * \brief Where the most recent allocation from the main block starts, so it can be given back
+     */
+    std::size_t last_allocation = 0;
+
+    overflow_block * overflow = nullptr;
+    std::size_t overflow_bytes = 0;
+
+    uint32_t num_heap_allocations = 0;
+
+    void * allocate_overflow(std::size_t size, std::size_t alignment);
+
+    void free_overflow();
+};
+
+/*!
+ * \brief One frame_arena for each frame in flight
+ *
+ * Each frame gets the arena the frame #FRAMES_IN_FLIGHT before it used. Anything allocated in a frame stays valid for
+ * the two frames after it, so work that's started in one frame (like a sort on a worker thread) can keep reading what
+ * that frame made while the next frame gets built
+ */
+class frame_arenas {
+public:
+    static const unsigned int FRAMES_IN_FLIGHT = 3;
+
+    /*!
+     * \brief Counts of heap allocations, for checking that frames aren't allocating
+     */
+    struct frame_stats {
+        uint32_t arena_heap_allocations = 0;    //!< How many times the frame's arena overflowed onto the heap
+        uint64_t heap_allocations = 0;          //!< How many heap allocations the render thread made in the frame
+        std::size_t arena_bytes_used = 0;
+    };
+
+    /*!
+     * \param initial_capacity How many bytes each arena starts out with
+     */
+    frame_arenas(std::size_t initial_capacity);
+
+    /*!
+     * \brief Finishes the current frame, and resets the arena for the next one
+     *
+     * Call this once, at the start of every frame
+     */
+    void begin_frame();
+
+    /*!
+     * \brief Returns the arena for the current frame
+     */
+    frame_arena & get_current();
+
+    /*!
+     * \brief Returns the stats for the last frame that finished
+     *
+     * heap_allocations only counts anything if Nova was built with NOVA_COUNT_HEAP_ALLOCATIONS. Otherwise it's always 0
+     */
+    const frame_stats & get_last_frame_stats() const;
+
+private:
+    std::unique_ptr<frame_arena> arenas[FRAMES_IN_FLIGHT];
+    unsigned int current = 0;
+
+    uint64_t heap_allocations_at_frame_start = 0;
+    frame_stats last_frame_stats;
+};
+
+/*!
+ * \brief An STL allocator that allocates from a frame_arena
+ *
+ * Deallocating does (almost) nothing, so reserve containers up front when you can. Containers that use this must not
+ * outlive the arena's frame
+ */
+template<typename T>
+class arena_allocator {
+public:
+    typedef T value_type;
+
+    arena_allocator(frame_arena & arena) noexcept : arena(&arena) {}
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U> & other) noexcept : arena(other.arena) {}
+
+    T * allocate(std::size_t count) {
+        return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T * memory, std::size_t count) noexcept {
+        arena->deallocate(memory, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const arena_allocator<U> & other) const noexcept {
+        return arena == other.arena;
+    }
+
+    template<typename U>
+    bool operator!=(const arena_allocator<U> & other) const noexcept {
+        return arena != other.arena;
+    }
+
+private:
+    template<typename U>
+    friend class arena_allocator;
+
+    frame_arena * arena;
+};
+
+/*!
+ * \brief A vector that lives in a frame arena. Make it with frame_vector<T>(arena_allocator<T>(arena))
+ */
+template<typename T>
+using frame_vector = std::vector<T, arena_allocator<T>>;
+
+#endif //RENDERER_FRAME_ARENA_H
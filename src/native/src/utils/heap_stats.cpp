@@ -0,0 +1,95 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <cstdlib>
+#include <new>
+#include "heap_stats.h"
+
+#ifdef NOVA_COUNT_HEAP_ALLOCATIONS
+
+static thread_local uint64_t thread_allocations = 0;
+
+static void * counted_allocate(std::size_t size) {
+    thread_allocations++;
+
+    // malloc(0) is allowed to return nullptr, but new has to return something unique
+    void * memory = std::malloc(size > 0 ? size : 1);
+    if(memory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void * operator new(std::size_t size) {
+    return counted_allocate(size);
+}
+
+void * operator new[](std::size_t size) {
+    return counted_allocate(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return counted_allocate(size);
+    } catch(const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return counted_allocate(size);
+    } catch(const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void * memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void * memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void * memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void * memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void * memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void * memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+namespace heap_stats {
+    bool is_counting() {
+        return true;
+    }
+
+    uint64_t get_thread_allocations() {
+        return thread_allocations;
+    }
+}
+
+#else
+
+namespace heap_stats {
+    bool is_counting() {
+        return false;
+    }
+
+    uint64_t get_thread_allocations() {
+        return 0;
+    }
+}
+
+#endif
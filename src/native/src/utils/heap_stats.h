@@ -0,0 +1,31 @@
+/*!
+ * \brief Counts heap allocations, so we can tell when something that shouldn't allocate does
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_HEAP_STATS_H
+#define RENDERER_HEAP_STATS_H
+
+#include <cstdint>
+
+/*!
+ * \brief When Nova is built with NOVA_COUNT_HEAP_ALLOCATIONS, operator new is replaced with one that counts how many
+ * times each thread calls it. Without it, nothing is counted and the counts are always 0
+ *
+ * It's off by default, since the replacement might end up counting (and serving) allocations from whatever else is
+ * loaded in the same process. Turn it on when you want to check that frames aren't allocating
+ */
+namespace heap_stats {
+    /*!
+     * \brief Returns true if allocations are being counted
+     */
+    bool is_counting();
+
+    /*!
+     * \brief Returns how many times the calling thread has allocated from the heap
+     */
+    uint64_t get_thread_allocations();
+}
+
+#endif //RENDERER_HEAP_STATS_H
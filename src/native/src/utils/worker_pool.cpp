@@ -0,0 +1,128 @@
+/*!
+ * \date 19-Oct-26
+ */
+
+#include <unistd.h>
+#include "worker_pool.h"
+
+job_group::job_group() : num_pending(0) {
+    pthread_mutex_init(&lock, nullptr);
+    pthread_cond_init(&finished, nullptr);
+}
+
+job_group::~job_group() {
+    // Never let a job finish into a group that's gone. This always takes the lock, unlike #wait, since the last job
+    // can still be inside finish_job after the count hits zero
+    pthread_mutex_lock(&lock);
+    while(num_pending.load(std::memory_order_acquire) != 0) {
+        pthread_cond_wait(&finished, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+    pthread_cond_destroy(&finished);
+    pthread_mutex_destroy(&lock);
+}
+
+void job_group::wait() {
+    if(is_done()) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    while(num_pending.load(std::memory_order_acquire) != 0) {
+        pthread_cond_wait(&finished, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+bool job_group::is_done() const {
+    return num_pending.load(std::memory_order_acquire) == 0;
+}
+
+void job_group::add_job() {
+    num_pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+void job_group::finish_job() {
+    // The lock makes sure a waiter can't check the count, miss this, and then sleep forever
+    pthread_mutex_lock(&lock);
+    if(num_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pthread_cond_broadcast(&finished);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+worker_pool::worker_pool(unsigned int num_threads) {
+    pthread_mutex_init(&queue_lock, nullptr);
+    pthread_cond_init(&job_available, nullptr);
+
+    if(num_threads == 0) {
+        num_threads = get_default_num_threads();
+    }
+
+    threads.resize(num_threads);
+    for(pthread_t & thread : threads) {
+        pthread_create(&thread, nullptr, run_worker, this);
+    }
+}
+
+worker_pool::~worker_pool() {
+    pthread_mutex_lock(&queue_lock);
+    stopping = true;
+    pthread_cond_broadcast(&job_available);
+    pthread_mutex_unlock(&queue_lock);
+
+    for(pthread_t & thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+
+    pthread_cond_destroy(&job_available);
+    pthread_mutex_destroy(&queue_lock);
+}
+
+void worker_pool::submit(job_function function, void * data, job_group * group) {
+    if(group != nullptr) {
+        group->add_job();
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    queue.push_back(job{function, data, group});
+    pthread_cond_signal(&job_available);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+unsigned int worker_pool::get_num_threads() const {
+    return (unsigned int) threads.size();
+}
+
+unsigned int worker_pool::get_default_num_threads() {
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return num_cores > 2 ? (unsigned int) (num_cores - 1) : 1;
+}
+
+void * worker_pool::run_worker(void * pool_pointer) {
+    worker_pool & pool = *static_cast<worker_pool *>(pool_pointer);
+
+    while(true) {
+        pthread_mutex_lock(&pool.queue_lock);
+        while(pool.queue.empty() && !pool.stopping) {
+            pthread_cond_wait(&pool.job_available, &pool.queue_lock);
+        }
+
+        // Finish everything that's queued before stopping, so nobody waits on a job that never runs
+        if(pool.queue.empty()) {
+            pthread_mutex_unlock(&pool.queue_lock);
+            return nullptr;
+        }
+
+        job next_job = pool.queue.front();
+        pool.queue.pop_front();
+        pthread_mutex_unlock(&pool.queue_lock);
+
+        next_job.function(next_job.data);
+
+        if(next_job.group != nullptr) {
+            next_job.group->finish_job();
+        }
+    }
+}
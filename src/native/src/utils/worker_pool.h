@@ -0,0 +1,103 @@
+/*!
+ * \brief Defines a pool of worker threads that run small jobs off the render thread
+ *
+ * \date 19-Oct-26
+ */
+
+#ifndef RENDERER_WORKER_POOL_H
+#define RENDERER_WORKER_POOL_H
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+
+/*!
+ * \brief Counts how many jobs in a group haven't finished yet, so whoever submitted them can wait for all of them
+ */
+class job_group {
+public:
+    job_group();
+    ~job_group();
+
+    job_group(const job_group & other) = delete;
+    job_group & operator=(const job_group & other) = delete;
+
+    /*!
+     * \brief Blocks until every job in the group is done
+     */
+    void wait();
+
+    bool is_done() const;
+
+private:
+    friend class worker_pool;
+
+    std::atomic<unsigned int> num_pending;
+
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+
+    void add_job();
+
+    void finish_job();
+};
+
+/*!
+ * \brief A few threads that take jobs off a queue and run them
+ *
+ * A job is a function pointer and a pointer to its data. No std::function, so submitting a job never allocates
+ * anything but queue space. The data has to stay alive until the job is done, which is easiest if it lives in
+ * whatever the job is working on.
+ *
+ * Jobs shouldn't touch OpenGL, since the context belongs to the render thread
+ */
+class worker_pool {
+public:
+    typedef void (*job_function)(void * data);
+
+    /*!
+     * \param num_threads How many worker threads to start. 0 means #get_default_num_threads
+     */
+    worker_pool(unsigned int num_threads = 0);
+
+    /*!
+     * \brief Finishes every job that's queued, then stops the threads
+     */
+    ~worker_pool();
+
+    worker_pool(const worker_pool & other) = delete;
+    worker_pool & operator=(const worker_pool & other) = delete;
+
+    /*!
+     * \brief Queues up a job
+     *
+     * \param group If this isn't nullptr, the job is part of this group, and the group isn't done until the job is
+     */
+    void submit(job_function function, void * data, job_group * group = nullptr);
+
+    unsigned int get_num_threads() const;
+
+    /*!
+     * \brief One less than the number of cores, so the render thread gets a core to itself. Always at least 1
+     */
+    static unsigned int get_default_num_threads();
+
+private:
+    struct job {
+        job_function function;
+        void * data;
+        job_group * group;
+    };
+
+    std::vector<pthread_t> threads;
+
+    pthread_mutex_t queue_lock;
+    pthread_cond_t job_available;
+    std::deque<job> queue;
+    bool stopping = false;
+
+    static void * run_worker(void * pool);
+};
+
+#endif //RENDERER_WORKER_POOL_H